@@ -5,6 +5,7 @@
 #include <map>
 #include <vector>
 #include "Literal128.h"
+#include "AssemblerStats.h"
 #include "Stream.h"
 #include "Types.h"
 
@@ -194,6 +195,10 @@ public:
 
 	void									SetStream(Framework::CStream*);
 
+	void									SetStats(CAssemblerStats*);
+	void									BeginStatsRegion(CAssemblerStats::CATEGORY, uint32 = CAssemblerStats::NO_TAG);
+	void									EndStatsRegion();
+
 	LABEL									CreateLabel();
 	void									ClearLabels();
 	void									MarkLabel(LABEL);
@@ -208,6 +213,7 @@ public:
 	void									Adrl(REGISTER, const LITERAL128&);
 	void									And(REGISTER, REGISTER, REGISTER);
 	void									And(REGISTER, REGISTER, const ImmediateAluOperand&);
+	void									B_offset(int32);
 	void									BCc(CONDITION, LABEL);
 	void									Bic(REGISTER, REGISTER, const ImmediateAluOperand&);
 	void									Bx(REGISTER);
@@ -265,7 +271,9 @@ public:
 	void									Vmovn_I32(DOUBLE_REGISTER, QUAD_REGISTER);
 	void									Vdup(QUAD_REGISTER, REGISTER);
 	void									Vzip_I8(DOUBLE_REGISTER, DOUBLE_REGISTER);
+	void									Vzip_I8(QUAD_REGISTER, QUAD_REGISTER);
 	void									Vzip_I16(DOUBLE_REGISTER, DOUBLE_REGISTER);
+	void									Vzip_I16(QUAD_REGISTER, QUAD_REGISTER);
 	void									Vzip_I32(QUAD_REGISTER, QUAD_REGISTER);
 	void									Vtbl(DOUBLE_REGISTER, DOUBLE_REGISTER, DOUBLE_REGISTER);
 	void									Vadd_F32(SINGLE_REGISTER, SINGLE_REGISTER, SINGLE_REGISTER);
@@ -368,6 +376,7 @@ private:
 
 	void									CreateLabelReference(LABEL);
 	void									WriteWord(uint32);
+	void									RecordStatsInstruction(CAssemblerStats::CATEGORY);
 
 	static uint32							FPSIMD_EncodeSd(SINGLE_REGISTER);
 	static uint32							FPSIMD_EncodeSn(SINGLE_REGISTER);
@@ -385,4 +394,5 @@ private:
 	Literal128ArrayType						m_literal128Refs;
 	
 	Framework::CStream*						m_stream = nullptr;
+	CAssemblerStats*						m_stats = nullptr;
 };
@@ -4,6 +4,7 @@
 #include <vector>
 #include "Stream.h"
 #include "Literal128.h"
+#include "AssemblerStats.h"
 
 class CAArch64Assembler
 {
@@ -76,6 +77,10 @@ public:
 
 	void    SetStream(Framework::CStream*);
 
+	void    SetStats(CAssemblerStats*);
+	void    BeginStatsRegion(CAssemblerStats::CATEGORY, uint32 = CAssemblerStats::NO_TAG);
+	void    EndStatsRegion();
+
 	LABEL    CreateLabel();
 	void     ClearLabels();
 	void     MarkLabel(LABEL);
@@ -280,6 +285,7 @@ private:
 	void    WriteLoadStoreOpImm(uint32, uint32 imm, uint32 rn, uint32 rt);
 	void    WriteMoveWideOpImm(uint32, uint32 hw, uint32 imm, uint32 rd);
 	void    WriteWord(uint32);
+	void    RecordStatsInstruction(CAssemblerStats::CATEGORY);
 	
 	unsigned int             m_nextLabelId = 1;
 	LabelMapType             m_labels;
@@ -287,4 +293,5 @@ private:
 	Literal128ArrayType      m_literal128Refs;
 	
 	Framework::CStream*    m_stream = nullptr;
+	CAssemblerStats*       m_stats = nullptr;
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "Types.h"
+
+//Accounts for the bytes emitted by an assembler. Emitted code is attributed to a category
+//(what kind of code it is) and to a tag (who asked for it, ie.: the IR operation being lowered).
+//Code is emitted in regions opened by the user of the assembler, instructions the assembler
+//knows more about (jumps, calls) are then carved out of the region's category.
+class CAssemblerStats
+{
+public:
+	enum CATEGORY
+	{
+		CATEGORY_CODE,
+		CATEGORY_PROLOG,
+		CATEGORY_EPILOG,
+		CATEGORY_SPILL,
+		CATEGORY_RELOAD,
+		CATEGORY_LITERALPOOL,
+		CATEGORY_JUMP_SHORT,		//Jumps with an 8-bit displacement (x86 only)
+		CATEGORY_JUMP_NEAR,			//Jumps with a full displacement, all ARM branches fall here
+		CATEGORY_CALL,				//Calls and jumps out of the function
+		CATEGORY_MAX,
+	};
+
+	enum : uint32
+	{
+		NO_TAG = ~0U,
+	};
+
+	struct TAG_STATS
+	{
+		uint64		bytes = 0;
+		uint64		regionCount = 0;
+	};
+
+	typedef std::array<uint64, CATEGORY_MAX> CategoryArray;
+	typedef std::vector<TAG_STATS> TagArray;
+
+	void					Reset();
+
+	void					BeginRegion(uint64, CATEGORY, uint32 = NO_TAG);
+	void					EndRegion(uint64);
+
+	//Instruction emitted inside the current region
+	void					RecordInstruction(CATEGORY, uint32);
+
+	//Bytes emitted outside of any region (ie.: resolved jumps, literal pools)
+	void					RecordDetached(CATEGORY, uint32, uint32, uint32);
+
+	uint32					GetCurrentTag() const;
+
+	uint64					GetTotalBytes() const;
+	const CategoryArray&	GetCategoryBytes() const;
+	const CategoryArray&	GetCategoryInstructionCounts() const;
+	const TagArray&			GetTags() const;
+
+	static const char*		GetCategoryName(CATEGORY);
+
+private:
+	TAG_STATS&				GetTag(uint32);
+
+	CategoryArray			m_categoryBytes = {};
+	CategoryArray			m_categoryInstructionCounts = {};
+	TagArray				m_tags;
+
+	bool					m_inRegion = false;
+	CATEGORY				m_regionCategory = CATEGORY_CODE;
+	uint32					m_regionTag = NO_TAG;
+	uint64					m_regionStart = 0;
+	uint64					m_regionCarvedBytes = 0;
+};
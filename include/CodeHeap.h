@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <mutex>
+#include "Types.h"
+
+//Executable memory shared by many small functions. Memory is reserved in large regions
+//and carved into size classes, freed blocks are kept in per-class free lists for reuse.
+class CCodeHeap
+{
+public:
+	enum
+	{
+		DEFAULT_REGION_SIZE = 0x400000,
+		BLOCK_ALIGN = 0x10,
+	};
+
+	struct STATS
+	{
+		size_t		regionCount = 0;
+		size_t		regionSize = 0;
+		size_t		allocatedSize = 0;
+		size_t		freeSize = 0;
+		size_t		allocationCount = 0;
+	};
+
+	//Delays instruction cache invalidation until the end of the scope, merging all requested ranges
+	class CFlushBatch
+	{
+	public:
+						CFlushBatch(CCodeHeap&);
+						CFlushBatch(const CFlushBatch&) = delete;
+						~CFlushBatch();
+
+		CFlushBatch&	operator =(const CFlushBatch&) = delete;
+
+	private:
+		CCodeHeap&		m_heap;
+	};
+
+						CCodeHeap(size_t = DEFAULT_REGION_SIZE);
+						CCodeHeap(const CCodeHeap&) = delete;
+	virtual				~CCodeHeap();
+
+	CCodeHeap&			operator =(const CCodeHeap&) = delete;
+
+	void*				Allocate(size_t);
+	void				Free(void*, size_t);
+
+	void				ClearCache(void*, size_t);
+
+	STATS				GetStats() const;
+
+	static size_t		GetAllocationSize(size_t);
+
+private:
+	enum
+	{
+		//Size classes go from 64 bytes to 64KB with 4 steps per power of two
+		MIN_CLASS_SHIFT = 6,
+		MAX_CLASS_SHIFT = 16,
+		CLASS_STEPS = 4,
+		CLASS_COUNT = ((MAX_CLASS_SHIFT - MIN_CLASS_SHIFT) * CLASS_STEPS) + 1,
+	};
+
+	struct REGION
+	{
+		uint8*		base = nullptr;
+		size_t		size = 0;
+	};
+
+	typedef std::vector<REGION> RegionArray;
+	typedef std::vector<void*> FreeList;
+	typedef std::vector<REGION> FlushRangeArray;
+
+	static unsigned int	GetSizeClass(size_t);
+	static size_t		GetSizeClassSize(unsigned int);
+
+	static void*		MapMemory(size_t);
+	static void			UnmapMemory(void*, size_t);
+
+	void				BeginFlushBatch();
+	void				EndFlushBatch();
+
+	mutable std::mutex	m_mutex;
+
+	size_t				m_regionSize = 0;
+	RegionArray			m_regions;
+	RegionArray			m_largeBlocks;
+	uint8*				m_regionCursor = nullptr;
+	uint8*				m_regionEnd = nullptr;
+	std::array<FreeList, CLASS_COUNT>	m_freeLists;
+
+	size_t				m_allocatedSize = 0;
+	size_t				m_freeSize = 0;
+	size_t				m_allocationCount = 0;
+
+	unsigned int		m_flushBatchDepth = 0;
+	FlushRangeArray		m_pendingFlushes;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Types.h"
+
+namespace Elf
+{
+	enum
+	{
+		EI_NIDENT = 0x10,
+	};
+
+	enum IDENT
+	{
+		ELFMAG0       = 0x7F,
+		ELFMAG1       = 'E',
+		ELFMAG2       = 'L',
+		ELFMAG3       = 'F',
+		ELFCLASS64    = 2,
+		ELFDATA2LSB   = 1,
+		EV_CURRENT    = 1,
+		ELFOSABI_NONE = 0,
+	};
+
+	enum FILE_TYPE
+	{
+		ET_REL = 1,
+	};
+
+	enum MACHINE_TYPE
+	{
+		EM_X86_64  = 0x3E,
+		EM_AARCH64 = 0xB7,
+	};
+
+	enum SECTION_TYPE
+	{
+		SHT_NULL     = 0,
+		SHT_PROGBITS = 1,
+		SHT_SYMTAB   = 2,
+		SHT_STRTAB   = 3,
+		SHT_RELA     = 4,
+	};
+
+	enum SECTION_FLAGS
+	{
+		SHF_WRITE     = 0x01,
+		SHF_ALLOC     = 0x02,
+		SHF_EXECINSTR = 0x04,
+		SHF_INFO_LINK = 0x40,
+	};
+
+	enum SECTION_INDEX
+	{
+		SHN_UNDEF = 0,
+	};
+
+	enum SYMBOL_BINDING
+	{
+		STB_LOCAL  = 0,
+		STB_GLOBAL = 1,
+	};
+
+	enum SYMBOL_TYPE
+	{
+		STT_NOTYPE = 0,
+		STT_OBJECT = 1,
+		STT_FUNC   = 2,
+	};
+
+	enum RELOCATION_TYPE_X86_64
+	{
+		R_X86_64_64 = 1,
+	};
+
+	enum RELOCATION_TYPE_AARCH64
+	{
+		R_AARCH64_ABS64  = 257,
+		R_AARCH64_JUMP26 = 282,
+		R_AARCH64_CALL26 = 283,
+	};
+
+	struct HEADER64
+	{
+		uint8		ident[EI_NIDENT];
+		uint16		type;
+		uint16		machine;
+		uint32		version;
+		uint64		entry;
+		uint64		phOffset;
+		uint64		shOffset;
+		uint32		flags;
+		uint16		ehSize;
+		uint16		phEntrySize;
+		uint16		phCount;
+		uint16		shEntrySize;
+		uint16		shCount;
+		uint16		shStrIndex;
+	};
+	static_assert(sizeof(HEADER64) == 0x40, "Size of HEADER64 must be 0x40 bytes.");
+
+	struct SECTION_HEADER64
+	{
+		uint32		name;
+		uint32		type;
+		uint64		flags;
+		uint64		address;
+		uint64		offset;
+		uint64		size;
+		uint32		link;
+		uint32		info;
+		uint64		addressAlign;
+		uint64		entrySize;
+	};
+	static_assert(sizeof(SECTION_HEADER64) == 0x40, "Size of SECTION_HEADER64 must be 0x40 bytes.");
+
+	struct SYMBOL64
+	{
+		uint32		name;
+		uint8		info;
+		uint8		other;
+		uint16		sectionIndex;
+		uint64		value;
+		uint64		size;
+	};
+	static_assert(sizeof(SYMBOL64) == 0x18, "Size of SYMBOL64 must be 0x18 bytes.");
+
+	struct RELA64
+	{
+		uint64		offset;
+		uint64		info;
+		int64		addend;
+	};
+	static_assert(sizeof(RELA64) == 0x18, "Size of RELA64 must be 0x18 bytes.");
+
+	static inline uint8 MakeSymbolInfo(uint8 binding, uint8 type)
+	{
+		return (binding << 4) | (type & 0x0F);
+	}
+
+	static inline uint64 MakeRelocationInfo(uint32 symbolIndex, uint32 type)
+	{
+		return (static_cast<uint64>(symbolIndex) << 32) | type;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ObjectFile.h"
+#include "ElfDefs.h"
+#include <vector>
+
+namespace Jitter
+{
+	//ELF64 relocatable object file, supports x86-64 and AArch64
+	class CElfObjectFile : public CObjectFile
+	{
+	public:
+									CElfObjectFile(CPU_ARCH);
+		virtual						~CElfObjectFile();
+
+		void						Write(Framework::CStream&) override;
+
+	private:
+		enum SECTION_INDEX
+		{
+			SECTION_INDEX_NULL,
+			SECTION_INDEX_TEXT,
+			SECTION_INDEX_DATA,
+			SECTION_INDEX_RELA_TEXT,
+			SECTION_INDEX_RELA_DATA,
+			SECTION_INDEX_SYMTAB,
+			SECTION_INDEX_STRTAB,
+			SECTION_INDEX_SHSTRTAB,
+			SECTION_INDEX_NOTE_GNU_STACK,
+			SECTION_INDEX_COUNT,
+		};
+
+		typedef std::vector<Elf::SECTION_HEADER64> SectionHeaderArray;
+		typedef std::vector<Elf::RELA64> RelocationArray;
+		typedef std::vector<Elf::SYMBOL64> SymbolArray;
+
+		struct INTERNAL_SYMBOL_INFO
+		{
+			uint32					nameOffset = 0;
+			uint32					dataOffset = 0;
+			uint32					symbolIndex = 0;
+		};
+		typedef std::vector<INTERNAL_SYMBOL_INFO> InternalSymbolInfoArray;
+
+		struct EXTERNAL_SYMBOL_INFO
+		{
+			uint32					nameOffset = 0;
+			uint32					symbolIndex = 0;
+		};
+		typedef std::vector<EXTERNAL_SYMBOL_INFO> ExternalSymbolInfoArray;
+
+		typedef std::vector<char> StringTable;
+		typedef std::vector<uint8> SectionData;
+
+		struct SECTION
+		{
+			SectionData				data;
+			SymbolReferenceArray	symbolReferences;
+		};
+
+		static uint32				AddString(StringTable&, const std::string&);
+		static void					FillStringTable(StringTable&, const InternalSymbolArray&, InternalSymbolInfoArray&);
+		static void					FillStringTable(StringTable&, const ExternalSymbolArray&, ExternalSymbolInfoArray&);
+		static SECTION				BuildSection(const InternalSymbolArray&, InternalSymbolInfoArray&, INTERNAL_SYMBOL_LOCATION);
+		static SymbolArray			BuildSymbols(const InternalSymbolArray&, InternalSymbolInfoArray&, const ExternalSymbolArray&, ExternalSymbolInfoArray&);
+		RelocationArray				BuildRelocations(SECTION&, const InternalSymbolInfoArray&, const ExternalSymbolInfoArray&) const;
+	};
+}
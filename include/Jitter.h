@@ -5,12 +5,15 @@
 #include <list>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <stack>
 #include "ArrayStack.h"
 #include "Stream.h"
 #include "Jitter_SymbolTable.h"
 #include "Jitter_CodeGen.h"
+#include "Jitter_CompileStats.h"
+#include "Jitter_CodeCache.h"
 
 #ifndef SIZE_MAX
 #define SIZE_MAX ((size_t)-1)
@@ -32,6 +35,14 @@ namespace Jitter
 			ROUND_TRUNCATE = 3
 		};
 
+		enum COMPILE_TIER
+		{
+			//Single pass over the statements and block local register allocation, for code that runs a few times
+			COMPILE_TIER_BASELINE,
+			//Full optimizer and global register allocation, for hot code
+			COMPILE_TIER_OPTIMIZED,
+		};
+
 		enum RETURN_VALUE_TYPE
 		{
 			RETURN_VALUE_NONE,
@@ -40,6 +51,14 @@ namespace Jitter
 			RETURN_VALUE_128,
 		};
 
+		//Entry of the tables probed by Lookup, the code has the same signature as the functions used with JumpTo.
+		//Empty entries need a tag that doesn't match any address.
+		struct LOOKUP_ENTRY
+		{
+			uint32		tag = ~0U;
+			void*		code = nullptr;
+		};
+
 		typedef unsigned int LABEL;
 
 										CJitter(CCodeGen*);
@@ -58,6 +77,13 @@ namespace Jitter
 		void							MarkLabel(LABEL);
 		void							Goto(LABEL);
 
+		//Continue goes back to the start of the innermost loop, execution leaves a loop by reaching EndLoop.
+		//Goto can't be used to enter a loop from outside.
+		void							BeginLoop();
+		void							Continue();
+		void							Continue(CONDITION);
+		void							EndLoop();
+
 		void							PushCtx();
 		void							PushCst(uint32);
 		virtual void					PushRel(size_t);
@@ -81,7 +107,9 @@ namespace Jitter
 		void							DivS();
 		void							JumpTo(void*);
 		void							JumpToDynamic(void*);
-		void							Lookup(uint32*);
+		//Pops an address and probes the table entry at (address & indexMask). Jumps to the entry's code if its tag
+		//matches the address, to the miss function (ie.: the dispatcher) otherwise. Nothing runs after the lookup.
+		void							Lookup(const LOOKUP_ENTRY*, uint32, void*);
 		void							Lzc();
 		void							Mult();
 		void							MultS();
@@ -233,6 +261,73 @@ namespace Jitter
 
 		void							SetStream(Framework::CStream*);
 
+		//Code generated for statement lists seen before is taken from the cache instead of being generated again.
+		//Cache isn't owned by the jitter and can be shared with others. Not used when an external symbol handler is set.
+		void							SetCodeCache(CCodeCache*);
+		CCodeCache*						GetCodeCache() const;
+
+		//Offsets of the OP_EXTERNJMP_DYN exits in the code generated by the last call to End
+		const CCodeGen::DynamicExitArray&	GetDynamicExits() const;
+
+		//Compilation statistics (disabled by default)
+		void							SetCompileStatsEnabled(bool);
+		bool							IsCompileStatsEnabled() const;
+		const CCompileStats::STATS&		GetCompileStats() const;
+		const CCompileStats::STATS&		GetLastCompileStats() const;
+		void							ResetCompileStats();
+
+		//Symbols and symbol references are allocated from a per-compilation arena (enabled by default)
+		void							SetSymbolArenaEnabled(bool);
+		bool							IsSymbolArenaEnabled() const;
+		//Arena state as of the last compilation
+		const CArena&					GetSymbolArenaState() const;
+
+		//Relatives used in many blocks are kept in the same register across the whole function (enabled by default)
+		void							SetGlobalRegisterAllocationEnabled(bool);
+		bool							IsGlobalRegisterAllocationEnabled() const;
+
+		//Pure operations computed more than once in a block reuse the first result (enabled by default)
+		void							SetValueNumberingEnabled(bool);
+		bool							IsValueNumberingEnabled() const;
+
+		//Multiplications, divisions and 64-bit operations with constants are replaced by cheaper operations (enabled by default)
+		void							SetStrengthReductionEnabled(bool);
+		bool							IsStrengthReductionEnabled() const;
+
+		//FP single values are kept in MD registers when the code generator supports it (enabled by default)
+		void							SetFpRegisterAllocationEnabled(bool);
+		bool							IsFpRegisterAllocationEnabled() const;
+
+		//Pure operations that give the same result in every iteration of a loop are computed before it (enabled by default)
+		void							SetLoopInvariantCodeMotionEnabled(bool);
+		bool							IsLoopInvariantCodeMotionEnabled() const;
+
+		//Tier used to compile the next functions (COMPILE_TIER_OPTIMIZED by default)
+		void							SetCompileTier(COMPILE_TIER);
+		COMPILE_TIER					GetCompileTier() const;
+
+		//Functions generated while set increment the counter when they are entered. Callers use it to find
+		//baseline functions worth promoting: generating them again at the optimized tier (and with a profile if
+		//they were instrumented) and replacing the baseline code. The counter needs to outlive the code.
+		void							SetExecutionCounter(uint32*);
+
+		//Profile guided compilation (disabled by default). Block ids only depend on the sequence of calls made to
+		//the jitter, generating the same function again with a profile uses the counts gathered for it.
+		//Both settings only apply to the next function generated, they are cleared by End.
+		//When instrumented, code increments counters[id] when entering a block (if id < counter count).
+		//Conditional jumps fall through in a block of their own, its counter gives the count of the not taken edge.
+		void							SetProfileInstrumentation(uint32*, unsigned int);
+		//Hot blocks are laid out as fall through, cold blocks (never entered) go at the end of the function and
+		//uses in hot blocks are favored when allocating registers. Counts need to outlive the next call to End.
+		void							SetProfile(const uint32*, unsigned int);
+		//Counters needed to instrument all blocks of the last function generated
+		unsigned int					GetProfileCounterCount() const;
+
+		//Context pure functions don't read or write the context, values held in registers are kept there across calls to them
+		void							DeclareContextPureFunction(const void*);
+		void							ClearContextPureFunctions();
+		bool							IsContextPureFunction(const void*) const;
+
 	private:
 		struct SYMBOL_REGALLOCINFO
 		{
@@ -242,17 +337,57 @@ namespace Jitter
 			unsigned int			firstDef = -1;
 			unsigned int			lastDef = -1;
 			bool					aliased = false;
+			bool					spansCall = false;
 			SYM_TYPE				registerType = SYM_REGISTER;
 			unsigned int			registerId = -1;
 		};
 
+		struct GLOBAL_REGISTER
+		{
+			SymbolPtr				symbol;
+			SYM_TYPE				registerType = SYM_REGISTER;
+			unsigned int			registerId = -1;
+		};
+
+		struct GLOBAL_REGISTER_CANDIDATE
+		{
+			unsigned int			useCount = 0;
+			unsigned int			blockCount = 0;
+			unsigned int			lastBlockIndex = -1;
+			bool					aliased = false;
+			bool					usedInLoop = false;
+		};
+
+		//One bit per entry in m_globalRegisters
+		typedef uint32 GlobalRegisterMask;
+
+		struct GLOBAL_REGISTER_FLOW
+		{
+			std::vector<unsigned int>	successors;
+			std::vector<unsigned int>	predecessors;
+			std::vector<GlobalRegisterMask>	spillMasks;
+			std::vector<GlobalRegisterMask>	reloadMasks;
+			bool					exitsAtEnd = false;
+			GlobalRegisterMask		dirtyIn = 0;
+			GlobalRegisterMask		dirtyOut = 0;
+			GlobalRegisterMask		liveIn = 0;
+			GlobalRegisterMask		liveOut = 0;
+		};
+
 		typedef size_t LABELREF;
 		typedef std::map<LABEL, unsigned int> LabelMapType;
 		typedef std::pair<unsigned int, unsigned int> AllocationRange;
 		typedef std::vector<AllocationRange> AllocationRangeArray;
 		typedef std::unordered_map<SymbolPtr, SYMBOL_REGALLOCINFO, SymbolHasher, SymbolComparator> SymbolRegAllocInfo;
 		typedef std::unordered_map<CSymbol*, unsigned int> SymbolUseCountMap;
+		typedef std::vector<uint32> StatementIndexArray;
+		typedef std::unordered_map<CSymbol*, StatementIndexArray> SymbolUseMap;
 		typedef std::stack<uint32> IntStack;
+		typedef std::vector<GLOBAL_REGISTER> GlobalRegisterArray;
+		typedef std::unordered_map<SymbolPtr, GLOBAL_REGISTER_CANDIDATE, SymbolHasher, SymbolComparator> GlobalRegisterCandidateMap;
+		typedef std::vector<GLOBAL_REGISTER_FLOW> GlobalRegisterFlowArray;
+		//Temporary id to stack location
+		typedef std::unordered_map<uint32, unsigned int> LoopInvariantTemporaryMap;
 
 		class CRelativeVersionManager
 		{
@@ -269,11 +404,20 @@ namespace Jitter
 
 		struct BASIC_BLOCK
 		{
+			BASIC_BLOCK(CArena* arena = nullptr)
+				: symbolTable(arena)
+			{
+
+			}
+
 			uint32						id = 0;
 			StatementList				statements;
 			CSymbolTable				symbolTable;
 			bool						optimized = false;
 			bool						hasJumpRef = false;
+			//Number of loops containing this block, the first block of a loop is its header
+			unsigned int				loopDepth = 0;
+			bool						loopHeader = false;
 		};
 		typedef std::list<BASIC_BLOCK> BasicBlockList;
 
@@ -289,11 +433,15 @@ namespace Jitter
 		void							InsertBinaryMdStatement(Jitter::OPERATION);
 
 		void							Compile();
+		void							OptimizeBlocks();
+		void							PrepareBaselineBlocks();
 
 		bool							ConstantFolding(StatementList&);
 		bool							ConstantPropagation(StatementList&);
 		bool							CopyPropagation(StatementList&);
 		bool							ReorderAdd(StatementList&);
+		bool							ValueNumbering(StatementList&);
+		bool							StrengthReduction(StatementList&);
 		bool							DeadcodeElimination(VERSIONED_STATEMENT_LIST&);
 
 		void							FixFlowControl(StatementList&);
@@ -309,6 +457,12 @@ namespace Jitter
 		void							HarmonizeBlocks();
 		void							MergeBasicBlocks(BASIC_BLOCK&, const BASIC_BLOCK&);
 
+		void							HoistLoopInvariants();
+		void							LayoutBlocks();
+		bool							IsProfiledBlock(uint32) const;
+		bool							IsColdBlock(uint32) const;
+		bool							IsLoopInvariantTemporary(const CSymbol*) const;
+
 		void							StartBlock(uint32);
 
 		void							InsertStatement(const STATEMENT&);
@@ -319,9 +473,12 @@ namespace Jitter
 		SymbolPtr						MakeConstant64(uint64);
 
 		SymbolRefPtr					MakeSymbolRef(const SymbolPtr&);
+		SymbolRefPtr					MakeVersionedSymbolRef(const SymbolPtr&, int);
+		CArena*							GetSymbolArena();
 		int								GetSymbolSize(const SymbolRefPtr&);
 
 		static CONDITION				GetReverseCondition(CONDITION);
+		static bool						IsContextPureCall(const STATEMENT&);
 
 		VERSIONED_STATEMENT_LIST		GenerateVersionedStatementList(const StatementList&);
 		StatementList					CollapseVersionedStatementList(const VERSIONED_STATEMENT_LIST&);
@@ -333,15 +490,49 @@ namespace Jitter
 		static AllocationRangeArray		ComputeAllocationRanges(const BASIC_BLOCK&);
 		void							ComputeLivenessForRange(const BASIC_BLOCK&, const AllocationRange&, SymbolRegAllocInfo&) const;
 		void							MarkAliasedSymbols(const BASIC_BLOCK&, const AllocationRange&, SymbolRegAllocInfo&) const;
+		void							MarkCallSpanningSymbols(const BASIC_BLOCK&, const AllocationRange&, SymbolRegAllocInfo&) const;
 		void							AssociateSymbolsToRegisters(SymbolRegAllocInfo&) const;
 
+		void							AllocateGlobalRegisters();
+		GlobalRegisterArray				SelectGlobalRegisters() const;
+		void							InsertGlobalRegisterLoadsAndSpills();
+		GlobalRegisterFlowArray			ComputeGlobalRegisterFlow(const std::vector<BASIC_BLOCK*>&) const;
+		GlobalRegisterMask				GetGlobalRegisterMask(const SymbolRefPtr&) const;
+		GlobalRegisterMask				GetGlobalRegisterCallClobberMask() const;
+		STATEMENT						MakeGlobalRegisterLoad(BASIC_BLOCK&, unsigned int);
+		STATEMENT						MakeGlobalRegisterSpill(BASIC_BLOCK&, unsigned int);
+
 		void							NormalizeStatements(BASIC_BLOCK&);
 		unsigned int					AllocateStack(BASIC_BLOCK&);
 
+		//Indices of the statements reading each non constant symbol, in order
+		static SymbolUseMap				GetSymbolUses(const StatementList&);
+
+		void							GenerateCode(const StatementList&, unsigned int);
+		void							GenerateCodeCached(const StatementList&, unsigned int);
+
+		static CCompileStats::IR_SIZE	GetIRSize(const StatementList&);
+		static CCompileStats::IR_SIZE	GetIRSize(const BASIC_BLOCK&);
+		static CCompileStats::IR_SIZE	GetIRSize(const BasicBlockList&);
+
+		//Must outlive every symbol and symbol reference (declared first, destroyed last)
+		CArena							m_symbolArena;
+		bool							m_symbolArenaEnabled = true;
+
 		bool							m_blockStarted = false;
+		bool							m_globalRegAllocEnabled = true;
+		bool							m_valueNumberingEnabled = true;
+		bool							m_strengthReductionEnabled = true;
+		bool							m_fpRegAllocEnabled = true;
+		bool							m_loopInvariantCodeMotionEnabled = true;
+		COMPILE_TIER					m_compileTier = COMPILE_TIER_OPTIMIZED;
+		uint32*							m_executionCounter = nullptr;
+		GlobalRegisterArray				m_globalRegisters;
+		std::unordered_set<const void*>	m_contextPureFunctions;
 
 		CArrayStack<SymbolPtr>			m_shadow;
 		IntStack						m_ifStack;
+		IntStack						m_loopStack;
 
 		unsigned int					m_nextTemporary = 1;
 		unsigned int					m_nextBlockId = 1;
@@ -349,9 +540,24 @@ namespace Jitter
 		BASIC_BLOCK*					m_currentBlock = nullptr;
 		BasicBlockList					m_basicBlocks;
 		CCodeGen*						m_codeGen = nullptr;
+		Framework::CStream*				m_stream = nullptr;
+		CCodeCache*						m_codeCache = nullptr;
+		CCodeGen::DynamicExitArray		m_dynamicExits;
 
 		unsigned int					m_nextLabelId = 1;
 		LabelMapType					m_labels;
+
+		uint32*							m_instrumentationCounters = nullptr;
+		unsigned int					m_instrumentationCounterCount = 0;
+		const uint32*					m_profile = nullptr;
+		unsigned int					m_profileSize = 0;
+		unsigned int					m_profileCounterCount = 0;
+
+		//Temporaries defined before a loop and used inside of it, they get a stack location shared by all blocks
+		LoopInvariantTemporaryMap		m_loopInvariantTemporaries;
+		unsigned int					m_loopInvariantStackSize = 0;
+
+		std::unique_ptr<CCompileStats>	m_compileStats;
 	};
 
 }
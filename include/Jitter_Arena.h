@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "Types.h"
+
+namespace Jitter
+{
+	//Bump allocator for objects that live for the duration of a single compilation.
+	//Individual deallocations are ignored, memory is reclaimed all at once by Reset,
+	//which keeps previously allocated chunks around for the next compilation.
+	class CArena
+	{
+	public:
+		enum
+		{
+			DEFAULT_CHUNK_SIZE = 0x10000,
+		};
+
+								CArena(size_t = DEFAULT_CHUNK_SIZE);
+								CArena(const CArena&) = delete;
+
+		CArena&					operator =(const CArena&) = delete;
+
+		void*					Allocate(size_t, size_t);
+		void					Reset();
+
+		size_t					GetChunkCount() const;
+		size_t					GetUsedSize() const;
+		size_t					GetAllocationCount() const;
+
+		//Counts heap allocations done on behalf of arena users (new chunks and CArenaAllocator's fallback
+		//to the default allocator) on the calling thread while a counter is set, used for measurements
+		static void				SetHeapAllocationCounter(size_t*);
+		static void				CountHeapAllocation();
+
+	private:
+		struct CHUNK
+		{
+			std::unique_ptr<uint8[]>	data;
+			size_t						size = 0;
+		};
+
+		typedef std::vector<CHUNK> ChunkArray;
+
+		ChunkArray				m_chunks;
+		size_t					m_chunkSize = 0;
+		size_t					m_currentChunk = 0;
+		size_t					m_currentOffset = 0;
+		size_t					m_usedSize = 0;
+		size_t					m_allocationCount = 0;
+
+		static thread_local size_t*	s_heapAllocationCounter;
+	};
+
+	//Standard allocator adapter over CArena, falls back to the default allocator when no arena is set
+	template <typename Type>
+	class CArenaAllocator
+	{
+	public:
+		typedef Type value_type;
+
+		CArenaAllocator(CArena* arena = nullptr) noexcept
+			: m_arena(arena)
+		{
+
+		}
+
+		template <typename OtherType>
+		CArenaAllocator(const CArenaAllocator<OtherType>& src) noexcept
+			: m_arena(src.GetArena())
+		{
+
+		}
+
+		Type* allocate(size_t count)
+		{
+			if(!m_arena)
+			{
+				CArena::CountHeapAllocation();
+				return std::allocator<Type>().allocate(count);
+			}
+			return static_cast<Type*>(m_arena->Allocate(sizeof(Type) * count, alignof(Type)));
+		}
+
+		void deallocate(Type* ptr, size_t count)
+		{
+			if(!m_arena)
+			{
+				std::allocator<Type>().deallocate(ptr, count);
+			}
+		}
+
+		CArena* GetArena() const
+		{
+			return m_arena;
+		}
+
+		template <typename OtherType>
+		bool operator ==(const CArenaAllocator<OtherType>& rhs) const
+		{
+			return m_arena == rhs.GetArena();
+		}
+
+		template <typename OtherType>
+		bool operator !=(const CArenaAllocator<OtherType>& rhs) const
+		{
+			return m_arena != rhs.GetArena();
+		}
+
+	private:
+		CArena* m_arena = nullptr;
+	};
+}
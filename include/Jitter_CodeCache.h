@@ -0,0 +1,136 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include "Types.h"
+#include "Stream.h"
+#include "Jitter_Statement.h"
+#include "Jitter_CodeGen.h"
+
+namespace Jitter
+{
+	//Keeps the code generated for recently compiled statement lists. Entries are keyed by a canonical
+	//encoding of the statements reaching the code generator and of the code generator configuration,
+	//the least recently used entry is evicted when the cache is full. Can be shared by many jitters.
+	class CCodeCache
+	{
+	public:
+		enum
+		{
+			DEFAULT_MAX_ENTRY_COUNT = 0x1000,
+		};
+
+		typedef std::vector<uint8> KeyType;
+		typedef std::vector<uint8> CodeBuffer;
+		typedef CCodeGen::DynamicExitArray DynamicExitArray;
+
+		struct RELOCATION
+		{
+			uint32							offset = 0;
+			uint32							symbolIndex = 0;
+			CCodeGen::SYMBOL_REF_TYPE		type = CCodeGen::SYMBOL_REF_TYPE::NATIVE_POINTER;
+		};
+		typedef std::vector<RELOCATION> RelocationArray;
+
+		struct STATS
+		{
+			uint64		hitCount = 0;
+			uint64		missCount = 0;
+			uint64		evictionCount = 0;
+			size_t		entryCount = 0;
+			size_t		codeSize = 0;
+		};
+
+								CCodeCache(size_t = DEFAULT_MAX_ENTRY_COUNT);
+								CCodeCache(const CCodeCache&) = delete;
+		virtual					~CCodeCache() = default;
+
+		CCodeCache&				operator =(const CCodeCache&) = delete;
+
+		//External symbols are identified by their name in keys and saved entries, their address can change
+		//between runs. Symbols must be added before any compilation or load and can't change address after that.
+		unsigned int			AddExternalSymbol(const std::string&, uintptr_t);
+		bool					GetExternalSymbolIndexByValue(uintptr_t, uint32&) const;
+		//Number of operands referring to external symbols, all of them need a relocation for the code to be saved
+		unsigned int			GetExternalSymbolUseCount(const StatementList&) const;
+
+		//Copies the cached code in the buffer and marks the entry as most recently used
+		bool					Find(const KeyType&, CodeBuffer&);
+		bool					Find(const KeyType&, CodeBuffer&, DynamicExitArray&);
+		void					Insert(KeyType, CodeBuffer, DynamicExitArray = DynamicExitArray());
+		//Code only refers to external symbols through the relocations, entry will be saved
+		void					InsertRelocatable(KeyType, CodeBuffer, RelocationArray, DynamicExitArray = DynamicExitArray());
+		void					Clear();
+
+		//Only relocatable entries are saved. Loaded entries are relocated to the current address of the
+		//external symbols, entries referring to symbols that weren't added are dropped.
+		void					Save(Framework::CStream&) const;
+		unsigned int			Load(Framework::CStream&);
+
+		STATS					GetStats() const;
+
+		KeyType					MakeKey(const StatementList&, unsigned int, uint32) const;
+		static uint64			HashKey(const KeyType&);
+		static bool				IsRelocatable(CCodeGen::SYMBOL_REF_TYPE);
+
+	private:
+		enum
+		{
+			FILE_MAGIC = 0x4643434A,
+			FILE_VERSION = 4,
+		};
+
+		struct ENTRY
+		{
+			KeyType			key;
+			CodeBuffer		code;
+			RelocationArray	relocations;
+			DynamicExitArray	dynamicExits;
+			bool			relocatable = false;
+		};
+
+		struct EXTERNAL_SYMBOL
+		{
+			std::string		name;
+			uintptr_t		value = 0;
+		};
+
+		typedef std::list<ENTRY> EntryList;
+		typedef std::vector<EXTERNAL_SYMBOL> ExternalSymbolArray;
+		typedef std::unordered_map<uintptr_t, uint32> ExternalSymbolIndexMap;
+
+		struct KeyHasher
+		{
+			size_t operator()(const KeyType*) const;
+		};
+
+		struct KeyComparator
+		{
+			bool operator()(const KeyType*, const KeyType*) const;
+		};
+
+		//Keys point inside the entries, which don't move when the list is reordered
+		typedef std::unordered_map<const KeyType*, EntryList::iterator, KeyHasher, KeyComparator> EntryMap;
+
+		void					InsertEntry(ENTRY);
+		void					WriteSymbol(KeyType&, const SymbolRefPtr&) const;
+
+		static void				WriteValue(KeyType&, uint32);
+		static void				ApplyRelocation(CodeBuffer&, const RELOCATION&, uintptr_t);
+
+		static void				WriteBuffer(Framework::CStream&, const std::vector<uint8>&);
+		static void				ReadBuffer(Framework::CStream&, std::vector<uint8>&);
+		static uint32			ReadValue(Framework::CStream&);
+
+		mutable std::mutex		m_mutex;
+		size_t					m_maxEntryCount = DEFAULT_MAX_ENTRY_COUNT;
+		EntryList				m_entries;
+		EntryMap				m_entryMap;
+		ExternalSymbolArray		m_externalSymbols;
+		ExternalSymbolIndexMap	m_externalSymbolIndices;
+		STATS					m_stats;
+	};
+}
@@ -1,13 +1,17 @@
 #pragma once
 
 #include "Stream.h"
+#include "AssemblerStats.h"
 #include "Jitter_Statement.h"
 #include <map>
+#include <array>
+#include <vector>
 #include <functional>
 
 namespace Jitter
 {
 	class CObjectFile;
+	class CCompileStats;
 
 	class CCodeGen
 	{
@@ -20,20 +24,47 @@ namespace Jitter
 		};
 
 		typedef std::function<void (uintptr_t, uint32, SYMBOL_REF_TYPE)> ExternalSymbolReferencedHandler;
+		//Receives the offset of every OP_EXTERNJMP_DYN exit, those can be linked with CMemoryFunction::LinkExit
+		typedef std::function<void (uint32)> DynamicExitHandler;
+		typedef std::vector<uint32> DynamicExitArray;
 
 		virtual					~CCodeGen() {};
 
 		virtual void			SetStream(Framework::CStream*) = 0;
 		void					SetExternalSymbolReferencedHandler(const ExternalSymbolReferencedHandler&);
+		bool					HasExternalSymbolReferencedHandler() const;
+		void					SetDynamicExitHandler(const DynamicExitHandler&);
+		void					SetCompileStats(CCompileStats*);
+
+		//Instruction selection goes through dense per-operation tables unless disabled (used for comparisons)
+		void					SetMatcherTableEnabled(bool);
 
 		virtual void			GenerateCode(const StatementList&, unsigned int) = 0;
 		virtual unsigned int	GetAvailableRegisterCount() const = 0;
 		virtual unsigned int	GetAvailableMdRegisterCount() const = 0;
 		virtual bool			CanHold128BitsReturnValueInRegisters() const = 0;
+		//FP single symbols can be allocated to the lower lane of the MD registers
+		virtual bool			CanHoldFpSingleInMdRegisters() const = 0;
+		//Bit N is set if register N keeps its value across a function call made by OP_CALL
+		virtual uint32			GetCallPreservedRegisterMask() const = 0;
+		virtual uint32			GetCallPreservedMdRegisterMask() const = 0;
 		virtual void			RegisterExternalSymbols(CObjectFile*) const = 0;
 		virtual uint32			GetPointerSize() const = 0;
+		//Identifies the backend and every option changing the code it generates
+		virtual uint32			GetConfigurationKey() const = 0;
 
 	protected:
+		enum CONFIGURATION_BACKEND
+		{
+			CONFIGURATION_BACKEND_X86_32 = 1,
+			CONFIGURATION_BACKEND_X86_64,
+			CONFIGURATION_BACKEND_AARCH32,
+			CONFIGURATION_BACKEND_AARCH64,
+		};
+
+		//Backend goes in the upper byte, backend options in the lower bits
+		static uint32			MakeConfigurationKey(CONFIGURATION_BACKEND, uint32);
+
 		enum MATCHTYPE
 		{
 			MATCH_ANY,
@@ -70,11 +101,13 @@ namespace Jitter
 			MATCH_RELATIVE_FP_SINGLE,
 			MATCH_TEMPORARY_FP_SINGLE,
 			MATCH_MEMORY_FP_SINGLE,
+			MATCH_REGISTER_FP_SINGLE,
+			MATCH_VARIABLE_FP_SINGLE,
 
 			MATCH_RELATIVE_FP_INT32,
 		};
 
-		typedef std::function<void (const STATEMENT&)> CodeEmitterType;
+		typedef void (CCodeGen::*CodeEmitterType)(const STATEMENT&);
 
 		struct MATCHER
 		{
@@ -83,15 +116,54 @@ namespace Jitter
 			MATCHTYPE src1Type;
 			MATCHTYPE src2Type;
 			MATCHTYPE src3Type = MATCH_NIL;
-			CodeEmitterType emitter;
+			CodeEmitterType emitter = nullptr;
 		};
 
 		typedef std::multimap<OPERATION, MATCHER> MatcherMapType;
 
-		bool								SymbolMatches(MATCHTYPE, const SymbolRefPtr&);
+		void								InsertMatcher(const MATCHER&);
+		CodeEmitterType						FindEmitter(const STATEMENT&);
+
+		static bool							SymbolTypeMatches(MATCHTYPE, SYM_TYPE);
 		static uint32						GetRegisterUsage(const StatementList&);
 
+		//Returns the stats to hand to the assembler for this compilation, null if stats are disabled
+		CAssemblerStats*					BeginAssemblerStats();
+		void								EndAssemblerStats();
+		static CAssemblerStats::CATEGORY	GetStatementStatsCategory(const STATEMENT&);
+
 		MatcherMapType						m_matchers;
 		ExternalSymbolReferencedHandler		m_externalSymbolReferencedHandler;
+		DynamicExitHandler					m_dynamicExitHandler;
+		CCompileStats*						m_compileStats = nullptr;
+		CAssemblerStats						m_assemblerStats;
+
+	private:
+		enum
+		{
+			OPERAND_COUNT = 4,
+			//Operand class 0 is used for absent operands, others are SYM_TYPE + 1
+			OPERAND_CLASS_NIL = 0,
+			OPERAND_CLASS_COUNT = SYM_TYPE_MAX + 1,
+		};
+
+		typedef std::array<uint8, OPERAND_CLASS_COUNT> OperandClassMap;
+
+		//Dense dispatch table for one operation: every operand class is mapped to the index
+		//of a group of classes that all matchers of this operation treat the same way.
+		struct MATCHER_TABLE
+		{
+			std::array<OperandClassMap, OPERAND_COUNT>	classGroups;
+			std::array<uint32, OPERAND_COUNT>			strides;
+			std::vector<CodeEmitterType>				emitters;
+		};
+
+		void								BuildMatcherTables();
+		CodeEmitterType						FindEmitterLinear(const STATEMENT&) const;
+		static uint8						GetOperandClass(const SymbolRefPtr&);
+		static bool							OperandClassMatches(MATCHTYPE, uint8);
+
+		std::vector<MATCHER_TABLE>			m_matcherTables;
+		bool								m_matcherTableEnabled = true;
 	};
 }
@@ -28,7 +28,11 @@ namespace Jitter
 		unsigned int							GetAvailableRegisterCount() const override;
 		unsigned int							GetAvailableMdRegisterCount() const override;
 		bool									CanHold128BitsReturnValueInRegisters() const override;
+		bool									CanHoldFpSingleInMdRegisters() const override;
+		uint32									GetCallPreservedRegisterMask() const override;
+		uint32									GetCallPreservedMdRegisterMask() const override;
 		uint32									GetPointerSize() const override;
+		uint32									GetConfigurationKey() const override;
 
 	private:
 		typedef std::map<uint32, CAArch32Assembler::LABEL> LabelMapType;
@@ -38,6 +42,7 @@ namespace Jitter
 		{
 			bool prepared = false;
 			unsigned int index = 0;
+			uint32 spillOffset = 0;
 		};
 
 		class CTempRegisterContext
@@ -71,6 +76,11 @@ namespace Jitter
 			MAX_REGISTERS = 6,
 		};
 
+		enum
+		{
+			MAX_MDREGISTERS = 8,
+		};
+
 		struct CONSTMATCHER
 		{
 			OPERATION							op;
@@ -84,6 +94,7 @@ namespace Jitter
 		void									InsertMatchers(const CONSTMATCHER*);
 
 		static uint16							GetSavedRegisterList(uint32);
+		static uint32							GetMaxParamSpillSize(const StatementList&);
 
 		void									Emit_Prolog();
 		void									Emit_Epilog();
@@ -126,6 +137,13 @@ namespace Jitter
 
 		void									LoadTemporary256ElementAddressInRegister(CAArch32Assembler::REGISTER, CSymbol*, uint32);
 
+		void									LoadMemory128InRegister(CAArch32Assembler::QUAD_REGISTER, CSymbol*);
+		void									StoreRegisterInMemory128(CSymbol*, CAArch32Assembler::QUAD_REGISTER);
+
+		CAArch32Assembler::QUAD_REGISTER		PrepareSymbolRegisterDefMd(CSymbol*, CAArch32Assembler::QUAD_REGISTER);
+		CAArch32Assembler::QUAD_REGISTER		PrepareSymbolRegisterUseMd(CSymbol*, CAArch32Assembler::QUAD_REGISTER);
+		void									CommitSymbolRegisterMd(CSymbol*, CAArch32Assembler::QUAD_REGISTER);
+
 		CAArch32Assembler::REGISTER				PrepareSymbolRegisterDef(CSymbol*, CAArch32Assembler::REGISTER);
 		CAArch32Assembler::REGISTER				PrepareSymbolRegisterUse(CSymbol*, CAArch32Assembler::REGISTER);
 		void									CommitSymbolRegister(CSymbol*, CAArch32Assembler::REGISTER);
@@ -501,6 +519,21 @@ namespace Jitter
 			static OpRegType OpReg() { return &CAArch32Assembler::Vcvt_S32_F32; }
 		};
 
+		struct MDOP_ZIPB : public MDOP_BASE2
+		{
+			static OpRegType OpReg() { return &CAArch32Assembler::Vzip_I8; }
+		};
+
+		struct MDOP_ZIPH : public MDOP_BASE2
+		{
+			static OpRegType OpReg() { return &CAArch32Assembler::Vzip_I16; }
+		};
+
+		struct MDOP_ZIPW : public MDOP_BASE2
+		{
+			static OpRegType OpReg() { return &CAArch32Assembler::Vzip_I32; }
+		};
+
 		//ALUOP
 		template <typename> void				Emit_Alu_GenericAnyAny(const STATEMENT&);
 		template <typename> void				Emit_Alu_GenericAnyCst(const STATEMENT&);
@@ -515,6 +548,7 @@ namespace Jitter
 		void									Emit_Param_Cst(const STATEMENT&);
 		void									Emit_Param_Mem64(const STATEMENT&);
 		void									Emit_Param_Cst64(const STATEMENT&);
+		void									Emit_Param_Reg128(const STATEMENT&);
 		void									Emit_Param_Mem128(const STATEMENT&);
 
 		//PARAM_RET
@@ -532,6 +566,12 @@ namespace Jitter
 		void									Emit_ExternJmp(const STATEMENT&);
 		void									Emit_ExternJmpDynamic(const STATEMENT&);
 
+		//LOOKUP
+		void									Emit_Lookup(const STATEMENT&);
+
+		//INCCOUNTER
+		void									Emit_IncCounter(const STATEMENT&);
+
 		//MUL/MULS
 		template<bool> void						Emit_MulTmp64AnyAny(const STATEMENT&);
 
@@ -676,46 +716,49 @@ namespace Jitter
 		void									Emit_Fp_LdCst_TmpCst(const STATEMENT&);
 		
 		//MDOP
-		template <typename> void				Emit_Md_MemMem(const STATEMENT&);
-		template <typename> void				Emit_Md_MemMemMem(const STATEMENT&);
-		template <typename> void				Emit_Md_Shift_MemMemCst(const STATEMENT&);
+		template <typename> void				Emit_Md_VarVar(const STATEMENT&);
+		template <typename> void				Emit_Md_VarVarVar(const STATEMENT&);
+		template <typename> void				Emit_Md_Shift_VarVarCst(const STATEMENT&);
 
+		void									Emit_Md_Mov_RegReg(const STATEMENT&);
+		void									Emit_Md_Mov_RegMem(const STATEMENT&);
+		void									Emit_Md_Mov_MemReg(const STATEMENT&);
 		void									Emit_Md_Mov_MemMem(const STATEMENT&);
-		void									Emit_Md_DivS_MemMemMem(const STATEMENT&);
-		void									Emit_Md_CmpLtS_MemMemMem(const STATEMENT&);
+		void									Emit_Md_DivS_VarVarVar(const STATEMENT&);
+		void									Emit_Md_CmpLtS_VarVarVar(const STATEMENT&);
 
-		void									Emit_Md_Srl256_MemMemVar(const STATEMENT&);
-		void									Emit_Md_Srl256_MemMemCst(const STATEMENT&);
+		void									Emit_Md_Srl256_VarMemVar(const STATEMENT&);
+		void									Emit_Md_Srl256_VarMemCst(const STATEMENT&);
 
-		void									Emit_Md_LoadFromRef_MemVar(const STATEMENT&);
-		void									Emit_Md_StoreAtRef_VarMem(const STATEMENT&);
+		void									Emit_Md_LoadFromRef_VarVar(const STATEMENT&);
+		void									Emit_Md_StoreAtRef_VarVar(const STATEMENT&);
 
-		void									Emit_Md_MovMasked_MemMemMem(const STATEMENT&);
-		void									Emit_Md_Expand_MemReg(const STATEMENT&);
-		void									Emit_Md_Expand_MemMem(const STATEMENT&);
-		void									Emit_Md_Expand_MemCst(const STATEMENT&);
+		void									Emit_Md_MovMasked_VarVarVar(const STATEMENT&);
+		void									Emit_Md_Expand_VarReg(const STATEMENT&);
+		void									Emit_Md_Expand_VarMem(const STATEMENT&);
+		void									Emit_Md_Expand_VarCst(const STATEMENT&);
 
 		void									Emit_Md_MakeSz_VarVar(const STATEMENT&);
 
-		void									Emit_Md_PackHB_MemMemMem(const STATEMENT&);
-		void									Emit_Md_PackWH_MemMemMem(const STATEMENT&);
+		void									Emit_Md_PackHB_VarVarVar(const STATEMENT&);
+		void									Emit_Md_PackWH_VarVarVar(const STATEMENT&);
 
-		template <uint32> void					Emit_Md_UnpackBH_MemMemMem(const STATEMENT&);
-		template <uint32> void					Emit_Md_UnpackHW_MemMemMem(const STATEMENT&);
-		template <uint32> void					Emit_Md_UnpackWD_MemMemMem(const STATEMENT&);
+		template <typename, bool> void			Emit_Md_Unpack_VarVarVar(const STATEMENT&);
 
-		void									Emit_MergeTo256_MemMemMem(const STATEMENT&);
+		void									Emit_MergeTo256_MemVarVar(const STATEMENT&);
 
-		static CONSTMATCHER						g_constMatchers[];
-		static CONSTMATCHER						g_64ConstMatchers[];
-		static CONSTMATCHER						g_fpuConstMatchers[];
-		static CONSTMATCHER						g_mdConstMatchers[];
-		static CAArch32Assembler::REGISTER		g_registers[MAX_REGISTERS];
-		static CAArch32Assembler::REGISTER		g_paramRegs[MAX_PARAM_REGS];
-		static CAArch32Assembler::REGISTER		g_baseRegister;
-		static CAArch32Assembler::REGISTER		g_callAddressRegister;
-		static CAArch32Assembler::REGISTER		g_tempParamRegister0;
-		static CAArch32Assembler::REGISTER		g_tempParamRegister1;
+		static const CONSTMATCHER						g_constMatchers[];
+		static const CONSTMATCHER						g_64ConstMatchers[];
+		static const CONSTMATCHER						g_fpuConstMatchers[];
+		static const CONSTMATCHER						g_mdConstMatchers[];
+		static const CAArch32Assembler::REGISTER		g_registers[MAX_REGISTERS];
+		static const CAArch32Assembler::QUAD_REGISTER	g_registersMd[MAX_MDREGISTERS];
+		static const CAArch32Assembler::REGISTER		g_paramRegs[MAX_PARAM_REGS];
+		static const CAArch32Assembler::REGISTER		g_baseRegister;
+		static const CAArch32Assembler::REGISTER		g_callAddressRegister;
+		static const CAArch32Assembler::REGISTER		g_tempParamRegister0;
+		static const CAArch32Assembler::REGISTER		g_tempParamRegister1;
+		static const CAArch32Assembler::REGISTER		g_mdAddressRegister;
 
 		Framework::CStream*						m_stream = nullptr;
 		CAArch32Assembler						m_assembler;
@@ -723,6 +766,7 @@ namespace Jitter
 		LabelMapType							m_labels;
 		ParamStack								m_params;
 		uint32									m_stackSize = 0;
+		uint32									m_paramSpillBase = 0;
 		uint16									m_registerSave = 0;
 		uint32									m_stackLevel = 0;
 		bool									m_hasIntegerDiv = false;
@@ -20,7 +20,11 @@ namespace Jitter
 		unsigned int    GetAvailableRegisterCount() const override;
 		unsigned int    GetAvailableMdRegisterCount() const override;
 		bool            CanHold128BitsReturnValueInRegisters() const override;
+		bool            CanHoldFpSingleInMdRegisters() const override;
+		uint32          GetCallPreservedRegisterMask() const override;
+		uint32          GetCallPreservedMdRegisterMask() const override;
 		uint32          GetPointerSize() const override;
+		uint32          GetConfigurationKey() const override;
 
 	private:
 		typedef std::map<uint32, CAArch64Assembler::LABEL> LabelMapType;
@@ -134,6 +138,10 @@ namespace Jitter
 		CAArch64Assembler::REGISTERMD    PrepareSymbolRegisterDefMd(CSymbol*, CAArch64Assembler::REGISTERMD);
 		CAArch64Assembler::REGISTERMD    PrepareSymbolRegisterUseMd(CSymbol*, CAArch64Assembler::REGISTERMD);
 		void                             CommitSymbolRegisterMd(CSymbol*, CAArch64Assembler::REGISTERMD);
+
+		CAArch64Assembler::REGISTERMD    PrepareSymbolRegisterDefFpSingle(CSymbol*, CAArch64Assembler::REGISTERMD);
+		CAArch64Assembler::REGISTERMD    PrepareSymbolRegisterUseFpSingle(CSymbol*, CAArch64Assembler::REGISTERMD);
+		void                             CommitSymbolRegisterFpSingle(CSymbol*, CAArch64Assembler::REGISTERMD);
 		
 		CAArch64Assembler::REGISTER32    PrepareParam(PARAM_STATE&);
 		CAArch64Assembler::REGISTER64    PrepareParam64(PARAM_STATE&);
@@ -654,6 +662,9 @@ namespace Jitter
 		void    Emit_ExternJmp(const STATEMENT&);
 		void    Emit_ExternJmpDynamic(const STATEMENT&);
 
+		void    Emit_Lookup(const STATEMENT&);
+		void    Emit_IncCounter(const STATEMENT&);
+
 		void    Emit_Jmp(const STATEMENT&);
 		
 		void    Emit_CondJmp(const STATEMENT&);
@@ -700,15 +711,19 @@ namespace Jitter
 		template <typename> void    Emit_Shift64_MemMemCst(const STATEMENT&);
 		
 		//FPU
-		template <typename> void    Emit_Fpu_MemMem(const STATEMENT&);
-		template <typename> void    Emit_Fpu_MemMemMem(const STATEMENT&);
-
-		void    Emit_Fp_Cmp_AnyMemMem(const STATEMENT&);
-		void    Emit_Fp_Rcpl_MemMem(const STATEMENT&);
-		void    Emit_Fp_Rsqrt_MemMem(const STATEMENT&);
-		void    Emit_Fp_Mov_MemSRelI32(const STATEMENT&);
-		void    Emit_Fp_ToIntTrunc_MemMem(const STATEMENT&);
+		template <typename> void    Emit_Fpu_VarVar(const STATEMENT&);
+		template <typename> void    Emit_Fpu_VarVarVar(const STATEMENT&);
+
+		void    Emit_Fp_Cmp_AnyVarVar(const STATEMENT&);
+		void    Emit_Fp_Rcpl_VarVar(const STATEMENT&);
+		void    Emit_Fp_Rsqrt_VarVar(const STATEMENT&);
+		void    Emit_Fp_Mov_RegReg(const STATEMENT&);
+		void    Emit_Fp_Mov_RegMem(const STATEMENT&);
+		void    Emit_Fp_Mov_MemReg(const STATEMENT&);
+		void    Emit_Fp_Mov_VarSRelI32(const STATEMENT&);
+		void    Emit_Fp_ToIntTrunc_VarVar(const STATEMENT&);
 		void    Emit_Fp_LdCst_TmpCst(const STATEMENT&);
+		void    Emit_Fp_LdCst_RegCst(const STATEMENT&);
 
 		//MD
 		template <typename> void    Emit_Md_VarVar(const STATEMENT&);
@@ -740,19 +755,19 @@ namespace Jitter
 		void    Emit_Md_Srl256_VarMemVar(const STATEMENT&);
 		void    Emit_Md_Srl256_VarMemCst(const STATEMENT&);
 		
-		static CONSTMATCHER    g_constMatchers[];
-		static CONSTMATCHER    g_64ConstMatchers[];
-		static CONSTMATCHER    g_fpuConstMatchers[];
-		static CONSTMATCHER    g_mdConstMatchers[];
-		
-		static CAArch64Assembler::REGISTER32    g_registers[MAX_REGISTERS];
-		static CAArch64Assembler::REGISTERMD    g_registersMd[MAX_MDREGISTERS];
-		static CAArch64Assembler::REGISTER32    g_tempRegisters[MAX_TEMP_REGS];
-		static CAArch64Assembler::REGISTER64    g_tempRegisters64[MAX_TEMP_REGS];
-		static CAArch64Assembler::REGISTERMD    g_tempRegistersMd[MAX_TEMP_MD_REGS];
-		static CAArch64Assembler::REGISTER32    g_paramRegisters[MAX_PARAM_REGS];
-		static CAArch64Assembler::REGISTER64    g_paramRegisters64[MAX_PARAM_REGS];
-		static CAArch64Assembler::REGISTER64    g_baseRegister;
+		static const CONSTMATCHER    g_constMatchers[];
+		static const CONSTMATCHER    g_64ConstMatchers[];
+		static const CONSTMATCHER    g_fpuConstMatchers[];
+		static const CONSTMATCHER    g_mdConstMatchers[];
+		
+		static const CAArch64Assembler::REGISTER32    g_registers[MAX_REGISTERS];
+		static const CAArch64Assembler::REGISTERMD    g_registersMd[MAX_MDREGISTERS];
+		static const CAArch64Assembler::REGISTER32    g_tempRegisters[MAX_TEMP_REGS];
+		static const CAArch64Assembler::REGISTER64    g_tempRegisters64[MAX_TEMP_REGS];
+		static const CAArch64Assembler::REGISTERMD    g_tempRegistersMd[MAX_TEMP_MD_REGS];
+		static const CAArch64Assembler::REGISTER32    g_paramRegisters[MAX_PARAM_REGS];
+		static const CAArch64Assembler::REGISTER64    g_paramRegisters64[MAX_PARAM_REGS];
+		static const CAArch64Assembler::REGISTER64    g_baseRegister;
 
 		Framework::CStream*    m_stream = nullptr;
 		CAArch64Assembler      m_assembler;
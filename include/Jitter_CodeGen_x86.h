@@ -20,6 +20,18 @@ namespace Jitter
 		typedef std::map<uint32, CX86Assembler::LABEL> LabelMapType;
 		typedef std::vector<std::pair<uintptr_t, CX86Assembler::LABEL>> SymbolReferenceLabelArray;
 
+		//Patchable region emitted by Emit_ExternJmpDynamic, followed by alignment - 1 bytes of slack.
+		//Once jumps are relaxed, the region is moved so that its start is at alignmentOffset modulo alignment.
+		struct DYNAMIC_EXIT
+		{
+			CX86Assembler::LABEL	label = 0;
+			CX86Assembler::LABEL	endLabel = 0;
+			uint32					alignment = 0;
+			uint32					alignmentOffset = 0;
+			uint32					shift = 0;
+		};
+		typedef std::vector<DYNAMIC_EXIT> DynamicExitArray;
+
 		//ALUOP ----------------------------------------------------------
 		struct ALUOP_BASE
 		{
@@ -62,24 +74,28 @@ namespace Jitter
 		{
 			typedef void (CX86Assembler::*OpCstType)(const CX86Assembler::CAddress&, uint8);
 			typedef void (CX86Assembler::*OpVarType)(const CX86Assembler::CAddress&);
+			typedef void (CX86Assembler::*OpBmi2Type)(CX86Assembler::REGISTER, const CX86Assembler::CAddress&, CX86Assembler::REGISTER);
 		};
 
 		struct SHIFTOP_SRL : public SHIFTOP_BASE
 		{
 			static OpCstType OpCst() { return &CX86Assembler::ShrEd; }
 			static OpVarType OpVar() { return &CX86Assembler::ShrEd; }
+			static OpBmi2Type OpBmi2() { return &CX86Assembler::ShrxEd; }
 		};
 
 		struct SHIFTOP_SRA : public SHIFTOP_BASE
 		{
 			static OpCstType OpCst() { return &CX86Assembler::SarEd; }
 			static OpVarType OpVar() { return &CX86Assembler::SarEd; }
+			static OpBmi2Type OpBmi2() { return &CX86Assembler::SarxEd; }
 		};
 
 		struct SHIFTOP_SLL : public SHIFTOP_BASE
 		{
 			static OpCstType OpCst() { return &CX86Assembler::ShlEd; }
 			static OpVarType OpVar() { return &CX86Assembler::ShlEd; }
+			static OpBmi2Type OpBmi2() { return &CX86Assembler::ShlxEd; }
 		};
 
 		//FPUOP -----------------------------------------------------------
@@ -458,6 +474,10 @@ namespace Jitter
 		virtual void				Emit_Prolog(const StatementList&, unsigned int) = 0;
 		virtual void				Emit_Epilog() = 0;
 
+		void						MarkDynamicExitEnd(DYNAMIC_EXIT&);
+		void						AlignDynamicExits();
+		uint32						GetDynamicExitShift(uint32) const;
+
 		virtual CX86Assembler::CAddress MakeConstant128Address(const LITERAL128&) = 0;
 
 		CX86Assembler::LABEL		GetLabel(uint32);
@@ -485,6 +505,7 @@ namespace Jitter
 		CX86Assembler::CAddress		MakeRelativeFpSingleSymbolAddress(CSymbol*);
 		CX86Assembler::CAddress		MakeTemporaryFpSingleSymbolAddress(CSymbol*);
 		CX86Assembler::CAddress		MakeMemoryFpSingleSymbolAddress(CSymbol*);
+		CX86Assembler::CAddress		MakeVariableFpSingleSymbolAddress(CSymbol*);
 
 		CX86Assembler::CAddress		MakeRelative128SymbolElementAddress(CSymbol*, unsigned int);
 		CX86Assembler::CAddress		MakeTemporary128SymbolElementAddress(CSymbol*, unsigned int);
@@ -541,6 +562,8 @@ namespace Jitter
 		template <typename> void	Emit_Shift_MemMemCst(const STATEMENT&);
 		template <typename> void	Emit_Shift_MemCstReg(const STATEMENT&);
 		template <typename> void	Emit_Shift_MemCstMem(const STATEMENT&);
+		template <typename> void	Emit_Shift_Bmi2_VarVarVar(const STATEMENT&);
+		template <typename> void	Emit_Shift_Bmi2_VarCstVar(const STATEMENT&);
 
 		//NOT
 		void						Emit_Not_RegReg(const STATEMENT&);
@@ -552,6 +575,7 @@ namespace Jitter
 		void						Emit_Lzc(CX86Assembler::REGISTER, const CX86Assembler::CAddress&);
 		void						Emit_Lzc_RegVar(const STATEMENT&);
 		void						Emit_Lzc_MemVar(const STATEMENT&);
+		void						Emit_Lzc_Lzcnt_VarVar(const STATEMENT&);
 
 		//CMP
 		void						Cmp_GetFlag(const CX86Assembler::CAddress&, CONDITION);
@@ -599,14 +623,16 @@ namespace Jitter
 		void						Emit_MergeTo64_Mem64MemMem(const STATEMENT&);
 		void						Emit_MergeTo64_Mem64CstReg(const STATEMENT&);
 		void						Emit_MergeTo64_Mem64CstMem(const STATEMENT&);
+		void						Emit_MergeTo64_Mem64RegCst(const STATEMENT&);
+		void						Emit_MergeTo64_Mem64MemCst(const STATEMENT&);
 
 		//EXTLOW64
-		void						Emit_ExtLow64RegTmp64(const STATEMENT&);
-		void						Emit_ExtLow64MemTmp64(const STATEMENT&);
+		void						Emit_ExtLow64RegMem64(const STATEMENT&);
+		void						Emit_ExtLow64MemMem64(const STATEMENT&);
 
 		//EXTHIGH64
-		void						Emit_ExtHigh64RegTmp64(const STATEMENT&);
-		void						Emit_ExtHigh64MemTmp64(const STATEMENT&);
+		void						Emit_ExtHigh64RegMem64(const STATEMENT&);
+		void						Emit_ExtHigh64MemMem64(const STATEMENT&);
 
 		//LOADFROMREF
 		void						Emit_LoadFromRef_VarVar(const STATEMENT&);
@@ -643,35 +669,37 @@ namespace Jitter
 		void						Emit_Store16AtRef_VarCst(const STATEMENT&);
 
 		//FPUOP
-		template <typename> void	Emit_Fpu_MemMem(const STATEMENT&);
-		template <typename> void	Emit_Fpu_MemMemMem(const STATEMENT&);
+		template <typename> void	Emit_Fpu_VarVar(const STATEMENT&);
+		template <typename> void	Emit_Fpu_VarVarVar(const STATEMENT&);
 
 		//FPCMP
 		CX86Assembler::SSE_CMP_TYPE	GetSseConditionCode(Jitter::CONDITION);
 
-		void						Emit_Fp_Cmp_VarMemMem(const STATEMENT&);
-		void						Emit_Fp_Cmp_VarMemCst(const STATEMENT&);
+		void						Emit_Fp_Cmp_VarVarVar(const STATEMENT&);
+		void						Emit_Fp_Cmp_VarVarCst(const STATEMENT&);
 
 		//FPABS
-		void						Emit_Fp_Abs_MemMem(const STATEMENT&);
+		void						Emit_Fp_Abs_VarVar(const STATEMENT&);
 
 		//FPNEG
-		void						Emit_Fp_Neg_MemMem(const STATEMENT&);
+		void						Emit_Fp_Neg_VarVar(const STATEMENT&);
 
 		//FPRSQRT
-		void						Emit_Fp_Rsqrt_MemMem(const STATEMENT&);
+		void						Emit_Fp_Rsqrt_VarVar(const STATEMENT&);
 
 		//FPRCPL
-		void						Emit_Fp_Rcpl_MemMem(const STATEMENT&);
+		void						Emit_Fp_Rcpl_VarVar(const STATEMENT&);
 
 		//FP_MOV
-		void						Emit_Fp_Mov_RelSRelI32(const STATEMENT&);
+		void						Emit_Fp_Mov_RegVar(const STATEMENT&);
+		void						Emit_Fp_Mov_MemReg(const STATEMENT&);
+		void						Emit_Fp_Mov_VarRelI32(const STATEMENT&);
 
 		//FP_TOINT_TRUNC
-		void						Emit_Fp_ToIntTrunc_RelRel(const STATEMENT&);
+		void						Emit_Fp_ToIntTrunc_VarVar(const STATEMENT&);
 
 		//FP_LDCST
-		void						Emit_Fp_LdCst_MemCst(const STATEMENT&);
+		void						Emit_Fp_LdCst_VarCst(const STATEMENT&);
 
 		//MDOP
 		template <typename> void	Emit_Md_RegVar(const STATEMENT&);
@@ -720,14 +748,16 @@ namespace Jitter
 		void						Emit_Md_MakeSz_Ssse3_VarVar(const STATEMENT&);
 
 		//FPUOP AVX
-		template <typename> void	Emit_Fpu_Avx_MemMem(const STATEMENT&);
-		template <typename> void	Emit_Fpu_Avx_MemMemMem(const STATEMENT&);
+		template <typename> void	Emit_Fpu_Avx_VarVar(const STATEMENT&);
+		template <typename> void	Emit_Fpu_Avx_VarVarVar(const STATEMENT&);
 
-		void						Emit_Fp_Avx_Cmp_VarMemMem(const STATEMENT&);
-		void						Emit_Fp_Avx_Rsqrt_MemMem(const STATEMENT&);
-		void						Emit_Fp_Avx_Rcpl_MemMem(const STATEMENT&);
-		void						Emit_Fp_Avx_Mov_RelSRelI32(const STATEMENT&);
-		void						Emit_Fp_Avx_ToIntTrunc_RelRel(const STATEMENT&);
+		void						Emit_Fp_Avx_Cmp_VarVarVar(const STATEMENT&);
+		void						Emit_Fp_Avx_Rsqrt_VarVar(const STATEMENT&);
+		void						Emit_Fp_Avx_Rcpl_VarVar(const STATEMENT&);
+		void						Emit_Fp_Avx_Mov_RegVar(const STATEMENT&);
+		void						Emit_Fp_Avx_Mov_MemReg(const STATEMENT&);
+		void						Emit_Fp_Avx_Mov_VarRelI32(const STATEMENT&);
+		void						Emit_Fp_Avx_ToIntTrunc_VarVar(const STATEMENT&);
 
 		//MDOP AVX
 		template <typename> void	Emit_Md_Avx_VarVar(const STATEMENT&);
@@ -754,13 +784,14 @@ namespace Jitter
 
 		void						Emit_Md_Avx_Expand_VarVar(const STATEMENT&);
 		void						Emit_Md_Avx_Expand_VarCst(const STATEMENT&);
+		void						Emit_Md_Avx2_Expand_VarMem(const STATEMENT&);
 
 		void						Emit_Avx_MergeTo256_MemVarVar(const STATEMENT&);
 
 		void						Emit_Md_Avx_Srl256_VarMemVar(const STATEMENT&);
 		void						Emit_Md_Avx_Srl256_VarMemCst(const STATEMENT&);
 
-		static CX86Assembler::REGISTER g_baseRegister;
+		static const CX86Assembler::REGISTER g_baseRegister;
 
 		CX86Assembler::REGISTER		PrepareSymbolRegisterDef(CSymbol*, CX86Assembler::REGISTER);
 		CX86Assembler::REGISTER		PrepareSymbolRegisterUse(CSymbol*, CX86Assembler::REGISTER);
@@ -771,21 +802,37 @@ namespace Jitter
 		CX86Assembler::XMMREGISTER	PrepareSymbolRegisterUseMdAvx(CSymbol*, CX86Assembler::XMMREGISTER);
 		void						CommitSymbolRegisterMdAvx(CSymbol*, CX86Assembler::XMMREGISTER);
 
+		CX86Assembler::XMMREGISTER	PrepareSymbolRegisterDefFpSingle(CSymbol*, CX86Assembler::XMMREGISTER);
+		CX86Assembler::XMMREGISTER	PrepareSymbolRegisterUseFpSingleAvx(CSymbol*, CX86Assembler::XMMREGISTER);
+		void						LoadFpSingleSymbolInRegister(CX86Assembler::XMMREGISTER, CSymbol*);
+		void						CommitSymbolRegisterFpSingle(CSymbol*, CX86Assembler::XMMREGISTER);
+		void						CommitSymbolRegisterFpSingleAvx(CSymbol*, CX86Assembler::XMMREGISTER);
+		void						LoadFpSingleSymbolInIntRegister(CX86Assembler::REGISTER, CSymbol*);
+		void						StoreIntRegisterInFpSingleSymbol(CSymbol*, CX86Assembler::REGISTER);
+
 		virtual CX86Assembler::REGISTER PrepareRefSymbolRegisterUse(CSymbol*, CX86Assembler::REGISTER) = 0;
 
 		static const LITERAL128		g_makeSzShufflePattern;
 
 		CX86Assembler				m_assembler;
-		CX86Assembler::REGISTER*	m_registers = nullptr;
-		CX86Assembler::XMMREGISTER*	m_mdRegisters = nullptr;
+		const CX86Assembler::REGISTER*	m_registers = nullptr;
+		const CX86Assembler::XMMREGISTER*	m_mdRegisters = nullptr;
 		LabelMapType				m_labels;
 		SymbolReferenceLabelArray	m_symbolReferenceLabels;
+		DynamicExitArray			m_dynamicExits;
+		Framework::CStream*			m_stream = nullptr;
 		uint32						m_stackLevel = 0;
 		uint32						m_registerUsage = 0;
 		
+		//Instruction set extensions used by the code generator, as configuration key options
+		uint32						GetInstructionSetOptions() const;
+
 		bool						m_hasSsse3 = false;
 		bool						m_hasSse41 = false;
 		bool						m_hasAvx = false;
+		bool						m_hasAvx2 = false;
+		bool						m_hasBmi2 = false;
+		bool						m_hasLzcnt = false;
 
 	private:
 		typedef void (CCodeGen_x86::*ConstCodeEmitterType)(const STATEMENT&);
@@ -800,25 +847,42 @@ namespace Jitter
 			ConstCodeEmitterType emitter;
 		};
 
+		struct CPU_FEATURES
+		{
+			bool hasSsse3 = false;
+			bool hasSse41 = false;
+			bool hasAvx = false;
+			bool hasAvx2 = false;
+			bool hasBmi2 = false;
+			bool hasLzcnt = false;
+		};
+
 		void						InsertMatchers(const CONSTMATCHER*);
 		void						SetGenerationFlags();
+
+		//Probed once per process, safe to call from multiple compiler threads
+		static const CPU_FEATURES&	GetCpuFeatures();
+		static CPU_FEATURES			ProbeCpuFeatures();
 		
-		static CONSTMATCHER			g_constMatchers[];
-		static CONSTMATCHER			g_fpuConstMatchers[];
-		static CONSTMATCHER			g_fpuSseConstMatchers[];
-		static CONSTMATCHER			g_fpuAvxConstMatchers[];
+		static const CONSTMATCHER			g_constMatchers[];
+		static const CONSTMATCHER			g_shiftBmi2ConstMatchers[];
+		static const CONSTMATCHER			g_lzcLzcntConstMatchers[];
+		static const CONSTMATCHER			g_fpuConstMatchers[];
+		static const CONSTMATCHER			g_fpuSseConstMatchers[];
+		static const CONSTMATCHER			g_fpuAvxConstMatchers[];
 
-		static CONSTMATCHER			g_mdConstMatchers[];
+		static const CONSTMATCHER			g_mdConstMatchers[];
 
-		static CONSTMATCHER			g_mdMinMaxWConstMatchers[];
-		static CONSTMATCHER			g_mdMinMaxWSse41ConstMatchers[];
+		static const CONSTMATCHER			g_mdMinMaxWConstMatchers[];
+		static const CONSTMATCHER			g_mdMinMaxWSse41ConstMatchers[];
 
-		static CONSTMATCHER			g_mdMovMaskedConstMatchers[];
-		static CONSTMATCHER			g_mdMovMaskedSse41ConstMatchers[];
+		static const CONSTMATCHER			g_mdMovMaskedConstMatchers[];
+		static const CONSTMATCHER			g_mdMovMaskedSse41ConstMatchers[];
 
-		static CONSTMATCHER			g_mdFpFlagConstMatchers[];
-		static CONSTMATCHER			g_mdFpFlagSsse3ConstMatchers[];
+		static const CONSTMATCHER			g_mdFpFlagConstMatchers[];
+		static const CONSTMATCHER			g_mdFpFlagSsse3ConstMatchers[];
 
-		static CONSTMATCHER			g_mdAvxConstMatchers[];
+		static const CONSTMATCHER			g_mdAvxConstMatchers[];
+		static const CONSTMATCHER			g_mdAvx2ConstMatchers[];
 	};
 }
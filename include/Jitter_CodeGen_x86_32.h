@@ -16,7 +16,11 @@ namespace Jitter
 		unsigned int						GetAvailableRegisterCount() const override;
 		unsigned int						GetAvailableMdRegisterCount() const override;
 		bool								CanHold128BitsReturnValueInRegisters() const override;
+		bool								CanHoldFpSingleInMdRegisters() const override;
+		uint32								GetCallPreservedRegisterMask() const override;
+		uint32								GetCallPreservedMdRegisterMask() const override;
 		uint32								GetPointerSize() const override;
+		uint32								GetConfigurationKey() const override;
 		
 	protected:
 		enum SHIFTRIGHT_TYPE
@@ -53,6 +57,13 @@ namespace Jitter
 
 		//EXTERNJMP
 		void								Emit_ExternJmp(const STATEMENT&);
+		void								Emit_ExternJmpDynamic(const STATEMENT&);
+
+		//LOOKUP
+		void								Emit_Lookup(const STATEMENT&);
+
+		//INCCOUNTER
+		void								Emit_IncCounter(const STATEMENT&);
 
 		//MOV
 		void								Emit_Mov_Mem64Mem64(const STATEMENT&);
@@ -160,9 +171,9 @@ namespace Jitter
 		CX86Assembler::REGISTER				PrepareRefSymbolRegisterUse(CSymbol*, CX86Assembler::REGISTER) override;
 		void								CommitRefSymbolRegister(CSymbol*, CX86Assembler::REGISTER);
 
-		static CONSTMATCHER					g_constMatchers[];
-		static CX86Assembler::REGISTER		g_registers[MAX_REGISTERS];
-		static CX86Assembler::XMMREGISTER	g_mdRegisters[MAX_MDREGISTERS];
+		static const CONSTMATCHER					g_constMatchers[];
+		static const CX86Assembler::REGISTER		g_registers[MAX_REGISTERS];
+		static const CX86Assembler::XMMREGISTER	g_mdRegisters[MAX_MDREGISTERS];
 		
 		ParamStack							m_params;
 		uint32								m_paramSpillBase = 0;
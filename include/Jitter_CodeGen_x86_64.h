@@ -22,7 +22,11 @@ namespace Jitter
 		unsigned int						GetAvailableRegisterCount() const override;
 		unsigned int						GetAvailableMdRegisterCount() const override;
 		bool								CanHold128BitsReturnValueInRegisters() const override;
+		bool								CanHoldFpSingleInMdRegisters() const override;
+		uint32								GetCallPreservedRegisterMask() const override;
+		uint32								GetCallPreservedMdRegisterMask() const override;
 		uint32								GetPointerSize() const override;
+		uint32								GetConfigurationKey() const override;
 
 	protected:
 		//ALUOP64 ----------------------------------------------------------
@@ -102,6 +106,13 @@ namespace Jitter
 
 		//EXTERNJMP
 		void								Emit_ExternJmp(const STATEMENT&);
+		void								Emit_ExternJmpDynamic(const STATEMENT&);
+
+		//LOOKUP
+		void								Emit_Lookup(const STATEMENT&);
+
+		//INCCOUNTER
+		void								Emit_IncCounter(const STATEMENT&);
 
 		//MOV
 		void								Emit_Mov_Mem64Mem64(const STATEMENT&);
@@ -201,18 +212,18 @@ namespace Jitter
 		CX86Assembler::REGISTER				PrepareRefSymbolRegisterUse(CSymbol*, CX86Assembler::REGISTER) override;
 		void								CommitRefSymbolRegister(CSymbol*, CX86Assembler::REGISTER);
 
-		static CONSTMATCHER					g_constMatchers[];
-		static CX86Assembler::REGISTER		g_systemVRegisters[SYSTEMV_MAX_REGISTERS];
-		static CX86Assembler::REGISTER		g_systemVParamRegs[SYSTEMV_MAX_PARAMS];
-		static CX86Assembler::REGISTER		g_win32Registers[WIN32_MAX_REGISTERS];
-		static CX86Assembler::REGISTER		g_win32ParamRegs[WIN32_MAX_PARAMS];
-		static CX86Assembler::XMMREGISTER	g_mdRegisters[MAX_MDREGISTERS];
+		static const CONSTMATCHER					g_constMatchers[];
+		static const CX86Assembler::REGISTER		g_systemVRegisters[SYSTEMV_MAX_REGISTERS];
+		static const CX86Assembler::REGISTER		g_systemVParamRegs[SYSTEMV_MAX_PARAMS];
+		static const CX86Assembler::REGISTER		g_win32Registers[WIN32_MAX_REGISTERS];
+		static const CX86Assembler::REGISTER		g_win32ParamRegs[WIN32_MAX_PARAMS];
+		static const CX86Assembler::XMMREGISTER	g_mdRegisters[MAX_MDREGISTERS];
 		
 		PLATFORM_ABI						m_platformAbi = PLATFORM_ABI_SYSTEMV;
 		uint32								m_maxRegisters = 0;
 		uint32								m_maxParams = 0;
 		bool								m_hasMdRegRetValues = false;
-		CX86Assembler::REGISTER*			m_paramRegs = nullptr;
+		const CX86Assembler::REGISTER*		m_paramRegs = nullptr;
 		
 		ParamStack							m_params;
 		uint32								m_paramSpillBase = 0;
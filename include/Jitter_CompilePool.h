@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include "Jitter.h"
+#include "MemoryFunction.h"
+
+class CCodeHeap;
+
+namespace Jitter
+{
+	//Compiles functions on background threads. Each worker owns its own CJitter (and code generator),
+	//so no compiler state is shared between threads. Builders are invoked between Begin and End
+	//on the worker's jitter and must only use state they own or that is safe to read concurrently.
+	class CCompilePool
+	{
+	public:
+		typedef std::function<void (CJitter&)> BuilderType;
+		typedef std::function<CCodeGen* ()> CodeGenFactoryType;
+
+		//A worker count of 0 uses one worker per hardware thread. If a code heap is provided,
+		//compiled functions are allocated from it, the heap must outlive the functions.
+									CCompilePool(unsigned int = 0, CCodeHeap* = nullptr, CodeGenFactoryType = CodeGenFactoryType());
+									CCompilePool(const CCompilePool&) = delete;
+		virtual						~CCompilePool();
+
+		CCompilePool&				operator =(const CCompilePool&) = delete;
+
+		std::future<CMemoryFunction>	Submit(BuilderType);
+
+		unsigned int				GetWorkerCount() const;
+
+		//Blocks until all submitted work is done
+		void						Wait();
+
+	private:
+		struct TASK
+		{
+			BuilderType						builder;
+			std::promise<CMemoryFunction>	promise;
+		};
+
+		typedef std::deque<TASK> TaskQueue;
+		typedef std::vector<std::thread> ThreadArray;
+
+		void						WorkerProc();
+		std::unique_ptr<CJitter>	CreateJitter();
+		CMemoryFunction				CompileTask(CJitter&, const BuilderType&);
+
+		CCodeHeap*					m_codeHeap = nullptr;
+
+		std::mutex					m_codeGenFactoryMutex;
+		CodeGenFactoryType			m_codeGenFactory;
+
+		std::mutex					m_mutex;
+		std::condition_variable		m_taskAvailableCondition;
+		std::condition_variable		m_idleCondition;
+		TaskQueue					m_tasks;
+		unsigned int				m_busyWorkerCount = 0;
+		bool						m_terminating = false;
+
+		ThreadArray					m_workers;
+	};
+}
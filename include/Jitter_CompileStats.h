@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include "Types.h"
+#include "AssemblerStats.h"
+#include "Jitter_Statement.h"
+
+namespace Jitter
+{
+	class CCompileStats
+	{
+	public:
+		enum PASS
+		{
+			PASS_CONSTANTPROPAGATION,
+			PASS_CONSTANTFOLDING,
+			PASS_STRENGTHREDUCTION,
+			PASS_VALUENUMBERING,
+			PASS_COPYPROPAGATION,
+			PASS_REORDERADD,
+			PASS_DEADCODEELIMINATION,
+			PASS_PRUNEBLOCKS,
+			PASS_MERGEBLOCKS,
+			PASS_LOOPINVARIANTCODEMOTION,
+			PASS_LAYOUTBLOCKS,
+			PASS_COALESCETEMPORARIES,
+			PASS_ALLOCATEGLOBALREGISTERS,
+			PASS_ALLOCATEREGISTERS,
+			PASS_ALLOCATESTACK,
+			PASS_GENERATECODE,
+			PASS_ASSEMBLEREND,
+			PASS_MAX,
+		};
+
+		enum
+		{
+			//Bucket N holds durations within [2^N, 2^(N + 1)[ nanoseconds
+			HISTOGRAM_BUCKET_COUNT = 32,
+		};
+
+		typedef std::array<uint64, HISTOGRAM_BUCKET_COUNT> Histogram;
+
+		struct IR_SIZE
+		{
+			uint64 statementCount = 0;
+			uint64 symbolCount = 0;
+		};
+
+		struct PASS_STATS
+		{
+			uint64		runCount = 0;
+			uint64		totalTime = 0;
+			uint64		maxTime = 0;
+			uint64		statementsBefore = 0;
+			uint64		statementsAfter = 0;
+			uint64		symbolsBefore = 0;
+			uint64		symbolsAfter = 0;
+			Histogram	timeHistogram = {};
+		};
+
+		struct OPERATION_CODE_STATS
+		{
+			uint64		statementCount = 0;
+			uint64		bytes = 0;
+		};
+
+		typedef std::array<uint64, CAssemblerStats::CATEGORY_MAX> CodeCategoryArray;
+
+		//Code emitted by the backend, bytes are attributed to the IR operation that produced them
+		//(literal pools, prolog and epilog aren't attributed to any operation)
+		struct CODE_STATS
+		{
+			uint64											totalBytes = 0;
+			CodeCategoryArray								categoryBytes = {};
+			CodeCategoryArray								categoryInstructionCounts = {};
+			std::array<OPERATION_CODE_STATS, OP_MAX>		operations = {};
+		};
+
+		struct STATS
+		{
+			uint64									compileCount = 0;
+			uint64									totalTime = 0;
+			uint64									maxTime = 0;
+			Histogram								timeHistogram = {};
+			std::array<PASS_STATS, PASS_MAX>		passes = {};
+			CODE_STATS								code;
+		};
+
+		class CPassScope
+		{
+		public:
+									CPassScope(CCompileStats*, PASS);
+									CPassScope(CCompileStats*, PASS, const IR_SIZE&);
+									CPassScope(const CPassScope&) = delete;
+									~CPassScope();
+
+			CPassScope&				operator =(const CPassScope&) = delete;
+
+			void					SetSizeAfter(const IR_SIZE&);
+
+		private:
+			CCompileStats*			m_stats = nullptr;
+			PASS					m_pass = PASS_MAX;
+			uint64					m_startTime = 0;
+			IR_SIZE					m_sizeBefore;
+			IR_SIZE					m_sizeAfter;
+		};
+
+		void						BeginCompilation();
+		void						EndCompilation();
+
+		void						RecordPass(PASS, uint64, const IR_SIZE&, const IR_SIZE&);
+		void						RecordCode(const CAssemblerStats&);
+
+		const STATS&				GetLastCompilation() const;
+		const STATS&				GetAggregate() const;
+		void						Reset();
+
+		static const char*			GetPassName(PASS);
+		static unsigned int			GetHistogramBucket(uint64);
+		static uint64				GetTimestamp();
+
+	private:
+		static void					RecordPassStats(PASS_STATS&, uint64, const IR_SIZE&, const IR_SIZE&);
+		static void					RecordTime(uint64&, uint64&, Histogram&, uint64);
+		static void					RecordCodeStats(CODE_STATS&, const CAssemblerStats&);
+
+		STATS						m_lastCompilation;
+		STATS						m_aggregate;
+		uint64						m_compilationStartTime = 0;
+	};
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <list>
+#include <vector>
 #include <functional>
 #include "Jitter_SymbolRef.h"
 
@@ -154,16 +154,20 @@ namespace Jitter
 
 		OP_PARAM,
 		OP_PARAM_RET,
-		OP_CALL,
+		OP_CALL,          //jmpCondition is non zero if the callee is context pure (doesn't access the context)
 		OP_RETVAL,
 		OP_JMP,
 		OP_CONDJMP,
 		OP_EXTERNJMP,     //Pass control to another function with same signature (void (*)(void*)) and same input parameter
 		OP_EXTERNJMP_DYN, //Same as above, but destination can be changed at run time, cannot be used in AOT mode
+		OP_LOOKUP,        //Probes a table of CJitter::LOOKUP_ENTRY (src2) at (src1 & src3), passes control to the entry's code if its tag is src1
 		OP_GOTO,
 		OP_BREAK,
+		OP_INCCOUNTER,    //Increments the 32-bit counter at src1 (constant pointer), used by profiling instrumentation
 
 		OP_LABEL,
+
+		OP_MAX,
 	};
 
 	enum CONDITION
@@ -239,12 +243,16 @@ namespace Jitter
 		}
 	};
 
-	typedef std::list<STATEMENT> StatementList;
+	typedef std::vector<STATEMENT> StatementList;
+	typedef std::vector<bool> StatementTombstoneList;
 
 	std::string		ConditionToString(CONDITION);
 	void			DumpStatementList(const StatementList&);
 	void			DumpStatementList(std::ostream&, const StatementList&);
 
+	//Removes all statements flagged in the tombstone list (indexed like the statement list) in a single pass
+	bool			CompactStatementList(StatementList&, const StatementTombstoneList&);
+
 	template<typename ListType, typename IteratorType, typename ValueType>
 	class IndexedStatementListBase
 	{
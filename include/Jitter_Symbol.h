@@ -34,8 +34,11 @@ namespace Jitter
 
 		SYM_FP_REL_SINGLE,
 		SYM_FP_TMP_SINGLE,
+		SYM_FP_REG_SINGLE,
 
 		SYM_FP_REL_INT32,
+
+		SYM_TYPE_MAX,
 	};
 
 	class CSymbol
@@ -98,6 +101,9 @@ namespace Jitter
 			case SYM_FP_TMP_SINGLE:
 				return "TMP(FP_S)[" + std::to_string(m_valueLow) + "]";
 				break;
+			case SYM_FP_REG_SINGLE:
+				return "REG(FP_S)[" + std::to_string(m_valueLow) + "]";
+				break;
 			case SYM_RELATIVE128:
 				return "REL128[" + std::to_string(m_valueLow) + "]";
 				break;
@@ -140,6 +146,7 @@ namespace Jitter
 				break;
 			case SYM_FP_REL_SINGLE:
 			case SYM_FP_TMP_SINGLE:
+			case SYM_FP_REG_SINGLE:
 			case SYM_FP_REL_INT32:
 				return 4;
 				break;
@@ -159,7 +166,8 @@ namespace Jitter
 			return
 				(m_type == SYM_REGISTER) ||
 				(m_type == SYM_REG_REFERENCE) ||
-				(m_type == SYM_REGISTER128);
+				(m_type == SYM_REGISTER128) ||
+				(m_type == SYM_FP_REG_SINGLE);
 		}
 
 		bool IsRelative() const
@@ -3,6 +3,7 @@
 
 #include <unordered_set>
 #include "Jitter_Symbol.h"
+#include "Jitter_Arena.h"
 
 namespace Jitter
 {
@@ -17,10 +18,10 @@ namespace Jitter
 			}
 		};
 
-		typedef std::unordered_set<SymbolPtr, SymbolHasher, SymbolComparator> SymbolSet;
+		typedef std::unordered_set<SymbolPtr, SymbolHasher, SymbolComparator, CArenaAllocator<SymbolPtr>> SymbolSet;
 		typedef SymbolSet::iterator SymbolIterator;
 
-								CSymbolTable();
+								CSymbolTable(CArena* = nullptr);
 		virtual					~CSymbolTable();
 
 		SymbolPtr				MakeSymbol(const SymbolPtr&);
@@ -28,8 +29,10 @@ namespace Jitter
 		SymbolIterator			RemoveSymbol(const SymbolIterator&);
 
 		SymbolSet&				GetSymbols();
+		const SymbolSet&		GetSymbols() const;
 
 	private:
+		CArena*					m_arena = nullptr;
 		SymbolSet				m_symbols;
 	};
 }
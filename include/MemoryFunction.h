@@ -2,11 +2,14 @@
 
 #include "Types.h"
 
+class CCodeHeap;
+
 class CMemoryFunction
 {
 public:
 						CMemoryFunction();
 						CMemoryFunction(const void*, size_t);
+						CMemoryFunction(const void*, size_t, CCodeHeap&);
 						CMemoryFunction(const CMemoryFunction&) = delete;
 						CMemoryFunction(CMemoryFunction&&);
 
@@ -24,11 +27,25 @@ public:
 
 	void				BeginModify();
 	void				EndModify();
+
+	//Dynamic exits (OP_EXTERNJMP_DYN) are identified by the offsets reported by the code generator.
+	//Linking branches directly to the target if it is within reach of a relative branch, the indirect
+	//target is replaced otherwise. Returns true if the exit branches directly to its target.
+	bool				LinkExit(uint32, const void*);
+	//Makes the exit go through its indirect target again (ie.: the dispatcher), when the linked target is invalidated
+	void				UnlinkExit(uint32, const void*);
 	
 private:
 	void				ClearCache();
 	void				Reset();
 
+	uint8*				GetExitSite(uint32) const;
+	static bool			EncodeExitBranch(const uint8*, const void*, uint32&);
+	static void			WriteExitBranch(uint8*, uint32);
+	static void			WriteIndirectExit(uint8*, const void*);
+	static void			WriteExitTarget(uint8*, const void*);
+
 	void*				m_code;
 	size_t				m_size;
+	CCodeHeap*			m_heap = nullptr;
 };
@@ -5,6 +5,7 @@
 #include <vector>
 #include <memory>
 #include "Stream.h"
+#include "Jitter_CodeGen.h"
 
 namespace Jitter
 {
@@ -30,6 +31,8 @@ namespace Jitter
 			SYMBOL_TYPE		type;
 			unsigned int	symbolIndex;
 			unsigned int	offset;
+			//As reported by the code generator, selects the relocation to use
+			CCodeGen::SYMBOL_REF_TYPE	refType = CCodeGen::SYMBOL_REF_TYPE::NATIVE_POINTER;
 		};
 		typedef std::vector<SYMBOL_REFERENCE> SymbolReferenceArray;
 
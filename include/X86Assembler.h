@@ -4,6 +4,8 @@
 #include "Stream.h"
 #include "MemStream.h"
 #include "Literal128.h"
+#include "AssemblerStats.h"
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -113,6 +115,10 @@ public:
 
 	void									SetStream(Framework::CStream*);
 
+	void									SetStats(CAssemblerStats*);
+	void									BeginStatsRegion(CAssemblerStats::CATEGORY, uint32 = CAssemblerStats::NO_TAG);
+	void									EndStatsRegion();
+
 	static CAddress							MakeRegisterAddress(REGISTER);
 	static CAddress							MakeXmmRegisterAddress(XMMREGISTER);
 	static CAddress							MakeByteRegisterAddress(BYTEREGISTER);
@@ -170,6 +176,7 @@ public:
 	void									JlJx(LABEL);
 	void									JleJx(LABEL);
 	void									JmpEd(const CAddress&);
+	void									JmpJd(uint32);
 	void									JmpJx(LABEL);
 	void									JnzJx(LABEL);
 	void									JnbeJx(LABEL);
@@ -177,6 +184,7 @@ public:
 	void									JnsJx(LABEL);
 	void									LeaGd(REGISTER, const CAddress&);
 	void									LeaGq(REGISTER, const CAddress&);
+	void									LzcntEd(REGISTER, const CAddress&);
 	void									MovEw(REGISTER, const CAddress&);
 	void									MovEd(REGISTER, const CAddress&);
 	void									MovEq(REGISTER, const CAddress&);
@@ -211,6 +219,7 @@ public:
 	void									SarEd(const CAddress&, uint8);
 	void									SarEq(const CAddress&);
 	void									SarEq(const CAddress&, uint8);
+	void									SarxEd(REGISTER, const CAddress&, REGISTER);
 	void									SbbEd(REGISTER, const CAddress&);
 	void									SbbId(const CAddress&, uint32);
 	void									SetaEb(const CAddress&);
@@ -226,12 +235,14 @@ public:
 	void									ShrEd(const CAddress&, uint8);
 	void									ShrEq(const CAddress&);
 	void									ShrEq(const CAddress&, uint8);
+	void									ShrxEd(REGISTER, const CAddress&, REGISTER);
 	void									ShrdEd(const CAddress&, REGISTER);
 	void									ShrdEd(const CAddress&, REGISTER, uint8);
 	void									ShlEd(const CAddress&);
 	void									ShlEd(const CAddress&, uint8);
 	void									ShlEq(const CAddress&);
 	void									ShlEq(const CAddress&, uint8);
+	void									ShlxEd(REGISTER, const CAddress&, REGISTER);
 	void									ShldEd(const CAddress&, REGISTER);
 	void									ShldEd(const CAddress&, REGISTER, uint8);
 	void									SubEd(REGISTER, const CAddress&);
@@ -444,6 +455,7 @@ public:
 	void									VpunpckhdqVo(XMMREGISTER, XMMREGISTER, const CAddress&);
 
 	void									VpshufbVo(XMMREGISTER, XMMREGISTER, const CAddress&);
+	void									VpbroadcastdVo(XMMREGISTER, const CAddress&);
 	void									VpmovmskbVo(REGISTER, XMMREGISTER);
 
 	void									VaddpsVo(XMMREGISTER, XMMREGISTER, const CAddress&);
@@ -503,7 +515,9 @@ private:
 		VEX_OPCODE_MAP_66_38 = 0x12,
 		VEX_OPCODE_MAP_66_3A = 0x13,
 		VEX_OPCODE_MAP_F3 = 0x21,
-		VEX_OPCODE_MAP_F2 = 0x31
+		VEX_OPCODE_MAP_F3_38 = 0x22,
+		VEX_OPCODE_MAP_F2 = 0x31,
+		VEX_OPCODE_MAP_F2_38 = 0x32
 	};
 
 	struct LABELREF
@@ -521,6 +535,7 @@ private:
 		uint32		offset;
 		JMP_TYPE	type;
 		JMP_LENGTH	length;
+		uint32		statsTag = CAssemblerStats::NO_TAG;
 	};
 
 	typedef std::vector<LABELREF> LabelRefArray;
@@ -538,6 +553,7 @@ private:
 			: start(0)
 			, size(0)
 			, projectedStart(0)
+			, firstJumpIndex(0)
 		{
 
 		}
@@ -545,13 +561,23 @@ private:
 		uint32			start;
 		uint32			size;
 		uint32			projectedStart;
+		uint32			firstJumpIndex;
 		LabelRefArray	labelRefs;
 		Literal128Refs	literal128Refs;
 	};
 
-	typedef std::map<LABEL, LABELINFO> LabelMap;
+	struct RELAXJUMP
+	{
+		LABELREF*	labelRef = nullptr;
+		uint32		targetStart = 0;
+		uint32		targetFirstJump = 0;
+	};
+
+	//Deque keeps references to labels stable while new ones are created
+	typedef std::deque<LABELINFO> LabelInfoArray;
 	typedef std::vector<LABEL> LabelArray;
-	typedef std::vector<uint8> ByteArray;
+	typedef std::vector<RELAXJUMP> RelaxJumpArray;
+	typedef std::vector<uint32> JumpGrowthArray;
 
 	void									WriteRexByte(bool, const CAddress&);
 	void									WriteRexByte(bool, const CAddress&, REGISTER&, bool = false);
@@ -575,13 +601,12 @@ private:
 	void									WriteEdVdOp_F3_0F(uint8, const CAddress&, XMMREGISTER);
 	void									WriteVrOp_66_0F(uint8, uint8, XMMREGISTER);
 	void									WriteVexVoOp(VEX_OPCODE_MAP, uint8, XMMREGISTER, XMMREGISTER, const CAddress&);
+	void									WriteVexGdOp(VEX_OPCODE_MAP, uint8, REGISTER, REGISTER, const CAddress&);
 	void									WriteVexShiftVoOp(uint8, uint8, XMMREGISTER, XMMREGISTER, uint8);
 	void									WriteStOp(uint8, uint8, uint8);
 
 	void									CreateLabelReference(LABEL, JMP_TYPE);
-
-	void									IncrementJumpOffsetsLocal(LABELINFO&, LabelRefArray::iterator, unsigned int);
-	void									IncrementJumpOffsets(LabelArray::const_iterator, unsigned int);
+	LABELINFO&								GetLabelInfo(LABEL);
 
 	static unsigned int						GetJumpSize(JMP_TYPE, JMP_LENGTH);
 	static void								WriteJump(Framework::CStream*, JMP_TYPE, JMP_LENGTH, uint32);
@@ -590,12 +615,14 @@ private:
 	void									WriteWord(uint16);
 	void									WriteDWord(uint32);
 
-	LabelMap								m_labels;
+	LabelInfoArray							m_labels;
 	LabelArray								m_labelOrder;
 	LABEL									m_nextLabelId = 1;
 	LITERAL128ID							m_nextLiteral128Id = 1;
 	LABELINFO*								m_currentLabel = nullptr;
 	Framework::CStream*						m_outputStream = nullptr;
+	CAssemblerStats*						m_stats = nullptr;
 	Framework::CMemStream					m_tmpStream;
-	ByteArray								m_copyBuffer;
+	RelaxJumpArray							m_relaxJumps;
+	JumpGrowthArray							m_jumpGrowth;
 };
@@ -10,6 +10,23 @@ void CAArch32Assembler::SetStream(Framework::CStream* stream)
 	m_stream = stream;
 }
 
+void CAArch32Assembler::SetStats(CAssemblerStats* stats)
+{
+	m_stats = stats;
+}
+
+void CAArch32Assembler::BeginStatsRegion(CAssemblerStats::CATEGORY category, uint32 tag)
+{
+	if(!m_stats) return;
+	m_stats->BeginRegion(m_stream->Tell(), category, tag);
+}
+
+void CAArch32Assembler::EndStatsRegion()
+{
+	if(!m_stats) return;
+	m_stats->EndRegion(m_stream->Tell());
+}
+
 CAArch32Assembler::LdrAddress CAArch32Assembler::MakeImmediateLdrAddress(int32 immediate)
 {
 	LdrAddress result;
@@ -115,6 +132,9 @@ void CAArch32Assembler::ResolveLiteralReferences()
 {
 	if(m_literal128Refs.empty()) return;
 	
+	uint64 poolStart = m_stream->Tell();
+	uint32 literalRefCount = static_cast<uint32>(m_literal128Refs.size());
+
 	CLiteralPool literalPool(m_stream);
 	literalPool.AlignPool();
 
@@ -137,6 +157,13 @@ void CAArch32Assembler::ResolveLiteralReferences()
 	}
 	m_literal128Refs.clear();
 	m_stream->Seek(0, Framework::STREAM_SEEK_END);
+
+	if(m_stats)
+	{
+		//Includes alignment padding
+		uint32 poolSize = static_cast<uint32>(m_stream->Tell() - poolStart);
+		m_stats->RecordDetached(CAssemblerStats::CATEGORY_LITERALPOOL, CAssemblerStats::NO_TAG, poolSize, literalRefCount);
+	}
 }
 
 void CAArch32Assembler::GenericAlu(ALU_OPCODE op, bool setFlags, REGISTER rd, REGISTER rn, REGISTER rm)
@@ -172,6 +199,7 @@ void CAArch32Assembler::CreateLabelReference(LABEL label)
 {
 	LABELREF reference = static_cast<size_t>(m_stream->Tell());
 	m_labelReferences.insert(LabelReferenceMapType::value_type(label, reference));
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_JUMP_NEAR);
 }
 
 void CAArch32Assembler::Adc(REGISTER rd, REGISTER rn, REGISTER rm)
@@ -215,6 +243,17 @@ void CAArch32Assembler::And(REGISTER rd, REGISTER rn, const ImmediateAluOperand&
 	GenericAlu(ALU_OPCODE_AND, false, rd, rn, operand);
 }
 
+void CAArch32Assembler::B_offset(int32 offset)
+{
+	//Offset is relative to the branch instruction, PC reads 8 bytes ahead
+	assert((offset & 0x3) == 0);
+	offset = (offset - 8) / 4;
+	assert((offset >= -0x800000) && (offset < 0x800000));
+	uint32 opcode = (CONDITION_AL << 28) | (0x0A000000);
+	opcode |= (offset & 0x00FFFFFF);
+	WriteWord(opcode);
+}
+
 void CAArch32Assembler::BCc(CONDITION condition, LABEL label)
 {
 	CreateLabelReference(label);
@@ -239,6 +278,7 @@ void CAArch32Assembler::Blx(REGISTER rn)
 	uint32 opcode = 0;
 	opcode = (CONDITION_AL << 28) | (0x12FFF30) | (rn);
 	WriteWord(opcode);
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_CALL);
 }
 
 void CAArch32Assembler::Clz(REGISTER rd, REGISTER rm)
@@ -781,6 +821,14 @@ void CAArch32Assembler::Vzip_I8(DOUBLE_REGISTER dd, DOUBLE_REGISTER dm)
 	WriteWord(opcode);
 }
 
+void CAArch32Assembler::Vzip_I8(QUAD_REGISTER qd, QUAD_REGISTER qm)
+{
+	uint32 opcode = 0xF3B201C0;
+	opcode |= FPSIMD_EncodeQd(qd);
+	opcode |= FPSIMD_EncodeQm(qm);
+	WriteWord(opcode);
+}
+
 void CAArch32Assembler::Vzip_I16(DOUBLE_REGISTER dd, DOUBLE_REGISTER dm)
 {
 	uint32 opcode = 0xF3B60180;
@@ -789,6 +837,14 @@ void CAArch32Assembler::Vzip_I16(DOUBLE_REGISTER dd, DOUBLE_REGISTER dm)
 	WriteWord(opcode);
 }
 
+void CAArch32Assembler::Vzip_I16(QUAD_REGISTER qd, QUAD_REGISTER qm)
+{
+	uint32 opcode = 0xF3B601C0;
+	opcode |= FPSIMD_EncodeQd(qd);
+	opcode |= FPSIMD_EncodeQm(qm);
+	WriteWord(opcode);
+}
+
 void CAArch32Assembler::Vzip_I32(QUAD_REGISTER qd, QUAD_REGISTER qm)
 {
 	uint32 opcode = 0xF3BA01C0;
@@ -1422,3 +1478,9 @@ void CAArch32Assembler::WriteWord(uint32 value)
 {
 	m_stream->Write32(value);
 }
+
+void CAArch32Assembler::RecordStatsInstruction(CAssemblerStats::CATEGORY category)
+{
+	if(!m_stats) return;
+	m_stats->RecordInstruction(category, 4);
+}
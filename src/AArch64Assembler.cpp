@@ -8,6 +8,23 @@ void CAArch64Assembler::SetStream(Framework::CStream* stream)
 	m_stream = stream;
 }
 
+void CAArch64Assembler::SetStats(CAssemblerStats* stats)
+{
+	m_stats = stats;
+}
+
+void CAArch64Assembler::BeginStatsRegion(CAssemblerStats::CATEGORY category, uint32 tag)
+{
+	if(!m_stats) return;
+	m_stats->BeginRegion(m_stream->Tell(), category, tag);
+}
+
+void CAArch64Assembler::EndStatsRegion()
+{
+	if(!m_stats) return;
+	m_stats->EndRegion(m_stream->Tell());
+}
+
 CAArch64Assembler::LABEL CAArch64Assembler::CreateLabel()
 {
 	return m_nextLabelId++;
@@ -29,6 +46,7 @@ void CAArch64Assembler::CreateBranchLabelReference(LABEL label, CONDITION condit
 	reference.offset    = static_cast<size_t>(m_stream->Tell());
 	reference.condition = condition;
 	m_labelReferences.insert(std::make_pair(label, reference));
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_JUMP_NEAR);
 }
 
 void CAArch64Assembler::CreateCompareBranchLabelReference(LABEL label, CONDITION condition, REGISTER32 cbRegister)
@@ -39,6 +57,7 @@ void CAArch64Assembler::CreateCompareBranchLabelReference(LABEL label, CONDITION
 	reference.cbz        = true;
 	reference.cbRegister = cbRegister;
 	m_labelReferences.insert(std::make_pair(label, reference));
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_JUMP_NEAR);
 }
 
 void CAArch64Assembler::CreateCompareBranchLabelReference(LABEL label, CONDITION condition, REGISTER64 cbRegister)
@@ -49,6 +68,7 @@ void CAArch64Assembler::CreateCompareBranchLabelReference(LABEL label, CONDITION
 	reference.cbz64      = true;
 	reference.cbRegister = static_cast<REGISTER32>(cbRegister);
 	m_labelReferences.insert(std::make_pair(label, reference));
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_JUMP_NEAR);
 }
 
 void CAArch64Assembler::ResolveLabelReferences()
@@ -113,6 +133,9 @@ void CAArch64Assembler::ResolveLiteralReferences()
 {
 	if(m_literal128Refs.empty()) return;
 	
+	uint64 poolStart = m_stream->Tell();
+	uint32 literalRefCount = static_cast<uint32>(m_literal128Refs.size());
+
 	CLiteralPool literalPool(m_stream);
 	literalPool.AlignPool();
 
@@ -128,6 +151,13 @@ void CAArch64Assembler::ResolveLiteralReferences()
 	}
 	m_literal128Refs.clear();
 	m_stream->Seek(0, Framework::STREAM_SEEK_END);
+
+	if(m_stats)
+	{
+		//Includes alignment padding
+		uint32 poolSize = static_cast<uint32>(m_stream->Tell() - poolStart);
+		m_stats->RecordDetached(CAssemblerStats::CATEGORY_LITERALPOOL, CAssemblerStats::NO_TAG, poolSize, literalRefCount);
+	}
 }
 
 void CAArch64Assembler::Add(REGISTER32 rd, REGISTER32 rn, REGISTER32 rm)
@@ -255,6 +285,7 @@ void CAArch64Assembler::B_offset(uint32 offset)
 	uint32 opcode = 0x14000000;
 	opcode |= offset;
 	WriteWord(opcode);
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_CALL);
 }
 
 void CAArch64Assembler::Bl(uint32 offset)
@@ -265,6 +296,7 @@ void CAArch64Assembler::Bl(uint32 offset)
 	uint32 opcode = 0x94000000;
 	opcode |= offset;
 	WriteWord(opcode);
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_CALL);
 }
 
 void CAArch64Assembler::Br(REGISTER64 rn)
@@ -272,6 +304,7 @@ void CAArch64Assembler::Br(REGISTER64 rn)
 	uint32 opcode = 0xD61F0000;
 	opcode |= (rn << 5);
 	WriteWord(opcode);
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_CALL);
 }
 
 void CAArch64Assembler::BCc(CONDITION condition, LABEL label)
@@ -285,6 +318,7 @@ void CAArch64Assembler::Blr(REGISTER64 rn)
 	uint32 opcode = 0xD63F0000;
 	opcode |= (rn << 5);
 	WriteWord(opcode);
+	RecordStatsInstruction(CAssemblerStats::CATEGORY_CALL);
 }
 
 void CAArch64Assembler::Cbnz(REGISTER32 rt, LABEL label)
@@ -1539,3 +1573,9 @@ void CAArch64Assembler::WriteWord(uint32 value)
 {
 	m_stream->Write32(value);
 }
+
+void CAArch64Assembler::RecordStatsInstruction(CAssemblerStats::CATEGORY category)
+{
+	if(!m_stats) return;
+	m_stats->RecordInstruction(category, 4);
+}
@@ -0,0 +1,138 @@
+#include <assert.h>
+#include "AssemblerStats.h"
+
+void CAssemblerStats::Reset()
+{
+	m_categoryBytes = CategoryArray();
+	m_categoryInstructionCounts = CategoryArray();
+	m_tags.clear();
+	m_inRegion = false;
+	m_regionCategory = CATEGORY_CODE;
+	m_regionTag = NO_TAG;
+	m_regionStart = 0;
+	m_regionCarvedBytes = 0;
+}
+
+void CAssemblerStats::BeginRegion(uint64 position, CATEGORY category, uint32 tag)
+{
+	assert(category < CATEGORY_MAX);
+	if(m_inRegion)
+	{
+		EndRegion(position);
+	}
+	m_inRegion = true;
+	m_regionCategory = category;
+	m_regionTag = tag;
+	m_regionStart = position;
+	m_regionCarvedBytes = 0;
+	if(tag != NO_TAG)
+	{
+		GetTag(tag).regionCount++;
+	}
+}
+
+void CAssemblerStats::EndRegion(uint64 position)
+{
+	if(!m_inRegion) return;
+	assert(position >= m_regionStart);
+	uint64 regionSize = position - m_regionStart;
+	assert(regionSize >= m_regionCarvedBytes);
+	m_categoryBytes[m_regionCategory] += regionSize - m_regionCarvedBytes;
+	if(m_regionTag != NO_TAG)
+	{
+		GetTag(m_regionTag).bytes += regionSize;
+	}
+	m_inRegion = false;
+	m_regionTag = NO_TAG;
+}
+
+void CAssemblerStats::RecordInstruction(CATEGORY category, uint32 size)
+{
+	assert(category < CATEGORY_MAX);
+	m_categoryBytes[category] += size;
+	m_categoryInstructionCounts[category]++;
+	if(m_inRegion)
+	{
+		//Tag will get those bytes when the region ends
+		m_regionCarvedBytes += size;
+	}
+}
+
+void CAssemblerStats::RecordDetached(CATEGORY category, uint32 tag, uint32 size, uint32 instructionCount)
+{
+	assert(category < CATEGORY_MAX);
+	m_categoryBytes[category] += size;
+	m_categoryInstructionCounts[category] += instructionCount;
+	if(tag != NO_TAG)
+	{
+		GetTag(tag).bytes += size;
+	}
+}
+
+uint32 CAssemblerStats::GetCurrentTag() const
+{
+	return m_inRegion ? m_regionTag : NO_TAG;
+}
+
+uint64 CAssemblerStats::GetTotalBytes() const
+{
+	uint64 totalBytes = 0;
+	for(const auto& categoryBytes : m_categoryBytes)
+	{
+		totalBytes += categoryBytes;
+	}
+	return totalBytes;
+}
+
+const CAssemblerStats::CategoryArray& CAssemblerStats::GetCategoryBytes() const
+{
+	return m_categoryBytes;
+}
+
+const CAssemblerStats::CategoryArray& CAssemblerStats::GetCategoryInstructionCounts() const
+{
+	return m_categoryInstructionCounts;
+}
+
+const CAssemblerStats::TagArray& CAssemblerStats::GetTags() const
+{
+	return m_tags;
+}
+
+const char* CAssemblerStats::GetCategoryName(CATEGORY category)
+{
+	switch(category)
+	{
+	case CATEGORY_CODE:
+		return "Code";
+	case CATEGORY_PROLOG:
+		return "Prolog";
+	case CATEGORY_EPILOG:
+		return "Epilog";
+	case CATEGORY_SPILL:
+		return "Spill";
+	case CATEGORY_RELOAD:
+		return "Reload";
+	case CATEGORY_LITERALPOOL:
+		return "LiteralPool";
+	case CATEGORY_JUMP_SHORT:
+		return "JumpShort";
+	case CATEGORY_JUMP_NEAR:
+		return "JumpNear";
+	case CATEGORY_CALL:
+		return "Call";
+	default:
+		assert(false);
+		return "";
+	}
+}
+
+CAssemblerStats::TAG_STATS& CAssemblerStats::GetTag(uint32 tag)
+{
+	assert(tag != NO_TAG);
+	if(tag >= m_tags.size())
+	{
+		m_tags.resize(tag + 1);
+	}
+	return m_tags[tag];
+}
@@ -0,0 +1,258 @@
+#include <assert.h>
+#include <algorithm>
+#include <stdexcept>
+#include "CodeHeap.h"
+#include "MemoryFunctionDefs.h"
+
+CCodeHeap::CFlushBatch::CFlushBatch(CCodeHeap& heap)
+: m_heap(heap)
+{
+	m_heap.BeginFlushBatch();
+}
+
+CCodeHeap::CFlushBatch::~CFlushBatch()
+{
+	m_heap.EndFlushBatch();
+}
+
+CCodeHeap::CCodeHeap(size_t regionSize)
+: m_regionSize(regionSize)
+{
+	assert(m_regionSize >= GetSizeClassSize(CLASS_COUNT - 1));
+}
+
+CCodeHeap::~CCodeHeap()
+{
+	assert(m_flushBatchDepth == 0);
+	for(const auto& region : m_regions)
+	{
+		UnmapMemory(region.base, region.size);
+	}
+	for(const auto& largeBlock : m_largeBlocks)
+	{
+		UnmapMemory(largeBlock.base, largeBlock.size);
+	}
+}
+
+void* CCodeHeap::Allocate(size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	assert(size != 0);
+	if(size > GetSizeClassSize(CLASS_COUNT - 1))
+	{
+		//Too big for size classes, give it its own mapping
+		REGION largeBlock;
+		largeBlock.size = size;
+		largeBlock.base = reinterpret_cast<uint8*>(MapMemory(size));
+		m_largeBlocks.push_back(largeBlock);
+		m_allocatedSize += size;
+		m_allocationCount++;
+		return largeBlock.base;
+	}
+
+	unsigned int sizeClass = GetSizeClass(size);
+	size_t classSize = GetSizeClassSize(sizeClass);
+
+	void* result = nullptr;
+	auto& freeList = m_freeLists[sizeClass];
+	if(!freeList.empty())
+	{
+		result = freeList.back();
+		freeList.pop_back();
+		m_freeSize -= classSize;
+	}
+	else
+	{
+		if((m_regionEnd - m_regionCursor) < static_cast<ptrdiff_t>(classSize))
+		{
+			REGION region;
+			region.size = m_regionSize;
+			region.base = reinterpret_cast<uint8*>(MapMemory(m_regionSize));
+			m_regions.push_back(region);
+			m_regionCursor = region.base;
+			m_regionEnd = region.base + region.size;
+		}
+		result = m_regionCursor;
+		m_regionCursor += classSize;
+	}
+
+	m_allocatedSize += classSize;
+	m_allocationCount++;
+	assert((reinterpret_cast<uintptr_t>(result) & (BLOCK_ALIGN - 1)) == 0);
+	return result;
+}
+
+void CCodeHeap::Free(void* ptr, size_t size)
+{
+	if(ptr == nullptr) return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	assert(m_allocationCount != 0);
+	m_allocationCount--;
+
+	if(size > GetSizeClassSize(CLASS_COUNT - 1))
+	{
+		auto largeBlockIterator = std::find_if(m_largeBlocks.begin(), m_largeBlocks.end(),
+			[ptr](const REGION& largeBlock) { return largeBlock.base == ptr; });
+		assert(largeBlockIterator != m_largeBlocks.end());
+		if(largeBlockIterator == m_largeBlocks.end()) return;
+		UnmapMemory(largeBlockIterator->base, largeBlockIterator->size);
+		m_allocatedSize -= largeBlockIterator->size;
+		m_largeBlocks.erase(largeBlockIterator);
+		return;
+	}
+
+	unsigned int sizeClass = GetSizeClass(size);
+	size_t classSize = GetSizeClassSize(sizeClass);
+	m_freeLists[sizeClass].push_back(ptr);
+	m_allocatedSize -= classSize;
+	m_freeSize += classSize;
+}
+
+void CCodeHeap::ClearCache(void* ptr, size_t size)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(m_flushBatchDepth != 0)
+		{
+			REGION range;
+			range.base = reinterpret_cast<uint8*>(ptr);
+			range.size = size;
+			m_pendingFlushes.push_back(range);
+			return;
+		}
+	}
+	MemoryFunction_ClearCache(ptr, size);
+}
+
+CCodeHeap::STATS CCodeHeap::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	STATS stats;
+	stats.regionCount = m_regions.size() + m_largeBlocks.size();
+	stats.regionSize = m_regions.size() * m_regionSize;
+	for(const auto& largeBlock : m_largeBlocks)
+	{
+		stats.regionSize += largeBlock.size;
+	}
+	stats.allocatedSize = m_allocatedSize;
+	stats.freeSize = m_freeSize;
+	stats.allocationCount = m_allocationCount;
+	return stats;
+}
+
+size_t CCodeHeap::GetAllocationSize(size_t size)
+{
+	if(size > GetSizeClassSize(CLASS_COUNT - 1))
+	{
+		return size;
+	}
+	return GetSizeClassSize(GetSizeClass(size));
+}
+
+unsigned int CCodeHeap::GetSizeClass(size_t size)
+{
+	for(unsigned int sizeClass = 0; sizeClass < CLASS_COUNT; sizeClass++)
+	{
+		if(size <= GetSizeClassSize(sizeClass))
+		{
+			return sizeClass;
+		}
+	}
+	assert(false);
+	return CLASS_COUNT - 1;
+}
+
+size_t CCodeHeap::GetSizeClassSize(unsigned int sizeClass)
+{
+	assert(sizeClass < CLASS_COUNT);
+	unsigned int shift = MIN_CLASS_SHIFT + (sizeClass / CLASS_STEPS);
+	unsigned int step = sizeClass % CLASS_STEPS;
+	size_t baseSize = static_cast<size_t>(1) << shift;
+	return baseSize + ((baseSize / CLASS_STEPS) * step);
+}
+
+void* CCodeHeap::MapMemory(size_t size)
+{
+	void* result = nullptr;
+#if defined(MEMFUNC_USE_WIN32)
+	result = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+	if(result == nullptr)
+	{
+		throw std::runtime_error("Failed to allocate code heap memory.");
+	}
+#elif defined(MEMFUNC_USE_MACHVM)
+	kern_return_t allocResult = vm_allocate(mach_task_self(), reinterpret_cast<vm_address_t*>(&result), size, TRUE);
+	if(allocResult != 0)
+	{
+		throw std::runtime_error("Failed to allocate code heap memory.");
+	}
+	vm_protect(mach_task_self(), reinterpret_cast<vm_address_t>(result), size, 0, VM_PROT_READ | VM_PROT_WRITE | VM_PROT_EXECUTE);
+#elif defined(MEMFUNC_USE_MMAP)
+	uint32 additionalMapFlags = 0;
+	#ifdef MEMFUNC_MMAP_ADDITIONAL_FLAGS
+		additionalMapFlags = MEMFUNC_MMAP_ADDITIONAL_FLAGS;
+	#endif
+	result = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS | additionalMapFlags, -1, 0);
+	if(result == MAP_FAILED)
+	{
+		throw std::runtime_error("Failed to allocate code heap memory.");
+	}
+#endif
+	return result;
+}
+
+void CCodeHeap::UnmapMemory(void* ptr, size_t size)
+{
+#if defined(MEMFUNC_USE_WIN32)
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(MEMFUNC_USE_MACHVM)
+	vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(ptr), size);
+#elif defined(MEMFUNC_USE_MMAP)
+	munmap(ptr, size);
+#endif
+}
+
+void CCodeHeap::BeginFlushBatch()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_flushBatchDepth++;
+}
+
+void CCodeHeap::EndFlushBatch()
+{
+	FlushRangeArray pendingFlushes;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		assert(m_flushBatchDepth != 0);
+		m_flushBatchDepth--;
+		if(m_flushBatchDepth != 0) return;
+		std::swap(pendingFlushes, m_pendingFlushes);
+	}
+
+	if(pendingFlushes.empty()) return;
+
+	//Coalesce contiguous or overlapping ranges
+	std::sort(pendingFlushes.begin(), pendingFlushes.end(),
+		[](const REGION& lhs, const REGION& rhs) { return lhs.base < rhs.base; });
+
+	auto currentRange = pendingFlushes[0];
+	for(size_t i = 1; i < pendingFlushes.size(); i++)
+	{
+		const auto& range = pendingFlushes[i];
+		if(range.base <= (currentRange.base + currentRange.size))
+		{
+			auto rangeEnd = std::max(currentRange.base + currentRange.size, range.base + range.size);
+			currentRange.size = rangeEnd - currentRange.base;
+		}
+		else
+		{
+			MemoryFunction_ClearCache(currentRange.base, currentRange.size);
+			currentRange = range;
+		}
+	}
+	MemoryFunction_ClearCache(currentRange.base, currentRange.size);
+}
@@ -0,0 +1,344 @@
+#include "ElfObjectFile.h"
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+using namespace Jitter;
+
+CElfObjectFile::CElfObjectFile(CPU_ARCH cpuArch)
+: CObjectFile(cpuArch)
+{
+	if((cpuArch != CPU_ARCH_X64) && (cpuArch != CPU_ARCH_ARM64))
+	{
+		throw std::runtime_error("ElfObjectFile: Unsupported CPU architecture.");
+	}
+}
+
+CElfObjectFile::~CElfObjectFile()
+{
+
+}
+
+void CElfObjectFile::Write(Framework::CStream& stream)
+{
+	auto internalSymbolInfos = InternalSymbolInfoArray(m_internalSymbols.size());
+	auto externalSymbolInfos = ExternalSymbolInfoArray(m_externalSymbols.size());
+
+	StringTable stringTable;
+	stringTable.push_back(0x00);
+	FillStringTable(stringTable, m_internalSymbols, internalSymbolInfos);
+	FillStringTable(stringTable, m_externalSymbols, externalSymbolInfos);
+
+	auto textSection = BuildSection(m_internalSymbols, internalSymbolInfos, INTERNAL_SYMBOL_LOCATION_TEXT);
+	auto dataSection = BuildSection(m_internalSymbols, internalSymbolInfos, INTERNAL_SYMBOL_LOCATION_DATA);
+
+	auto symbols = BuildSymbols(m_internalSymbols, internalSymbolInfos, m_externalSymbols, externalSymbolInfos);
+
+	auto textSectionRelocations = BuildRelocations(textSection, internalSymbolInfos, externalSymbolInfos);
+	auto dataSectionRelocations = BuildRelocations(dataSection, internalSymbolInfos, externalSymbolInfos);
+
+	StringTable sectionStringTable;
+	sectionStringTable.push_back(0x00);
+	uint32 textNameOffset = AddString(sectionStringTable, ".text");
+	uint32 dataNameOffset = AddString(sectionStringTable, ".data");
+	uint32 relaTextNameOffset = AddString(sectionStringTable, ".rela.text");
+	uint32 relaDataNameOffset = AddString(sectionStringTable, ".rela.data");
+	uint32 symtabNameOffset = AddString(sectionStringTable, ".symtab");
+	uint32 strtabNameOffset = AddString(sectionStringTable, ".strtab");
+	uint32 shstrtabNameOffset = AddString(sectionStringTable, ".shstrtab");
+	uint32 noteGnuStackNameOffset = AddString(sectionStringTable, ".note.GNU-stack");
+
+	//Everything that follows the header is kept 16 bytes aligned
+	auto alignOffset = [] (uint64 offset) { return (offset + 0x0F) & ~static_cast<uint64>(0x0F); };
+
+	uint64 textSectionOffset = alignOffset(sizeof(Elf::HEADER64));
+	uint64 dataSectionOffset = alignOffset(textSectionOffset + textSection.data.size());
+	uint64 relaTextSectionOffset = alignOffset(dataSectionOffset + dataSection.data.size());
+	uint64 relaDataSectionOffset = alignOffset(relaTextSectionOffset + (textSectionRelocations.size() * sizeof(Elf::RELA64)));
+	uint64 symtabSectionOffset = alignOffset(relaDataSectionOffset + (dataSectionRelocations.size() * sizeof(Elf::RELA64)));
+	uint64 strtabSectionOffset = alignOffset(symtabSectionOffset + (symbols.size() * sizeof(Elf::SYMBOL64)));
+	uint64 shstrtabSectionOffset = alignOffset(strtabSectionOffset + stringTable.size());
+	uint64 sectionHeadersOffset = alignOffset(shstrtabSectionOffset + sectionStringTable.size());
+
+	SectionHeaderArray sectionHeaders(SECTION_INDEX_COUNT);
+
+	{
+		auto& sectionHeader = sectionHeaders[SECTION_INDEX_TEXT];
+		sectionHeader.name				= textNameOffset;
+		sectionHeader.type				= Elf::SHT_PROGBITS;
+		sectionHeader.flags				= Elf::SHF_ALLOC | Elf::SHF_EXECINSTR;
+		sectionHeader.offset			= textSectionOffset;
+		sectionHeader.size				= textSection.data.size();
+		sectionHeader.addressAlign		= 0x10;
+	}
+
+	{
+		auto& sectionHeader = sectionHeaders[SECTION_INDEX_DATA];
+		sectionHeader.name				= dataNameOffset;
+		sectionHeader.type				= Elf::SHT_PROGBITS;
+		sectionHeader.flags				= Elf::SHF_ALLOC | Elf::SHF_WRITE;
+		sectionHeader.offset			= dataSectionOffset;
+		sectionHeader.size				= dataSection.data.size();
+		sectionHeader.addressAlign		= 0x10;
+	}
+
+	{
+		auto& sectionHeader = sectionHeaders[SECTION_INDEX_RELA_TEXT];
+		sectionHeader.name				= relaTextNameOffset;
+		sectionHeader.type				= Elf::SHT_RELA;
+		sectionHeader.flags				= Elf::SHF_INFO_LINK;
+		sectionHeader.offset			= relaTextSectionOffset;
+		sectionHeader.size				= textSectionRelocations.size() * sizeof(Elf::RELA64);
+		sectionHeader.link				= SECTION_INDEX_SYMTAB;
+		sectionHeader.info				= SECTION_INDEX_TEXT;
+		sectionHeader.addressAlign		= 0x08;
+		sectionHeader.entrySize			= sizeof(Elf::RELA64);
+	}
+
+	{
+		auto& sectionHeader = sectionHeaders[SECTION_INDEX_RELA_DATA];
+		sectionHeader.name				= relaDataNameOffset;
+		sectionHeader.type				= Elf::SHT_RELA;
+		sectionHeader.flags				= Elf::SHF_INFO_LINK;
+		sectionHeader.offset			= relaDataSectionOffset;
+		sectionHeader.size				= dataSectionRelocations.size() * sizeof(Elf::RELA64);
+		sectionHeader.link				= SECTION_INDEX_SYMTAB;
+		sectionHeader.info				= SECTION_INDEX_DATA;
+		sectionHeader.addressAlign		= 0x08;
+		sectionHeader.entrySize			= sizeof(Elf::RELA64);
+	}
+
+	{
+		auto& sectionHeader = sectionHeaders[SECTION_INDEX_SYMTAB];
+		sectionHeader.name				= symtabNameOffset;
+		sectionHeader.type				= Elf::SHT_SYMTAB;
+		sectionHeader.offset			= symtabSectionOffset;
+		sectionHeader.size				= symbols.size() * sizeof(Elf::SYMBOL64);
+		sectionHeader.link				= SECTION_INDEX_STRTAB;
+		sectionHeader.info				= 1;		//Index of first non-local symbol, only the null symbol is local
+		sectionHeader.addressAlign		= 0x08;
+		sectionHeader.entrySize			= sizeof(Elf::SYMBOL64);
+	}
+
+	{
+		auto& sectionHeader = sectionHeaders[SECTION_INDEX_STRTAB];
+		sectionHeader.name				= strtabNameOffset;
+		sectionHeader.type				= Elf::SHT_STRTAB;
+		sectionHeader.offset			= strtabSectionOffset;
+		sectionHeader.size				= stringTable.size();
+		sectionHeader.addressAlign		= 0x01;
+	}
+
+	{
+		auto& sectionHeader = sectionHeaders[SECTION_INDEX_SHSTRTAB];
+		sectionHeader.name				= shstrtabNameOffset;
+		sectionHeader.type				= Elf::SHT_STRTAB;
+		sectionHeader.offset			= shstrtabSectionOffset;
+		sectionHeader.size				= sectionStringTable.size();
+		sectionHeader.addressAlign		= 0x01;
+	}
+
+	{
+		//Empty marker section, tells the linker that our code doesn't need an executable stack
+		auto& sectionHeader = sectionHeaders[SECTION_INDEX_NOTE_GNU_STACK];
+		sectionHeader.name				= noteGnuStackNameOffset;
+		sectionHeader.type				= Elf::SHT_PROGBITS;
+		sectionHeader.offset			= sectionHeadersOffset;
+		sectionHeader.addressAlign		= 0x01;
+	}
+
+	Elf::HEADER64 header = {};
+	header.ident[0]			= Elf::ELFMAG0;
+	header.ident[1]			= Elf::ELFMAG1;
+	header.ident[2]			= Elf::ELFMAG2;
+	header.ident[3]			= Elf::ELFMAG3;
+	header.ident[4]			= Elf::ELFCLASS64;
+	header.ident[5]			= Elf::ELFDATA2LSB;
+	header.ident[6]			= Elf::EV_CURRENT;
+	header.ident[7]			= Elf::ELFOSABI_NONE;
+	header.type				= Elf::ET_REL;
+	header.machine			= (m_cpuArch == CPU_ARCH_X64) ? Elf::EM_X86_64 : Elf::EM_AARCH64;
+	header.version			= Elf::EV_CURRENT;
+	header.shOffset			= sectionHeadersOffset;
+	header.ehSize			= sizeof(Elf::HEADER64);
+	header.shEntrySize		= sizeof(Elf::SECTION_HEADER64);
+	header.shCount			= SECTION_INDEX_COUNT;
+	header.shStrIndex		= SECTION_INDEX_SHSTRTAB;
+
+	auto writeAt =
+		[&stream] (uint64 offset, const void* data, size_t size)
+		{
+			static const uint8 padding[0x10] = {};
+			uint64 position = stream.Tell();
+			assert(offset >= position);
+			assert((offset - position) <= sizeof(padding));
+			stream.Write(padding, offset - position);
+			stream.Write(data, size);
+		};
+
+	uint64 baseOffset = stream.Tell();
+	stream.Write(&header, sizeof(Elf::HEADER64));
+	writeAt(baseOffset + textSectionOffset, textSection.data.data(), textSection.data.size());
+	writeAt(baseOffset + dataSectionOffset, dataSection.data.data(), dataSection.data.size());
+	writeAt(baseOffset + relaTextSectionOffset, textSectionRelocations.data(), textSectionRelocations.size() * sizeof(Elf::RELA64));
+	writeAt(baseOffset + relaDataSectionOffset, dataSectionRelocations.data(), dataSectionRelocations.size() * sizeof(Elf::RELA64));
+	writeAt(baseOffset + symtabSectionOffset, symbols.data(), symbols.size() * sizeof(Elf::SYMBOL64));
+	writeAt(baseOffset + strtabSectionOffset, stringTable.data(), stringTable.size());
+	writeAt(baseOffset + shstrtabSectionOffset, sectionStringTable.data(), sectionStringTable.size());
+	writeAt(baseOffset + sectionHeadersOffset, sectionHeaders.data(), sectionHeaders.size() * sizeof(Elf::SECTION_HEADER64));
+}
+
+uint32 CElfObjectFile::AddString(StringTable& stringTable, const std::string& string)
+{
+	uint32 offset = static_cast<uint32>(stringTable.size());
+	stringTable.insert(std::end(stringTable), std::begin(string), std::end(string));
+	stringTable.push_back(0);
+	return offset;
+}
+
+void CElfObjectFile::FillStringTable(StringTable& stringTable, const InternalSymbolArray& internalSymbols, InternalSymbolInfoArray& internalSymbolInfos)
+{
+	for(uint32 i = 0; i < internalSymbols.size(); i++)
+	{
+		internalSymbolInfos[i].nameOffset = AddString(stringTable, internalSymbols[i].name);
+	}
+}
+
+void CElfObjectFile::FillStringTable(StringTable& stringTable, const ExternalSymbolArray& externalSymbols, ExternalSymbolInfoArray& externalSymbolInfos)
+{
+	for(uint32 i = 0; i < externalSymbols.size(); i++)
+	{
+		externalSymbolInfos[i].nameOffset = AddString(stringTable, externalSymbols[i].name);
+	}
+}
+
+CElfObjectFile::SECTION CElfObjectFile::BuildSection(const InternalSymbolArray& internalSymbols, InternalSymbolInfoArray& internalSymbolInfos, INTERNAL_SYMBOL_LOCATION location)
+{
+	SECTION section;
+	auto& sectionData(section.data);
+	for(uint32 i = 0; i < internalSymbols.size(); i++)
+	{
+		const auto& internalSymbol = internalSymbols[i];
+		if(internalSymbol.location != location) continue;
+
+		//Keep every symbol aligned, functions are expected to start on 16 bytes boundaries
+		sectionData.resize((sectionData.size() + 0x0F) & ~0x0F);
+
+		auto& internalSymbolInfo = internalSymbolInfos[i];
+		internalSymbolInfo.dataOffset = static_cast<uint32>(sectionData.size());
+		for(const auto& symbolReference : internalSymbol.symbolReferences)
+		{
+			SYMBOL_REFERENCE newReference;
+			newReference.offset			= symbolReference.offset + internalSymbolInfo.dataOffset;
+			newReference.symbolIndex	= symbolReference.symbolIndex;
+			newReference.type			= symbolReference.type;
+			newReference.refType		= symbolReference.refType;
+			section.symbolReferences.push_back(newReference);
+		}
+		sectionData.insert(std::end(sectionData), std::begin(internalSymbol.data), std::end(internalSymbol.data));
+	}
+	return section;
+}
+
+CElfObjectFile::SymbolArray CElfObjectFile::BuildSymbols(
+	const InternalSymbolArray& internalSymbols, InternalSymbolInfoArray& internalSymbolInfos,
+	const ExternalSymbolArray& externalSymbols, ExternalSymbolInfoArray& externalSymbolInfos)
+{
+	SymbolArray symbols;
+	symbols.reserve(1 + internalSymbols.size() + externalSymbols.size());
+
+	//Null symbol
+	symbols.push_back(Elf::SYMBOL64());
+
+	//Internal symbols
+	for(uint32 i = 0; i < internalSymbols.size(); i++)
+	{
+		const auto& internalSymbol = internalSymbols[i];
+		auto& internalSymbolInfo = internalSymbolInfos[i];
+		internalSymbolInfo.symbolIndex = static_cast<uint32>(symbols.size());
+
+		bool isText = (internalSymbol.location == CObjectFile::INTERNAL_SYMBOL_LOCATION_TEXT);
+
+		Elf::SYMBOL64 symbol = {};
+		symbol.name				= internalSymbolInfo.nameOffset;
+		symbol.info				= Elf::MakeSymbolInfo(Elf::STB_GLOBAL, isText ? Elf::STT_FUNC : Elf::STT_OBJECT);
+		symbol.sectionIndex		= isText ? SECTION_INDEX_TEXT : SECTION_INDEX_DATA;
+		symbol.value			= internalSymbolInfo.dataOffset;
+		symbol.size				= internalSymbol.data.size();
+		symbols.push_back(symbol);
+	}
+
+	//External symbols
+	for(uint32 i = 0; i < externalSymbols.size(); i++)
+	{
+		auto& externalSymbolInfo = externalSymbolInfos[i];
+		externalSymbolInfo.symbolIndex = static_cast<uint32>(symbols.size());
+
+		Elf::SYMBOL64 symbol = {};
+		symbol.name				= externalSymbolInfo.nameOffset;
+		symbol.info				= Elf::MakeSymbolInfo(Elf::STB_GLOBAL, Elf::STT_NOTYPE);
+		symbol.sectionIndex		= Elf::SHN_UNDEF;
+		symbols.push_back(symbol);
+	}
+
+	return symbols;
+}
+
+CElfObjectFile::RelocationArray CElfObjectFile::BuildRelocations(
+	SECTION& section, const InternalSymbolInfoArray& internalSymbolInfos,
+	const ExternalSymbolInfoArray& externalSymbolInfos) const
+{
+	RelocationArray relocations;
+	relocations.reserve(section.symbolReferences.size());
+
+	for(const auto& symbolReference : section.symbolReferences)
+	{
+		uint32 symbolIndex = (symbolReference.type == SYMBOL_TYPE_INTERNAL) ?
+			internalSymbolInfos[symbolReference.symbolIndex].symbolIndex :
+			externalSymbolInfos[symbolReference.symbolIndex].symbolIndex;
+
+		uint32 relocationType = 0;
+		auto location = section.data.data() + symbolReference.offset;
+		switch(symbolReference.refType)
+		{
+		case CCodeGen::SYMBOL_REF_TYPE::NATIVE_POINTER:
+			if(m_cpuArch == CPU_ARCH_ARM64)
+			{
+				relocationType = Elf::R_AARCH64_ABS64;
+			}
+			else
+			{
+				relocationType = Elf::R_X86_64_64;
+			}
+			memset(location, 0, sizeof(uint64));
+			break;
+		case CCodeGen::SYMBOL_REF_TYPE::ARMV8_PCRELATIVE:
+			{
+				//Relocatable calls and jumps are emitted as BL/B
+				if(m_cpuArch != CPU_ARCH_ARM64)
+				{
+					throw std::runtime_error("ElfObjectFile: AArch64 relocation used on another CPU architecture.");
+				}
+				uint32 opcode = 0;
+				memcpy(&opcode, location, sizeof(uint32));
+				assert((opcode & 0x7C000000) == 0x14000000);
+				relocationType = (opcode & 0x80000000) ? Elf::R_AARCH64_CALL26 : Elf::R_AARCH64_JUMP26;
+				opcode &= ~0x03FFFFFF;
+				memcpy(location, &opcode, sizeof(uint32));
+			}
+			break;
+		default:
+			throw std::runtime_error("ElfObjectFile: Unsupported symbol reference type.");
+			break;
+		}
+
+		//RELA relocations carry their addend, the location in section data is cleared
+		Elf::RELA64 relocation = {};
+		relocation.offset		= symbolReference.offset;
+		relocation.info			= Elf::MakeRelocationInfo(symbolIndex, relocationType);
+		relocation.addend		= 0;
+		relocations.push_back(relocation);
+	}
+
+	return relocations;
+}
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <cstddef>
 #include "Jitter.h"
 #include "placeholder_def.h"
 
@@ -23,9 +24,187 @@ CCodeGen* CJitter::GetCodeGen()
 
 void CJitter::SetStream(Framework::CStream* stream)
 {
+	m_stream = stream;
 	m_codeGen->SetStream(stream);
 }
 
+void CJitter::SetCodeCache(CCodeCache* codeCache)
+{
+	m_codeCache = codeCache;
+}
+
+CCodeCache* CJitter::GetCodeCache() const
+{
+	return m_codeCache;
+}
+
+const CCodeGen::DynamicExitArray& CJitter::GetDynamicExits() const
+{
+	return m_dynamicExits;
+}
+
+void CJitter::SetCompileStatsEnabled(bool enabled)
+{
+	if(enabled)
+	{
+		if(!m_compileStats)
+		{
+			m_compileStats = std::make_unique<CCompileStats>();
+		}
+	}
+	else
+	{
+		m_compileStats.reset();
+	}
+	m_codeGen->SetCompileStats(m_compileStats.get());
+}
+
+bool CJitter::IsCompileStatsEnabled() const
+{
+	return static_cast<bool>(m_compileStats);
+}
+
+const CCompileStats::STATS& CJitter::GetCompileStats() const
+{
+	assert(m_compileStats);
+	return m_compileStats->GetAggregate();
+}
+
+const CCompileStats::STATS& CJitter::GetLastCompileStats() const
+{
+	assert(m_compileStats);
+	return m_compileStats->GetLastCompilation();
+}
+
+void CJitter::ResetCompileStats()
+{
+	if(m_compileStats)
+	{
+		m_compileStats->Reset();
+	}
+}
+
+void CJitter::SetSymbolArenaEnabled(bool enabled)
+{
+	assert(!m_blockStarted);
+	m_symbolArenaEnabled = enabled;
+}
+
+bool CJitter::IsSymbolArenaEnabled() const
+{
+	return m_symbolArenaEnabled;
+}
+
+const CArena& CJitter::GetSymbolArenaState() const
+{
+	return m_symbolArena;
+}
+
+void CJitter::SetGlobalRegisterAllocationEnabled(bool enabled)
+{
+	m_globalRegAllocEnabled = enabled;
+}
+
+bool CJitter::IsGlobalRegisterAllocationEnabled() const
+{
+	return m_globalRegAllocEnabled;
+}
+
+void CJitter::SetValueNumberingEnabled(bool enabled)
+{
+	m_valueNumberingEnabled = enabled;
+}
+
+bool CJitter::IsValueNumberingEnabled() const
+{
+	return m_valueNumberingEnabled;
+}
+
+void CJitter::SetStrengthReductionEnabled(bool enabled)
+{
+	m_strengthReductionEnabled = enabled;
+}
+
+bool CJitter::IsStrengthReductionEnabled() const
+{
+	return m_strengthReductionEnabled;
+}
+
+void CJitter::SetFpRegisterAllocationEnabled(bool enabled)
+{
+	m_fpRegAllocEnabled = enabled;
+}
+
+bool CJitter::IsFpRegisterAllocationEnabled() const
+{
+	return m_fpRegAllocEnabled;
+}
+
+void CJitter::SetLoopInvariantCodeMotionEnabled(bool enabled)
+{
+	m_loopInvariantCodeMotionEnabled = enabled;
+}
+
+bool CJitter::IsLoopInvariantCodeMotionEnabled() const
+{
+	return m_loopInvariantCodeMotionEnabled;
+}
+
+void CJitter::SetCompileTier(COMPILE_TIER compileTier)
+{
+	assert(!m_blockStarted);
+	m_compileTier = compileTier;
+}
+
+CJitter::COMPILE_TIER CJitter::GetCompileTier() const
+{
+	return m_compileTier;
+}
+
+void CJitter::SetExecutionCounter(uint32* counter)
+{
+	assert(!m_blockStarted);
+	m_executionCounter = counter;
+}
+
+void CJitter::SetProfileInstrumentation(uint32* counters, unsigned int counterCount)
+{
+	assert(!m_blockStarted);
+	m_instrumentationCounters = counters;
+	m_instrumentationCounterCount = counters ? counterCount : 0;
+}
+
+void CJitter::SetProfile(const uint32* counts, unsigned int countCount)
+{
+	m_profile = counts;
+	m_profileSize = counts ? countCount : 0;
+}
+
+unsigned int CJitter::GetProfileCounterCount() const
+{
+	return m_profileCounterCount;
+}
+
+void CJitter::DeclareContextPureFunction(const void* func)
+{
+	m_contextPureFunctions.insert(func);
+}
+
+void CJitter::ClearContextPureFunctions()
+{
+	m_contextPureFunctions.clear();
+}
+
+bool CJitter::IsContextPureFunction(const void* func) const
+{
+	return m_contextPureFunctions.find(func) != std::end(m_contextPureFunctions);
+}
+
+bool CJitter::IsContextPureCall(const STATEMENT& statement)
+{
+	return (statement.op == OP_CALL) && (statement.jmpCondition != CONDITION_NEVER);
+}
+
 void CJitter::Begin()
 {
 	assert(m_blockStarted == false);
@@ -34,15 +213,31 @@ void CJitter::Begin()
 	m_nextBlockId = 1;
 	m_basicBlocks.clear();
 
+	//All symbols from the previous compilation are gone, arena memory can be reused
+	assert(m_shadow.GetCount() == 0);
+	m_symbolArena.Reset();
+
 	StartBlock(m_nextBlockId++);
+
+	if(m_executionCounter)
+	{
+		STATEMENT statement;
+		statement.op	= OP_INCCOUNTER;
+		statement.src1	= MakeSymbolRef(MakeConstantPtr(reinterpret_cast<uintptr_t>(m_executionCounter)));
+		InsertStatement(statement);
+	}
 }
 
 void CJitter::End()
 {
 	assert(m_shadow.GetCount() == 0);
+	assert(m_loopStack.empty());
 	assert(m_blockStarted == true);
 	m_blockStarted = false;
 
+	//Blocks created from now on don't come from the caller
+	m_profileCounterCount = m_nextBlockId;
+
 	Compile();
 }
 
@@ -53,9 +248,18 @@ bool CJitter::IsStackEmpty() const
 
 void CJitter::StartBlock(uint32 blockId)
 {
-	auto blockIterator = m_basicBlocks.emplace(m_basicBlocks.end(), BASIC_BLOCK());
+	auto blockIterator = m_basicBlocks.emplace(m_basicBlocks.end(), GetSymbolArena());
 	m_currentBlock = &(*blockIterator);
 	m_currentBlock->id = blockId;
+	m_currentBlock->loopDepth = m_loopStack.size();
+
+	if(blockId < m_instrumentationCounterCount)
+	{
+		STATEMENT statement;
+		statement.op	= OP_INCCOUNTER;
+		statement.src1	= MakeSymbolRef(MakeConstantPtr(reinterpret_cast<uintptr_t>(m_instrumentationCounters + blockId)));
+		InsertStatement(statement);
+	}
 }
 
 CJitter::LABEL CJitter::CreateLabel()
@@ -167,6 +371,57 @@ void CJitter::EndIf()
 	StartBlock(nextBlockId);
 }
 
+void CJitter::BeginLoop()
+{
+	assert(m_shadow.GetCount() == 0);
+
+	uint32 headerBlockId = m_nextBlockId++;
+	m_loopStack.push(headerBlockId);
+
+	StartBlock(headerBlockId);
+	m_currentBlock->loopHeader = true;
+}
+
+void CJitter::Continue()
+{
+	assert(!m_loopStack.empty());
+	assert(m_shadow.GetCount() == 0);
+
+	STATEMENT statement;
+	statement.op		= OP_JMP;
+	statement.jmpBlock	= m_loopStack.top();
+	InsertStatement(statement);
+}
+
+void CJitter::Continue(CONDITION condition)
+{
+	assert(!m_loopStack.empty());
+
+	STATEMENT statement;
+	statement.op			= OP_CONDJMP;
+	statement.src2			= MakeSymbolRef(m_shadow.Pull());
+	statement.src1			= MakeSymbolRef(m_shadow.Pull());
+	statement.jmpCondition	= condition;
+	statement.jmpBlock		= m_loopStack.top();
+	InsertStatement(statement);
+
+	assert(m_shadow.GetCount() == 0);
+
+	uint32 newBlockId = m_nextBlockId++;
+	StartBlock(newBlockId);
+}
+
+void CJitter::EndLoop()
+{
+	assert(!m_loopStack.empty());
+	assert(m_shadow.GetCount() == 0);
+
+	m_loopStack.pop();
+
+	uint32 newBlockId = m_nextBlockId++;
+	StartBlock(newBlockId);
+}
+
 void CJitter::PushCtx()
 {
 	m_shadow.Push(MakeSymbol(SYM_CONTEXT, 0));
@@ -293,6 +548,10 @@ void CJitter::Call(void* func, unsigned int paramCount, RETURN_VALUE_TYPE return
 	callStatement.src1 = MakeSymbolRef(MakeConstantPtr(reinterpret_cast<uintptr_t>(func)));
 	callStatement.src2 = MakeSymbolRef(MakeSymbol(SYM_CONSTANT, paramCount));
 	callStatement.op = OP_CALL;
+	if(IsContextPureFunction(func))
+	{
+		callStatement.jmpCondition = static_cast<CONDITION>(1);
+	}
 	InsertStatement(callStatement);
 
 	if(returnValue != RETURN_VALUE_NONE)
@@ -368,9 +627,21 @@ void CJitter::JumpToDynamic(void* func)
 	InsertStatement(statement);
 }
 
-void CJitter::Lookup(uint32* table)
+void CJitter::Lookup(const LOOKUP_ENTRY* table, uint32 indexMask, void* missFunction)
 {
-	throw std::exception();
+	//Code generators assume entries are made of two pointer sized fields
+	static_assert(sizeof(LOOKUP_ENTRY) == (sizeof(void*) * 2), "Unexpected lookup entry size.");
+	static_assert(offsetof(LOOKUP_ENTRY, code) == sizeof(void*), "Unexpected lookup entry layout.");
+
+	STATEMENT statement;
+	statement.src1 = MakeSymbolRef(m_shadow.Pull());
+	statement.src2 = MakeSymbolRef(MakeConstantPtr(reinterpret_cast<uintptr_t>(table)));
+	statement.src3 = MakeSymbolRef(MakeSymbol(SYM_CONSTANT, indexMask));
+	statement.op   = OP_LOOKUP;
+	InsertStatement(statement);
+
+	//Register allocation relies on the miss path following the lookup right away
+	JumpTo(missFunction);
 }
 
 void CJitter::Lzc()
@@ -0,0 +1,81 @@
+#include <assert.h>
+#include <algorithm>
+#include "Jitter_Arena.h"
+
+using namespace Jitter;
+
+thread_local size_t* CArena::s_heapAllocationCounter = nullptr;
+
+CArena::CArena(size_t chunkSize)
+: m_chunkSize(chunkSize)
+{
+	assert(m_chunkSize != 0);
+}
+
+void* CArena::Allocate(size_t size, size_t alignment)
+{
+	assert((alignment != 0) && ((alignment & (alignment - 1)) == 0));
+	m_allocationCount++;
+	while(1)
+	{
+		if(m_currentChunk == m_chunks.size())
+		{
+			CountHeapAllocation();
+			CHUNK chunk;
+			chunk.size = std::max<size_t>(m_chunkSize, size + alignment);
+			chunk.data = std::make_unique<uint8[]>(chunk.size);
+			m_chunks.push_back(std::move(chunk));
+		}
+
+		auto& chunk = m_chunks[m_currentChunk];
+		uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data.get());
+		uintptr_t address = (base + m_currentOffset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+		size_t offset = address - base;
+		if((offset + size) <= chunk.size)
+		{
+			m_usedSize += (offset + size) - m_currentOffset;
+			m_currentOffset = offset + size;
+			return reinterpret_cast<void*>(address);
+		}
+
+		//Doesn't fit, move on to the next chunk
+		m_currentChunk++;
+		m_currentOffset = 0;
+	}
+}
+
+void CArena::Reset()
+{
+	m_currentChunk = 0;
+	m_currentOffset = 0;
+	m_usedSize = 0;
+	m_allocationCount = 0;
+}
+
+size_t CArena::GetChunkCount() const
+{
+	return m_chunks.size();
+}
+
+size_t CArena::GetUsedSize() const
+{
+	return m_usedSize;
+}
+
+size_t CArena::GetAllocationCount() const
+{
+	return m_allocationCount;
+}
+
+void CArena::SetHeapAllocationCounter(size_t* counter)
+{
+	s_heapAllocationCounter = counter;
+}
+
+void CArena::CountHeapAllocation()
+{
+	if(s_heapAllocationCounter)
+	{
+		(*s_heapAllocationCounter)++;
+	}
+}
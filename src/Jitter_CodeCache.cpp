@@ -0,0 +1,409 @@
+#include <assert.h>
+#include <cstring>
+#include <stdexcept>
+#include "Jitter_CodeCache.h"
+
+using namespace Jitter;
+
+CCodeCache::CCodeCache(size_t maxEntryCount)
+: m_maxEntryCount(maxEntryCount)
+{
+	assert(m_maxEntryCount != 0);
+}
+
+unsigned int CCodeCache::AddExternalSymbol(const std::string& name, uintptr_t value)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for(uint32 i = 0; i < m_externalSymbols.size(); i++)
+	{
+		const auto& externalSymbol = m_externalSymbols[i];
+		if(externalSymbol.name != name) continue;
+		if(externalSymbol.value != value)
+		{
+			throw std::runtime_error("External symbol already added with a different value.");
+		}
+		return i;
+	}
+	if(m_externalSymbolIndices.find(value) != std::end(m_externalSymbolIndices))
+	{
+		throw std::runtime_error("External symbol value already added with a different name.");
+	}
+	EXTERNAL_SYMBOL externalSymbol;
+	externalSymbol.name = name;
+	externalSymbol.value = value;
+	uint32 index = static_cast<uint32>(m_externalSymbols.size());
+	m_externalSymbols.push_back(std::move(externalSymbol));
+	m_externalSymbolIndices.insert(std::make_pair(value, index));
+	return index;
+}
+
+bool CCodeCache::GetExternalSymbolIndexByValue(uintptr_t value, uint32& index) const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto indexIterator = m_externalSymbolIndices.find(value);
+	if(indexIterator == std::end(m_externalSymbolIndices)) return false;
+	index = indexIterator->second;
+	return true;
+}
+
+unsigned int CCodeCache::GetExternalSymbolUseCount(const StatementList& statements) const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if(m_externalSymbolIndices.empty()) return 0;
+	unsigned int useCount = 0;
+	for(const auto& statement : statements)
+	{
+		statement.VisitOperands(
+			[&] (const SymbolRefPtr& symbolRef, bool)
+			{
+				auto symbol = symbolRef->GetSymbol();
+				if(symbol->m_type != SYM_CONSTANTPTR) return;
+				if(m_externalSymbolIndices.find(symbol->GetConstantPtr()) == std::end(m_externalSymbolIndices)) return;
+				useCount++;
+			}
+		);
+	}
+	return useCount;
+}
+
+bool CCodeCache::Find(const KeyType& key, CodeBuffer& code)
+{
+	DynamicExitArray dynamicExits;
+	return Find(key, code, dynamicExits);
+}
+
+bool CCodeCache::Find(const KeyType& key, CodeBuffer& code, DynamicExitArray& dynamicExits)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto entryIterator = m_entryMap.find(&key);
+	if(entryIterator == std::end(m_entryMap))
+	{
+		m_stats.missCount++;
+		return false;
+	}
+	m_stats.hitCount++;
+	m_entries.splice(std::begin(m_entries), m_entries, entryIterator->second);
+	code = entryIterator->second->code;
+	dynamicExits = entryIterator->second->dynamicExits;
+	return true;
+}
+
+void CCodeCache::Insert(KeyType key, CodeBuffer code, DynamicExitArray dynamicExits)
+{
+	ENTRY entry;
+	entry.key = std::move(key);
+	entry.code = std::move(code);
+	entry.dynamicExits = std::move(dynamicExits);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	InsertEntry(std::move(entry));
+}
+
+void CCodeCache::InsertRelocatable(KeyType key, CodeBuffer code, RelocationArray relocations, DynamicExitArray dynamicExits)
+{
+	ENTRY entry;
+	entry.key = std::move(key);
+	entry.code = std::move(code);
+	entry.relocations = std::move(relocations);
+	entry.dynamicExits = std::move(dynamicExits);
+	entry.relocatable = true;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	InsertEntry(std::move(entry));
+}
+
+void CCodeCache::Clear()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_entryMap.clear();
+	m_entries.clear();
+	m_stats.codeSize = 0;
+}
+
+void CCodeCache::Save(Framework::CStream& stream) const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	uint32 entryCount = 0;
+	for(const auto& entry : m_entries)
+	{
+		if(entry.relocatable) entryCount++;
+	}
+	stream.Write32(FILE_MAGIC);
+	stream.Write32(FILE_VERSION);
+	stream.Write32(static_cast<uint32>(m_externalSymbols.size()));
+	for(const auto& externalSymbol : m_externalSymbols)
+	{
+		WriteBuffer(stream, std::vector<uint8>(std::begin(externalSymbol.name), std::end(externalSymbol.name)));
+	}
+	stream.Write32(entryCount);
+	//Least recently used first, loading will restore the same order
+	for(auto entryIterator = m_entries.rbegin(); entryIterator != m_entries.rend(); entryIterator++)
+	{
+		const auto& entry = *entryIterator;
+		if(!entry.relocatable) continue;
+		WriteBuffer(stream, entry.key);
+		WriteBuffer(stream, entry.code);
+		stream.Write32(static_cast<uint32>(entry.relocations.size()));
+		for(const auto& relocation : entry.relocations)
+		{
+			stream.Write32(relocation.offset);
+			stream.Write32(relocation.symbolIndex);
+			stream.Write32(static_cast<uint32>(relocation.type));
+		}
+		stream.Write32(static_cast<uint32>(entry.dynamicExits.size()));
+		for(auto dynamicExit : entry.dynamicExits)
+		{
+			stream.Write32(dynamicExit);
+		}
+	}
+}
+
+unsigned int CCodeCache::Load(Framework::CStream& stream)
+{
+	if(ReadValue(stream) != FILE_MAGIC)
+	{
+		throw std::runtime_error("Invalid code cache file.");
+	}
+	if(ReadValue(stream) != FILE_VERSION)
+	{
+		throw std::runtime_error("Unsupported code cache file version.");
+	}
+	std::unique_lock<std::mutex> lock(m_mutex);
+	static const uint32 INVALID_INDEX = ~0U;
+	std::vector<uint32> symbolIndices(ReadValue(stream));
+	for(auto& symbolIndex : symbolIndices)
+	{
+		std::vector<uint8> nameBuffer;
+		ReadBuffer(stream, nameBuffer);
+		std::string name(std::begin(nameBuffer), std::end(nameBuffer));
+		symbolIndex = INVALID_INDEX;
+		for(uint32 i = 0; i < m_externalSymbols.size(); i++)
+		{
+			if(m_externalSymbols[i].name == name)
+			{
+				symbolIndex = i;
+				break;
+			}
+		}
+	}
+	unsigned int loadedCount = 0;
+	uint32 entryCount = ReadValue(stream);
+	for(uint32 i = 0; i < entryCount; i++)
+	{
+		ENTRY entry;
+		entry.relocatable = true;
+		ReadBuffer(stream, entry.key);
+		ReadBuffer(stream, entry.code);
+		bool resolved = true;
+		entry.relocations.resize(ReadValue(stream));
+		for(auto& relocation : entry.relocations)
+		{
+			relocation.offset = ReadValue(stream);
+			relocation.symbolIndex = ReadValue(stream);
+			relocation.type = static_cast<CCodeGen::SYMBOL_REF_TYPE>(ReadValue(stream));
+			if(relocation.symbolIndex >= symbolIndices.size())
+			{
+				throw std::runtime_error("Invalid code cache relocation.");
+			}
+			relocation.symbolIndex = symbolIndices[relocation.symbolIndex];
+			resolved &= (relocation.symbolIndex != INVALID_INDEX);
+		}
+		entry.dynamicExits.resize(ReadValue(stream));
+		for(auto& dynamicExit : entry.dynamicExits)
+		{
+			dynamicExit = ReadValue(stream);
+		}
+		if(!resolved) continue;
+		for(const auto& relocation : entry.relocations)
+		{
+			ApplyRelocation(entry.code, relocation, m_externalSymbols[relocation.symbolIndex].value);
+		}
+		InsertEntry(std::move(entry));
+		loadedCount++;
+	}
+	return loadedCount;
+}
+
+CCodeCache::STATS CCodeCache::GetStats() const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto stats = m_stats;
+	stats.entryCount = m_entries.size();
+	return stats;
+}
+
+CCodeCache::KeyType CCodeCache::MakeKey(const StatementList& statements, unsigned int stackSize, uint32 configuration) const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	KeyType key;
+	key.reserve((statements.size() * 0x20) + 0x10);
+	WriteValue(key, configuration);
+	WriteValue(key, stackSize);
+	WriteValue(key, static_cast<uint32>(statements.size()));
+	for(const auto& statement : statements)
+	{
+		WriteValue(key, statement.op);
+		WriteValue(key, statement.jmpBlock);
+		WriteValue(key, statement.jmpCondition);
+		WriteSymbol(key, statement.dst);
+		WriteSymbol(key, statement.src1);
+		WriteSymbol(key, statement.src2);
+		WriteSymbol(key, statement.src3);
+	}
+	return key;
+}
+
+uint64 CCodeCache::HashKey(const KeyType& key)
+{
+	//FNV-1a, stable across runs and platforms
+	uint64 hash = 0xCBF29CE484222325ULL;
+	for(auto value : key)
+	{
+		hash ^= value;
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+bool CCodeCache::IsRelocatable(CCodeGen::SYMBOL_REF_TYPE type)
+{
+	switch(type)
+	{
+	case CCodeGen::SYMBOL_REF_TYPE::NATIVE_POINTER:
+	case CCodeGen::SYMBOL_REF_TYPE::ARMV7_LOAD_HALF:
+		return true;
+	default:
+		//PC relative references depend on where the code ends up
+		return false;
+	}
+}
+
+void CCodeCache::InsertEntry(ENTRY entry)
+{
+	{
+		//Another jitter might have inserted the same code in the meantime
+		auto entryIterator = m_entryMap.find(&entry.key);
+		if(entryIterator != std::end(m_entryMap))
+		{
+			m_entries.splice(std::begin(m_entries), m_entries, entryIterator->second);
+			return;
+		}
+	}
+	while(m_entries.size() >= m_maxEntryCount)
+	{
+		const auto& lastEntry = m_entries.back();
+		m_stats.codeSize -= lastEntry.code.size();
+		m_stats.evictionCount++;
+		m_entryMap.erase(&lastEntry.key);
+		m_entries.pop_back();
+	}
+	m_stats.codeSize += entry.code.size();
+	m_entries.push_front(std::move(entry));
+	m_entryMap.insert(std::make_pair(&m_entries.front().key, std::begin(m_entries)));
+}
+
+void CCodeCache::WriteValue(KeyType& key, uint32 value)
+{
+	key.push_back(static_cast<uint8>(value >> 0));
+	key.push_back(static_cast<uint8>(value >> 8));
+	key.push_back(static_cast<uint8>(value >> 16));
+	key.push_back(static_cast<uint8>(value >> 24));
+}
+
+void CCodeCache::WriteSymbol(KeyType& key, const SymbolRefPtr& symbolRef) const
+{
+	if(!symbolRef)
+	{
+		WriteValue(key, SYM_TYPE_MAX);
+		return;
+	}
+	auto symbol = symbolRef->GetSymbol();
+	WriteValue(key, symbol->m_type);
+	if(symbol->m_type == SYM_CONSTANTPTR)
+	{
+		auto indexIterator = m_externalSymbolIndices.find(symbol->GetConstantPtr());
+		WriteValue(key, indexIterator != std::end(m_externalSymbolIndices));
+		if(indexIterator != std::end(m_externalSymbolIndices))
+		{
+			const auto& name = m_externalSymbols[indexIterator->second].name;
+			WriteValue(key, static_cast<uint32>(name.size()));
+			key.insert(std::end(key), std::begin(name), std::end(name));
+			return;
+		}
+	}
+	WriteValue(key, symbol->m_valueLow);
+	WriteValue(key, symbol->m_valueHigh);
+	//Stack slots are assigned before code generation and end up in the code
+	WriteValue(key, symbol->IsTemporary() ? symbol->m_stackLocation : 0);
+}
+
+void CCodeCache::ApplyRelocation(CodeBuffer& code, const RELOCATION& relocation, uintptr_t value)
+{
+	switch(relocation.type)
+	{
+	case CCodeGen::SYMBOL_REF_TYPE::NATIVE_POINTER:
+		if((relocation.offset + sizeof(uintptr_t)) > code.size())
+		{
+			throw std::runtime_error("Invalid code cache relocation.");
+		}
+		memcpy(code.data() + relocation.offset, &value, sizeof(uintptr_t));
+		break;
+	case CCodeGen::SYMBOL_REF_TYPE::ARMV7_LOAD_HALF:
+		{
+			//MOVW then MOVT, immediate is split in imm4:imm12
+			if((relocation.offset + 8) > code.size())
+			{
+				throw std::runtime_error("Invalid code cache relocation.");
+			}
+			for(unsigned int i = 0; i < 2; i++)
+			{
+				uint32 halfValue = static_cast<uint32>(value >> (i * 16)) & 0xFFFF;
+				uint32 opcode = 0;
+				memcpy(&opcode, code.data() + relocation.offset + (i * 4), 4);
+				opcode &= ~0x000F0FFF;
+				opcode |= ((halfValue & 0xF000) << 4) | (halfValue & 0x0FFF);
+				memcpy(code.data() + relocation.offset + (i * 4), &opcode, 4);
+			}
+		}
+		break;
+	default:
+		throw std::runtime_error("Unsupported code cache relocation.");
+	}
+}
+
+void CCodeCache::WriteBuffer(Framework::CStream& stream, const std::vector<uint8>& buffer)
+{
+	stream.Write32(static_cast<uint32>(buffer.size()));
+	if(!buffer.empty())
+	{
+		stream.Write(buffer.data(), buffer.size());
+	}
+}
+
+void CCodeCache::ReadBuffer(Framework::CStream& stream, std::vector<uint8>& buffer)
+{
+	buffer.resize(ReadValue(stream));
+	if(buffer.empty()) return;
+	if(stream.Read(buffer.data(), buffer.size()) != buffer.size())
+	{
+		throw std::runtime_error("Truncated code cache file.");
+	}
+}
+
+uint32 CCodeCache::ReadValue(Framework::CStream& stream)
+{
+	uint32 value = 0;
+	if(stream.Read(&value, sizeof(value)) != sizeof(value))
+	{
+		throw std::runtime_error("Truncated code cache file.");
+	}
+	return value;
+}
+
+size_t CCodeCache::KeyHasher::operator()(const KeyType* key) const
+{
+	return static_cast<size_t>(HashKey(*key));
+}
+
+bool CCodeCache::KeyComparator::operator()(const KeyType* key1, const KeyType* key2) const
+{
+	return (*key1) == (*key2);
+}
@@ -1,4 +1,7 @@
+#include <assert.h>
+#include <algorithm>
 #include "Jitter_CodeGen.h"
+#include "Jitter_CompileStats.h"
 
 using namespace Jitter;
 
@@ -7,79 +10,284 @@ void CCodeGen::SetExternalSymbolReferencedHandler(const ExternalSymbolReferenced
 	m_externalSymbolReferencedHandler = externalSymbolReferencedHandler;
 }
 
-bool CCodeGen::SymbolMatches(MATCHTYPE match, const SymbolRefPtr& symbolRef)
+bool CCodeGen::HasExternalSymbolReferencedHandler() const
+{
+	return static_cast<bool>(m_externalSymbolReferencedHandler);
+}
+
+void CCodeGen::SetDynamicExitHandler(const DynamicExitHandler& dynamicExitHandler)
+{
+	m_dynamicExitHandler = dynamicExitHandler;
+}
+
+void CCodeGen::SetCompileStats(CCompileStats* compileStats)
+{
+	m_compileStats = compileStats;
+}
+
+uint32 CCodeGen::MakeConfigurationKey(CONFIGURATION_BACKEND backend, uint32 options)
+{
+	assert(options < 0x1000000);
+	return (static_cast<uint32>(backend) << 24) | options;
+}
+
+CAssemblerStats* CCodeGen::BeginAssemblerStats()
+{
+	if(!m_compileStats) return nullptr;
+	m_assemblerStats.Reset();
+	return &m_assemblerStats;
+}
+
+void CCodeGen::EndAssemblerStats()
+{
+	if(!m_compileStats) return;
+	m_compileStats->RecordCode(m_assemblerStats);
+}
+
+CAssemblerStats::CATEGORY CCodeGen::GetStatementStatsCategory(const STATEMENT& statement)
+{
+	//Moves between a register and a memory location are what the register allocator
+	//inserts to load and spill values
+	if(statement.op != OP_MOV) return CAssemblerStats::CATEGORY_CODE;
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+	bool srcIsMemory = src1->IsRelative() || src1->IsTemporary();
+	bool dstIsMemory = dst->IsRelative() || dst->IsTemporary();
+	if(dst->IsRegister() && srcIsMemory) return CAssemblerStats::CATEGORY_RELOAD;
+	if(dstIsMemory && src1->IsRegister()) return CAssemblerStats::CATEGORY_SPILL;
+	return CAssemblerStats::CATEGORY_CODE;
+}
+
+void CCodeGen::InsertMatcher(const MATCHER& matcher)
+{
+	assert(matcher.op < OP_MAX);
+	assert(matcher.emitter != nullptr);
+	m_matchers.insert(MatcherMapType::value_type(matcher.op, matcher));
+	//Tables will be rebuilt on next lookup
+	m_matcherTables.clear();
+}
+
+void CCodeGen::SetMatcherTableEnabled(bool matcherTableEnabled)
+{
+	m_matcherTableEnabled = matcherTableEnabled;
+}
+
+CCodeGen::CodeEmitterType CCodeGen::FindEmitter(const STATEMENT& statement)
+{
+	if(!m_matcherTableEnabled)
+	{
+		return FindEmitterLinear(statement);
+	}
+	if(m_matcherTables.empty())
+	{
+		BuildMatcherTables();
+	}
+	assert(statement.op < OP_MAX);
+	const auto& table = m_matcherTables[statement.op];
+	if(table.emitters.empty()) return nullptr;
+	uint32 index =
+		(table.classGroups[0][GetOperandClass(statement.dst)]  * table.strides[0]) +
+		(table.classGroups[1][GetOperandClass(statement.src1)] * table.strides[1]) +
+		(table.classGroups[2][GetOperandClass(statement.src2)] * table.strides[2]) +
+		(table.classGroups[3][GetOperandClass(statement.src3)] * table.strides[3]);
+	return table.emitters[index];
+}
+
+CCodeGen::CodeEmitterType CCodeGen::FindEmitterLinear(const STATEMENT& statement) const
+{
+	auto dstClass = GetOperandClass(statement.dst);
+	auto src1Class = GetOperandClass(statement.src1);
+	auto src2Class = GetOperandClass(statement.src2);
+	auto src3Class = GetOperandClass(statement.src3);
+	auto matcherRange = m_matchers.equal_range(statement.op);
+	for(auto matcherIterator = matcherRange.first; matcherIterator != matcherRange.second; matcherIterator++)
+	{
+		const auto& matcher = matcherIterator->second;
+		if(!OperandClassMatches(matcher.dstType, dstClass)) continue;
+		if(!OperandClassMatches(matcher.src1Type, src1Class)) continue;
+		if(!OperandClassMatches(matcher.src2Type, src2Class)) continue;
+		if(!OperandClassMatches(matcher.src3Type, src3Class)) continue;
+		return matcher.emitter;
+	}
+	return nullptr;
+}
+
+void CCodeGen::BuildMatcherTables()
+{
+	typedef std::vector<bool> MatchSignature;
+	typedef std::vector<MatchSignature> MatchSignatureArray;
+
+	m_matcherTables.clear();
+	m_matcherTables.resize(OP_MAX);
+
+	for(unsigned int op = 0; op < OP_MAX; op++)
+	{
+		//Candidates, in insertion order (first one that matches wins)
+		std::vector<const MATCHER*> matchers;
+		auto matcherRange = m_matchers.equal_range(static_cast<OPERATION>(op));
+		for(auto matcherIterator = matcherRange.first; matcherIterator != matcherRange.second; matcherIterator++)
+		{
+			matchers.push_back(&matcherIterator->second);
+		}
+		if(matchers.empty()) continue;
+
+		auto getMatchType =
+			[](const MATCHER& matcher, unsigned int operand)
+			{
+				switch(operand)
+				{
+				default:
+					assert(false);
+				case 0:
+					return matcher.dstType;
+				case 1:
+					return matcher.src1Type;
+				case 2:
+					return matcher.src2Type;
+				case 3:
+					return matcher.src3Type;
+				}
+			};
+
+		auto& table = m_matcherTables[op];
+		std::array<MatchSignatureArray, OPERAND_COUNT> groupSignatures;
+		uint32 tableSize = 1;
+		for(unsigned int operand = OPERAND_COUNT; operand-- > 0;)
+		{
+			//Operand classes for which every candidate gives the same answer share a group
+			auto& signatures = groupSignatures[operand];
+			for(uint8 operandClass = 0; operandClass < OPERAND_CLASS_COUNT; operandClass++)
+			{
+				MatchSignature signature(matchers.size());
+				for(unsigned int i = 0; i < matchers.size(); i++)
+				{
+					signature[i] = OperandClassMatches(getMatchType(*matchers[i], operand), operandClass);
+				}
+				auto signatureIterator = std::find(signatures.begin(), signatures.end(), signature);
+				if(signatureIterator == signatures.end())
+				{
+					signatureIterator = signatures.insert(signatures.end(), std::move(signature));
+				}
+				table.classGroups[operand][operandClass] = static_cast<uint8>(signatureIterator - signatures.begin());
+			}
+			table.strides[operand] = tableSize;
+			tableSize *= static_cast<uint32>(signatures.size());
+		}
+
+		table.emitters.resize(tableSize, nullptr);
+		for(uint32 index = 0; index < tableSize; index++)
+		{
+			for(unsigned int i = 0; i < matchers.size(); i++)
+			{
+				bool matches = true;
+				for(unsigned int operand = 0; operand < OPERAND_COUNT; operand++)
+				{
+					const auto& signatures = groupSignatures[operand];
+					uint32 group = (index / table.strides[operand]) % signatures.size();
+					if(!signatures[group][i])
+					{
+						matches = false;
+						break;
+					}
+				}
+				if(matches)
+				{
+					table.emitters[index] = matchers[i]->emitter;
+					break;
+				}
+			}
+		}
+	}
+}
+
+uint8 CCodeGen::GetOperandClass(const SymbolRefPtr& symbolRef)
+{
+	if(!symbolRef) return OPERAND_CLASS_NIL;
+	return static_cast<uint8>(symbolRef->GetSymbol()->m_type + 1);
+}
+
+bool CCodeGen::OperandClassMatches(MATCHTYPE match, uint8 operandClass)
 {
 	if(match == MATCH_ANY) return true;
-	if(match == MATCH_NIL) { if(!symbolRef) return true; else return false; }
-	CSymbol* symbol = symbolRef->GetSymbol().get();
+	if(match == MATCH_NIL) return (operandClass == OPERAND_CLASS_NIL);
+	if(operandClass == OPERAND_CLASS_NIL) return false;
+	return SymbolTypeMatches(match, static_cast<SYM_TYPE>(operandClass - 1));
+}
+
+bool CCodeGen::SymbolTypeMatches(MATCHTYPE match, SYM_TYPE symbolType)
+{
 	switch(match)
 	{
 	case MATCH_RELATIVE:
-		return (symbol->m_type == SYM_RELATIVE);
+		return (symbolType == SYM_RELATIVE);
 	case MATCH_CONSTANT:
-		return (symbol->m_type == SYM_CONSTANT);
+		return (symbolType == SYM_CONSTANT);
 	case MATCH_CONSTANTPTR:
-		return (symbol->m_type == SYM_CONSTANTPTR);
+		return (symbolType == SYM_CONSTANTPTR);
 	case MATCH_REGISTER:
-		return (symbol->m_type == SYM_REGISTER);
+		return (symbolType == SYM_REGISTER);
 	case MATCH_TEMPORARY:
-		return (symbol->m_type == SYM_TEMPORARY);
+		return (symbolType == SYM_TEMPORARY);
 	case MATCH_MEMORY:
-		return (symbol->m_type == SYM_RELATIVE) || (symbol->m_type == SYM_TEMPORARY);
+		return (symbolType == SYM_RELATIVE) || (symbolType == SYM_TEMPORARY);
 	case MATCH_VARIABLE:
-		return (symbol->m_type == SYM_REGISTER) || (symbol->m_type == SYM_RELATIVE) || (symbol->m_type == SYM_TEMPORARY);
+		return (symbolType == SYM_REGISTER) || (symbolType == SYM_RELATIVE) || (symbolType == SYM_TEMPORARY);
 
 	case MATCH_REL_REF:
-		return (symbol->m_type == SYM_REL_REFERENCE);
+		return (symbolType == SYM_REL_REFERENCE);
 		break;
 	case MATCH_REG_REF:
-		return (symbol->m_type == SYM_REG_REFERENCE);
+		return (symbolType == SYM_REG_REFERENCE);
 		break;
 	case MATCH_TMP_REF:
-		return (symbol->m_type == SYM_TMP_REFERENCE);
+		return (symbolType == SYM_TMP_REFERENCE);
 		break;
 	case MATCH_MEM_REF:
-		return (symbol->m_type == SYM_REL_REFERENCE) || (symbol->m_type == SYM_TMP_REFERENCE);
+		return (symbolType == SYM_REL_REFERENCE) || (symbolType == SYM_TMP_REFERENCE);
 		break;
 	case MATCH_VAR_REF:
-		return (symbol->m_type == SYM_REG_REFERENCE) || (symbol->m_type == SYM_REL_REFERENCE) || (symbol->m_type == SYM_TMP_REFERENCE);
+		return (symbolType == SYM_REG_REFERENCE) || (symbolType == SYM_REL_REFERENCE) || (symbolType == SYM_TMP_REFERENCE);
 		break;
 
 	case MATCH_RELATIVE64:
-		return (symbol->m_type == SYM_RELATIVE64);
+		return (symbolType == SYM_RELATIVE64);
 	case MATCH_TEMPORARY64:
-		return (symbol->m_type == SYM_TEMPORARY64);
+		return (symbolType == SYM_TEMPORARY64);
 	case MATCH_CONSTANT64:
-		return (symbol->m_type == SYM_CONSTANT64);
+		return (symbolType == SYM_CONSTANT64);
 	case MATCH_MEMORY64:
-		return (symbol->m_type == SYM_RELATIVE64) || (symbol->m_type == SYM_TEMPORARY64);
+		return (symbolType == SYM_RELATIVE64) || (symbolType == SYM_TEMPORARY64);
 
 	case MATCH_RELATIVE_FP_SINGLE:
-		return (symbol->m_type == SYM_FP_REL_SINGLE);
+		return (symbolType == SYM_FP_REL_SINGLE);
 	case MATCH_TEMPORARY_FP_SINGLE:
-		return (symbol->m_type == SYM_FP_TMP_SINGLE);
+		return (symbolType == SYM_FP_TMP_SINGLE);
 	case MATCH_MEMORY_FP_SINGLE:
-		return (symbol->m_type == SYM_FP_REL_SINGLE) || (symbol->m_type == SYM_FP_TMP_SINGLE);
+		return (symbolType == SYM_FP_REL_SINGLE) || (symbolType == SYM_FP_TMP_SINGLE);
+	case MATCH_REGISTER_FP_SINGLE:
+		return (symbolType == SYM_FP_REG_SINGLE);
+	case MATCH_VARIABLE_FP_SINGLE:
+		return (symbolType == SYM_FP_REG_SINGLE) || (symbolType == SYM_FP_REL_SINGLE) || (symbolType == SYM_FP_TMP_SINGLE);
 
 	case MATCH_RELATIVE_FP_INT32:
-		return (symbol->m_type == SYM_FP_REL_INT32);
+		return (symbolType == SYM_FP_REL_INT32);
 
 	case MATCH_REGISTER128:
-		return (symbol->m_type == SYM_REGISTER128);
+		return (symbolType == SYM_REGISTER128);
 	case MATCH_RELATIVE128:
-		return (symbol->m_type == SYM_RELATIVE128);
+		return (symbolType == SYM_RELATIVE128);
 	case MATCH_TEMPORARY128:
-		return (symbol->m_type == SYM_TEMPORARY128);
+		return (symbolType == SYM_TEMPORARY128);
 	case MATCH_MEMORY128:
-		return (symbol->m_type == SYM_RELATIVE128) || (symbol->m_type == SYM_TEMPORARY128);
+		return (symbolType == SYM_RELATIVE128) || (symbolType == SYM_TEMPORARY128);
 	case MATCH_VARIABLE128:
-		return (symbol->m_type == SYM_REGISTER128) || (symbol->m_type == SYM_RELATIVE128) || (symbol->m_type == SYM_TEMPORARY128);
+		return (symbolType == SYM_REGISTER128) || (symbolType == SYM_RELATIVE128) || (symbolType == SYM_TEMPORARY128);
 
 	case MATCH_MEMORY256:
-		return (symbol->m_type == SYM_TEMPORARY256);
+		return (symbolType == SYM_TEMPORARY256);
 		
 	case MATCH_CONTEXT:
-		return (symbol->m_type == SYM_CONTEXT);
+		return (symbolType == SYM_CONTEXT);
 	}
 	return false;
 }
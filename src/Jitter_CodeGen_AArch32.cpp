@@ -1,5 +1,7 @@
 #include <stdexcept>
+#include <algorithm>
 #include "Jitter_CodeGen_AArch32.h"
+#include "Jitter_CompileStats.h"
 #include "ObjectFile.h"
 #include "BitManip.h"
 #ifdef __ANDROID__
@@ -8,12 +10,13 @@
 
 using namespace Jitter;
 
-CAArch32Assembler::REGISTER CCodeGen_AArch32::g_baseRegister = CAArch32Assembler::r11;
-CAArch32Assembler::REGISTER CCodeGen_AArch32::g_callAddressRegister = CAArch32Assembler::r4;
-CAArch32Assembler::REGISTER CCodeGen_AArch32::g_tempParamRegister0 = CAArch32Assembler::r4;
-CAArch32Assembler::REGISTER CCodeGen_AArch32::g_tempParamRegister1 = CAArch32Assembler::r5;
+const CAArch32Assembler::REGISTER CCodeGen_AArch32::g_baseRegister = CAArch32Assembler::r11;
+const CAArch32Assembler::REGISTER CCodeGen_AArch32::g_callAddressRegister = CAArch32Assembler::r4;
+const CAArch32Assembler::REGISTER CCodeGen_AArch32::g_tempParamRegister0 = CAArch32Assembler::r4;
+const CAArch32Assembler::REGISTER CCodeGen_AArch32::g_tempParamRegister1 = CAArch32Assembler::r5;
+const CAArch32Assembler::REGISTER CCodeGen_AArch32::g_mdAddressRegister = CAArch32Assembler::rIP;
 
-CAArch32Assembler::REGISTER CCodeGen_AArch32::g_registers[MAX_REGISTERS] =
+const CAArch32Assembler::REGISTER CCodeGen_AArch32::g_registers[MAX_REGISTERS] =
 {
 	CAArch32Assembler::r4,
 	CAArch32Assembler::r5,
@@ -23,7 +26,20 @@ CAArch32Assembler::REGISTER CCodeGen_AArch32::g_registers[MAX_REGISTERS] =
 	CAArch32Assembler::r10,
 };
 
-CAArch32Assembler::REGISTER CCodeGen_AArch32::g_paramRegs[MAX_PARAM_REGS] =
+//q8-q15 don't overlap with single precision FPU registers and don't need to be saved
+const CAArch32Assembler::QUAD_REGISTER CCodeGen_AArch32::g_registersMd[MAX_MDREGISTERS] =
+{
+	CAArch32Assembler::q8,
+	CAArch32Assembler::q9,
+	CAArch32Assembler::q10,
+	CAArch32Assembler::q11,
+	CAArch32Assembler::q12,
+	CAArch32Assembler::q13,
+	CAArch32Assembler::q14,
+	CAArch32Assembler::q15,
+};
+
+const CAArch32Assembler::REGISTER CCodeGen_AArch32::g_paramRegs[MAX_PARAM_REGS] =
 {
 	CAArch32Assembler::r0,
 	CAArch32Assembler::r1,
@@ -134,7 +150,7 @@ void CCodeGen_AArch32::Emit_Shift_Generic(const STATEMENT& statement)
 	CommitSymbolRegister(dst, dstReg);
 }
 
-CCodeGen_AArch32::CONSTMATCHER CCodeGen_AArch32::g_constMatchers[] = 
+const CCodeGen_AArch32::CONSTMATCHER CCodeGen_AArch32::g_constMatchers[] = 
 { 
 	{ OP_LABEL, MATCH_NIL,    MATCH_NIL, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::MarkLabel },
 
@@ -167,6 +183,7 @@ CCodeGen_AArch32::CONSTMATCHER CCodeGen_AArch32::g_constMatchers[] =
 	{ OP_PARAM, MATCH_NIL, MATCH_CONSTANT,   MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Param_Cst    },
 	{ OP_PARAM, MATCH_NIL, MATCH_MEMORY64,   MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Param_Mem64  },
 	{ OP_PARAM, MATCH_NIL, MATCH_CONSTANT64, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Param_Cst64  },
+	{ OP_PARAM, MATCH_NIL, MATCH_REGISTER128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Param_Reg128 },
 	{ OP_PARAM, MATCH_NIL, MATCH_MEMORY128,  MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Param_Mem128 },
 
 	{ OP_PARAM_RET, MATCH_NIL, MATCH_TEMPORARY128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_ParamRet_Tmp128 },
@@ -180,6 +197,10 @@ CCodeGen_AArch32::CONSTMATCHER CCodeGen_AArch32::g_constMatchers[] =
 	{ OP_EXTERNJMP,     MATCH_NIL, MATCH_CONSTANTPTR, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_ExternJmp        },
 	{ OP_EXTERNJMP_DYN, MATCH_NIL, MATCH_CONSTANTPTR, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_ExternJmpDynamic },
 
+	{ OP_LOOKUP, MATCH_NIL, MATCH_ANY, MATCH_CONSTANTPTR, MATCH_CONSTANT, &CCodeGen_AArch32::Emit_Lookup },
+
+	{ OP_INCCOUNTER, MATCH_NIL, MATCH_CONSTANTPTR, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_IncCounter },
+
 	{ OP_JMP, MATCH_NIL, MATCH_NIL, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Jmp },
 
 	{ OP_CONDJMP, MATCH_NIL, MATCH_VARIABLE, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_CondJmp_VarCst     },
@@ -257,7 +278,7 @@ unsigned int CCodeGen_AArch32::GetAvailableRegisterCount() const
 
 unsigned int CCodeGen_AArch32::GetAvailableMdRegisterCount() const
 {
-	return 0;
+	return MAX_MDREGISTERS;
 }
 
 bool CCodeGen_AArch32::CanHold128BitsReturnValueInRegisters() const
@@ -265,11 +286,43 @@ bool CCodeGen_AArch32::CanHold128BitsReturnValueInRegisters() const
 	return false;
 }
 
+bool CCodeGen_AArch32::CanHoldFpSingleInMdRegisters() const
+{
+	//Q8-Q15 overlap D16-D31 which have no single precision view
+	return false;
+}
+
+uint32 CCodeGen_AArch32::GetCallPreservedRegisterMask() const
+{
+	//Registers are callee-saved, but Emit_Call uses r4 and r5 to hold the call address and parameters
+	uint32 result = 0;
+	for(unsigned int i = 0; i < MAX_REGISTERS; i++)
+	{
+		if(g_registers[i] == g_callAddressRegister) continue;
+		if(g_registers[i] == g_tempParamRegister0) continue;
+		if(g_registers[i] == g_tempParamRegister1) continue;
+		result |= (1 << i);
+	}
+	return result;
+}
+
+uint32 CCodeGen_AArch32::GetCallPreservedMdRegisterMask() const
+{
+	return 0;
+}
+
 uint32 CCodeGen_AArch32::GetPointerSize() const
 {
 	return 4;
 }
 
+uint32 CCodeGen_AArch32::GetConfigurationKey() const
+{
+	uint32 options = static_cast<uint32>(m_platformAbi);
+	if(m_hasIntegerDiv) options |= 0x100;
+	return MakeConfigurationKey(CONFIGURATION_BACKEND_AARCH32, options);
+}
+
 void CCodeGen_AArch32::SetStream(Framework::CStream* stream)
 {
 	m_stream = stream;
@@ -287,42 +340,40 @@ void CCodeGen_AArch32::RegisterExternalSymbols(CObjectFile* objectFile) const
 void CCodeGen_AArch32::GenerateCode(const StatementList& statements, unsigned int stackSize)
 {
 	//Align stack size (must be aligned on 16 bytes boundary)
-	m_stackSize = (stackSize + 0xF) & ~0xF;
+	m_paramSpillBase = (stackSize + 0xF) & ~0xF;
+	m_stackSize = m_paramSpillBase + GetMaxParamSpillSize(statements);
 
 	m_registerSave = GetSavedRegisterList(GetRegisterUsage(statements));
 
+	m_assembler.SetStats(BeginAssemblerStats());
+	m_assembler.BeginStatsRegion(CAssemblerStats::CATEGORY_PROLOG);
 	Emit_Prolog();
 
 	for(const auto& statement : statements)
 	{
-		bool found = false;
-		auto begin = m_matchers.lower_bound(statement.op);
-		auto end = m_matchers.upper_bound(statement.op);
-
-		for(auto matchIterator(begin); matchIterator != end; matchIterator++)
-		{
-			const MATCHER& matcher(matchIterator->second);
-			if(!SymbolMatches(matcher.dstType, statement.dst)) continue;
-			if(!SymbolMatches(matcher.src1Type, statement.src1)) continue;
-			if(!SymbolMatches(matcher.src2Type, statement.src2)) continue;
-			if(!SymbolMatches(matcher.src3Type, statement.src3)) continue;
-			matcher.emitter(statement);
-			found = true;
-			break;
-		}
-		//assert(found);
-		if(!found)
+		auto emitter = FindEmitter(statement);
+		//assert(emitter);
+		if(!emitter)
 		{
 			throw std::runtime_error("No suitable emitter found for statement.");
 		}
+		m_assembler.BeginStatsRegion(GetStatementStatsCategory(statement), statement.op);
+		(this->*emitter)(statement);
 	}
 
+	m_assembler.BeginStatsRegion(CAssemblerStats::CATEGORY_EPILOG);
 	Emit_Epilog();
 	m_assembler.Bx(CAArch32Assembler::rLR);
+	m_assembler.EndStatsRegion();
 
-	m_assembler.ResolveLabelReferences();
-	m_assembler.ClearLabels();
-	m_assembler.ResolveLiteralReferences();
+	{
+		CCompileStats::CPassScope passScope(m_compileStats, CCompileStats::PASS_ASSEMBLEREND);
+		m_assembler.ResolveLabelReferences();
+		m_assembler.ClearLabels();
+		m_assembler.ResolveLiteralReferences();
+	}
+	m_assembler.SetStats(nullptr);
+	EndAssemblerStats();
 	m_labels.clear();
 }
 
@@ -336,8 +387,8 @@ void CCodeGen_AArch32::InsertMatchers(const CONSTMATCHER* constMatchers)
 		matcher.src1Type = constMatcher->src1Type;
 		matcher.src2Type = constMatcher->src2Type;
 		matcher.src3Type = constMatcher->src3Type;
-		matcher.emitter  = std::bind(constMatcher->emitter, this, std::placeholders::_1);
-		m_matchers.insert(MatcherMapType::value_type(matcher.op, matcher));
+		matcher.emitter  = static_cast<CodeEmitterType>(constMatcher->emitter);
+		InsertMatcher(matcher);
 	}
 }
 
@@ -359,6 +410,34 @@ uint16 CCodeGen_AArch32::GetSavedRegisterList(uint32 registerUsage)
 	return registerSave;
 }
 
+uint32 CCodeGen_AArch32::GetMaxParamSpillSize(const StatementList& statements)
+{
+	uint32 maxParamSpillSize = 0;
+	uint32 currParamSpillSize = 0;
+	for(const auto& statement : statements)
+	{
+		switch(statement.op)
+		{
+		case OP_PARAM:
+			{
+				CSymbol* src1 = statement.src1->GetSymbol().get();
+				if(src1->m_type == SYM_REGISTER128)
+				{
+					currParamSpillSize += 16;
+				}
+			}
+			break;
+		case OP_CALL:
+			maxParamSpillSize = std::max<uint32>(currParamSpillSize, maxParamSpillSize);
+			currParamSpillSize = 0;
+			break;
+		default:
+			break;
+		}
+	}
+	return maxParamSpillSize;
+}
+
 void CCodeGen_AArch32::Emit_Prolog()
 {
 	m_assembler.Stmdb(CAArch32Assembler::rSP, m_registerSave);
@@ -913,6 +992,33 @@ void CCodeGen_AArch32::Emit_Param_Cst64(const STATEMENT& statement)
 	);
 }
 
+void CCodeGen_AArch32::Emit_Param_Reg128(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+
+	m_params.push_back(
+		[this, src1] (PARAM_STATE& paramState)
+		{
+			auto paramReg = PrepareParam(paramState);
+			uint32 paramBase = m_paramSpillBase + paramState.spillOffset + m_stackLevel;
+			uint8 immediate = 0;
+			uint8 shiftAmount = 0;
+			if(TryGetAluImmediateParams(paramBase, immediate, shiftAmount))
+			{
+				m_assembler.Add(paramReg, CAArch32Assembler::rSP, CAArch32Assembler::MakeImmediateAluOperand(immediate, shiftAmount));
+			}
+			else
+			{
+				LoadConstantInRegister(paramReg, paramBase);
+				m_assembler.Add(paramReg, CAArch32Assembler::rSP, paramReg);
+			}
+			m_assembler.Vst1_32x4(g_registersMd[src1->m_valueLow], paramReg);
+			paramState.spillOffset += 0x10;
+			CommitParam(paramState);
+		}
+	);
+}
+
 void CCodeGen_AArch32::Emit_Param_Mem128(const STATEMENT& statement)
 {
 	auto src1 = statement.src1->GetSymbol().get();
@@ -1018,6 +1124,13 @@ void CCodeGen_AArch32::Emit_ExternJmpDynamic(const STATEMENT& statement)
 	m_assembler.Mov(CAArch32Assembler::r0, g_baseRegister);
 	Emit_Epilog();
 
+	//Branches to the next instruction until the exit is linked to its target by CMemoryFunction::LinkExit
+	if(m_dynamicExitHandler)
+	{
+		m_dynamicExitHandler(static_cast<uint32>(m_stream->GetLength()));
+	}
+	m_assembler.B_offset(4);
+
 	m_assembler.Ldr_Pc(CAArch32Assembler::rPC, -4);
 
 	//Write target function address
@@ -1029,6 +1142,55 @@ void CCodeGen_AArch32::Emit_ExternJmpDynamic(const STATEMENT& statement)
 	m_stream->Write32(src1->GetConstantPtr());
 }
 
+void CCodeGen_AArch32::Emit_Lookup(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+	auto src2 = statement.src2->GetSymbol().get();
+	auto src3 = statement.src3->GetSymbol().get();
+
+	assert(src2->m_type == SYM_CONSTANTPTR);
+	assert(src3->m_type == SYM_CONSTANT);
+
+	//Epilog uses r3, code pointer needs to be in another register when jumping
+	auto missLabel = m_assembler.CreateLabel();
+	auto addressRegister = PrepareSymbolRegisterUse(src1, CAArch32Assembler::r1);
+	auto indexRegister = CAArch32Assembler::r2;
+	auto entryRegister = CAArch32Assembler::r3;
+
+	//Entries are 8 bytes (tag, code pointer)
+	LoadConstantInRegister(indexRegister, src3->m_valueLow);
+	m_assembler.And(indexRegister, addressRegister, indexRegister);
+	m_assembler.Mov(indexRegister, CAArch32Assembler::MakeRegisterAluOperand(indexRegister, CAArch32Assembler::MakeConstantShift(CAArch32Assembler::SHIFT_LSL, 3)));
+	LoadConstantPtrInRegister(entryRegister, src2->GetConstantPtr());
+	m_assembler.Add(entryRegister, entryRegister, indexRegister);
+
+	m_assembler.Ldr(indexRegister, entryRegister, CAArch32Assembler::MakeImmediateLdrAddress(0));
+	m_assembler.Cmp(indexRegister, addressRegister);
+	m_assembler.BCc(CAArch32Assembler::CONDITION_NE, missLabel);
+
+	m_assembler.Ldr(indexRegister, entryRegister, CAArch32Assembler::MakeImmediateLdrAddress(4));
+	m_assembler.Mov(CAArch32Assembler::r0, g_baseRegister);
+	Emit_Epilog();
+	m_assembler.Mov(CAArch32Assembler::rPC, indexRegister);
+
+	m_assembler.MarkLabel(missLabel);
+}
+
+void CCodeGen_AArch32::Emit_IncCounter(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+
+	assert(src1->m_type == SYM_CONSTANTPTR);
+
+	auto counterAddressRegister = CAArch32Assembler::r0;
+	auto counterRegister = CAArch32Assembler::r1;
+
+	LoadConstantPtrInRegister(counterAddressRegister, src1->GetConstantPtr());
+	m_assembler.Ldr(counterRegister, counterAddressRegister, CAArch32Assembler::MakeImmediateLdrAddress(0));
+	m_assembler.Add(counterRegister, counterRegister, CAArch32Assembler::MakeImmediateAluOperand(1, 0));
+	m_assembler.Str(counterRegister, counterAddressRegister, CAArch32Assembler::MakeImmediateLdrAddress(0));
+}
+
 void CCodeGen_AArch32::Emit_Mov_RegReg(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
@@ -871,7 +871,7 @@ void CCodeGen_AArch32::Emit_Cmp64_VarMemAny(const STATEMENT& statement)
 	}
 }
 
-CCodeGen_AArch32::CONSTMATCHER CCodeGen_AArch32::g_64ConstMatchers[] = 
+const CCodeGen_AArch32::CONSTMATCHER CCodeGen_AArch32::g_64ConstMatchers[] = 
 {
 	{ OP_EXTLOW64,  MATCH_VARIABLE, MATCH_MEMORY64, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_ExtLow64VarMem64  },
 	{ OP_EXTHIGH64, MATCH_VARIABLE, MATCH_MEMORY64, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_ExtHigh64VarMem64 },
@@ -1,4 +1,5 @@
 #include "Jitter_CodeGen_AArch32.h"
+#include <stdexcept>
 
 using namespace Jitter;
 
@@ -75,67 +76,141 @@ void CCodeGen_AArch32::LoadTemporary256ElementAddressInRegister(CAArch32Assemble
 	}
 }
 
+void CCodeGen_AArch32::LoadMemory128InRegister(CAArch32Assembler::QUAD_REGISTER dstReg, CSymbol* symbol)
+{
+	LoadMemory128AddressInRegister(g_mdAddressRegister, symbol);
+	m_assembler.Vld1_32x4(dstReg, g_mdAddressRegister);
+}
+
+void CCodeGen_AArch32::StoreRegisterInMemory128(CSymbol* symbol, CAArch32Assembler::QUAD_REGISTER srcReg)
+{
+	LoadMemory128AddressInRegister(g_mdAddressRegister, symbol);
+	m_assembler.Vst1_32x4(srcReg, g_mdAddressRegister);
+}
+
+CAArch32Assembler::QUAD_REGISTER CCodeGen_AArch32::PrepareSymbolRegisterDefMd(CSymbol* symbol, CAArch32Assembler::QUAD_REGISTER preferedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_REGISTER128:
+		assert(symbol->m_valueLow < MAX_MDREGISTERS);
+		return g_registersMd[symbol->m_valueLow];
+		break;
+	case SYM_TEMPORARY128:
+	case SYM_RELATIVE128:
+		return preferedRegister;
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+CAArch32Assembler::QUAD_REGISTER CCodeGen_AArch32::PrepareSymbolRegisterUseMd(CSymbol* symbol, CAArch32Assembler::QUAD_REGISTER preferedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_REGISTER128:
+		assert(symbol->m_valueLow < MAX_MDREGISTERS);
+		return g_registersMd[symbol->m_valueLow];
+		break;
+	case SYM_TEMPORARY128:
+	case SYM_RELATIVE128:
+		LoadMemory128InRegister(preferedRegister, symbol);
+		return preferedRegister;
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+void CCodeGen_AArch32::CommitSymbolRegisterMd(CSymbol* symbol, CAArch32Assembler::QUAD_REGISTER usedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_REGISTER128:
+		assert(usedRegister == g_registersMd[symbol->m_valueLow]);
+		break;
+	case SYM_TEMPORARY128:
+	case SYM_RELATIVE128:
+		StoreRegisterInMemory128(symbol, usedRegister);
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
 template <typename MDOP>
-void CCodeGen_AArch32::Emit_Md_MemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_VarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto dstReg = CAArch32Assembler::q0;
-	auto src1Reg = CAArch32Assembler::q1;
-
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, CAArch32Assembler::q1);
 
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
 	((m_assembler).*(MDOP::OpReg()))(dstReg, src1Reg);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
 template <typename MDOP>
-void CCodeGen_AArch32::Emit_Md_MemMemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto src2AddrReg = CAArch32Assembler::r2;
-	auto dstReg = CAArch32Assembler::q0;
-	auto src1Reg = CAArch32Assembler::q1;
-	auto src2Reg = CAArch32Assembler::q2;
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, CAArch32Assembler::q1);
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, CAArch32Assembler::q2);
 
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
-	LoadMemory128AddressInRegister(src2AddrReg, src2);
-
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
-	m_assembler.Vld1_32x4(src2Reg, src2AddrReg);
 	((m_assembler).*(MDOP::OpReg()))(dstReg, src1Reg, src2Reg);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
 template <typename MDSHIFTOP>
-void CCodeGen_AArch32::Emit_Md_Shift_MemMemCst(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_Shift_VarVarCst(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto dstReg = CAArch32Assembler::q0;
-	auto src1Reg = CAArch32Assembler::q1;
-
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, CAArch32Assembler::q1);
 
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
 	((m_assembler).*(MDSHIFTOP::OpReg()))(dstReg, src1Reg, src2->m_valueLow);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
+}
+
+void CCodeGen_AArch32::Emit_Md_Mov_RegReg(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	assert(!dst->Equals(src1));
+
+	m_assembler.Vorr(g_registersMd[dst->m_valueLow], g_registersMd[src1->m_valueLow], g_registersMd[src1->m_valueLow]);
+}
+
+void CCodeGen_AArch32::Emit_Md_Mov_RegMem(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	LoadMemory128InRegister(g_registersMd[dst->m_valueLow], src1);
+}
+
+void CCodeGen_AArch32::Emit_Md_Mov_MemReg(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	StoreRegisterInMemory128(dst, g_registersMd[src1->m_valueLow]);
 }
 
 void CCodeGen_AArch32::Emit_Md_Mov_MemMem(const STATEMENT& statement)
@@ -152,64 +227,62 @@ void CCodeGen_AArch32::Emit_Md_Mov_MemMem(const STATEMENT& statement)
 	m_assembler.Vst1_32x4(tmpReg, dstAddrReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_DivS_MemMemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_DivS_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto src2AddrReg = CAArch32Assembler::r2;
-	auto dstReg = CAArch32Assembler::q0;
-	auto src1Reg = CAArch32Assembler::q1;
-	auto src2Reg = CAArch32Assembler::q2;
-
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
-	LoadMemory128AddressInRegister(src2AddrReg, src2);
+	//Single precision registers only alias q0-q7, allocated registers need to be copied
+	auto resultReg = CAArch32Assembler::q0;
+	auto tmpSrc1Reg = CAArch32Assembler::q1;
+	auto tmpSrc2Reg = CAArch32Assembler::q2;
 
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
-	m_assembler.Vld1_32x4(src2Reg, src2AddrReg);
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, tmpSrc1Reg);
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, tmpSrc2Reg);
+	if(src1Reg != tmpSrc1Reg)
+	{
+		m_assembler.Vorr(tmpSrc1Reg, src1Reg, src1Reg);
+	}
+	if(src2Reg != tmpSrc2Reg)
+	{
+		m_assembler.Vorr(tmpSrc2Reg, src2Reg, src2Reg);
+	}
 
 	//No vector floating point divide on NEON, gotta do it 4x
 	for(unsigned int i = 0; i < 4; i++)
 	{
-		auto subDstReg = static_cast<CAArch32Assembler::SINGLE_REGISTER>(dstReg * 2 + i);
-		auto subSrc1Reg = static_cast<CAArch32Assembler::SINGLE_REGISTER>(src1Reg * 2 + i);
-		auto subSrc2Reg = static_cast<CAArch32Assembler::SINGLE_REGISTER>(src2Reg * 2 + i);
+		auto subDstReg = static_cast<CAArch32Assembler::SINGLE_REGISTER>(resultReg * 2 + i);
+		auto subSrc1Reg = static_cast<CAArch32Assembler::SINGLE_REGISTER>(tmpSrc1Reg * 2 + i);
+		auto subSrc2Reg = static_cast<CAArch32Assembler::SINGLE_REGISTER>(tmpSrc2Reg * 2 + i);
 		m_assembler.Vdiv_F32(subDstReg, subSrc1Reg, subSrc2Reg);
 	}
 
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, resultReg);
+	if(dstReg != resultReg)
+	{
+		m_assembler.Vorr(dstReg, resultReg, resultReg);
+	}
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_CmpLtS_MemMemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_CmpLtS_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto src2AddrReg = CAArch32Assembler::r2;
-
-	auto dstReg = CAArch32Assembler::q0;
-	auto src1Reg = CAArch32Assembler::q1;
-	auto src2Reg = CAArch32Assembler::q2;
-
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
-	LoadMemory128AddressInRegister(src2AddrReg, src2);
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, CAArch32Assembler::q1);
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, CAArch32Assembler::q2);
 
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
-	m_assembler.Vld1_32x4(src2Reg, src2AddrReg);
 	m_assembler.Vcge_F32(dstReg, src1Reg, src2Reg);
 	m_assembler.Vmvn(dstReg, dstReg);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_Srl256_MemMemCst(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_Srl256_VarMemCst(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
@@ -218,20 +291,19 @@ void CCodeGen_AArch32::Emit_Md_Srl256_MemMemCst(const STATEMENT& statement)
 	assert(src1->m_type == SYM_TEMPORARY256);
 	assert(src2->m_type == SYM_CONSTANT);
 
-	auto dstAddrReg = CAArch32Assembler::r0;
 	auto src1AddrReg = CAArch32Assembler::r1;
-	auto dstReg = CAArch32Assembler::q0;
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
 
 	uint32 offset = (src2->m_valueLow & 0x7F) / 8;
 
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
 	LoadTemporary256ElementAddressInRegister(src1AddrReg, src1, offset);
 
 	m_assembler.Vld1_32x4_u(dstReg, src1AddrReg);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_Srl256_MemMemVar(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_Srl256_VarMemVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
@@ -240,15 +312,13 @@ void CCodeGen_AArch32::Emit_Md_Srl256_MemMemVar(const STATEMENT& statement)
 	assert(src1->m_type == SYM_TEMPORARY256);
 
 	auto offsetRegister = CAArch32Assembler::r0;
-	auto dstAddrReg = CAArch32Assembler::r1;
 	auto src1AddrReg = CAArch32Assembler::r2;
 	auto src2Register = PrepareSymbolRegisterUse(src2, CAArch32Assembler::r3);
 
-	auto dstReg = CAArch32Assembler::q0;
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
 
 	auto offsetShift = CAArch32Assembler::MakeConstantShift(CAArch32Assembler::SHIFT_LSR, 3);
 
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
 	LoadTemporary256ElementAddressInRegister(src1AddrReg, src1, 0);
 
 	//Compute offset and modify address
@@ -257,42 +327,35 @@ void CCodeGen_AArch32::Emit_Md_Srl256_MemMemVar(const STATEMENT& statement)
 	m_assembler.Add(src1AddrReg, src1AddrReg, offsetRegister);
 
 	m_assembler.Vld1_32x4_u(dstReg, src1AddrReg);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_LoadFromRef_MemVar(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_LoadFromRef_VarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
 	auto src1AddrReg = PrepareSymbolRegisterUseRef(src1, CAArch32Assembler::r0);
-	auto dstAddrReg = CAArch32Assembler::r1;
-
-	auto dstReg = CAArch32Assembler::q0;
-
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
 
 	m_assembler.Vld1_32x4(dstReg, src1AddrReg);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_StoreAtRef_VarMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_StoreAtRef_VarVar(const STATEMENT& statement)
 {
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
 	auto src1AddrReg = PrepareSymbolRegisterUseRef(src1, CAArch32Assembler::r0);
-	auto src2AddrReg = CAArch32Assembler::r1;
-
-	auto src2Reg = CAArch32Assembler::q0;
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, CAArch32Assembler::q0);
 
-	LoadMemory128AddressInRegister(src2AddrReg, src2);
-
-	m_assembler.Vld1_32x4(src2Reg, src2AddrReg);
 	m_assembler.Vst1_32x4(src2Reg, src1AddrReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_MovMasked_MemMemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_MovMasked_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
@@ -302,21 +365,14 @@ void CCodeGen_AArch32::Emit_Md_MovMasked_MemMemMem(const STATEMENT& statement)
 
 	auto mask = static_cast<uint8>(statement.jmpCondition);
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src2AddrReg = CAArch32Assembler::r2;
 	auto tmpReg = CAArch32Assembler::r3;
-	auto dstReg = CAArch32Assembler::q0;
-	auto src2Reg = CAArch32Assembler::q2;
+	auto dstReg = PrepareSymbolRegisterUseMd(dst, CAArch32Assembler::q0);
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, CAArch32Assembler::q2);
 	auto dstRegLo = static_cast<CAArch32Assembler::DOUBLE_REGISTER>(dstReg + 0);
 	auto dstRegHi = static_cast<CAArch32Assembler::DOUBLE_REGISTER>(dstReg + 1);
 	auto src2RegLo = static_cast<CAArch32Assembler::DOUBLE_REGISTER>(src2Reg + 0);
 	auto src2RegHi = static_cast<CAArch32Assembler::DOUBLE_REGISTER>(src2Reg + 1);
 
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src2AddrReg, src2);
-
-	m_assembler.Vld1_32x4(dstReg, dstAddrReg);
-	m_assembler.Vld1_32x4(src2Reg, src2AddrReg);
 	for(unsigned int i = 0; i < 4; i++)
 	{
 		if(mask & (1 << i))
@@ -326,53 +382,49 @@ void CCodeGen_AArch32::Emit_Md_MovMasked_MemMemMem(const STATEMENT& statement)
 		}
 	}
 
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_Expand_MemReg(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_Expand_VarReg(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto tmpReg = CAArch32Assembler::q0;
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
 
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
+	m_assembler.Vdup(dstReg, g_registers[src1->m_valueLow]);
 
-	m_assembler.Vdup(tmpReg, g_registers[src1->m_valueLow]);
-	m_assembler.Vst1_32x4(tmpReg, dstAddrReg);
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_Expand_MemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_Expand_VarMem(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
 	auto src1Reg = CAArch32Assembler::r1;
-	auto tmpReg = CAArch32Assembler::q0;
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
 
 	LoadMemoryInRegister(src1Reg, src1);
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
 
-	m_assembler.Vdup(tmpReg, src1Reg);
-	m_assembler.Vst1_32x4(tmpReg, dstAddrReg);
+	m_assembler.Vdup(dstReg, src1Reg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_Expand_MemCst(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_Expand_VarCst(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
 	auto src1Reg = CAArch32Assembler::r1;
-	auto tmpReg = CAArch32Assembler::q0;
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, CAArch32Assembler::q0);
 
 	LoadConstantInRegister(src1Reg, src1->m_valueLow);
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
 
-	m_assembler.Vdup(tmpReg, src1Reg);
-	m_assembler.Vst1_32x4(tmpReg, dstAddrReg);
+	m_assembler.Vdup(dstReg, src1Reg);
+
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
 void CCodeGen_AArch32::Emit_Md_MakeSz_VarVar(const STATEMENT& statement)
@@ -380,9 +432,7 @@ void CCodeGen_AArch32::Emit_Md_MakeSz_VarVar(const STATEMENT& statement)
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	
-	auto src1AddrReg = CAArch32Assembler::r0;
 	auto cstAddrReg = CAArch32Assembler::r1;
-	auto src1Reg = CAArch32Assembler::q0;
 	auto signReg = CAArch32Assembler::q1;
 	auto zeroReg = CAArch32Assembler::q2;
 	auto cstReg = CAArch32Assembler::q3;
@@ -390,8 +440,7 @@ void CCodeGen_AArch32::Emit_Md_MakeSz_VarVar(const STATEMENT& statement)
 	LITERAL128 lit1(0x0004080C1014181CUL, 0xFFFFFFFFFFFFFFFFUL);
 	LITERAL128 lit2(0x8040201008040201UL, 0x0000000000000000UL);
 
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, CAArch32Assembler::q0);
 	
 	auto dstReg = PrepareSymbolRegisterDef(dst, CAArch32Assembler::r0);
 	
@@ -415,127 +464,83 @@ void CCodeGen_AArch32::Emit_Md_MakeSz_VarVar(const STATEMENT& statement)
 	CommitSymbolRegister(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_PackHB_MemMemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_PackHB_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto src2AddrReg = CAArch32Assembler::r2;
-	auto dstReg = CAArch32Assembler::q0;
-	auto src1Reg = CAArch32Assembler::q1;
-	auto src2Reg = CAArch32Assembler::q2;
+	//Result is built in two steps, so it can't be written directly in a register that might be a source
+	auto resultReg = CAArch32Assembler::q0;
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, CAArch32Assembler::q1);
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, CAArch32Assembler::q2);
 
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
-	LoadMemory128AddressInRegister(src2AddrReg, src2);
+	m_assembler.Vmovn_I16(static_cast<CAArch32Assembler::DOUBLE_REGISTER>(resultReg + 1), src1Reg);
+	m_assembler.Vmovn_I16(static_cast<CAArch32Assembler::DOUBLE_REGISTER>(resultReg + 0), src2Reg);
 
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
-	m_assembler.Vld1_32x4(src2Reg, src2AddrReg);
-	m_assembler.Vmovn_I16(static_cast<CAArch32Assembler::DOUBLE_REGISTER>(dstReg + 1), src1Reg);
-	m_assembler.Vmovn_I16(static_cast<CAArch32Assembler::DOUBLE_REGISTER>(dstReg + 0), src2Reg);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, resultReg);
+	if(dstReg != resultReg)
+	{
+		m_assembler.Vorr(dstReg, resultReg, resultReg);
+	}
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_Md_PackWH_MemMemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_Md_PackWH_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto src2AddrReg = CAArch32Assembler::r2;
-	auto dstReg = CAArch32Assembler::q0;
-	auto src1Reg = CAArch32Assembler::q1;
-	auto src2Reg = CAArch32Assembler::q2;
+	//Result is built in two steps, so it can't be written directly in a register that might be a source
+	auto resultReg = CAArch32Assembler::q0;
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, CAArch32Assembler::q1);
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, CAArch32Assembler::q2);
 
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
-	LoadMemory128AddressInRegister(src2AddrReg, src2);
+	m_assembler.Vmovn_I32(static_cast<CAArch32Assembler::DOUBLE_REGISTER>(resultReg + 1), src1Reg);
+	m_assembler.Vmovn_I32(static_cast<CAArch32Assembler::DOUBLE_REGISTER>(resultReg + 0), src2Reg);
 
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
-	m_assembler.Vld1_32x4(src2Reg, src2AddrReg);
-	m_assembler.Vmovn_I32(static_cast<CAArch32Assembler::DOUBLE_REGISTER>(dstReg + 1), src1Reg);
-	m_assembler.Vmovn_I32(static_cast<CAArch32Assembler::DOUBLE_REGISTER>(dstReg + 0), src2Reg);
-	m_assembler.Vst1_32x4(dstReg, dstAddrReg);
-}
-
-template <uint32 offset>
-void CCodeGen_AArch32::Emit_Md_UnpackBH_MemMemMem(const STATEMENT& statement)
-{
-	auto dst = statement.dst->GetSymbol().get();
-	auto src1 = statement.src1->GetSymbol().get();
-	auto src2 = statement.src2->GetSymbol().get();
-
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto src2AddrReg = CAArch32Assembler::r2;
-	auto src1Reg = CAArch32Assembler::d0;
-	auto src2Reg = CAArch32Assembler::d1;
-
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1, offset);
-	LoadMemory128AddressInRegister(src2AddrReg, src2, offset);
-
-	//Warning: VZIP modifies both registers
-	m_assembler.Vld1_32x2(src1Reg, src2AddrReg);
-	m_assembler.Vld1_32x2(src2Reg, src1AddrReg);
-	m_assembler.Vzip_I8(src1Reg, src2Reg);
-	m_assembler.Vst1_32x4(static_cast<CAArch32Assembler::QUAD_REGISTER>(src1Reg), dstAddrReg);
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, resultReg);
+	if(dstReg != resultReg)
+	{
+		m_assembler.Vorr(dstReg, resultReg, resultReg);
+	}
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-template <uint32 offset>
-void CCodeGen_AArch32::Emit_Md_UnpackHW_MemMemMem(const STATEMENT& statement)
+template <typename MDOP, bool upper>
+void CCodeGen_AArch32::Emit_Md_Unpack_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto src2AddrReg = CAArch32Assembler::r2;
-	auto src1Reg = CAArch32Assembler::d0;
-	auto src2Reg = CAArch32Assembler::d1;
-
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1, offset);
-	LoadMemory128AddressInRegister(src2AddrReg, src2, offset);
-
-	//Warning: VZIP modifies both registers
-	m_assembler.Vld1_32x2(src1Reg, src2AddrReg);
-	m_assembler.Vld1_32x2(src2Reg, src1AddrReg);
-	m_assembler.Vzip_I16(src1Reg, src2Reg);
-	m_assembler.Vst1_32x4(static_cast<CAArch32Assembler::QUAD_REGISTER>(src1Reg), dstAddrReg);
-}
+	//Warning: VZIP modifies both registers, lower half of the result ends up in the first one
+	auto zipLoReg = CAArch32Assembler::q0;
+	auto zipHiReg = CAArch32Assembler::q1;
 
-template <uint32 offset>
-void CCodeGen_AArch32::Emit_Md_UnpackWD_MemMemMem(const STATEMENT& statement)
-{
-	auto dst = statement.dst->GetSymbol().get();
-	auto src1 = statement.src1->GetSymbol().get();
-	auto src2 = statement.src2->GetSymbol().get();
-
-	auto dstAddrReg = CAArch32Assembler::r0;
-	auto src1AddrReg = CAArch32Assembler::r1;
-	auto src2AddrReg = CAArch32Assembler::r2;
-	auto src1Reg = CAArch32Assembler::d0;
-	auto src2Reg = CAArch32Assembler::d2;
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, zipHiReg);
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, zipLoReg);
+	if(src1Reg != zipHiReg)
+	{
+		m_assembler.Vorr(zipHiReg, src1Reg, src1Reg);
+	}
+	if(src2Reg != zipLoReg)
+	{
+		m_assembler.Vorr(zipLoReg, src2Reg, src2Reg);
+	}
+	((m_assembler).*(MDOP::OpReg()))(zipLoReg, zipHiReg);
 
-	LoadMemory128AddressInRegister(dstAddrReg, dst);
-	LoadMemory128AddressInRegister(src1AddrReg, src1, offset);
-	LoadMemory128AddressInRegister(src2AddrReg, src2, offset);
-
-	//Warning: VZIP modifies both registers
-	m_assembler.Vld1_32x2(src1Reg, src2AddrReg);
-	m_assembler.Vld1_32x2(src2Reg, src1AddrReg);
-	m_assembler.Vzip_I32(static_cast<CAArch32Assembler::QUAD_REGISTER>(src1Reg), static_cast<CAArch32Assembler::QUAD_REGISTER>(src2Reg));
-	m_assembler.Vst1_32x4(static_cast<CAArch32Assembler::QUAD_REGISTER>(src1Reg), dstAddrReg);
+	auto resultReg = upper ? zipHiReg : zipLoReg;
+	auto dstReg = PrepareSymbolRegisterDefMd(dst, resultReg);
+	if(dstReg != resultReg)
+	{
+		m_assembler.Vorr(dstReg, resultReg, resultReg);
+	}
+	CommitSymbolRegisterMd(dst, dstReg);
 }
 
-void CCodeGen_AArch32::Emit_MergeTo256_MemMemMem(const STATEMENT& statement)
+void CCodeGen_AArch32::Emit_MergeTo256_MemVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
@@ -545,118 +550,115 @@ void CCodeGen_AArch32::Emit_MergeTo256_MemMemMem(const STATEMENT& statement)
 
 	auto dstLoAddrReg = CAArch32Assembler::r0;
 	auto dstHiAddrReg = CAArch32Assembler::r1;
-	auto src1AddrReg = CAArch32Assembler::r2;
-	auto src2AddrReg = CAArch32Assembler::r3;
-	auto src1Reg = CAArch32Assembler::q0;
-	auto src2Reg = CAArch32Assembler::q1;
+	auto src1Reg = PrepareSymbolRegisterUseMd(src1, CAArch32Assembler::q0);
+	auto src2Reg = PrepareSymbolRegisterUseMd(src2, CAArch32Assembler::q1);
 
 	LoadTemporary256ElementAddressInRegister(dstLoAddrReg, dst, 0x00);
 	LoadTemporary256ElementAddressInRegister(dstHiAddrReg, dst, 0x10);
-	LoadMemory128AddressInRegister(src1AddrReg, src1);
-	LoadMemory128AddressInRegister(src2AddrReg, src2);
 
-	m_assembler.Vld1_32x4(src1Reg, src1AddrReg);
-	m_assembler.Vld1_32x4(src2Reg, src2AddrReg);
 	m_assembler.Vst1_32x4(src1Reg, dstLoAddrReg);
 	m_assembler.Vst1_32x4(src2Reg, dstHiAddrReg);
 }
 
-CCodeGen_AArch32::CONSTMATCHER CCodeGen_AArch32::g_mdConstMatchers[] = 
+const CCodeGen_AArch32::CONSTMATCHER CCodeGen_AArch32::g_mdConstMatchers[] = 
 {
-	{ OP_MD_ADD_B, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDB> },
-	{ OP_MD_ADD_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDH> },
-	{ OP_MD_ADD_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDW> },
+	{ OP_MD_ADD_B, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDB> },
+	{ OP_MD_ADD_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDH> },
+	{ OP_MD_ADD_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDW> },
 
-	{ OP_MD_SUB_B, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBB> },
-	{ OP_MD_SUB_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBH> },
-	{ OP_MD_SUB_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBW> },
+	{ OP_MD_SUB_B, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBB> },
+	{ OP_MD_SUB_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBH> },
+	{ OP_MD_SUB_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBW> },
 
-	{ OP_MD_ADDUS_B, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDBUS> },
-	{ OP_MD_ADDUS_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDHUS> },
-	{ OP_MD_ADDUS_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDWUS> },
+	{ OP_MD_ADDUS_B, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDBUS> },
+	{ OP_MD_ADDUS_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDHUS> },
+	{ OP_MD_ADDUS_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDWUS> },
 
-	{ OP_MD_ADDSS_B, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDBSS> },
-	{ OP_MD_ADDSS_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDHSS> },
-	{ OP_MD_ADDSS_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDWSS> },
+	{ OP_MD_ADDSS_B, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDBSS> },
+	{ OP_MD_ADDSS_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDHSS> },
+	{ OP_MD_ADDSS_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDWSS> },
 
-	{ OP_MD_SUBUS_B, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBBUS> },
-	{ OP_MD_SUBUS_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBHUS> },
-	{ OP_MD_SUBUS_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBWUS> },
+	{ OP_MD_SUBUS_B, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBBUS> },
+	{ OP_MD_SUBUS_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBHUS> },
+	{ OP_MD_SUBUS_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBWUS> },
 
-	{ OP_MD_SUBSS_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBHSS> },
-	{ OP_MD_SUBSS_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBWSS> },
+	{ OP_MD_SUBSS_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBHSS> },
+	{ OP_MD_SUBSS_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBWSS> },
 
-	{ OP_MD_CMPEQ_B, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_CMPEQB> },
-	{ OP_MD_CMPEQ_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_CMPEQH> },
-	{ OP_MD_CMPEQ_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_CMPEQW> },
+	{ OP_MD_CMPEQ_B, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_CMPEQB> },
+	{ OP_MD_CMPEQ_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_CMPEQH> },
+	{ OP_MD_CMPEQ_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_CMPEQW> },
 
-	{ OP_MD_CMPGT_B, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_CMPGTB> },
-	{ OP_MD_CMPGT_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_CMPGTH> },
-	{ OP_MD_CMPGT_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_CMPGTW> },
+	{ OP_MD_CMPGT_B, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_CMPGTB> },
+	{ OP_MD_CMPGT_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_CMPGTH> },
+	{ OP_MD_CMPGT_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_CMPGTW> },
 
-	{ OP_MD_MIN_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_MINH> },
-	{ OP_MD_MIN_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_MINW> },
+	{ OP_MD_MIN_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_MINH> },
+	{ OP_MD_MIN_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_MINW> },
 
-	{ OP_MD_MAX_H, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_MAXH> },
-	{ OP_MD_MAX_W, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_MAXW> },
+	{ OP_MD_MAX_H, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_MAXH> },
+	{ OP_MD_MAX_W, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_MAXW> },
 
-	{ OP_MD_ADD_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_ADDS> },
-	{ OP_MD_SUB_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_SUBS> },
-	{ OP_MD_MUL_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_MULS> },
-	{ OP_MD_DIV_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_DivS_MemMemMem       },
+	{ OP_MD_ADD_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_ADDS> },
+	{ OP_MD_SUB_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_SUBS> },
+	{ OP_MD_MUL_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_MULS> },
+	{ OP_MD_DIV_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_DivS_VarVarVar       },
 
-	{ OP_MD_ABS_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL,       MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMem<MDOP_ABSS>      },
-	{ OP_MD_MIN_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<FPUMDOP_MIN> },
-	{ OP_MD_MAX_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<FPUMDOP_MAX> },
+	{ OP_MD_ABS_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL,         MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVar<MDOP_ABSS>      },
+	{ OP_MD_MIN_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<FPUMDOP_MIN> },
+	{ OP_MD_MAX_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<FPUMDOP_MAX> },
 
-	{ OP_MD_CMPLT_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_CmpLtS_MemMemMem         },
-	{ OP_MD_CMPGT_S, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<FPUMDOP_CMPGT> },
+	{ OP_MD_CMPLT_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_CmpLtS_VarVarVar         },
+	{ OP_MD_CMPGT_S, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<FPUMDOP_CMPGT> },
 
-	{ OP_MD_AND, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_AND> },
-	{ OP_MD_OR,  MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_OR>  },
-	{ OP_MD_XOR, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMemMem<MDOP_XOR> },
-	{ OP_MD_NOT, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL,       MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMem<MDOP_NOT>    },
+	{ OP_MD_AND, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_AND> },
+	{ OP_MD_OR,  MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_OR>  },
+	{ OP_MD_XOR, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVarVar<MDOP_XOR> },
+	{ OP_MD_NOT, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL,         MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVar<MDOP_NOT>    },
 
-	{ OP_MD_SLLH, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_MemMemCst<MDOP_SLLH> },
-	{ OP_MD_SLLW, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_MemMemCst<MDOP_SLLW> },
+	{ OP_MD_SLLH, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_VarVarCst<MDOP_SLLH> },
+	{ OP_MD_SLLW, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_VarVarCst<MDOP_SLLW> },
 
-	{ OP_MD_SRLH, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_MemMemCst<MDOP_SRLH> },
-	{ OP_MD_SRLW, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_MemMemCst<MDOP_SRLW> },
+	{ OP_MD_SRLH, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_VarVarCst<MDOP_SRLH> },
+	{ OP_MD_SRLW, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_VarVarCst<MDOP_SRLW> },
 
-	{ OP_MD_SRAH, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_MemMemCst<MDOP_SRAH> },
-	{ OP_MD_SRAW, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_MemMemCst<MDOP_SRAW> },
+	{ OP_MD_SRAH, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_VarVarCst<MDOP_SRAH> },
+	{ OP_MD_SRAW, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Shift_VarVarCst<MDOP_SRAW> },
 
-	{ OP_MD_SRL256, MATCH_VARIABLE128, MATCH_MEMORY256, MATCH_VARIABLE, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Srl256_MemMemVar },
-	{ OP_MD_SRL256, MATCH_VARIABLE128, MATCH_MEMORY256, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Srl256_MemMemCst },
+	{ OP_MD_SRL256, MATCH_VARIABLE128, MATCH_MEMORY256, MATCH_VARIABLE, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Srl256_VarMemVar },
+	{ OP_MD_SRL256, MATCH_VARIABLE128, MATCH_MEMORY256, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Srl256_VarMemCst },
 
-	{ OP_MD_MAKESZ, MATCH_VARIABLE, MATCH_MEMORY128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MakeSz_VarVar },
+	{ OP_MD_MAKESZ, MATCH_VARIABLE, MATCH_VARIABLE128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MakeSz_VarVar },
 
-	{ OP_MD_TOSINGLE,        MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMem<MDOP_TOSINGLE> },
-	{ OP_MD_TOWORD_TRUNCATE, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MemMem<MDOP_TOWORD>   },
+	{ OP_MD_TOSINGLE,        MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVar<MDOP_TOSINGLE> },
+	{ OP_MD_TOWORD_TRUNCATE, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_VarVar<MDOP_TOWORD>   },
 
-	{ OP_MOV, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Mov_MemMem },
+	{ OP_MOV, MATCH_REGISTER128, MATCH_REGISTER128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Mov_RegReg },
+	{ OP_MOV, MATCH_REGISTER128, MATCH_MEMORY128,   MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Mov_RegMem },
+	{ OP_MOV, MATCH_MEMORY128,   MATCH_REGISTER128, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Mov_MemReg },
+	{ OP_MOV, MATCH_MEMORY128,   MATCH_MEMORY128,   MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Mov_MemMem },
 
-	{ OP_LOADFROMREF, MATCH_MEMORY128, MATCH_VAR_REF, MATCH_NIL,       MATCH_NIL, &CCodeGen_AArch32::Emit_Md_LoadFromRef_MemVar },
-	{ OP_STOREATREF,  MATCH_NIL,       MATCH_VAR_REF, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_StoreAtRef_VarMem  },
+	{ OP_LOADFROMREF, MATCH_VARIABLE128, MATCH_VAR_REF, MATCH_NIL,         MATCH_NIL, &CCodeGen_AArch32::Emit_Md_LoadFromRef_VarVar },
+	{ OP_STOREATREF,  MATCH_NIL,         MATCH_VAR_REF, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_StoreAtRef_VarVar  },
 
-	{ OP_MD_MOV_MASKED, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MovMasked_MemMemMem },
+	{ OP_MD_MOV_MASKED, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_MovMasked_VarVarVar },
 
-	{ OP_MD_EXPAND, MATCH_MEMORY128, MATCH_REGISTER, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Expand_MemReg },
-	{ OP_MD_EXPAND, MATCH_MEMORY128, MATCH_MEMORY,   MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Expand_MemMem },
-	{ OP_MD_EXPAND, MATCH_MEMORY128, MATCH_CONSTANT, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Expand_MemCst },
+	{ OP_MD_EXPAND, MATCH_VARIABLE128, MATCH_REGISTER, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Expand_VarReg },
+	{ OP_MD_EXPAND, MATCH_VARIABLE128, MATCH_MEMORY,   MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Expand_VarMem },
+	{ OP_MD_EXPAND, MATCH_VARIABLE128, MATCH_CONSTANT, MATCH_NIL, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Expand_VarCst },
 
-	{ OP_MD_PACK_HB, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_PackHB_MemMemMem },
-	{ OP_MD_PACK_WH, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_PackWH_MemMemMem },
+	{ OP_MD_PACK_HB, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_PackHB_VarVarVar },
+	{ OP_MD_PACK_WH, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_PackWH_VarVarVar },
 
-	{ OP_MD_UNPACK_LOWER_BH, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_UnpackBH_MemMemMem<0> },
-	{ OP_MD_UNPACK_LOWER_HW, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_UnpackHW_MemMemMem<0> },
-	{ OP_MD_UNPACK_LOWER_WD, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_UnpackWD_MemMemMem<0> },
+	{ OP_MD_UNPACK_LOWER_BH, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Unpack_VarVarVar<MDOP_ZIPB, false> },
+	{ OP_MD_UNPACK_LOWER_HW, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Unpack_VarVarVar<MDOP_ZIPH, false> },
+	{ OP_MD_UNPACK_LOWER_WD, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Unpack_VarVarVar<MDOP_ZIPW, false> },
 
-	{ OP_MD_UNPACK_UPPER_BH, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_UnpackBH_MemMemMem<8> },
-	{ OP_MD_UNPACK_UPPER_HW, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_UnpackHW_MemMemMem<8> },
-	{ OP_MD_UNPACK_UPPER_WD, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_MEMORY128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_UnpackWD_MemMemMem<8> },
+	{ OP_MD_UNPACK_UPPER_BH, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Unpack_VarVarVar<MDOP_ZIPB, true> },
+	{ OP_MD_UNPACK_UPPER_HW, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Unpack_VarVarVar<MDOP_ZIPH, true> },
+	{ OP_MD_UNPACK_UPPER_WD, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_Md_Unpack_VarVarVar<MDOP_ZIPW, true> },
 
-	{ OP_MERGETO256, MATCH_MEMORY256, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_MergeTo256_MemMemMem },
+	{ OP_MERGETO256, MATCH_MEMORY256, MATCH_VARIABLE128, MATCH_VARIABLE128, MATCH_NIL, &CCodeGen_AArch32::Emit_MergeTo256_MemVarVar },
 
 	{ OP_MOV, MATCH_NIL, MATCH_NIL, MATCH_NIL, MATCH_NIL, nullptr },
 };
@@ -1,11 +1,12 @@
 #include <algorithm>
 #include <stdexcept>
 #include "Jitter_CodeGen_AArch64.h"
+#include "Jitter_CompileStats.h"
 #include "BitManip.h"
 
 using namespace Jitter;
 
-CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_registers[MAX_REGISTERS] =
+const CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_registers[MAX_REGISTERS] =
 {
 	CAArch64Assembler::w20,
 	CAArch64Assembler::w21,
@@ -18,7 +19,7 @@ CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_registers[MAX_REGISTERS] =
 	CAArch64Assembler::w28,
 };
 
-CAArch64Assembler::REGISTERMD    CCodeGen_AArch64::g_registersMd[MAX_MDREGISTERS] =
+const CAArch64Assembler::REGISTERMD    CCodeGen_AArch64::g_registersMd[MAX_MDREGISTERS] =
 {
 	//v0-v3 are used for work values, v7-v15 need to be preserved
 	CAArch64Assembler::v4,  CAArch64Assembler::v5,  CAArch64Assembler::v6,  CAArch64Assembler::v7,
@@ -28,7 +29,7 @@ CAArch64Assembler::REGISTERMD    CCodeGen_AArch64::g_registersMd[MAX_MDREGISTERS
 	CAArch64Assembler::v28, CAArch64Assembler::v29, CAArch64Assembler::v30, CAArch64Assembler::v31,
 };
 
-CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_tempRegisters[MAX_TEMP_REGS] =
+const CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_tempRegisters[MAX_TEMP_REGS] =
 {
 	CAArch64Assembler::w9,
 	CAArch64Assembler::w10,
@@ -39,7 +40,7 @@ CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_tempRegisters[MAX_TEMP_REGS
 	CAArch64Assembler::w15
 };
 
-CAArch64Assembler::REGISTER64    CCodeGen_AArch64::g_tempRegisters64[MAX_TEMP_REGS] =
+const CAArch64Assembler::REGISTER64    CCodeGen_AArch64::g_tempRegisters64[MAX_TEMP_REGS] =
 {
 	CAArch64Assembler::x9,
 	CAArch64Assembler::x10,
@@ -50,7 +51,7 @@ CAArch64Assembler::REGISTER64    CCodeGen_AArch64::g_tempRegisters64[MAX_TEMP_RE
 	CAArch64Assembler::x15
 };
 
-CAArch64Assembler::REGISTERMD    CCodeGen_AArch64::g_tempRegistersMd[MAX_TEMP_MD_REGS] =
+const CAArch64Assembler::REGISTERMD    CCodeGen_AArch64::g_tempRegistersMd[MAX_TEMP_MD_REGS] =
 {
 	CAArch64Assembler::v0,
 	CAArch64Assembler::v1,
@@ -58,7 +59,7 @@ CAArch64Assembler::REGISTERMD    CCodeGen_AArch64::g_tempRegistersMd[MAX_TEMP_MD
 	CAArch64Assembler::v3,
 };
 
-CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_paramRegisters[MAX_PARAM_REGS] =
+const CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_paramRegisters[MAX_PARAM_REGS] =
 {
 	CAArch64Assembler::w0,
 	CAArch64Assembler::w1,
@@ -70,7 +71,7 @@ CAArch64Assembler::REGISTER32    CCodeGen_AArch64::g_paramRegisters[MAX_PARAM_RE
 	CAArch64Assembler::w7,
 };
 
-CAArch64Assembler::REGISTER64    CCodeGen_AArch64::g_paramRegisters64[MAX_PARAM_REGS] =
+const CAArch64Assembler::REGISTER64    CCodeGen_AArch64::g_paramRegisters64[MAX_PARAM_REGS] =
 {
 	CAArch64Assembler::x0,
 	CAArch64Assembler::x1,
@@ -82,7 +83,7 @@ CAArch64Assembler::REGISTER64    CCodeGen_AArch64::g_paramRegisters64[MAX_PARAM_
 	CAArch64Assembler::x7,
 };
 
-CAArch64Assembler::REGISTER64    CCodeGen_AArch64::g_baseRegister = CAArch64Assembler::x19;
+const CAArch64Assembler::REGISTER64    CCodeGen_AArch64::g_baseRegister = CAArch64Assembler::x19;
 
 static bool isMask(uint32 value)
 {
@@ -266,7 +267,7 @@ void CCodeGen_AArch64::Emit_Div_Tmp64AnyAny(const STATEMENT& statement)
 	{ LOGICOP_CST,          MATCH_VARIABLE,       MATCH_VARIABLE,       MATCH_CONSTANT,    MATCH_NIL, &CCodeGen_AArch64::Emit_Logic_VarVarCst<LOGICOP>        }, \
 	{ LOGICOP_CST,          MATCH_VARIABLE,       MATCH_ANY,            MATCH_VARIABLE,    MATCH_NIL, &CCodeGen_AArch64::Emit_Logic_VarAnyVar<LOGICOP>        },
 
-CCodeGen_AArch64::CONSTMATCHER CCodeGen_AArch64::g_constMatchers[] =
+const CCodeGen_AArch64::CONSTMATCHER CCodeGen_AArch64::g_constMatchers[] =
 {
 	{ OP_NOP,            MATCH_NIL,            MATCH_NIL,            MATCH_NIL,           MATCH_NIL,      &CCodeGen_AArch64::Emit_Nop                                 },
 
@@ -329,6 +330,10 @@ CCodeGen_AArch64::CONSTMATCHER CCodeGen_AArch64::g_constMatchers[] =
 	{ OP_EXTERNJMP,      MATCH_NIL,            MATCH_CONSTANTPTR,    MATCH_NIL,           MATCH_NIL,      &CCodeGen_AArch64::Emit_ExternJmp                           },
 	{ OP_EXTERNJMP_DYN,  MATCH_NIL,            MATCH_CONSTANTPTR,    MATCH_NIL,           MATCH_NIL,      &CCodeGen_AArch64::Emit_ExternJmpDynamic                    },
 
+	{ OP_LOOKUP,         MATCH_NIL,            MATCH_ANY,            MATCH_CONSTANTPTR,   MATCH_CONSTANT, &CCodeGen_AArch64::Emit_Lookup                              },
+
+	{ OP_INCCOUNTER,     MATCH_NIL,            MATCH_CONSTANTPTR,    MATCH_NIL,           MATCH_NIL,      &CCodeGen_AArch64::Emit_IncCounter                          },
+
 	{ OP_JMP,            MATCH_NIL,            MATCH_NIL,            MATCH_NIL,           MATCH_NIL,      &CCodeGen_AArch64::Emit_Jmp                                 },
 	
 	{ OP_CONDJMP,        MATCH_NIL,            MATCH_ANY,            MATCH_VARIABLE,      MATCH_NIL,      &CCodeGen_AArch64::Emit_CondJmp_AnyVar                      },
@@ -380,8 +385,8 @@ CCodeGen_AArch64::CCodeGen_AArch64()
 				matcher.src1Type = constMatcher->src1Type;
 				matcher.src2Type = constMatcher->src2Type;
 				matcher.src3Type = constMatcher->src3Type;
-				matcher.emitter  = std::bind(constMatcher->emitter, this, std::placeholders::_1);
-				m_matchers.insert(MatcherMapType::value_type(matcher.op, matcher));
+				matcher.emitter  = static_cast<CodeEmitterType>(constMatcher->emitter);
+				InsertMatcher(matcher);
 			}
 		};
 	
@@ -411,11 +416,35 @@ bool CCodeGen_AArch64::CanHold128BitsReturnValueInRegisters() const
 	return true;
 }
 
+bool CCodeGen_AArch64::CanHoldFpSingleInMdRegisters() const
+{
+	return true;
+}
+
+uint32 CCodeGen_AArch64::GetCallPreservedRegisterMask() const
+{
+	//w20-w28 are callee-saved
+	return (1 << MAX_REGISTERS) - 1;
+}
+
+uint32 CCodeGen_AArch64::GetCallPreservedMdRegisterMask() const
+{
+	//Only the lower half of v8-v15 is preserved, none of them are allocated
+	return 0;
+}
+
 uint32 CCodeGen_AArch64::GetPointerSize() const
 {
 	return 8;
 }
 
+uint32 CCodeGen_AArch64::GetConfigurationKey() const
+{
+	uint32 options = 0;
+	if(m_generateRelocatableCalls) options |= 0x01;
+	return MakeConfigurationKey(CONFIGURATION_BACKEND_AARCH64, options);
+}
+
 void CCodeGen_AArch64::SetStream(Framework::CStream* stream)
 {
 	m_stream = stream;
@@ -437,38 +466,35 @@ void CCodeGen_AArch64::GenerateCode(const StatementList& statements, unsigned in
 
 	m_registerSave = GetSavedRegisterList(GetRegisterUsage(statements));
 
+	m_assembler.SetStats(BeginAssemblerStats());
+	m_assembler.BeginStatsRegion(CAssemblerStats::CATEGORY_PROLOG);
 	Emit_Prolog(statements, stackSize);
 
 	for(const auto& statement : statements)
 	{
-		bool found = false;
-		auto begin = m_matchers.lower_bound(statement.op);
-		auto end = m_matchers.upper_bound(statement.op);
-
-		for(auto matchIterator(begin); matchIterator != end; matchIterator++)
-		{
-			const MATCHER& matcher(matchIterator->second);
-			if(!SymbolMatches(matcher.dstType, statement.dst)) continue;
-			if(!SymbolMatches(matcher.src1Type, statement.src1)) continue;
-			if(!SymbolMatches(matcher.src2Type, statement.src2)) continue;
-			if(!SymbolMatches(matcher.src3Type, statement.src3)) continue;
-			matcher.emitter(statement);
-			found = true;
-			break;
-		}
-		assert(found);
-		if(!found)
+		auto emitter = FindEmitter(statement);
+		assert(emitter);
+		if(!emitter)
 		{
 			throw std::runtime_error("No suitable emitter found for statement.");
 		}
+		m_assembler.BeginStatsRegion(GetStatementStatsCategory(statement), statement.op);
+		(this->*emitter)(statement);
 	}
 	
+	m_assembler.BeginStatsRegion(CAssemblerStats::CATEGORY_EPILOG);
 	Emit_Epilog();
 	m_assembler.Ret();
+	m_assembler.EndStatsRegion();
 
-	m_assembler.ResolveLabelReferences();
-	m_assembler.ClearLabels();
-	m_assembler.ResolveLiteralReferences();
+	{
+		CCompileStats::CPassScope passScope(m_compileStats, CCompileStats::PASS_ASSEMBLEREND);
+		m_assembler.ResolveLabelReferences();
+		m_assembler.ClearLabels();
+		m_assembler.ResolveLiteralReferences();
+	}
+	m_assembler.SetStats(nullptr);
+	EndAssemblerStats();
 	m_labels.clear();
 }
 
@@ -1521,6 +1547,21 @@ void CCodeGen_AArch64::Emit_ExternJmpDynamic(const STATEMENT& statement)
 
 	m_assembler.Mov(g_paramRegisters64[0], g_baseRegister);
 	Emit_Epilog();
+
+	//Target address is patched with a single store, keep it 8 bytes aligned (3 instructions after the exit)
+	if((m_stream->GetLength() & 0x7) != 4)
+	{
+		//NOP
+		m_stream->Write32(0xD503201F);
+	}
+
+	//Branches to the next instruction until the exit is linked to its target by CMemoryFunction::LinkExit
+	if(m_dynamicExitHandler)
+	{
+		m_dynamicExitHandler(static_cast<uint32>(m_stream->GetLength()));
+	}
+	m_assembler.B_offset(4);
+
 	auto fctAddressReg = GetNextTempRegister64();
 	m_assembler.Ldr_Pc(fctAddressReg, 8);
 	m_assembler.Br(fctAddressReg);
@@ -1534,6 +1575,55 @@ void CCodeGen_AArch64::Emit_ExternJmpDynamic(const STATEMENT& statement)
 	m_stream->Write64(src1->GetConstantPtr());
 }
 
+void CCodeGen_AArch64::Emit_Lookup(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+	auto src2 = statement.src2->GetSymbol().get();
+	auto src3 = statement.src3->GetSymbol().get();
+
+	assert(src2->m_type == SYM_CONSTANTPTR);
+	assert(src3->m_type == SYM_CONSTANT);
+
+	auto missLabel = m_assembler.CreateLabel();
+	auto addressReg = PrepareSymbolRegisterUse(src1, GetNextTempRegister());
+	auto indexReg = GetNextTempRegister();
+	auto indexReg64 = static_cast<CAArch64Assembler::REGISTER64>(indexReg);
+	auto entryReg = GetNextTempRegister64();
+
+	//Entries are 16 bytes (tag, code pointer), 32-bit operations clear the upper half of the index
+	LoadConstantInRegister(indexReg, src3->m_valueLow);
+	m_assembler.And(indexReg, addressReg, indexReg);
+	m_assembler.Lsl(indexReg64, indexReg64, 4);
+	LoadConstant64InRegister(entryReg, src2->GetConstantPtr());
+	m_assembler.Add(entryReg, entryReg, indexReg64);
+
+	m_assembler.Ldr(indexReg, entryReg, 0);
+	m_assembler.Cmp(indexReg, addressReg);
+	m_assembler.BCc(CAArch64Assembler::CONDITION_NE, missLabel);
+
+	m_assembler.Ldr(entryReg, entryReg, 8);
+	m_assembler.Mov(g_paramRegisters64[0], g_baseRegister);
+	Emit_Epilog();
+	m_assembler.Br(entryReg);
+
+	m_assembler.MarkLabel(missLabel);
+}
+
+void CCodeGen_AArch64::Emit_IncCounter(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+
+	assert(src1->m_type == SYM_CONSTANTPTR);
+
+	auto counterAddressReg = GetNextTempRegister64();
+	auto counterReg = GetNextTempRegister();
+
+	LoadConstant64InRegister(counterAddressReg, src1->GetConstantPtr());
+	m_assembler.Ldr(counterReg, counterAddressReg, 0);
+	m_assembler.Add(counterReg, counterReg, 1, CAArch64Assembler::ADDSUB_IMM_SHIFT_LSL0);
+	m_assembler.Str(counterReg, counterAddressReg, 0);
+}
+
 void CCodeGen_AArch64::Emit_Jmp(const STATEMENT& statement)
 {
 	m_assembler.B(GetLabel(statement.jmpBlock));
@@ -445,7 +445,7 @@ void CCodeGen_AArch64::Emit_Mov_Mem64Cst64(const STATEMENT& statement)
 	StoreRegisterInMemory64(dst, tmpReg);
 }
 
-CCodeGen_AArch64::CONSTMATCHER CCodeGen_AArch64::g_64ConstMatchers[] =
+const CCodeGen_AArch64::CONSTMATCHER CCodeGen_AArch64::g_64ConstMatchers[] =
 {
 	{ OP_EXTLOW64,       MATCH_VARIABLE,       MATCH_MEMORY64,       MATCH_NIL,           MATCH_NIL, &CCodeGen_AArch64::Emit_ExtLow64VarMem64                    },
 	{ OP_EXTHIGH64,      MATCH_VARIABLE,       MATCH_MEMORY64,       MATCH_NIL,           MATCH_NIL, &CCodeGen_AArch64::Emit_ExtHigh64VarMem64                   },
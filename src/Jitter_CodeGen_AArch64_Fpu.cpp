@@ -1,4 +1,5 @@
 #include "Jitter_CodeGen_AArch64.h"
+#include <stdexcept>
 
 using namespace Jitter;
 
@@ -34,111 +35,182 @@ void CCodeGen_AArch64::StoreRegisterInMemoryFpSingle(CSymbol* symbol, CAArch64As
 	}
 }
 
+CAArch64Assembler::REGISTERMD CCodeGen_AArch64::PrepareSymbolRegisterDefFpSingle(CSymbol* symbol, CAArch64Assembler::REGISTERMD preferedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		assert(symbol->m_valueLow < MAX_MDREGISTERS);
+		return g_registersMd[symbol->m_valueLow];
+		break;
+	case SYM_FP_REL_SINGLE:
+	case SYM_FP_TMP_SINGLE:
+		return preferedRegister;
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+CAArch64Assembler::REGISTERMD CCodeGen_AArch64::PrepareSymbolRegisterUseFpSingle(CSymbol* symbol, CAArch64Assembler::REGISTERMD preferedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		assert(symbol->m_valueLow < MAX_MDREGISTERS);
+		return g_registersMd[symbol->m_valueLow];
+		break;
+	case SYM_FP_REL_SINGLE:
+	case SYM_FP_TMP_SINGLE:
+		LoadMemoryFpSingleInRegister(preferedRegister, symbol);
+		return preferedRegister;
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+void CCodeGen_AArch64::CommitSymbolRegisterFpSingle(CSymbol* symbol, CAArch64Assembler::REGISTERMD usedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		assert(usedRegister == g_registersMd[symbol->m_valueLow]);
+		break;
+	case SYM_FP_REL_SINGLE:
+	case SYM_FP_TMP_SINGLE:
+		StoreRegisterInMemoryFpSingle(symbol, usedRegister);
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
 template <typename FPUOP>
-void CCodeGen_AArch64::Emit_Fpu_MemMem(const STATEMENT& statement)
+void CCodeGen_AArch64::Emit_Fpu_VarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
-	auto dstReg = GetNextTempRegisterMd();
-	auto src1Reg = GetNextTempRegisterMd();
+	auto dstReg = PrepareSymbolRegisterDefFpSingle(dst, GetNextTempRegisterMd());
+	auto src1Reg = PrepareSymbolRegisterUseFpSingle(src1, GetNextTempRegisterMd());
 	
-	LoadMemoryFpSingleInRegister(src1Reg, src1);
 	((m_assembler).*(FPUOP::OpReg()))(dstReg, src1Reg);
-	StoreRegisterInMemoryFpSingle(dst, dstReg);
+	CommitSymbolRegisterFpSingle(dst, dstReg);
 }
 
 template <typename FPUOP>
-void CCodeGen_AArch64::Emit_Fpu_MemMemMem(const STATEMENT& statement)
+void CCodeGen_AArch64::Emit_Fpu_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
-	auto dstReg = GetNextTempRegisterMd();
-	auto src1Reg = GetNextTempRegisterMd();
-	auto src2Reg = GetNextTempRegisterMd();
+	auto dstReg = PrepareSymbolRegisterDefFpSingle(dst, GetNextTempRegisterMd());
+	auto src1Reg = PrepareSymbolRegisterUseFpSingle(src1, GetNextTempRegisterMd());
+	auto src2Reg = PrepareSymbolRegisterUseFpSingle(src2, GetNextTempRegisterMd());
 	
-	LoadMemoryFpSingleInRegister(src1Reg, src1);
-	LoadMemoryFpSingleInRegister(src2Reg, src2);
 	((m_assembler).*(FPUOP::OpReg()))(dstReg, src1Reg, src2Reg);
-	StoreRegisterInMemoryFpSingle(dst, dstReg);
+	CommitSymbolRegisterFpSingle(dst, dstReg);
 }
 
-void CCodeGen_AArch64::Emit_Fp_Cmp_AnyMemMem(const STATEMENT& statement)
+void CCodeGen_AArch64::Emit_Fp_Cmp_AnyVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	auto src2 = statement.src2->GetSymbol().get();
 
 	auto dstReg = PrepareSymbolRegisterDef(dst, GetNextTempRegister());
-	auto src1Reg = GetNextTempRegisterMd();
-	auto src2Reg = GetNextTempRegisterMd();
+	auto src1Reg = PrepareSymbolRegisterUseFpSingle(src1, GetNextTempRegisterMd());
+	auto src2Reg = PrepareSymbolRegisterUseFpSingle(src2, GetNextTempRegisterMd());
 
-	LoadMemoryFpSingleInRegister(src1Reg, src1);
-	LoadMemoryFpSingleInRegister(src2Reg, src2);
 	m_assembler.Fcmp_1s(src1Reg, src2Reg);
 	Cmp_GetFlag(dstReg, statement.jmpCondition);
 	CommitSymbolRegister(dst, dstReg);
 }
 
-void CCodeGen_AArch64::Emit_Fp_Rcpl_MemMem(const STATEMENT& statement)
+void CCodeGen_AArch64::Emit_Fp_Rcpl_VarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	
-	auto dstReg = GetNextTempRegisterMd();
-	auto src1Reg = GetNextTempRegisterMd();
+	auto dstReg = PrepareSymbolRegisterDefFpSingle(dst, GetNextTempRegisterMd());
+	auto src1Reg = PrepareSymbolRegisterUseFpSingle(src1, GetNextTempRegisterMd());
 	auto oneReg = GetNextTempRegisterMd();
 	
 	m_assembler.Fmov_1s(oneReg, 0x70);	//Loads 1.0f
-	LoadMemoryFpSingleInRegister(src1Reg, src1);
 	m_assembler.Fdiv_1s(dstReg, oneReg, src1Reg);
-	StoreRegisterInMemoryFpSingle(dst, dstReg);
+	CommitSymbolRegisterFpSingle(dst, dstReg);
 }
 
-void CCodeGen_AArch64::Emit_Fp_Rsqrt_MemMem(const STATEMENT& statement)
+void CCodeGen_AArch64::Emit_Fp_Rsqrt_VarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 	
-	auto dstReg = GetNextTempRegisterMd();
-	auto src1Reg = GetNextTempRegisterMd();
+	auto dstReg = PrepareSymbolRegisterDefFpSingle(dst, GetNextTempRegisterMd());
+	auto src1Reg = PrepareSymbolRegisterUseFpSingle(src1, GetNextTempRegisterMd());
 	auto oneReg = GetNextTempRegisterMd();
+	auto sqrtReg = GetNextTempRegisterMd();
 	
 	m_assembler.Fmov_1s(oneReg, 0x70);	//Loads 1.0f
-	LoadMemoryFpSingleInRegister(src1Reg, src1);
-	m_assembler.Fsqrt_1s(src1Reg, src1Reg);
-	m_assembler.Fdiv_1s(dstReg, oneReg, src1Reg);
-	StoreRegisterInMemoryFpSingle(dst, dstReg);
+	m_assembler.Fsqrt_1s(sqrtReg, src1Reg);
+	m_assembler.Fdiv_1s(dstReg, oneReg, sqrtReg);
+	CommitSymbolRegisterFpSingle(dst, dstReg);
+}
+
+void CCodeGen_AArch64::Emit_Fp_Mov_RegReg(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	m_assembler.Mov(g_registersMd[dst->m_valueLow], g_registersMd[src1->m_valueLow]);
+}
+
+void CCodeGen_AArch64::Emit_Fp_Mov_RegMem(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	LoadMemoryFpSingleInRegister(g_registersMd[dst->m_valueLow], src1);
 }
 
-void CCodeGen_AArch64::Emit_Fp_Mov_MemSRelI32(const STATEMENT& statement)
+void CCodeGen_AArch64::Emit_Fp_Mov_MemReg(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	StoreRegisterInMemoryFpSingle(dst, g_registersMd[src1->m_valueLow]);
+}
+
+void CCodeGen_AArch64::Emit_Fp_Mov_VarSRelI32(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
 	assert(src1->m_type == SYM_FP_REL_INT32);
 
-	auto dstReg = GetNextTempRegisterMd();
+	auto dstReg = PrepareSymbolRegisterDefFpSingle(dst, GetNextTempRegisterMd());
 	auto src1Reg = GetNextTempRegisterMd();
 
 	m_assembler.Ldr_1s(src1Reg, g_baseRegister, src1->m_valueLow);
 	m_assembler.Scvtf_1s(dstReg, src1Reg);
-	StoreRegisterInMemoryFpSingle(dst, dstReg);
+	CommitSymbolRegisterFpSingle(dst, dstReg);
 }
 
-void CCodeGen_AArch64::Emit_Fp_ToIntTrunc_MemMem(const STATEMENT& statement)
+void CCodeGen_AArch64::Emit_Fp_ToIntTrunc_VarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
-	auto dstReg = GetNextTempRegisterMd();
-	auto src1Reg = GetNextTempRegisterMd();
+	auto dstReg = PrepareSymbolRegisterDefFpSingle(dst, GetNextTempRegisterMd());
+	auto src1Reg = PrepareSymbolRegisterUseFpSingle(src1, GetNextTempRegisterMd());
 
-	LoadMemoryFpSingleInRegister(src1Reg, src1);
 	m_assembler.Fcvtzs_1s(dstReg, src1Reg);
-	StoreRegisterInMemoryFpSingle(dst, dstReg);
+	CommitSymbolRegisterFpSingle(dst, dstReg);
 }
 
 void CCodeGen_AArch64::Emit_Fp_LdCst_TmpCst(const STATEMENT& statement)
@@ -155,29 +227,46 @@ void CCodeGen_AArch64::Emit_Fp_LdCst_TmpCst(const STATEMENT& statement)
 	m_assembler.Str(tmpReg, CAArch64Assembler::xSP, dst->m_stackLocation);
 }
 
-CCodeGen_AArch64::CONSTMATCHER CCodeGen_AArch64::g_fpuConstMatchers[] =
+void CCodeGen_AArch64::Emit_Fp_LdCst_RegCst(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	assert(src1->m_type == SYM_CONSTANT);
+
+	auto tmpReg = GetNextTempRegister();
+
+	LoadConstantInRegister(tmpReg, src1->m_valueLow);
+	m_assembler.Dup_4s(g_registersMd[dst->m_valueLow], tmpReg);
+}
+
+const CCodeGen_AArch64::CONSTMATCHER CCodeGen_AArch64::g_fpuConstMatchers[] =
 {
-	{ OP_FP_ADD,            MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_MEMORY_FP_SINGLE,    MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMemMem<FPUOP_ADD>    },
-	{ OP_FP_SUB,            MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_MEMORY_FP_SINGLE,    MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMemMem<FPUOP_SUB>    },
-	{ OP_FP_MUL,            MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_MEMORY_FP_SINGLE,    MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMemMem<FPUOP_MUL>    },
-	{ OP_FP_DIV,            MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_MEMORY_FP_SINGLE,    MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMemMem<FPUOP_DIV>    },
+	{ OP_FP_ADD,            MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_VARIABLE_FP_SINGLE,  MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVarVar<FPUOP_ADD>    },
+	{ OP_FP_SUB,            MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_VARIABLE_FP_SINGLE,  MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVarVar<FPUOP_SUB>    },
+	{ OP_FP_MUL,            MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_VARIABLE_FP_SINGLE,  MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVarVar<FPUOP_MUL>    },
+	{ OP_FP_DIV,            MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_VARIABLE_FP_SINGLE,  MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVarVar<FPUOP_DIV>    },
 
-	{ OP_FP_CMP,            MATCH_ANY,                    MATCH_MEMORY_FP_SINGLE,     MATCH_MEMORY_FP_SINGLE,    MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Cmp_AnyMemMem            },
+	{ OP_FP_CMP,            MATCH_ANY,                    MATCH_VARIABLE_FP_SINGLE,   MATCH_VARIABLE_FP_SINGLE,  MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Cmp_AnyVarVar            },
 
-	{ OP_FP_MIN,            MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_MEMORY_FP_SINGLE,    MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMemMem<FPUOP_MIN>    },
-	{ OP_FP_MAX,            MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_MEMORY_FP_SINGLE,    MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMemMem<FPUOP_MAX>    },
+	{ OP_FP_MIN,            MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_VARIABLE_FP_SINGLE,  MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVarVar<FPUOP_MIN>    },
+	{ OP_FP_MAX,            MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_VARIABLE_FP_SINGLE,  MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVarVar<FPUOP_MAX>    },
 
-	{ OP_FP_RCPL,           MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Rcpl_MemMem              },
-	{ OP_FP_SQRT,           MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMem<FPUOP_SQRT>      },
-	{ OP_FP_RSQRT,          MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Rsqrt_MemMem             },
+	{ OP_FP_RCPL,           MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Rcpl_VarVar              },
+	{ OP_FP_SQRT,           MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVar<FPUOP_SQRT>      },
+	{ OP_FP_RSQRT,          MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Rsqrt_VarVar             },
 
-	{ OP_FP_ABS,            MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMem<FPUOP_ABS>       },
-	{ OP_FP_NEG,            MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_MemMem<FPUOP_NEG>       },
+	{ OP_FP_ABS,            MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVar<FPUOP_ABS>       },
+	{ OP_FP_NEG,            MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fpu_VarVar<FPUOP_NEG>       },
 
-	{ OP_MOV,               MATCH_MEMORY_FP_SINGLE,       MATCH_RELATIVE_FP_INT32,    MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Mov_MemSRelI32           },
-	{ OP_FP_TOINT_TRUNC,    MATCH_MEMORY_FP_SINGLE,       MATCH_MEMORY_FP_SINGLE,     MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_ToIntTrunc_MemMem        },
+	{ OP_MOV,               MATCH_REGISTER_FP_SINGLE,     MATCH_REGISTER_FP_SINGLE,   MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Mov_RegReg               },
+	{ OP_MOV,               MATCH_REGISTER_FP_SINGLE,     MATCH_MEMORY_FP_SINGLE,     MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Mov_RegMem               },
+	{ OP_MOV,               MATCH_MEMORY_FP_SINGLE,       MATCH_REGISTER_FP_SINGLE,   MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Mov_MemReg               },
+	{ OP_MOV,               MATCH_VARIABLE_FP_SINGLE,     MATCH_RELATIVE_FP_INT32,    MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_Mov_VarSRelI32           },
+	{ OP_FP_TOINT_TRUNC,    MATCH_VARIABLE_FP_SINGLE,     MATCH_VARIABLE_FP_SINGLE,   MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_ToIntTrunc_VarVar        },
 
 	{ OP_FP_LDCST,          MATCH_TEMPORARY_FP_SINGLE,    MATCH_CONSTANT,             MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_LdCst_TmpCst             },
+	{ OP_FP_LDCST,          MATCH_REGISTER_FP_SINGLE,     MATCH_CONSTANT,             MATCH_NIL,                 MATCH_NIL, &CCodeGen_AArch64::Emit_Fp_LdCst_RegCst             },
 
 	{ OP_MOV,               MATCH_NIL,                    MATCH_NIL,                  MATCH_NIL,                 MATCH_NIL, nullptr                                             },
 };
@@ -3,6 +3,7 @@
 #include <assert.h>
 #include <stdexcept>
 #include "Jitter_CodeGen_x86.h"
+#include "Jitter_CompileStats.h"
 
 //Check if CPUID is available
 #ifdef _WIN32
@@ -35,9 +36,9 @@ using namespace Jitter;
 #include "Jitter_CodeGen_x86_Mul.h"
 #include "Jitter_CodeGen_x86_Div.h"
 
-CX86Assembler::REGISTER CCodeGen_x86::g_baseRegister = CX86Assembler::rBP;
+const CX86Assembler::REGISTER CCodeGen_x86::g_baseRegister = CX86Assembler::rBP;
 
-CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_constMatchers[] = 
+const CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_constMatchers[] = 
 { 
 	{ OP_LABEL, MATCH_NIL, MATCH_NIL, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::MarkLabel  },
 
@@ -113,12 +114,14 @@ CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_constMatchers[] =
 	{ OP_MERGETO64, MATCH_MEMORY64, MATCH_MEMORY,   MATCH_MEMORY,   MATCH_NIL, &CCodeGen_x86::Emit_MergeTo64_Mem64MemMem },
 	{ OP_MERGETO64, MATCH_MEMORY64, MATCH_CONSTANT, MATCH_REGISTER, MATCH_NIL, &CCodeGen_x86::Emit_MergeTo64_Mem64CstReg },
 	{ OP_MERGETO64, MATCH_MEMORY64, MATCH_CONSTANT, MATCH_MEMORY,   MATCH_NIL, &CCodeGen_x86::Emit_MergeTo64_Mem64CstMem },
+	{ OP_MERGETO64, MATCH_MEMORY64, MATCH_REGISTER, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_x86::Emit_MergeTo64_Mem64RegCst },
+	{ OP_MERGETO64, MATCH_MEMORY64, MATCH_MEMORY,   MATCH_CONSTANT, MATCH_NIL, &CCodeGen_x86::Emit_MergeTo64_Mem64MemCst },
 
-	{ OP_EXTLOW64, MATCH_REGISTER, MATCH_TEMPORARY64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_ExtLow64RegTmp64 },
-	{ OP_EXTLOW64, MATCH_MEMORY,   MATCH_TEMPORARY64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_ExtLow64MemTmp64 },
+	{ OP_EXTLOW64, MATCH_REGISTER, MATCH_MEMORY64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_ExtLow64RegMem64 },
+	{ OP_EXTLOW64, MATCH_MEMORY,   MATCH_MEMORY64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_ExtLow64MemMem64 },
 	
-	{ OP_EXTHIGH64, MATCH_REGISTER, MATCH_TEMPORARY64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_ExtHigh64RegTmp64 },
-	{ OP_EXTHIGH64, MATCH_MEMORY,   MATCH_TEMPORARY64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_ExtHigh64MemTmp64 },
+	{ OP_EXTHIGH64, MATCH_REGISTER, MATCH_MEMORY64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_ExtHigh64RegMem64 },
+	{ OP_EXTHIGH64, MATCH_MEMORY,   MATCH_MEMORY64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_ExtHigh64MemMem64 },
 
 	{ OP_LOADFROMREF, MATCH_VARIABLE,    MATCH_VAR_REF, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_LoadFromRef_VarVar    },
 	{ OP_LOADFROMREF, MATCH_REGISTER128, MATCH_VAR_REF, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_LoadFromRef_Md_RegVar },
@@ -149,16 +152,46 @@ CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_constMatchers[] =
 	{ OP_MOV, MATCH_NIL, MATCH_NIL, MATCH_NIL, MATCH_NIL, nullptr },
 };
 
+const CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_shiftBmi2ConstMatchers[] = 
+{
+	SHIFT_BMI2_CONST_MATCHERS(OP_SRL, SHIFTOP_SRL)
+	SHIFT_BMI2_CONST_MATCHERS(OP_SRA, SHIFTOP_SRA)
+	SHIFT_BMI2_CONST_MATCHERS(OP_SLL, SHIFTOP_SLL)
+
+	{ OP_MOV, MATCH_NIL, MATCH_NIL, MATCH_NIL, MATCH_NIL, nullptr },
+};
+
+const CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_lzcLzcntConstMatchers[] = 
+{
+	{ OP_LZC, MATCH_VARIABLE, MATCH_VARIABLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Lzc_Lzcnt_VarVar },
+
+	{ OP_MOV, MATCH_NIL, MATCH_NIL, MATCH_NIL, MATCH_NIL, nullptr },
+};
+
 CCodeGen_x86::CCodeGen_x86()
 {
 	SetGenerationFlags();
 
+	//Matchers inserted first have priority
+	if(m_hasBmi2)
+	{
+		InsertMatchers(g_shiftBmi2ConstMatchers);
+	}
+	if(m_hasLzcnt)
+	{
+		InsertMatchers(g_lzcLzcntConstMatchers);
+	}
+
 	InsertMatchers(g_constMatchers);
 	InsertMatchers(g_fpuConstMatchers);
 
 	if(m_hasAvx)
 	{
 		InsertMatchers(g_fpuAvxConstMatchers);
+		if(m_hasAvx2)
+		{
+			InsertMatchers(g_mdAvx2ConstMatchers);
+		}
 		InsertMatchers(g_mdAvxConstMatchers);
 	}
 	else
@@ -200,53 +233,116 @@ void CCodeGen_x86::GenerateCode(const StatementList& statements, unsigned int st
 	stackSize = (stackSize + 0xF) & ~0xF;
 	m_stackLevel = 0;
 
+	m_assembler.SetStats(BeginAssemblerStats());
 	m_assembler.Begin();
 	{
 		CX86Assembler::LABEL rootLabel = m_assembler.CreateLabel();
 		m_assembler.MarkLabel(rootLabel);
 
+		m_assembler.BeginStatsRegion(CAssemblerStats::CATEGORY_PROLOG);
 		Emit_Prolog(statements, stackSize);
 
 		for(const auto& statement : statements)
 		{
-			bool found = false;
-			auto begin = m_matchers.lower_bound(statement.op);
-			auto end = m_matchers.upper_bound(statement.op);
-
-			for(auto matchIterator(begin); matchIterator != end; matchIterator++)
-			{
-				const auto& matcher(matchIterator->second);
-				if(!SymbolMatches(matcher.dstType, statement.dst)) continue;
-				if(!SymbolMatches(matcher.src1Type, statement.src1)) continue;
-				if(!SymbolMatches(matcher.src2Type, statement.src2)) continue;
-				if(!SymbolMatches(matcher.src3Type, statement.src3)) continue;
-				matcher.emitter(statement);
-				found = true;
-				break;
-			}
-			assert(found);
-			if(!found)
+			auto emitter = FindEmitter(statement);
+			assert(emitter);
+			if(!emitter)
 			{
 				throw std::exception();
 			}
+			m_assembler.BeginStatsRegion(GetStatementStatsCategory(statement), statement.op);
+			(this->*emitter)(statement);
 		}
 
+		m_assembler.BeginStatsRegion(CAssemblerStats::CATEGORY_EPILOG);
 		Emit_Epilog();
 		m_assembler.Ret();
 	}
-	m_assembler.End();
+	{
+		CCompileStats::CPassScope passScope(m_compileStats, CCompileStats::PASS_ASSEMBLEREND);
+		m_assembler.End();
+	}
+	m_assembler.SetStats(nullptr);
+	EndAssemblerStats();
+
+	AlignDynamicExits();
 
 	if(m_externalSymbolReferencedHandler)
 	{
 		for(const auto& symbolRefLabel : m_symbolReferenceLabels)
 		{
 			uint32 offset = m_assembler.GetLabelOffset(symbolRefLabel.second);
+			offset += GetDynamicExitShift(offset);
 			m_externalSymbolReferencedHandler(symbolRefLabel.first, offset, CCodeGen::SYMBOL_REF_TYPE::NATIVE_POINTER);
 		}
 	}
 
+	if(m_dynamicExitHandler)
+	{
+		for(const auto& dynamicExit : m_dynamicExits)
+		{
+			m_dynamicExitHandler(m_assembler.GetLabelOffset(dynamicExit.label) + dynamicExit.shift);
+		}
+	}
+
 	m_labels.clear();
 	m_symbolReferenceLabels.clear();
+	m_dynamicExits.clear();
+}
+
+void CCodeGen_x86::MarkDynamicExitEnd(DYNAMIC_EXIT& dynamicExit)
+{
+	assert(dynamicExit.label != 0);
+	assert(dynamicExit.alignment != 0);
+	assert(dynamicExit.alignmentOffset < dynamicExit.alignment);
+	dynamicExit.endLabel = m_assembler.CreateLabel();
+	m_assembler.MarkLabel(dynamicExit.endLabel);
+	//Slack used by AlignDynamicExits, never executed
+	for(unsigned int i = 0; i < (dynamicExit.alignment - 1); i++)
+	{
+		m_assembler.Int3();
+	}
+}
+
+void CCodeGen_x86::AlignDynamicExits()
+{
+	//Final offsets are only known after jump relaxation. CMemoryFunction patches the branch's rel32
+	//and the target immediate with single aligned stores, move each exit forward into its slack so
+	//both end up naturally aligned (code buffers are at least 16 bytes aligned).
+	for(auto& dynamicExit : m_dynamicExits)
+	{
+		uint32 start = m_assembler.GetLabelOffset(dynamicExit.label);
+		uint32 end = m_assembler.GetLabelOffset(dynamicExit.endLabel);
+		uint32 alignment = dynamicExit.alignment;
+		dynamicExit.shift = (dynamicExit.alignmentOffset - start) & (alignment - 1);
+		if(dynamicExit.shift == 0) continue;
+
+		std::vector<uint8> code(end - start);
+		m_stream->Seek(start, Framework::STREAM_SEEK_SET);
+		m_stream->Read(code.data(), code.size());
+		m_stream->Seek(start, Framework::STREAM_SEEK_SET);
+		for(uint32 i = 0; i < dynamicExit.shift; i++)
+		{
+			//NOP, falls through to the exit
+			m_stream->Write8(0x90);
+		}
+		m_stream->Write(code.data(), code.size());
+	}
+	m_stream->Seek(0, Framework::STREAM_SEEK_END);
+}
+
+uint32 CCodeGen_x86::GetDynamicExitShift(uint32 offset) const
+{
+	for(const auto& dynamicExit : m_dynamicExits)
+	{
+		uint32 start = m_assembler.GetLabelOffset(dynamicExit.label);
+		uint32 end = m_assembler.GetLabelOffset(dynamicExit.endLabel);
+		if((offset >= start) && (offset < end))
+		{
+			return dynamicExit.shift;
+		}
+	}
+	return 0;
 }
 
 void CCodeGen_x86::InsertMatchers(const CONSTMATCHER* constMatchers)
@@ -259,39 +355,97 @@ void CCodeGen_x86::InsertMatchers(const CONSTMATCHER* constMatchers)
 		matcher.src1Type = constMatcher->src1Type;
 		matcher.src2Type = constMatcher->src2Type;
 		matcher.src3Type = constMatcher->src3Type;
-		matcher.emitter  = std::bind(constMatcher->emitter, this, std::placeholders::_1);
-		m_matchers.insert(MatcherMapType::value_type(matcher.op, matcher));
+		matcher.emitter  = static_cast<CodeEmitterType>(constMatcher->emitter);
+		InsertMatcher(matcher);
 	}
 }
 
 void CCodeGen_x86::SetGenerationFlags()
+{
+	const auto& cpuFeatures = GetCpuFeatures();
+	m_hasSsse3 = cpuFeatures.hasSsse3;
+	m_hasSse41 = cpuFeatures.hasSse41;
+	m_hasAvx = cpuFeatures.hasAvx;
+	m_hasAvx2 = cpuFeatures.hasAvx2;
+	m_hasBmi2 = cpuFeatures.hasBmi2;
+	m_hasLzcnt = cpuFeatures.hasLzcnt;
+}
+
+uint32 CCodeGen_x86::GetInstructionSetOptions() const
+{
+	uint32 options = 0;
+	if(m_hasSsse3) options |= 0x01;
+	if(m_hasSse41) options |= 0x02;
+	if(m_hasAvx)   options |= 0x04;
+	if(m_hasAvx2)  options |= 0x08;
+	if(m_hasBmi2)  options |= 0x10;
+	if(m_hasLzcnt) options |= 0x20;
+	return options;
+}
+
+const CCodeGen_x86::CPU_FEATURES& CCodeGen_x86::GetCpuFeatures()
+{
+	static const CPU_FEATURES cpuFeatures = ProbeCpuFeatures();
+	return cpuFeatures;
+}
+
+CCodeGen_x86::CPU_FEATURES CCodeGen_x86::ProbeCpuFeatures()
 {
 	static const uint32 CPUID_FLAG_SSSE3 = 0x000200;
 	static const uint32 CPUID_FLAG_SSE41 = 0x080000;
 	static const uint32 CPUID_FLAG_AVX = 0x10000000;
+	//Leaf 7, EBX
+	static const uint32 CPUID_FLAG_AVX2 = 0x000020;
+	static const uint32 CPUID_FLAG_BMI2 = 0x000100;
+	//Leaf 0x80000001, ECX
+	static const uint32 CPUID_FLAG_LZCNT = 0x000020;
+
+	CPU_FEATURES cpuFeatures;
 
 #ifdef HAS_CPUID
 
+	std::array<uint32, 4> extendedFeatureInfo = {};
+	std::array<uint32, 4> extendedProcessorInfo = {};
+
 #ifdef HAS_CPUID_MSVC
-	std::array<int, 4> cpuInfo;
+	std::array<int, 4> cpuInfo = {};
+	__cpuid(cpuInfo.data(), 0);
+	int maxLeaf = cpuInfo[0];
+	if(maxLeaf >= 7)
+	{
+		__cpuidex(reinterpret_cast<int*>(extendedFeatureInfo.data()), 7, 0);
+	}
+	__cpuid(cpuInfo.data(), 0x80000000);
+	if(static_cast<uint32>(cpuInfo[0]) >= 0x80000001)
+	{
+		__cpuid(reinterpret_cast<int*>(extendedProcessorInfo.data()), 0x80000001);
+	}
 	__cpuid(cpuInfo.data(), 1);
 #endif //HAS_CPUID_MSVC
 
 #ifdef HAS_CPUID_GCC
-	std::array<unsigned int, 4> cpuInfo;
+	std::array<unsigned int, 4> cpuInfo = {};
+	//These return 0 and leave the outputs untouched if the leaf isn't supported
+	__get_cpuid_count(7, 0, &extendedFeatureInfo[0], &extendedFeatureInfo[1], &extendedFeatureInfo[2], &extendedFeatureInfo[3]);
+	__get_cpuid(0x80000001, &extendedProcessorInfo[0], &extendedProcessorInfo[1], &extendedProcessorInfo[2], &extendedProcessorInfo[3]);
 	__get_cpuid(1, &cpuInfo[0], &cpuInfo[1], &cpuInfo[2], &cpuInfo[3]);
 #endif //HAS_CPUID_GCC
 
-	m_hasSsse3 = (cpuInfo[2] & CPUID_FLAG_SSSE3) != 0;
-	m_hasSse41 = (cpuInfo[2] & CPUID_FLAG_SSE41) != 0;
-	m_hasAvx = (cpuInfo[2] & CPUID_FLAG_AVX) != 0;
+	cpuFeatures.hasSsse3 = (cpuInfo[2] & CPUID_FLAG_SSSE3) != 0;
+	cpuFeatures.hasSse41 = (cpuInfo[2] & CPUID_FLAG_SSE41) != 0;
+	cpuFeatures.hasAvx = (cpuInfo[2] & CPUID_FLAG_AVX) != 0;
+	cpuFeatures.hasAvx2 = cpuFeatures.hasAvx && ((extendedFeatureInfo[1] & CPUID_FLAG_AVX2) != 0);
+	cpuFeatures.hasBmi2 = (extendedFeatureInfo[1] & CPUID_FLAG_BMI2) != 0;
+	cpuFeatures.hasLzcnt = (extendedProcessorInfo[2] & CPUID_FLAG_LZCNT) != 0;
 
 #endif //HAS_CPUID
 
+	return cpuFeatures;
 }
 
 void CCodeGen_x86::SetStream(Framework::CStream* stream)
 {
+	m_stream = stream;
 	m_assembler.SetStream(stream);
 }
 
@@ -620,6 +774,26 @@ void CCodeGen_x86::Emit_Lzc_MemVar(const STATEMENT& statement)
 	m_assembler.MovGd(MakeMemorySymbolAddress(dst), dstRegister);
 }
 
+void CCodeGen_x86::Emit_Lzc_Lzcnt_VarVar(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	auto valueRegister = CX86Assembler::rAX;
+	auto signRegister = CX86Assembler::rDX;
+	auto dstRegister = PrepareSymbolRegisterDef(dst, CX86Assembler::rAX);
+
+	//Invert negative values to count leading ones, LZCNT gives 32 for 0 which becomes 31 like the other path
+	m_assembler.MovEd(valueRegister, MakeVariableSymbolAddress(src1));
+	m_assembler.MovEd(signRegister, CX86Assembler::MakeRegisterAddress(valueRegister));
+	m_assembler.SarEd(CX86Assembler::MakeRegisterAddress(signRegister), 31);
+	m_assembler.XorEd(valueRegister, CX86Assembler::MakeRegisterAddress(signRegister));
+	m_assembler.LzcntEd(dstRegister, CX86Assembler::MakeRegisterAddress(valueRegister));
+	m_assembler.SubId(CX86Assembler::MakeRegisterAddress(dstRegister), 1);
+
+	CommitSymbolRegister(dst, dstRegister);
+}
+
 void CCodeGen_x86::Emit_Mov_RegReg(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
@@ -771,47 +945,68 @@ void CCodeGen_x86::Emit_MergeTo64_Mem64CstMem(const STATEMENT& statement)
 	m_assembler.MovGd(MakeMemory64SymbolHiAddress(dst), CX86Assembler::rDX);
 }
 
-void CCodeGen_x86::Emit_ExtLow64RegTmp64(const STATEMENT& statement)
+void CCodeGen_x86::Emit_MergeTo64_Mem64RegCst(const STATEMENT& statement)
+{
+	CSymbol* dst = statement.dst->GetSymbol().get();
+	CSymbol* src1 = statement.src1->GetSymbol().get();
+	CSymbol* src2 = statement.src2->GetSymbol().get();
+
+	assert(src1->m_type == SYM_REGISTER);
+	assert(src2->m_type == SYM_CONSTANT);
+
+	m_assembler.MovGd(MakeMemory64SymbolLoAddress(dst), m_registers[src1->m_valueLow]);
+	m_assembler.MovId(MakeMemory64SymbolHiAddress(dst), src2->m_valueLow);
+}
+
+void CCodeGen_x86::Emit_MergeTo64_Mem64MemCst(const STATEMENT& statement)
+{
+	CSymbol* dst = statement.dst->GetSymbol().get();
+	CSymbol* src1 = statement.src1->GetSymbol().get();
+	CSymbol* src2 = statement.src2->GetSymbol().get();
+
+	assert(src2->m_type == SYM_CONSTANT);
+
+	m_assembler.MovEd(CX86Assembler::rAX, MakeMemorySymbolAddress(src1));
+
+	m_assembler.MovGd(MakeMemory64SymbolLoAddress(dst), CX86Assembler::rAX);
+	m_assembler.MovId(MakeMemory64SymbolHiAddress(dst), src2->m_valueLow);
+}
+
+void CCodeGen_x86::Emit_ExtLow64RegMem64(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
 
 	assert(dst->m_type  == SYM_REGISTER);
-	assert(src1->m_type == SYM_TEMPORARY64);
 
-	m_assembler.MovEd(m_registers[dst->m_valueLow], CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rSP, src1->m_stackLocation + m_stackLevel + 0));
+	m_assembler.MovEd(m_registers[dst->m_valueLow], MakeMemory64SymbolLoAddress(src1));
 }
 
-void CCodeGen_x86::Emit_ExtLow64MemTmp64(const STATEMENT& statement)
+void CCodeGen_x86::Emit_ExtLow64MemMem64(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
-	assert(src1->m_type == SYM_TEMPORARY64);
-
-	m_assembler.MovEd(CX86Assembler::rAX, CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rSP, src1->m_stackLocation + m_stackLevel + 0));
+	m_assembler.MovEd(CX86Assembler::rAX, MakeMemory64SymbolLoAddress(src1));
 	m_assembler.MovGd(MakeMemorySymbolAddress(dst), CX86Assembler::rAX);
 }
 
-void CCodeGen_x86::Emit_ExtHigh64RegTmp64(const STATEMENT& statement)
+void CCodeGen_x86::Emit_ExtHigh64RegMem64(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
 
 	assert(dst->m_type  == SYM_REGISTER);
-	assert(src1->m_type == SYM_TEMPORARY64);
 
-	m_assembler.MovEd(m_registers[dst->m_valueLow], CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rSP, src1->m_stackLocation + m_stackLevel + 4));
+	m_assembler.MovEd(m_registers[dst->m_valueLow], MakeMemory64SymbolHiAddress(src1));
 }
 
-void CCodeGen_x86::Emit_ExtHigh64MemTmp64(const STATEMENT& statement)
+void CCodeGen_x86::Emit_ExtHigh64MemMem64(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
 
-	assert(src1->m_type == SYM_TEMPORARY64);
-
-	m_assembler.MovEd(CX86Assembler::rAX, CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rSP, src1->m_stackLocation + m_stackLevel + 4));
+	m_assembler.MovEd(CX86Assembler::rAX, MakeMemory64SymbolHiAddress(src1));
 	m_assembler.MovGd(MakeMemorySymbolAddress(dst), CX86Assembler::rAX);
 }
 
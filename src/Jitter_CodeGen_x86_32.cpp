@@ -4,14 +4,14 @@
 
 using namespace Jitter;
 
-CX86Assembler::REGISTER CCodeGen_x86_32::g_registers[MAX_REGISTERS] =
+const CX86Assembler::REGISTER CCodeGen_x86_32::g_registers[MAX_REGISTERS] =
 {
 	CX86Assembler::rBX,
 	CX86Assembler::rSI,
 	CX86Assembler::rDI,
 };
 
-CX86Assembler::XMMREGISTER CCodeGen_x86_32::g_mdRegisters[MAX_MDREGISTERS] =
+const CX86Assembler::XMMREGISTER CCodeGen_x86_32::g_mdRegisters[MAX_MDREGISTERS] =
 {
 	CX86Assembler::xMM4,
 	CX86Assembler::xMM5,
@@ -19,7 +19,7 @@ CX86Assembler::XMMREGISTER CCodeGen_x86_32::g_mdRegisters[MAX_MDREGISTERS] =
 	CX86Assembler::xMM7
 };
 
-CCodeGen_x86_32::CONSTMATCHER CCodeGen_x86_32::g_constMatchers[] = 
+const CCodeGen_x86_32::CONSTMATCHER CCodeGen_x86_32::g_constMatchers[] = 
 { 
 	{ OP_PARAM,			MATCH_NIL,			MATCH_CONTEXT,		MATCH_NIL,			&CCodeGen_x86_32::Emit_Param_Ctx				},
 	{ OP_PARAM,			MATCH_NIL,			MATCH_MEMORY,		MATCH_NIL,			&CCodeGen_x86_32::Emit_Param_Mem				},
@@ -39,7 +39,9 @@ CCodeGen_x86_32::CONSTMATCHER CCodeGen_x86_32::g_constMatchers[] =
 	{ OP_RETVAL,		MATCH_MEMORY64,		MATCH_NIL,			MATCH_NIL,			&CCodeGen_x86_32::Emit_RetVal_Mem64				},
 
 	{ OP_EXTERNJMP,		MATCH_NIL,			MATCH_CONSTANTPTR,	MATCH_NIL,			&CCodeGen_x86_32::Emit_ExternJmp				},
-	{ OP_EXTERNJMP_DYN,	MATCH_NIL,			MATCH_CONSTANTPTR,	MATCH_NIL,			&CCodeGen_x86_32::Emit_ExternJmp				},
+	{ OP_EXTERNJMP_DYN,	MATCH_NIL,			MATCH_CONSTANTPTR,	MATCH_NIL,			&CCodeGen_x86_32::Emit_ExternJmpDynamic		},
+
+	{ OP_INCCOUNTER,	MATCH_NIL,			MATCH_CONSTANTPTR,	MATCH_NIL,			&CCodeGen_x86_32::Emit_IncCounter			},
 
 	{ OP_MOV,			MATCH_MEMORY64,		MATCH_MEMORY64,		MATCH_NIL,			&CCodeGen_x86_32::Emit_Mov_Mem64Mem64			},
 	{ OP_MOV,			MATCH_MEMORY64,		MATCH_CONSTANT64,	MATCH_NIL,			&CCodeGen_x86_32::Emit_Mov_Mem64Cst64			},
@@ -102,15 +104,27 @@ CCodeGen_x86_32::CCodeGen_x86_32()
 	CCodeGen_x86::m_registers = g_registers;
 	CCodeGen_x86::m_mdRegisters = g_mdRegisters;
 
-	for(CONSTMATCHER* constMatcher = g_constMatchers; constMatcher->emitter != NULL; constMatcher++)
+	for(const CONSTMATCHER* constMatcher = g_constMatchers; constMatcher->emitter != NULL; constMatcher++)
 	{
 		MATCHER matcher;
 		matcher.op			= constMatcher->op;
 		matcher.dstType		= constMatcher->dstType;
 		matcher.src1Type	= constMatcher->src1Type;
 		matcher.src2Type	= constMatcher->src2Type;
-		matcher.emitter		= std::bind(constMatcher->emitter, this, std::placeholders::_1);
-		m_matchers.insert(MatcherMapType::value_type(matcher.op, matcher));
+		matcher.emitter		= static_cast<CodeEmitterType>(constMatcher->emitter);
+		InsertMatcher(matcher);
+	}
+
+	//Needs a third source operand, which the table above doesn't have
+	{
+		MATCHER matcher;
+		matcher.op			= OP_LOOKUP;
+		matcher.dstType		= MATCH_NIL;
+		matcher.src1Type	= MATCH_ANY;
+		matcher.src2Type	= MATCH_CONSTANTPTR;
+		matcher.src3Type	= MATCH_CONSTANT;
+		matcher.emitter		= static_cast<CodeEmitterType>(&CCodeGen_x86_32::Emit_Lookup);
+		InsertMatcher(matcher);
 	}
 }
 
@@ -293,11 +307,34 @@ bool CCodeGen_x86_32::CanHold128BitsReturnValueInRegisters() const
 	return false;
 }
 
+bool CCodeGen_x86_32::CanHoldFpSingleInMdRegisters() const
+{
+	return true;
+}
+
+uint32 CCodeGen_x86_32::GetCallPreservedRegisterMask() const
+{
+	//EBX, ESI and EDI are callee-saved
+	return (1 << MAX_REGISTERS) - 1;
+}
+
+uint32 CCodeGen_x86_32::GetCallPreservedMdRegisterMask() const
+{
+	return 0;
+}
+
 uint32 CCodeGen_x86_32::GetPointerSize() const
 {
 	return 4;
 }
 
+uint32 CCodeGen_x86_32::GetConfigurationKey() const
+{
+	uint32 options = GetInstructionSetOptions();
+	if(m_hasImplicitRetValueParam) options |= 0x100;
+	return MakeConfigurationKey(CONFIGURATION_BACKEND_X86_32, options);
+}
+
 void CCodeGen_x86_32::Emit_Param_Ctx(const STATEMENT& statement)
 {
 	m_params.push_back(
@@ -481,6 +518,75 @@ void CCodeGen_x86_32::Emit_ExternJmp(const STATEMENT& statement)
 	m_assembler.JmpEd(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX));
 }
 
+void CCodeGen_x86_32::Emit_ExternJmpDynamic(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+	
+	Emit_Epilog();
+	//Jumps to the next instruction until the exit is linked to its target by CMemoryFunction::LinkExit
+	DYNAMIC_EXIT dynamicExit;
+	dynamicExit.label = m_assembler.CreateLabel();
+	dynamicExit.alignment = 4;
+	dynamicExit.alignmentOffset = 3;
+	m_assembler.MarkLabel(dynamicExit.label);
+	m_assembler.JmpJd(0);
+	//Once the exit is aligned, the rel32 and the imm32 are both at 0 modulo 4
+	for(unsigned int i = 0; i < 3; i++)
+	{
+		m_assembler.Nop();
+	}
+	m_assembler.MovId(CX86Assembler::rAX, src1->m_valueLow);
+	auto symbolRefLabel = m_assembler.CreateLabel();
+	m_assembler.MarkLabel(symbolRefLabel, -4);
+	m_symbolReferenceLabels.push_back(std::make_pair(src1->GetConstantPtr(), symbolRefLabel));
+	m_assembler.JmpEd(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX));
+	MarkDynamicExitEnd(dynamicExit);
+	m_dynamicExits.push_back(dynamicExit);
+}
+
+void CCodeGen_x86_32::Emit_Lookup(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+	auto src2 = statement.src2->GetSymbol().get();
+	auto src3 = statement.src3->GetSymbol().get();
+
+	assert(src2->m_type == SYM_CONSTANTPTR);
+	assert(src3->m_type == SYM_CONSTANT);
+
+	auto missLabel = m_assembler.CreateLabel();
+	auto addressRegister = PrepareSymbolRegisterUse(src1, CX86Assembler::rDX);
+
+	//Entries are 8 bytes (tag, code pointer)
+	m_assembler.MovEd(CX86Assembler::rAX, CX86Assembler::MakeRegisterAddress(addressRegister));
+	m_assembler.AndId(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX), src3->m_valueLow);
+	m_assembler.MovId(CX86Assembler::rCX, src2->m_valueLow);
+	auto symbolRefLabel = m_assembler.CreateLabel();
+	m_assembler.MarkLabel(symbolRefLabel, -4);
+	m_symbolReferenceLabels.push_back(std::make_pair(src2->GetConstantPtr(), symbolRefLabel));
+	m_assembler.LeaGd(CX86Assembler::rAX, CX86Assembler::MakeBaseIndexScaleAddress(CX86Assembler::rCX, CX86Assembler::rAX, 8));
+
+	m_assembler.CmpEd(addressRegister, CX86Assembler::MakeIndRegAddress(CX86Assembler::rAX));
+	m_assembler.JnzJx(missLabel);
+
+	Emit_Epilog();
+	m_assembler.JmpEd(CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rAX, 4));
+
+	m_assembler.MarkLabel(missLabel);
+}
+
+void CCodeGen_x86_32::Emit_IncCounter(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+
+	assert(src1->m_type == SYM_CONSTANTPTR);
+
+	m_assembler.MovId(CX86Assembler::rAX, src1->m_valueLow);
+	auto symbolRefLabel = m_assembler.CreateLabel();
+	m_assembler.MarkLabel(symbolRefLabel, -4);
+	m_symbolReferenceLabels.push_back(std::make_pair(src1->GetConstantPtr(), symbolRefLabel));
+	m_assembler.AddId(CX86Assembler::MakeIndRegAddress(CX86Assembler::rAX), 1);
+}
+
 void CCodeGen_x86_32::Emit_Mov_Mem64Mem64(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
@@ -4,7 +4,7 @@
 
 using namespace Jitter;
 
-CX86Assembler::REGISTER CCodeGen_x86_64::g_systemVRegisters[SYSTEMV_MAX_REGISTERS] =
+const CX86Assembler::REGISTER CCodeGen_x86_64::g_systemVRegisters[SYSTEMV_MAX_REGISTERS] =
 {
 	CX86Assembler::rBX,
 	CX86Assembler::r12,
@@ -13,7 +13,7 @@ CX86Assembler::REGISTER CCodeGen_x86_64::g_systemVRegisters[SYSTEMV_MAX_REGISTER
 	CX86Assembler::r15,
 };
 
-CX86Assembler::REGISTER CCodeGen_x86_64::g_systemVParamRegs[SYSTEMV_MAX_PARAMS] =
+const CX86Assembler::REGISTER CCodeGen_x86_64::g_systemVParamRegs[SYSTEMV_MAX_PARAMS] =
 {
 	CX86Assembler::rDI,
 	CX86Assembler::rSI,
@@ -23,7 +23,7 @@ CX86Assembler::REGISTER CCodeGen_x86_64::g_systemVParamRegs[SYSTEMV_MAX_PARAMS]
 	CX86Assembler::r9,
 };
 
-CX86Assembler::REGISTER CCodeGen_x86_64::g_win32Registers[WIN32_MAX_REGISTERS] =
+const CX86Assembler::REGISTER CCodeGen_x86_64::g_win32Registers[WIN32_MAX_REGISTERS] =
 {
 	CX86Assembler::rBX,
 	CX86Assembler::rSI,
@@ -34,7 +34,7 @@ CX86Assembler::REGISTER CCodeGen_x86_64::g_win32Registers[WIN32_MAX_REGISTERS] =
 	CX86Assembler::r15,
 };
 
-CX86Assembler::REGISTER CCodeGen_x86_64::g_win32ParamRegs[WIN32_MAX_PARAMS] =
+const CX86Assembler::REGISTER CCodeGen_x86_64::g_win32ParamRegs[WIN32_MAX_PARAMS] =
 {
 	CX86Assembler::rCX,
 	CX86Assembler::rDX,
@@ -43,7 +43,7 @@ CX86Assembler::REGISTER CCodeGen_x86_64::g_win32ParamRegs[WIN32_MAX_PARAMS] =
 };
 
 //xMM0->xMM3 are used internally for temporary uses
-CX86Assembler::XMMREGISTER CCodeGen_x86_64::g_mdRegisters[MAX_MDREGISTERS] =
+const CX86Assembler::XMMREGISTER CCodeGen_x86_64::g_mdRegisters[MAX_MDREGISTERS] =
 {
 	CX86Assembler::xMM4,
 	CX86Assembler::xMM5,
@@ -194,7 +194,7 @@ void CCodeGen_x86_64::Emit_Shift64_RelRelCst(const STATEMENT& statement)
 	{ SHIFTOP_CST, MATCH_RELATIVE64, MATCH_RELATIVE64, MATCH_MEMORY,   MATCH_NIL, &CCodeGen_x86_64::Emit_Shift64_RelRelMem<SHIFTOP> }, \
 	{ SHIFTOP_CST, MATCH_RELATIVE64, MATCH_RELATIVE64, MATCH_CONSTANT, MATCH_NIL, &CCodeGen_x86_64::Emit_Shift64_RelRelCst<SHIFTOP> },
 
-CCodeGen_x86_64::CONSTMATCHER CCodeGen_x86_64::g_constMatchers[] = 
+const CCodeGen_x86_64::CONSTMATCHER CCodeGen_x86_64::g_constMatchers[] = 
 {
 	{ OP_PARAM, MATCH_NIL, MATCH_CONTEXT,     MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_Param_Ctx    },
 	{ OP_PARAM, MATCH_NIL, MATCH_REGISTER,    MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_Param_Reg    },
@@ -216,7 +216,11 @@ CCodeGen_x86_64::CONSTMATCHER CCodeGen_x86_64::g_constMatchers[] =
 	{ OP_RETVAL, MATCH_MEMORY128,   MATCH_NIL, MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_RetVal_Mem128 },
 
 	{ OP_EXTERNJMP,     MATCH_NIL, MATCH_CONSTANTPTR, MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_ExternJmp },
-	{ OP_EXTERNJMP_DYN, MATCH_NIL, MATCH_CONSTANTPTR, MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_ExternJmp },
+	{ OP_EXTERNJMP_DYN, MATCH_NIL, MATCH_CONSTANTPTR, MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_ExternJmpDynamic },
+
+	{ OP_LOOKUP, MATCH_NIL, MATCH_ANY, MATCH_CONSTANTPTR, MATCH_CONSTANT, &CCodeGen_x86_64::Emit_Lookup },
+
+	{ OP_INCCOUNTER, MATCH_NIL, MATCH_CONSTANTPTR, MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_IncCounter },
 
 	{ OP_MOV, MATCH_MEMORY64,   MATCH_MEMORY64,   MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_Mov_Mem64Mem64 },
 	{ OP_MOV, MATCH_RELATIVE64, MATCH_CONSTANT64, MATCH_NIL, MATCH_NIL, &CCodeGen_x86_64::Emit_Mov_Rel64Cst64 },
@@ -264,7 +268,7 @@ CCodeGen_x86_64::CCodeGen_x86_64()
 	SetPlatformAbi(PLATFORM_ABI_SYSTEMV);
 	CCodeGen_x86::m_mdRegisters = g_mdRegisters;
 
-	for(CONSTMATCHER* constMatcher = g_constMatchers; constMatcher->emitter != NULL; constMatcher++)
+	for(const CONSTMATCHER* constMatcher = g_constMatchers; constMatcher->emitter != NULL; constMatcher++)
 	{
 		MATCHER matcher;
 		matcher.op       = constMatcher->op;
@@ -272,8 +276,8 @@ CCodeGen_x86_64::CCodeGen_x86_64()
 		matcher.src1Type = constMatcher->src1Type;
 		matcher.src2Type = constMatcher->src2Type;
 		matcher.src3Type = constMatcher->src3Type;
-		matcher.emitter  = std::bind(constMatcher->emitter, this, std::placeholders::_1);
-		m_matchers.insert(MatcherMapType::value_type(matcher.op, matcher));
+		matcher.emitter  = static_cast<CodeEmitterType>(constMatcher->emitter);
+		InsertMatcher(matcher);
 	}
 }
 
@@ -317,11 +321,36 @@ bool CCodeGen_x86_64::CanHold128BitsReturnValueInRegisters() const
 	return m_hasMdRegRetValues;
 }
 
+bool CCodeGen_x86_64::CanHoldFpSingleInMdRegisters() const
+{
+	return true;
+}
+
+uint32 CCodeGen_x86_64::GetCallPreservedRegisterMask() const
+{
+	//All allocatable registers are callee-saved on both ABIs
+	return (1 << m_maxRegisters) - 1;
+}
+
+uint32 CCodeGen_x86_64::GetCallPreservedMdRegisterMask() const
+{
+	//xMM6->xMM15 are callee-saved on Win32, no XMM register is preserved on SystemV
+	return (m_platformAbi == PLATFORM_ABI_WIN32) ? (((1 << MAX_MDREGISTERS) - 1) & ~0x3) : 0;
+}
+
 uint32 CCodeGen_x86_64::GetPointerSize() const
 {
 	return 8;
 }
 
+uint32 CCodeGen_x86_64::GetConfigurationKey() const
+{
+	uint32 options = GetInstructionSetOptions();
+	options |= static_cast<uint32>(m_platformAbi) << 8;
+	if(m_hasMdRegRetValues) options |= 0x10000;
+	return MakeConfigurationKey(CONFIGURATION_BACKEND_X86_64, options);
+}
+
 void CCodeGen_x86_64::Emit_Prolog(const StatementList& statements, unsigned int stackSize)
 {
 	m_params.clear();
@@ -612,6 +641,78 @@ void CCodeGen_x86_64::Emit_ExternJmp(const STATEMENT& statement)
 	m_assembler.JmpEd(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX));
 }
 
+void CCodeGen_x86_64::Emit_ExternJmpDynamic(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+	
+	m_assembler.MovEq(m_paramRegs[0], CX86Assembler::MakeRegisterAddress(g_baseRegister));
+	Emit_Epilog();
+	//Jumps to the next instruction until the exit is linked to its target by CMemoryFunction::LinkExit
+	DYNAMIC_EXIT dynamicExit;
+	dynamicExit.label = m_assembler.CreateLabel();
+	dynamicExit.alignment = 8;
+	dynamicExit.alignmentOffset = 3;
+	m_assembler.MarkLabel(dynamicExit.label);
+	m_assembler.JmpJd(0);
+	//Once the exit is aligned, the rel32 is at 0 modulo 4 and the imm64 at 0 modulo 8
+	for(unsigned int i = 0; i < 6; i++)
+	{
+		m_assembler.Nop();
+	}
+	m_assembler.MovIq(CX86Assembler::rAX, CombineConstant64(src1->m_valueLow, src1->m_valueHigh));
+	auto symbolRefLabel = m_assembler.CreateLabel();
+	m_assembler.MarkLabel(symbolRefLabel, -8);
+	m_symbolReferenceLabels.push_back(std::make_pair(src1->GetConstantPtr(), symbolRefLabel));
+	m_assembler.JmpEd(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX));
+	MarkDynamicExitEnd(dynamicExit);
+	m_dynamicExits.push_back(dynamicExit);
+}
+
+void CCodeGen_x86_64::Emit_Lookup(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+	auto src2 = statement.src2->GetSymbol().get();
+	auto src3 = statement.src3->GetSymbol().get();
+
+	assert(src2->m_type == SYM_CONSTANTPTR);
+	assert(src3->m_type == SYM_CONSTANT);
+
+	auto missLabel = m_assembler.CreateLabel();
+	auto addressRegister = PrepareSymbolRegisterUse(src1, CX86Assembler::rDX);
+
+	//Entries are 16 bytes (tag, code pointer), 32-bit operations clear the upper half of the index
+	m_assembler.MovEd(CX86Assembler::rAX, CX86Assembler::MakeRegisterAddress(addressRegister));
+	m_assembler.AndId(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX), src3->m_valueLow);
+	m_assembler.ShlEq(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX), 4);
+	m_assembler.MovIq(CX86Assembler::rCX, CombineConstant64(src2->m_valueLow, src2->m_valueHigh));
+	auto symbolRefLabel = m_assembler.CreateLabel();
+	m_assembler.MarkLabel(symbolRefLabel, -8);
+	m_symbolReferenceLabels.push_back(std::make_pair(src2->GetConstantPtr(), symbolRefLabel));
+	m_assembler.AddEq(CX86Assembler::rAX, CX86Assembler::MakeRegisterAddress(CX86Assembler::rCX));
+
+	m_assembler.CmpEd(addressRegister, CX86Assembler::MakeIndRegAddress(CX86Assembler::rAX));
+	m_assembler.JnzJx(missLabel);
+
+	m_assembler.MovEq(m_paramRegs[0], CX86Assembler::MakeRegisterAddress(g_baseRegister));
+	Emit_Epilog();
+	m_assembler.JmpEd(CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rAX, 8));
+
+	m_assembler.MarkLabel(missLabel);
+}
+
+void CCodeGen_x86_64::Emit_IncCounter(const STATEMENT& statement)
+{
+	auto src1 = statement.src1->GetSymbol().get();
+
+	assert(src1->m_type == SYM_CONSTANTPTR);
+
+	m_assembler.MovIq(CX86Assembler::rAX, CombineConstant64(src1->m_valueLow, src1->m_valueHigh));
+	auto symbolRefLabel = m_assembler.CreateLabel();
+	m_assembler.MarkLabel(symbolRefLabel, -8);
+	m_symbolReferenceLabels.push_back(std::make_pair(src1->GetConstantPtr(), symbolRefLabel));
+	m_assembler.AddId(CX86Assembler::MakeIndRegAddress(CX86Assembler::rAX), 1);
+}
+
 void CCodeGen_x86_64::Emit_Mov_Mem64Mem64(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
@@ -1,4 +1,5 @@
 #include "Jitter_CodeGen_x86.h"
+#include <stdexcept>
 
 using namespace Jitter;
 
@@ -32,6 +33,145 @@ CX86Assembler::CAddress CCodeGen_x86::MakeMemoryFpSingleSymbolAddress(CSymbol* s
 	}
 }
 
+CX86Assembler::CAddress CCodeGen_x86::MakeVariableFpSingleSymbolAddress(CSymbol* symbol)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		return CX86Assembler::MakeXmmRegisterAddress(m_mdRegisters[symbol->m_valueLow]);
+		break;
+	case SYM_FP_REL_SINGLE:
+		return MakeRelativeFpSingleSymbolAddress(symbol);
+		break;
+	case SYM_FP_TMP_SINGLE:
+		return MakeTemporaryFpSingleSymbolAddress(symbol);
+		break;
+	default:
+		throw std::exception();
+		break;
+	}
+}
+
+CX86Assembler::XMMREGISTER CCodeGen_x86::PrepareSymbolRegisterDefFpSingle(CSymbol* symbol, CX86Assembler::XMMREGISTER preferedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		return m_mdRegisters[symbol->m_valueLow];
+		break;
+	case SYM_FP_REL_SINGLE:
+	case SYM_FP_TMP_SINGLE:
+		return preferedRegister;
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+void CCodeGen_x86::LoadFpSingleSymbolInRegister(CX86Assembler::XMMREGISTER dstRegister, CSymbol* symbol)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		if(m_mdRegisters[symbol->m_valueLow] != dstRegister)
+		{
+			m_assembler.MovapsVo(dstRegister, CX86Assembler::MakeXmmRegisterAddress(m_mdRegisters[symbol->m_valueLow]));
+		}
+		break;
+	case SYM_FP_REL_SINGLE:
+	case SYM_FP_TMP_SINGLE:
+		m_assembler.MovssEd(dstRegister, MakeMemoryFpSingleSymbolAddress(symbol));
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+void CCodeGen_x86::CommitSymbolRegisterFpSingle(CSymbol* symbol, CX86Assembler::XMMREGISTER usedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		//Result might have been computed in a temporary register to avoid clobbering a source
+		if(m_mdRegisters[symbol->m_valueLow] != usedRegister)
+		{
+			m_assembler.MovapsVo(m_mdRegisters[symbol->m_valueLow], CX86Assembler::MakeXmmRegisterAddress(usedRegister));
+		}
+		break;
+	case SYM_FP_REL_SINGLE:
+	case SYM_FP_TMP_SINGLE:
+		m_assembler.MovssEd(MakeMemoryFpSingleSymbolAddress(symbol), usedRegister);
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+CX86Assembler::XMMREGISTER CCodeGen_x86::PrepareSymbolRegisterUseFpSingleAvx(CSymbol* symbol, CX86Assembler::XMMREGISTER preferedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		return m_mdRegisters[symbol->m_valueLow];
+		break;
+	case SYM_FP_REL_SINGLE:
+	case SYM_FP_TMP_SINGLE:
+		m_assembler.VmovssEd(preferedRegister, MakeMemoryFpSingleSymbolAddress(symbol));
+		return preferedRegister;
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+void CCodeGen_x86::CommitSymbolRegisterFpSingleAvx(CSymbol* symbol, CX86Assembler::XMMREGISTER usedRegister)
+{
+	switch(symbol->m_type)
+	{
+	case SYM_FP_REG_SINGLE:
+		if(m_mdRegisters[symbol->m_valueLow] != usedRegister)
+		{
+			m_assembler.VmovapsVo(m_mdRegisters[symbol->m_valueLow], CX86Assembler::MakeXmmRegisterAddress(usedRegister));
+		}
+		break;
+	case SYM_FP_REL_SINGLE:
+	case SYM_FP_TMP_SINGLE:
+		m_assembler.VmovssEd(MakeMemoryFpSingleSymbolAddress(symbol), usedRegister);
+		break;
+	default:
+		throw std::runtime_error("Invalid symbol type.");
+		break;
+	}
+}
+
+void CCodeGen_x86::LoadFpSingleSymbolInIntRegister(CX86Assembler::REGISTER dstRegister, CSymbol* symbol)
+{
+	if(symbol->m_type == SYM_FP_REG_SINGLE)
+	{
+		m_assembler.MovdVo(CX86Assembler::MakeRegisterAddress(dstRegister), m_mdRegisters[symbol->m_valueLow]);
+	}
+	else
+	{
+		m_assembler.MovEd(dstRegister, MakeMemoryFpSingleSymbolAddress(symbol));
+	}
+}
+
+void CCodeGen_x86::StoreIntRegisterInFpSingleSymbol(CSymbol* symbol, CX86Assembler::REGISTER srcRegister)
+{
+	if(symbol->m_type == SYM_FP_REG_SINGLE)
+	{
+		m_assembler.MovdVo(m_mdRegisters[symbol->m_valueLow], CX86Assembler::MakeRegisterAddress(srcRegister));
+	}
+	else
+	{
+		m_assembler.MovGd(MakeMemoryFpSingleSymbolAddress(symbol), srcRegister);
+	}
+}
+
 CX86Assembler::SSE_CMP_TYPE CCodeGen_x86::GetSseConditionCode(Jitter::CONDITION condition)
 {
 	CX86Assembler::SSE_CMP_TYPE conditionCode = CX86Assembler::SSE_CMP_EQ;
@@ -56,27 +196,27 @@ CX86Assembler::SSE_CMP_TYPE CCodeGen_x86::GetSseConditionCode(Jitter::CONDITION
 	return conditionCode;
 }
 
-void CCodeGen_x86::Emit_Fp_Abs_MemMem(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_Abs_VarVar(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
 
-	m_assembler.MovEd(CX86Assembler::rAX, MakeMemoryFpSingleSymbolAddress(src1));
+	LoadFpSingleSymbolInIntRegister(CX86Assembler::rAX, src1);
 	m_assembler.AndId(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX), 0x7FFFFFFF);
-	m_assembler.MovGd(MakeMemoryFpSingleSymbolAddress(dst), CX86Assembler::rAX);
+	StoreIntRegisterInFpSingleSymbol(dst, CX86Assembler::rAX);
 }
 
-void CCodeGen_x86::Emit_Fp_Neg_MemMem(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_Neg_VarVar(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
 
-	m_assembler.MovEd(CX86Assembler::rAX, MakeMemoryFpSingleSymbolAddress(src1));
+	LoadFpSingleSymbolInIntRegister(CX86Assembler::rAX, src1);
 	m_assembler.XorId(CX86Assembler::MakeRegisterAddress(CX86Assembler::rAX), 0x80000000);
-	m_assembler.MovGd(MakeMemoryFpSingleSymbolAddress(dst), CX86Assembler::rAX);
+	StoreIntRegisterInFpSingleSymbol(dst, CX86Assembler::rAX);
 }
 
-void CCodeGen_x86::Emit_Fp_LdCst_MemCst(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_LdCst_VarCst(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
@@ -86,15 +226,15 @@ void CCodeGen_x86::Emit_Fp_LdCst_MemCst(const STATEMENT& statement)
 	CX86Assembler::REGISTER tmpRegister = CX86Assembler::rAX;
 
 	m_assembler.MovId(tmpRegister, src1->m_valueLow);
-	m_assembler.MovGd(MakeMemoryFpSingleSymbolAddress(dst), tmpRegister);
+	StoreIntRegisterInFpSingleSymbol(dst, tmpRegister);
 }
 
-CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_fpuConstMatchers[] = 
+const CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_fpuConstMatchers[] = 
 { 
-	{ OP_FP_ABS, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Abs_MemMem },
-	{ OP_FP_NEG, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Neg_MemMem },
+	{ OP_FP_ABS, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Abs_VarVar },
+	{ OP_FP_NEG, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Neg_VarVar },
 
-	{ OP_FP_LDCST, MATCH_MEMORY_FP_SINGLE, MATCH_CONSTANT, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_LdCst_MemCst },
+	{ OP_FP_LDCST, MATCH_VARIABLE_FP_SINGLE, MATCH_CONSTANT, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_LdCst_VarCst },
 
 	{ OP_MOV, MATCH_NIL, MATCH_NIL, MATCH_NIL, MATCH_NIL, nullptr },
 };
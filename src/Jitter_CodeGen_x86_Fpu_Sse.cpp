@@ -3,28 +3,39 @@
 using namespace Jitter;
 
 template <typename FPUOP>
-void CCodeGen_x86::Emit_Fpu_MemMem(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fpu_VarVar(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
 
-	((m_assembler).*(FPUOP::OpEd()))(CX86Assembler::xMM0, MakeMemoryFpSingleSymbolAddress(src1));
-	m_assembler.MovssEd(MakeMemoryFpSingleSymbolAddress(dst), CX86Assembler::xMM0);
+	auto dstRegister = PrepareSymbolRegisterDefFpSingle(dst, CX86Assembler::xMM0);
+
+	((m_assembler).*(FPUOP::OpEd()))(dstRegister, MakeVariableFpSingleSymbolAddress(src1));
+
+	CommitSymbolRegisterFpSingle(dst, dstRegister);
 }
 
 template <typename FPUOP>
-void CCodeGen_x86::Emit_Fpu_MemMemMem(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fpu_VarVarVar(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
 	CSymbol* src2 = statement.src2->GetSymbol().get();
 
-	m_assembler.MovssEd(CX86Assembler::xMM0, MakeMemoryFpSingleSymbolAddress(src1));
-	((m_assembler).*(FPUOP::OpEd()))(CX86Assembler::xMM0, MakeMemoryFpSingleSymbolAddress(src2));
-	m_assembler.MovssEd(MakeMemoryFpSingleSymbolAddress(dst), CX86Assembler::xMM0);
+	auto dstRegister = PrepareSymbolRegisterDefFpSingle(dst, CX86Assembler::xMM0);
+	if(dst->Equals(src2) && !dst->Equals(src1))
+	{
+		//Copying src1 in dst would overwrite src2
+		dstRegister = CX86Assembler::xMM0;
+	}
+
+	LoadFpSingleSymbolInRegister(dstRegister, src1);
+	((m_assembler).*(FPUOP::OpEd()))(dstRegister, MakeVariableFpSingleSymbolAddress(src2));
+
+	CommitSymbolRegisterFpSingle(dst, dstRegister);
 }
 
-void CCodeGen_x86::Emit_Fp_Cmp_VarMemMem(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_Cmp_VarVarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
@@ -33,14 +44,14 @@ void CCodeGen_x86::Emit_Fp_Cmp_VarMemMem(const STATEMENT& statement)
 	auto dstReg = PrepareSymbolRegisterDef(dst, CX86Assembler::rAX);
 
 	auto conditionCode = GetSseConditionCode(statement.jmpCondition);
-	m_assembler.MovssEd(CX86Assembler::xMM0, MakeMemoryFpSingleSymbolAddress(src1));
-	m_assembler.CmpssEd(CX86Assembler::xMM0, MakeMemoryFpSingleSymbolAddress(src2), conditionCode);
+	LoadFpSingleSymbolInRegister(CX86Assembler::xMM0, src1);
+	m_assembler.CmpssEd(CX86Assembler::xMM0, MakeVariableFpSingleSymbolAddress(src2), conditionCode);
 	m_assembler.MovdVo(CX86Assembler::MakeRegisterAddress(dstReg), CX86Assembler::xMM0);
 
 	CommitSymbolRegister(dst, dstReg);
 }
 
-void CCodeGen_x86::Emit_Fp_Cmp_VarMemCst(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_Cmp_VarVarCst(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
@@ -65,14 +76,14 @@ void CCodeGen_x86::Emit_Fp_Cmp_VarMemCst(const STATEMENT& statement)
 		m_assembler.MovdVo(src2Reg, CX86Assembler::MakeRegisterAddress(cstReg));
 	}
 
-	m_assembler.MovssEd(src1Reg, MakeMemoryFpSingleSymbolAddress(src1));
+	LoadFpSingleSymbolInRegister(src1Reg, src1);
 	m_assembler.CmpssEd(src1Reg, CX86Assembler::MakeXmmRegisterAddress(src2Reg), conditionCode);
 	m_assembler.MovdVo(CX86Assembler::MakeRegisterAddress(dstReg), src1Reg);
 
 	CommitSymbolRegister(dst, dstReg);
 }
 
-void CCodeGen_x86::Emit_Fp_Rsqrt_MemMem(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_Rsqrt_VarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
@@ -81,14 +92,15 @@ void CCodeGen_x86::Emit_Fp_Rsqrt_MemMem(const STATEMENT& statement)
 	auto resultRegister = CX86Assembler::xMM0;
 	auto sqrtRegister = CX86Assembler::xMM1;
 
-	m_assembler.SqrtssEd(sqrtRegister, MakeMemoryFpSingleSymbolAddress(src1));
+	m_assembler.SqrtssEd(sqrtRegister, MakeVariableFpSingleSymbolAddress(src1));
 	m_assembler.MovId(tmpIntRegister, 0x3F800000);
 	m_assembler.MovdVo(resultRegister, CX86Assembler::MakeRegisterAddress(tmpIntRegister));
 	m_assembler.DivssEd(resultRegister, CX86Assembler::MakeXmmRegisterAddress(sqrtRegister));
-	m_assembler.MovssEd(MakeMemoryFpSingleSymbolAddress(dst), resultRegister);
+
+	CommitSymbolRegisterFpSingle(dst, resultRegister);
 }
 
-void CCodeGen_x86::Emit_Fp_Rcpl_MemMem(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_Rcpl_VarVar(const STATEMENT& statement)
 {
 	auto dst = statement.dst->GetSymbol().get();
 	auto src1 = statement.src1->GetSymbol().get();
@@ -98,52 +110,70 @@ void CCodeGen_x86::Emit_Fp_Rcpl_MemMem(const STATEMENT& statement)
 
 	m_assembler.MovId(tmpIntRegister, 0x3F800000);
 	m_assembler.MovdVo(resultRegister, CX86Assembler::MakeRegisterAddress(tmpIntRegister));
-	m_assembler.DivssEd(resultRegister, MakeMemoryFpSingleSymbolAddress(src1));
-	m_assembler.MovssEd(MakeMemoryFpSingleSymbolAddress(dst), resultRegister);
+	m_assembler.DivssEd(resultRegister, MakeVariableFpSingleSymbolAddress(src1));
+
+	CommitSymbolRegisterFpSingle(dst, resultRegister);
 }
 
-void CCodeGen_x86::Emit_Fp_Mov_RelSRelI32(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_Mov_RegVar(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	LoadFpSingleSymbolInRegister(m_mdRegisters[dst->m_valueLow], src1);
+}
+
+void CCodeGen_x86::Emit_Fp_Mov_MemReg(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+
+	m_assembler.MovssEd(MakeMemoryFpSingleSymbolAddress(dst), m_mdRegisters[src1->m_valueLow]);
+}
+
+void CCodeGen_x86::Emit_Fp_Mov_VarRelI32(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
 
-	assert(dst->m_type  == SYM_FP_REL_SINGLE);
 	assert(src1->m_type == SYM_FP_REL_INT32);
 
-	m_assembler.Cvtsi2ssEd(CX86Assembler::xMM0, CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rBP, src1->m_valueLow));
-	m_assembler.MovssEd(CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rBP, dst->m_valueLow), CX86Assembler::xMM0);
+	auto dstRegister = PrepareSymbolRegisterDefFpSingle(dst, CX86Assembler::xMM0);
+
+	m_assembler.Cvtsi2ssEd(dstRegister, CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rBP, src1->m_valueLow));
+
+	CommitSymbolRegisterFpSingle(dst, dstRegister);
 }
 
-void CCodeGen_x86::Emit_Fp_ToIntTrunc_RelRel(const STATEMENT& statement)
+void CCodeGen_x86::Emit_Fp_ToIntTrunc_VarVar(const STATEMENT& statement)
 {
 	CSymbol* dst = statement.dst->GetSymbol().get();
 	CSymbol* src1 = statement.src1->GetSymbol().get();
 
-	assert(dst->m_type  == SYM_FP_REL_SINGLE);
-	assert(src1->m_type == SYM_FP_REL_SINGLE);
-
-	m_assembler.Cvttss2siEd(CX86Assembler::rAX, CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rBP, src1->m_valueLow));
-	m_assembler.MovGd(CX86Assembler::MakeIndRegOffAddress(CX86Assembler::rBP, dst->m_valueLow), CX86Assembler::rAX);
+	m_assembler.Cvttss2siEd(CX86Assembler::rAX, MakeVariableFpSingleSymbolAddress(src1));
+	StoreIntRegisterInFpSingleSymbol(dst, CX86Assembler::rAX);
 }
 
-CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_fpuSseConstMatchers[] = 
+const CCodeGen_x86::CONSTMATCHER CCodeGen_x86::g_fpuSseConstMatchers[] = 
 {
-	{ OP_FP_ADD, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_MemMemMem<FPUOP_ADD> },
-	{ OP_FP_SUB, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_MemMemMem<FPUOP_SUB> },
-	{ OP_FP_MUL, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_MemMemMem<FPUOP_MUL> },
-	{ OP_FP_DIV, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_MemMemMem<FPUOP_DIV> },
-	{ OP_FP_MAX, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_MemMemMem<FPUOP_MAX> },
-	{ OP_FP_MIN, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_MemMemMem<FPUOP_MIN> },
-
-	{ OP_FP_CMP, MATCH_VARIABLE, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Cmp_VarMemMem },
-	{ OP_FP_CMP, MATCH_VARIABLE, MATCH_MEMORY_FP_SINGLE, MATCH_CONSTANT,         MATCH_NIL, &CCodeGen_x86::Emit_Fp_Cmp_VarMemCst },
-
-	{ OP_FP_SQRT,  MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_MemMem<FPUOP_SQRT> },
-	{ OP_FP_RSQRT, MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Rsqrt_MemMem        },
-	{ OP_FP_RCPL,  MATCH_MEMORY_FP_SINGLE, MATCH_MEMORY_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Rcpl_MemMem         },
-
-	{ OP_MOV,            MATCH_RELATIVE_FP_SINGLE, MATCH_RELATIVE_FP_INT32,  MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Mov_RelSRelI32    },
-	{ OP_FP_TOINT_TRUNC, MATCH_RELATIVE_FP_SINGLE, MATCH_RELATIVE_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_ToIntTrunc_RelRel },
+	{ OP_FP_ADD, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_VarVarVar<FPUOP_ADD> },
+	{ OP_FP_SUB, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_VarVarVar<FPUOP_SUB> },
+	{ OP_FP_MUL, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_VarVarVar<FPUOP_MUL> },
+	{ OP_FP_DIV, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_VarVarVar<FPUOP_DIV> },
+	{ OP_FP_MAX, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_VarVarVar<FPUOP_MAX> },
+	{ OP_FP_MIN, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_VarVarVar<FPUOP_MIN> },
+
+	{ OP_FP_CMP, MATCH_VARIABLE, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Cmp_VarVarVar },
+	{ OP_FP_CMP, MATCH_VARIABLE, MATCH_VARIABLE_FP_SINGLE, MATCH_CONSTANT,           MATCH_NIL, &CCodeGen_x86::Emit_Fp_Cmp_VarVarCst },
+
+	{ OP_FP_SQRT,  MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fpu_VarVar<FPUOP_SQRT> },
+	{ OP_FP_RSQRT, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Rsqrt_VarVar        },
+	{ OP_FP_RCPL,  MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Rcpl_VarVar         },
+
+	{ OP_MOV,            MATCH_REGISTER_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Mov_RegVar        },
+	{ OP_MOV,            MATCH_MEMORY_FP_SINGLE,   MATCH_REGISTER_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Mov_MemReg        },
+	{ OP_MOV,            MATCH_VARIABLE_FP_SINGLE, MATCH_RELATIVE_FP_INT32,  MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_Mov_VarRelI32     },
+	{ OP_FP_TOINT_TRUNC, MATCH_VARIABLE_FP_SINGLE, MATCH_VARIABLE_FP_SINGLE, MATCH_NIL, MATCH_NIL, &CCodeGen_x86::Emit_Fp_ToIntTrunc_VarVar },
 
 	{ OP_MOV, MATCH_NIL, MATCH_NIL, MATCH_NIL, MATCH_NIL, nullptr },
 };
@@ -276,6 +276,41 @@ void CCodeGen_x86::Emit_Shift_MemCstMem(const STATEMENT& statement)
 	m_assembler.MovGd(MakeMemorySymbolAddress(dst), CX86Assembler::rAX);
 }
 
+template <typename SHIFTOP>
+void CCodeGen_x86::Emit_Shift_Bmi2_VarVarVar(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+	auto src2 = statement.src2->GetSymbol().get();
+
+	//Amount can be in any register, rCX isn't needed
+	auto dstRegister = PrepareSymbolRegisterDef(dst, CX86Assembler::rAX);
+	auto amountRegister = PrepareSymbolRegisterUse(src2, CX86Assembler::rCX);
+
+	((m_assembler).*(SHIFTOP::OpBmi2()))(dstRegister, MakeVariableSymbolAddress(src1), amountRegister);
+
+	CommitSymbolRegister(dst, dstRegister);
+}
+
+template <typename SHIFTOP>
+void CCodeGen_x86::Emit_Shift_Bmi2_VarCstVar(const STATEMENT& statement)
+{
+	auto dst = statement.dst->GetSymbol().get();
+	auto src1 = statement.src1->GetSymbol().get();
+	auto src2 = statement.src2->GetSymbol().get();
+
+	assert(src1->m_type == SYM_CONSTANT);
+
+	auto dstRegister = PrepareSymbolRegisterDef(dst, CX86Assembler::rAX);
+	auto valueRegister = CX86Assembler::rDX;
+	auto amountRegister = PrepareSymbolRegisterUse(src2, CX86Assembler::rCX);
+
+	m_assembler.MovId(valueRegister, src1->m_valueLow);
+	((m_assembler).*(SHIFTOP::OpBmi2()))(dstRegister, CX86Assembler::MakeRegisterAddress(valueRegister), amountRegister);
+
+	CommitSymbolRegister(dst, dstRegister);
+}
+
 #define SHIFT_CONST_MATCHERS(SHIFTOP_CST, SHIFTOP) \
 	{ SHIFTOP_CST, MATCH_REGISTER, MATCH_REGISTER, MATCH_REGISTER, MATCH_NIL, &CCodeGen_x86::Emit_Shift_RegRegReg<SHIFTOP> }, \
 	{ SHIFTOP_CST, MATCH_REGISTER, MATCH_REGISTER, MATCH_MEMORY,   MATCH_NIL, &CCodeGen_x86::Emit_Shift_RegRegMem<SHIFTOP> }, \
@@ -295,4 +330,8 @@ void CCodeGen_x86::Emit_Shift_MemCstMem(const STATEMENT& statement)
 	{ SHIFTOP_CST, MATCH_MEMORY, MATCH_CONSTANT, MATCH_REGISTER, MATCH_NIL, &CCodeGen_x86::Emit_Shift_MemCstReg<SHIFTOP>	}, \
 	{ SHIFTOP_CST, MATCH_MEMORY, MATCH_CONSTANT, MATCH_MEMORY,   MATCH_NIL, &CCodeGen_x86::Emit_Shift_MemCstMem<SHIFTOP>	}, \
 
+#define SHIFT_BMI2_CONST_MATCHERS(SHIFTOP_CST, SHIFTOP) \
+	{ SHIFTOP_CST, MATCH_VARIABLE, MATCH_VARIABLE, MATCH_VARIABLE, MATCH_NIL, &CCodeGen_x86::Emit_Shift_Bmi2_VarVarVar<SHIFTOP> }, \
+	{ SHIFTOP_CST, MATCH_VARIABLE, MATCH_CONSTANT, MATCH_VARIABLE, MATCH_NIL, &CCodeGen_x86::Emit_Shift_Bmi2_VarCstVar<SHIFTOP> }, \
+
 #endif
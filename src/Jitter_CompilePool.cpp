@@ -0,0 +1,124 @@
+#include <assert.h>
+#include <algorithm>
+#include "Jitter_CompilePool.h"
+#include "Jitter_CodeGenFactory.h"
+#include "MemStream.h"
+
+using namespace Jitter;
+
+CCompilePool::CCompilePool(unsigned int workerCount, CCodeHeap* codeHeap, CodeGenFactoryType codeGenFactory)
+: m_codeHeap(codeHeap)
+, m_codeGenFactory(std::move(codeGenFactory))
+{
+	if(workerCount == 0)
+	{
+		workerCount = std::max<unsigned int>(std::thread::hardware_concurrency(), 1);
+	}
+	if(!m_codeGenFactory)
+	{
+		m_codeGenFactory = &Jitter::CreateCodeGen;
+	}
+	m_workers.reserve(workerCount);
+	for(unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.emplace_back(&CCompilePool::WorkerProc, this);
+	}
+}
+
+CCompilePool::~CCompilePool()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_terminating = true;
+	}
+	m_taskAvailableCondition.notify_all();
+	for(auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	assert(m_tasks.empty());
+}
+
+std::future<CMemoryFunction> CCompilePool::Submit(BuilderType builder)
+{
+	TASK task;
+	task.builder = std::move(builder);
+	auto result = task.promise.get_future();
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		assert(!m_terminating);
+		m_tasks.push_back(std::move(task));
+	}
+	m_taskAvailableCondition.notify_one();
+	return result;
+}
+
+unsigned int CCompilePool::GetWorkerCount() const
+{
+	return static_cast<unsigned int>(m_workers.size());
+}
+
+void CCompilePool::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idleCondition.wait(lock, [this] () { return m_tasks.empty() && (m_busyWorkerCount == 0); });
+}
+
+void CCompilePool::WorkerProc()
+{
+	auto jitter = CreateJitter();
+	while(1)
+	{
+		TASK task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskAvailableCondition.wait(lock, [this] () { return m_terminating || !m_tasks.empty(); });
+			//Pending tasks are still processed when terminating, their futures need to be satisfied
+			if(m_tasks.empty()) break;
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+			m_busyWorkerCount++;
+		}
+		try
+		{
+			task.promise.set_value(CompileTask(*jitter, task.builder));
+		}
+		catch(...)
+		{
+			task.promise.set_exception(std::current_exception());
+			//Jitter is left in the middle of a compilation, start over with a new one
+			jitter = CreateJitter();
+		}
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_busyWorkerCount--;
+		}
+		m_idleCondition.notify_all();
+	}
+}
+
+std::unique_ptr<CJitter> CCompilePool::CreateJitter()
+{
+	//Factory doesn't need to be thread safe
+	std::unique_lock<std::mutex> lock(m_codeGenFactoryMutex);
+	//Jitter takes ownership of the code generator
+	return std::make_unique<CJitter>(m_codeGenFactory());
+}
+
+CMemoryFunction CCompilePool::CompileTask(CJitter& jitter, const BuilderType& builder)
+{
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+	jitter.Begin();
+	builder(jitter);
+	jitter.End();
+	jitter.SetStream(nullptr);
+	if(m_codeHeap)
+	{
+		return CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize(), *m_codeHeap);
+	}
+	else
+	{
+		return CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	}
+}
@@ -0,0 +1,180 @@
+#include <assert.h>
+#include <chrono>
+#include <algorithm>
+#include "Jitter_CompileStats.h"
+
+using namespace Jitter;
+
+CCompileStats::CPassScope::CPassScope(CCompileStats* stats, PASS pass)
+: CPassScope(stats, pass, IR_SIZE())
+{
+
+}
+
+CCompileStats::CPassScope::CPassScope(CCompileStats* stats, PASS pass, const IR_SIZE& sizeBefore)
+: m_stats(stats)
+, m_pass(pass)
+, m_sizeBefore(sizeBefore)
+, m_sizeAfter(sizeBefore)
+{
+	if(m_stats)
+	{
+		m_startTime = GetTimestamp();
+	}
+}
+
+CCompileStats::CPassScope::~CPassScope()
+{
+	if(m_stats)
+	{
+		uint64 elapsed = GetTimestamp() - m_startTime;
+		m_stats->RecordPass(m_pass, elapsed, m_sizeBefore, m_sizeAfter);
+	}
+}
+
+void CCompileStats::CPassScope::SetSizeAfter(const IR_SIZE& sizeAfter)
+{
+	m_sizeAfter = sizeAfter;
+}
+
+void CCompileStats::BeginCompilation()
+{
+	m_lastCompilation = STATS();
+	m_compilationStartTime = GetTimestamp();
+}
+
+void CCompileStats::EndCompilation()
+{
+	uint64 elapsed = GetTimestamp() - m_compilationStartTime;
+
+	m_lastCompilation.compileCount = 1;
+	RecordTime(m_lastCompilation.totalTime, m_lastCompilation.maxTime, m_lastCompilation.timeHistogram, elapsed);
+
+	m_aggregate.compileCount++;
+	RecordTime(m_aggregate.totalTime, m_aggregate.maxTime, m_aggregate.timeHistogram, elapsed);
+}
+
+void CCompileStats::RecordPass(PASS pass, uint64 elapsed, const IR_SIZE& sizeBefore, const IR_SIZE& sizeAfter)
+{
+	assert(pass < PASS_MAX);
+	RecordPassStats(m_lastCompilation.passes[pass], elapsed, sizeBefore, sizeAfter);
+	RecordPassStats(m_aggregate.passes[pass], elapsed, sizeBefore, sizeAfter);
+}
+
+void CCompileStats::RecordCode(const CAssemblerStats& assemblerStats)
+{
+	RecordCodeStats(m_lastCompilation.code, assemblerStats);
+	RecordCodeStats(m_aggregate.code, assemblerStats);
+}
+
+const CCompileStats::STATS& CCompileStats::GetLastCompilation() const
+{
+	return m_lastCompilation;
+}
+
+const CCompileStats::STATS& CCompileStats::GetAggregate() const
+{
+	return m_aggregate;
+}
+
+void CCompileStats::Reset()
+{
+	m_lastCompilation = STATS();
+	m_aggregate = STATS();
+}
+
+const char* CCompileStats::GetPassName(PASS pass)
+{
+	switch(pass)
+	{
+	case PASS_CONSTANTPROPAGATION:
+		return "ConstantPropagation";
+	case PASS_CONSTANTFOLDING:
+		return "ConstantFolding";
+	case PASS_STRENGTHREDUCTION:
+		return "StrengthReduction";
+	case PASS_VALUENUMBERING:
+		return "ValueNumbering";
+	case PASS_COPYPROPAGATION:
+		return "CopyPropagation";
+	case PASS_REORDERADD:
+		return "ReorderAdd";
+	case PASS_DEADCODEELIMINATION:
+		return "DeadcodeElimination";
+	case PASS_PRUNEBLOCKS:
+		return "PruneBlocks";
+	case PASS_MERGEBLOCKS:
+		return "MergeBlocks";
+	case PASS_LOOPINVARIANTCODEMOTION:
+		return "LoopInvariantCodeMotion";
+	case PASS_LAYOUTBLOCKS:
+		return "LayoutBlocks";
+	case PASS_COALESCETEMPORARIES:
+		return "CoalesceTemporaries";
+	case PASS_ALLOCATEGLOBALREGISTERS:
+		return "AllocateGlobalRegisters";
+	case PASS_ALLOCATEREGISTERS:
+		return "AllocateRegisters";
+	case PASS_ALLOCATESTACK:
+		return "AllocateStack";
+	case PASS_GENERATECODE:
+		return "GenerateCode";
+	case PASS_ASSEMBLEREND:
+		return "AssemblerEnd";
+	default:
+		assert(false);
+		return "";
+	}
+}
+
+unsigned int CCompileStats::GetHistogramBucket(uint64 elapsed)
+{
+	unsigned int bucket = 0;
+	while((elapsed >>= 1) != 0)
+	{
+		bucket++;
+	}
+	return std::min<unsigned int>(bucket, HISTOGRAM_BUCKET_COUNT - 1);
+}
+
+uint64 CCompileStats::GetTimestamp()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void CCompileStats::RecordPassStats(PASS_STATS& passStats, uint64 elapsed, const IR_SIZE& sizeBefore, const IR_SIZE& sizeAfter)
+{
+	passStats.runCount++;
+	passStats.statementsBefore += sizeBefore.statementCount;
+	passStats.statementsAfter += sizeAfter.statementCount;
+	passStats.symbolsBefore += sizeBefore.symbolCount;
+	passStats.symbolsAfter += sizeAfter.symbolCount;
+	RecordTime(passStats.totalTime, passStats.maxTime, passStats.timeHistogram, elapsed);
+}
+
+void CCompileStats::RecordTime(uint64& totalTime, uint64& maxTime, Histogram& histogram, uint64 elapsed)
+{
+	totalTime += elapsed;
+	maxTime = std::max(maxTime, elapsed);
+	histogram[GetHistogramBucket(elapsed)]++;
+}
+
+void CCompileStats::RecordCodeStats(CODE_STATS& codeStats, const CAssemblerStats& assemblerStats)
+{
+	codeStats.totalBytes += assemblerStats.GetTotalBytes();
+	for(unsigned int i = 0; i < CAssemblerStats::CATEGORY_MAX; i++)
+	{
+		codeStats.categoryBytes[i] += assemblerStats.GetCategoryBytes()[i];
+		codeStats.categoryInstructionCounts[i] += assemblerStats.GetCategoryInstructionCounts()[i];
+	}
+	const auto& tags = assemblerStats.GetTags();
+	for(unsigned int op = 0; op < tags.size(); op++)
+	{
+		//Backends tag statements with their operation
+		assert(op < OP_MAX);
+		auto& operationStats = codeStats.operations[op];
+		operationStats.statementCount += tags[op].regionCount;
+		operationStats.bytes += tags[op].bytes;
+	}
+}
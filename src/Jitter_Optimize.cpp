@@ -1,8 +1,11 @@
 #include <assert.h>
 #include <vector>
 #include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
 #include "Jitter.h"
 #include "BitManip.h"
+#include "MemStream.h"
 
 #ifdef _DEBUG
 //#define DUMP_STATEMENTS
@@ -49,7 +52,7 @@ static uint32 GetPowerOf2(uint32 x)
 
 static uint64 MergeConstant64(uint32 lo, uint32 hi)
 {
-	uint64 result = static_cast<uint64>(lo) | (static_cast<uint64>(hi) >> 32);
+	uint64 result = static_cast<uint64>(lo) | (static_cast<uint64>(hi) << 32);
 	return result;
 }
 
@@ -70,34 +73,33 @@ unsigned int CJitter::CRelativeVersionManager::IncrementRelativeVersion(uint32 r
 CJitter::VERSIONED_STATEMENT_LIST CJitter::GenerateVersionedStatementList(const StatementList& statements)
 {
 	VERSIONED_STATEMENT_LIST result;
+	result.statements.reserve(statements.size());
 
-	struct ReplaceUse
-	{
-		void operator() (SymbolRefPtr& symbolRef, CRelativeVersionManager& relativeVersions) const
+	auto replaceUse =
+		[this, &result](SymbolRefPtr& symbolRef)
 		{
 			if(CSymbol* symbol = dynamic_symbolref_cast(SYM_RELATIVE, symbolRef))
 			{
-				unsigned int currentVersion = relativeVersions.GetRelativeVersion(symbol->m_valueLow);
-				symbolRef = std::make_shared<CVersionedSymbolRef>(symbolRef->GetSymbol(), currentVersion);
+				unsigned int currentVersion = result.relativeVersions.GetRelativeVersion(symbol->m_valueLow);
+				symbolRef = MakeVersionedSymbolRef(symbolRef->GetSymbol(), currentVersion);
 			}
 			if(CSymbol* symbol = dynamic_symbolref_cast(SYM_RELATIVE64, symbolRef))
 			{
-				unsigned int currentVersion = relativeVersions.GetRelativeVersion(symbol->m_valueLow);
-				symbolRef = std::make_shared<CVersionedSymbolRef>(symbolRef->GetSymbol(), currentVersion);
+				unsigned int currentVersion = result.relativeVersions.GetRelativeVersion(symbol->m_valueLow);
+				symbolRef = MakeVersionedSymbolRef(symbolRef->GetSymbol(), currentVersion);
 			}
-		}
-	};
+		};
 
 	for(auto newStatement : statements)
 	{
-		ReplaceUse()(newStatement.src1, result.relativeVersions);
-		ReplaceUse()(newStatement.src2, result.relativeVersions);
-		ReplaceUse()(newStatement.src3, result.relativeVersions);
+		replaceUse(newStatement.src1);
+		replaceUse(newStatement.src2);
+		replaceUse(newStatement.src3);
 
 		if(CSymbol* dst = dynamic_symbolref_cast(SYM_RELATIVE, newStatement.dst))
 		{
 			unsigned int nextVersion = result.relativeVersions.IncrementRelativeVersion(dst->m_valueLow);
-			newStatement.dst = std::make_shared<CVersionedSymbolRef>(newStatement.dst->GetSymbol(), nextVersion);
+			newStatement.dst = MakeVersionedSymbolRef(newStatement.dst->GetSymbol(), nextVersion);
 		}
 		//Increment relative versions to prevent some optimization problems
 		else if(CSymbol* dst = dynamic_symbolref_cast(SYM_FP_REL_SINGLE, newStatement.dst))
@@ -127,7 +129,7 @@ CJitter::VERSIONED_STATEMENT_LIST CJitter::GenerateVersionedStatementList(const
 			if(mask & 0x08) result.relativeVersions.IncrementRelativeVersion(dst->m_valueLow + 12);
 		}
 
-		result.statements.push_back(newStatement);
+		result.statements.push_back(std::move(newStatement));
 	}
 
 	return result;
@@ -136,25 +138,91 @@ CJitter::VERSIONED_STATEMENT_LIST CJitter::GenerateVersionedStatementList(const
 StatementList CJitter::CollapseVersionedStatementList(const VERSIONED_STATEMENT_LIST& statements)
 {
 	StatementList result;
+	result.reserve(statements.statements.size());
 	for(auto newStatement : statements.statements)
 	{
 		newStatement.VisitOperands(
-			[](SymbolRefPtr& symbolRef, bool)
+			[this](SymbolRefPtr& symbolRef, bool)
 			{
-				if(auto versionedSymbolRef = std::dynamic_pointer_cast<CVersionedSymbolRef>(symbolRef))
+				if(dynamic_cast<CVersionedSymbolRef*>(symbolRef.get()))
 				{
-					symbolRef = std::make_shared<CSymbolRef>(symbolRef->GetSymbol());
+					symbolRef = MakeSymbolRef(symbolRef->GetSymbol());
 				}
 			}
 		);
 		
-		result.push_back(newStatement);
+		result.push_back(std::move(newStatement));
 	}
 	return result;
 }
 
 void CJitter::Compile()
 {
+	auto compileStats = m_compileStats.get();
+	if(compileStats)
+	{
+		compileStats->BeginCompilation();
+	}
+
+	if(m_compileTier == COMPILE_TIER_BASELINE)
+	{
+		PrepareBaselineBlocks();
+	}
+	else
+	{
+		OptimizeBlocks();
+	}
+
+	unsigned int stackSize = 0;
+
+	for(auto& basicBlock : m_basicBlocks)
+	{
+		m_currentBlock = &basicBlock;
+
+		{
+			CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_ALLOCATESTACK, GetIRSize(basicBlock));
+			unsigned int blockStackSize = AllocateStack(basicBlock);
+			stackSize = std::max<unsigned int>(stackSize, blockStackSize);
+			passScope.SetSizeAfter(GetIRSize(basicBlock));
+		}
+
+		NormalizeStatements(basicBlock);
+	}
+
+	auto result = ConcatBlocks(m_basicBlocks);
+
+#ifdef DUMP_STATEMENTS
+	DumpStatementList(result.statements);
+	std::cout << std::endl;
+#endif
+
+	{
+		//Includes PASS_ASSEMBLEREND which is recorded separately by the code generator
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_GENERATECODE, compileStats ? GetIRSize(result) : CCompileStats::IR_SIZE());
+		GenerateCode(result.statements, stackSize);
+	}
+
+	m_labels.clear();
+	m_loopInvariantTemporaries.clear();
+	//Not reset by the baseline tier, which doesn't hoist loop invariants
+	m_loopInvariantStackSize = 0;
+
+	//Profile and instrumentation only apply to the function that was just generated
+	m_instrumentationCounters = nullptr;
+	m_instrumentationCounterCount = 0;
+	m_profile = nullptr;
+	m_profileSize = 0;
+
+	if(compileStats)
+	{
+		compileStats->EndCompilation();
+	}
+}
+
+void CJitter::OptimizeBlocks()
+{
+	auto compileStats = m_compileStats.get();
+
 	while(1)
 	{
 		for(auto& basicBlock : m_basicBlocks)
@@ -170,11 +238,44 @@ void CJitter::Compile()
 				while(1)
 				{
 					bool dirty = false;
-					dirty |= ConstantPropagation(versionedStatements.statements);
-					dirty |= ConstantFolding(versionedStatements.statements);
-					dirty |= CopyPropagation(versionedStatements.statements);
-					dirty |= ReorderAdd(versionedStatements.statements);
-					dirty |= DeadcodeElimination(versionedStatements);
+					auto& statements = versionedStatements.statements;
+					{
+						CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_CONSTANTPROPAGATION, compileStats ? GetIRSize(statements) : CCompileStats::IR_SIZE());
+						dirty |= ConstantPropagation(statements);
+						if(compileStats) passScope.SetSizeAfter(GetIRSize(statements));
+					}
+					{
+						CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_CONSTANTFOLDING, compileStats ? GetIRSize(statements) : CCompileStats::IR_SIZE());
+						dirty |= ConstantFolding(statements);
+						if(compileStats) passScope.SetSizeAfter(GetIRSize(statements));
+					}
+					if(m_strengthReductionEnabled)
+					{
+						CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_STRENGTHREDUCTION, compileStats ? GetIRSize(statements) : CCompileStats::IR_SIZE());
+						dirty |= StrengthReduction(statements);
+						if(compileStats) passScope.SetSizeAfter(GetIRSize(statements));
+					}
+					if(m_valueNumberingEnabled)
+					{
+						CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_VALUENUMBERING, compileStats ? GetIRSize(statements) : CCompileStats::IR_SIZE());
+						dirty |= ValueNumbering(statements);
+						if(compileStats) passScope.SetSizeAfter(GetIRSize(statements));
+					}
+					{
+						CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_COPYPROPAGATION, compileStats ? GetIRSize(statements) : CCompileStats::IR_SIZE());
+						dirty |= CopyPropagation(statements);
+						if(compileStats) passScope.SetSizeAfter(GetIRSize(statements));
+					}
+					{
+						CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_REORDERADD, compileStats ? GetIRSize(statements) : CCompileStats::IR_SIZE());
+						dirty |= ReorderAdd(statements);
+						if(compileStats) passScope.SetSizeAfter(GetIRSize(statements));
+					}
+					{
+						CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_DEADCODEELIMINATION, compileStats ? GetIRSize(statements) : CCompileStats::IR_SIZE());
+						dirty |= DeadcodeElimination(versionedStatements);
+						if(compileStats) passScope.SetSizeAfter(GetIRSize(statements));
+					}
 
 					if(!dirty) break;
 				}
@@ -186,40 +287,295 @@ void CJitter::Compile()
 		}
 
 		bool dirty = false;
-		dirty |= PruneBlocks();
-		dirty |= MergeBlocks();
+		{
+			CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_PRUNEBLOCKS, compileStats ? GetIRSize(m_basicBlocks) : CCompileStats::IR_SIZE());
+			dirty |= PruneBlocks();
+			if(compileStats) passScope.SetSizeAfter(GetIRSize(m_basicBlocks));
+		}
+		{
+			CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_MERGEBLOCKS, compileStats ? GetIRSize(m_basicBlocks) : CCompileStats::IR_SIZE());
+			dirty |= MergeBlocks();
+			if(compileStats) passScope.SetSizeAfter(GetIRSize(m_basicBlocks));
+		}
 
 		if(!dirty) break;
 	}
 
-	unsigned int stackSize = 0;
+	{
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_LOOPINVARIANTCODEMOTION, compileStats ? GetIRSize(m_basicBlocks) : CCompileStats::IR_SIZE());
+		HoistLoopInvariants();
+		if(compileStats) passScope.SetSizeAfter(GetIRSize(m_basicBlocks));
+	}
+
+	{
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_LAYOUTBLOCKS, compileStats ? GetIRSize(m_basicBlocks) : CCompileStats::IR_SIZE());
+		LayoutBlocks();
+		if(compileStats) passScope.SetSizeAfter(GetIRSize(m_basicBlocks));
+	}
 
 	//Allocate registers
 	for(auto& basicBlock : m_basicBlocks)
 	{
 		m_currentBlock = &basicBlock;
 
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_COALESCETEMPORARIES, GetIRSize(basicBlock));
 		CoalesceTemporaries(basicBlock);
 		RemoveSelfAssignments(basicBlock);
 		PruneSymbols(basicBlock);
+		passScope.SetSizeAfter(GetIRSize(basicBlock));
+	}
+
+	{
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_ALLOCATEGLOBALREGISTERS, compileStats ? GetIRSize(m_basicBlocks) : CCompileStats::IR_SIZE());
+		AllocateGlobalRegisters();
+		if(compileStats) passScope.SetSizeAfter(GetIRSize(m_basicBlocks));
+	}
+
+	for(auto& basicBlock : m_basicBlocks)
+	{
+		m_currentBlock = &basicBlock;
 
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_ALLOCATEREGISTERS, GetIRSize(basicBlock));
 		AllocateRegisters(basicBlock);
-		unsigned int blockStackSize = AllocateStack(basicBlock);
-		stackSize = std::max<unsigned int>(stackSize, blockStackSize);
+		passScope.SetSizeAfter(GetIRSize(basicBlock));
+	}
 
-		NormalizeStatements(basicBlock);
+	if(!m_globalRegisters.empty())
+	{
+		//Done after local allocation to prevent it from allocating the relatives used by loads and spills
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_ALLOCATEGLOBALREGISTERS, compileStats ? GetIRSize(m_basicBlocks) : CCompileStats::IR_SIZE());
+		InsertGlobalRegisterLoadsAndSpills();
+		if(compileStats) passScope.SetSizeAfter(GetIRSize(m_basicBlocks));
+		m_globalRegisters.clear();
 	}
+}
 
-	auto result = ConcatBlocks(m_basicBlocks);
+void CJitter::PrepareBaselineBlocks()
+{
+	//Only does what code generators need, in a single pass over each block: statements with constant operands
+	//are folded, temporaries holding a constant are replaced by it (temporaries are only written once) and
+	//results only used to be moved somewhere else are written there directly
+	auto compileStats = m_compileStats.get();
+	for(auto& basicBlock : m_basicBlocks)
+	{
+		m_currentBlock = &basicBlock;
 
-#ifdef DUMP_STATEMENTS
-	DumpStatementList(result.statements);
-	std::cout << std::endl;
-#endif
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_CONSTANTFOLDING, GetIRSize(basicBlock));
 
-	m_codeGen->GenerateCode(result.statements, stackSize);
+		std::unordered_map<const CSymbol*, unsigned int> temporaryUseCounts;
+		for(const auto& statement : basicBlock.statements)
+		{
+			statement.VisitSources(
+				[&] (const SymbolRefPtr& symbolRef, bool)
+				{
+					auto symbol = symbolRef->GetSymbol().get();
+					if(symbol->IsTemporary()) temporaryUseCounts[symbol]++;
+				}
+			);
+		}
 
-	m_labels.clear();
+		std::unordered_map<const CSymbol*, SymbolRefPtr> constantTemporaries;
+		StatementList statements;
+		statements.reserve(basicBlock.statements.size());
+		for(auto& statement : basicBlock.statements)
+		{
+			statement.VisitSources(
+				[&] (SymbolRefPtr& symbolRef, bool)
+				{
+					auto constantIterator = constantTemporaries.find(symbolRef->GetSymbol().get());
+					if(constantIterator != std::end(constantTemporaries))
+					{
+						symbolRef = constantIterator->second;
+					}
+				}
+			);
+
+			FoldConstantOperation(statement);
+			FoldConstant64Operation(statement);
+			FoldConstant6432Operation(statement);
+			FoldConstant12832Operation(statement);
+
+			if((statement.op == OP_MOV) && statement.dst->GetSymbol()->IsTemporary() && statement.src1->GetSymbol()->IsConstant())
+			{
+				constantTemporaries[statement.dst->GetSymbol().get()] = statement.src1;
+				continue;
+			}
+
+			if((statement.op == OP_MOV) && !statements.empty())
+			{
+				auto& prevStatement = statements.back();
+				auto symbol = statement.src1->GetSymbol().get();
+				if(
+					(prevStatement.op != OP_RETVAL) && prevStatement.dst && symbol->IsTemporary() &&
+					prevStatement.dst->GetSymbol()->Equals(symbol) && (temporaryUseCounts[symbol] == 1)
+					)
+				{
+					prevStatement.dst = statement.dst;
+					if((prevStatement.op == OP_MOV) && prevStatement.dst->Equals(prevStatement.src1.get()))
+					{
+						statements.pop_back();
+					}
+					continue;
+				}
+			}
+
+			if((statement.op == OP_MOV) && statement.dst->Equals(statement.src1.get())) continue;
+
+			statements.push_back(std::move(statement));
+		}
+		basicBlock.statements = std::move(statements);
+
+		FixFlowControl(basicBlock.statements);
+		basicBlock.optimized = true;
+		passScope.SetSizeAfter(GetIRSize(basicBlock));
+	}
+
+	//Code generators don't handle every combination of memory operands, the local register allocator is still
+	//used (it only looks at one block at a time)
+	for(auto& basicBlock : m_basicBlocks)
+	{
+		m_currentBlock = &basicBlock;
+
+		CCompileStats::CPassScope passScope(compileStats, CCompileStats::PASS_ALLOCATEREGISTERS, GetIRSize(basicBlock));
+		AllocateRegisters(basicBlock);
+		passScope.SetSizeAfter(GetIRSize(basicBlock));
+	}
+}
+
+void CJitter::GenerateCode(const StatementList& statements, unsigned int stackSize)
+{
+	m_dynamicExits.clear();
+	m_codeGen->SetDynamicExitHandler([this] (uint32 offset) { m_dynamicExits.push_back(offset); });
+	try
+	{
+		GenerateCodeCached(statements, stackSize);
+	}
+	catch(...)
+	{
+		m_codeGen->SetDynamicExitHandler(CCodeGen::DynamicExitHandler());
+		throw;
+	}
+	m_codeGen->SetDynamicExitHandler(CCodeGen::DynamicExitHandler());
+}
+
+void CJitter::GenerateCodeCached(const StatementList& statements, unsigned int stackSize)
+{
+	//External symbols are reported to whoever set the handler, code needs to be generated
+	if(!m_codeCache || m_codeGen->HasExternalSymbolReferencedHandler())
+	{
+		m_codeGen->GenerateCode(statements, stackSize);
+		return;
+	}
+
+	auto key = m_codeCache->MakeKey(statements, stackSize, m_codeGen->GetConfigurationKey());
+	CCodeCache::CodeBuffer code;
+	if(!m_codeCache->Find(key, code, m_dynamicExits))
+	{
+		CCodeCache::RelocationArray relocations;
+		bool relocatable = true;
+		Framework::CMemStream codeStream;
+		m_codeGen->SetStream(&codeStream);
+		m_codeGen->SetExternalSymbolReferencedHandler(
+			[&] (uintptr_t symbol, uint32 offset, CCodeGen::SYMBOL_REF_TYPE type)
+			{
+				CCodeCache::RELOCATION relocation;
+				relocation.offset = offset;
+				relocation.type = type;
+				relocatable &= CCodeCache::IsRelocatable(type);
+				relocatable &= m_codeCache->GetExternalSymbolIndexByValue(symbol, relocation.symbolIndex);
+				relocations.push_back(relocation);
+			}
+		);
+		try
+		{
+			m_codeGen->GenerateCode(statements, stackSize);
+		}
+		catch(...)
+		{
+			m_codeGen->SetExternalSymbolReferencedHandler(CCodeGen::ExternalSymbolReferencedHandler());
+			m_codeGen->SetStream(m_stream);
+			throw;
+		}
+		m_codeGen->SetExternalSymbolReferencedHandler(CCodeGen::ExternalSymbolReferencedHandler());
+		m_codeGen->SetStream(m_stream);
+		auto codeBuffer = codeStream.GetBuffer();
+		code.assign(codeBuffer, codeBuffer + codeStream.GetSize());
+		//Every use of an external symbol must have been reported, otherwise its address is baked in the code
+		relocatable &= (relocations.size() == m_codeCache->GetExternalSymbolUseCount(statements));
+		if(relocatable)
+		{
+			m_codeCache->InsertRelocatable(std::move(key), code, std::move(relocations), m_dynamicExits);
+		}
+		else
+		{
+			m_codeCache->Insert(std::move(key), code, m_dynamicExits);
+		}
+	}
+	if(!code.empty())
+	{
+		m_stream->Write(code.data(), code.size());
+	}
+}
+
+CCompileStats::IR_SIZE CJitter::GetIRSize(const StatementList& statements)
+{
+	//Only called when statistics are enabled, counts distinct symbols used by the statements
+	CCompileStats::IR_SIZE size;
+	size.statementCount = statements.size();
+	std::unordered_set<const CSymbol*> symbols;
+	for(const auto& statement : statements)
+	{
+		statement.VisitOperands(
+			[&] (const SymbolRefPtr& symbolRef, bool)
+			{
+				symbols.insert(symbolRef->GetSymbol().get());
+			}
+		);
+	}
+	size.symbolCount = symbols.size();
+	return size;
+}
+
+CCompileStats::IR_SIZE CJitter::GetIRSize(const BASIC_BLOCK& basicBlock)
+{
+	CCompileStats::IR_SIZE size;
+	size.statementCount = basicBlock.statements.size();
+	size.symbolCount = basicBlock.symbolTable.GetSymbols().size();
+	return size;
+}
+
+CCompileStats::IR_SIZE CJitter::GetIRSize(const BasicBlockList& basicBlocks)
+{
+	//Only called when statistics are enabled, walks all blocks
+	CCompileStats::IR_SIZE size;
+	for(auto& basicBlock : basicBlocks)
+	{
+		auto blockSize = GetIRSize(basicBlock);
+		size.statementCount += blockSize.statementCount;
+		size.symbolCount += blockSize.symbolCount;
+	}
+	return size;
+}
+
+CJitter::SymbolUseMap CJitter::GetSymbolUses(const StatementList& statements)
+{
+	SymbolUseMap result;
+	for(uint32 index = 0; index < statements.size(); index++)
+	{
+		statements[index].VisitSources(
+			[&] (const SymbolRefPtr& symbolRef, bool)
+			{
+				auto symbol = symbolRef->GetSymbol().get();
+				if(symbol->IsConstant()) return;
+				auto& uses = result[symbol];
+				if(uses.empty() || (uses.back() != index))
+				{
+					uses.push_back(index);
+				}
+			}
+		);
+	}
+	return result;
 }
 
 void CJitter::InsertStatement(const STATEMENT& statement)
@@ -261,7 +617,17 @@ SymbolPtr CJitter::MakeSymbol(BASIC_BLOCK* basicBlock, SYM_TYPE type, uint32 val
 
 SymbolRefPtr CJitter::MakeSymbolRef(const SymbolPtr& symbol)
 {
-	return std::make_shared<CSymbolRef>(symbol);
+	return std::allocate_shared<CSymbolRef>(CArenaAllocator<CSymbolRef>(GetSymbolArena()), symbol);
+}
+
+SymbolRefPtr CJitter::MakeVersionedSymbolRef(const SymbolPtr& symbol, int version)
+{
+	return std::allocate_shared<CVersionedSymbolRef>(CArenaAllocator<CVersionedSymbolRef>(GetSymbolArena()), symbol, version);
+}
+
+CArena* CJitter::GetSymbolArena()
+{
+	return m_symbolArenaEnabled ? &m_symbolArena : nullptr;
 }
 
 int CJitter::GetSymbolSize(const SymbolRefPtr& symbolRef)
@@ -344,6 +710,14 @@ bool CJitter::FoldConstantOperation(STATEMENT& statement)
 			statement.src2.reset();
 			changed = true;
 		}
+		else if(src1cst && src1cst->m_valueLow == ~0)
+		{
+			//Anding with ~0
+			statement.op = OP_MOV;
+			std::swap(statement.src1, statement.src2);
+			statement.src2.reset();
+			changed = true;
+		}
 		else if(src2cst && src2cst->m_valueLow == ~0)
 		{
 			//Anding with ~0
@@ -377,6 +751,17 @@ bool CJitter::FoldConstantOperation(STATEMENT& statement)
 			statement.src2.reset();
 			changed = true;
 		}
+		else if(
+			(src1cst && src1cst->m_valueLow == ~0) ||
+			(src2cst && src2cst->m_valueLow == ~0)
+		)
+		{
+			//Oring with ~0
+			statement.op = OP_MOV;
+			statement.src1 = MakeSymbolRef(MakeSymbol(SYM_CONSTANT, ~0));
+			statement.src2.reset();
+			changed = true;
+		}
 	}
 	else if(statement.op == OP_XOR)
 	{
@@ -496,6 +881,17 @@ bool CJitter::FoldConstantOperation(STATEMENT& statement)
 			statement.src2.reset();
 			changed = true;
 		}
+		else if(
+			(src1cst && src1cst->m_valueLow == 0) ||
+			(src2cst && src2cst->m_valueLow == 0)
+		)
+		{
+			//Multiplying by zero
+			statement.op = OP_MOV;
+			statement.src1 = MakeSymbolRef(MakeConstant64(0));
+			statement.src2.reset();
+			changed = true;
+		}
 	}
 	else if(statement.op == OP_MULS)
 	{
@@ -507,6 +903,28 @@ bool CJitter::FoldConstantOperation(STATEMENT& statement)
 			statement.src2.reset();
 			changed = true;
 		}
+		else if(
+			(src1cst && src1cst->m_valueLow == 0) ||
+			(src2cst && src2cst->m_valueLow == 0)
+		)
+		{
+			//Multiplying by zero
+			statement.op = OP_MOV;
+			statement.src1 = MakeSymbolRef(MakeConstant64(0));
+			statement.src2.reset();
+			changed = true;
+		}
+	}
+	else if(statement.op == OP_MERGETO64)
+	{
+		if(src1cst && src2cst)
+		{
+			uint64 result = MergeConstant64(src1cst->m_valueLow, src2cst->m_valueLow);
+			statement.op = OP_MOV;
+			statement.src1 = MakeSymbolRef(MakeConstant64(result));
+			statement.src2.reset();
+			changed = true;
+		}
 	}
 	else if(statement.op == OP_DIV)
 	{
@@ -713,6 +1131,21 @@ bool CJitter::FoldConstant64Operation(STATEMENT& statement)
 			statement.src2.reset();
 			changed = true;
 		}
+		else if(src1cst && (src1cst->m_valueLow == ~0U) && (src1cst->m_valueHigh == ~0U))
+		{
+			//ANDing with ~0
+			statement.op = OP_MOV;
+			std::swap(statement.src1, statement.src2);
+			statement.src2.reset();
+			changed = true;
+		}
+		else if(src2cst && (src2cst->m_valueLow == ~0U) && (src2cst->m_valueHigh == ~0U))
+		{
+			//ANDing with ~0
+			statement.op = OP_MOV;
+			statement.src2.reset();
+			changed = true;
+		}
 	}
 	else if(statement.op == OP_CMP64)
 	{
@@ -773,7 +1206,32 @@ bool CJitter::FoldConstant6432Operation(STATEMENT& statement)
 		statement.op == OP_SRL64 ||
 		statement.op == OP_SRA64)
 	{
-		if(src2cst && ((src2cst->m_valueLow & 0x3F) == 0))
+		if(src1cst && src2cst)
+		{
+			uint64 value = MergeConstant64(src1cst->m_valueLow, src1cst->m_valueHigh);
+			uint32 shiftAmount = src2cst->m_valueLow & 0x3F;
+			uint64 result = 0;
+			switch(statement.op)
+			{
+			case OP_SLL64:
+				result = value << shiftAmount;
+				break;
+			case OP_SRL64:
+				result = value >> shiftAmount;
+				break;
+			case OP_SRA64:
+				result = static_cast<int64>(value) >> shiftAmount;
+				break;
+			default:
+				assert(false);
+				break;
+			}
+			statement.op = OP_MOV;
+			statement.src1 = MakeSymbolRef(MakeConstant64(result));
+			statement.src2.reset();
+			changed = true;
+		}
+		else if(src2cst && ((src2cst->m_valueLow & 0x3F) == 0))
 		{
 			statement.op = OP_MOV;
 			statement.src2.reset();
@@ -840,6 +1298,294 @@ bool CJitter::ConstantFolding(StatementList& statements)
 	return changed;
 }
 
+struct UNSIGNED_DIVISION_MAGIC
+{
+	uint32 multiplier = 0;
+	uint32 shift = 0;
+	bool needsAdd = false;
+};
+
+static UNSIGNED_DIVISION_MAGIC GetUnsignedDivisionMagic(uint32 divisor)
+{
+	//From "Division by Invariant Integers using Multiplication" (Granlund & Montgomery)
+	//If the multiplier fits in 32 bits: q = (x * m) >> (32 + shift)
+	//Otherwise, only its low 32 bits are kept and t = (x * m) >> 32: q = (((x - t) >> 1) + t) >> shift
+	assert((divisor > 1) && !IsPowerOfTwo(divisor));
+	UNSIGNED_DIVISION_MAGIC result;
+	for(uint32 shift = 0; shift < 32; shift++)
+	{
+		uint64 power = 1ULL << (32 + shift);
+		uint64 multiplier = (power + divisor - 1) / divisor;
+		if(multiplier > 0xFFFFFFFFULL) break;
+		if((multiplier * divisor - power) <= (1ULL << shift))
+		{
+			result.multiplier = static_cast<uint32>(multiplier);
+			result.shift = shift;
+			return result;
+		}
+	}
+	uint32 log2Divisor = 32 - __builtin_clz(divisor);
+	result.multiplier = static_cast<uint32>(((((1ULL << log2Divisor) - divisor) << 32) / divisor) + 1);
+	result.shift = log2Divisor - 1;
+	result.needsAdd = true;
+	return result;
+}
+
+bool CJitter::StrengthReduction(StatementList& statements)
+{
+	//Multiplications and divisions by constants are replaced by shifts, masks or multiplications
+	//by a magic number. 64-bit shifts by 32 or more and 64-bit ANDs with half masks only need to work
+	//on one half of their operand. Halves extracted from values built by MERGETO64 are then forwarded.
+
+	bool changed = false;
+	StatementList newStatements;
+	newStatements.reserve(statements.size());
+
+	auto makeTemporary =
+		[&]()
+		{
+			return MakeSymbolRef(MakeSymbol(SYM_TEMPORARY, m_nextTemporary++));
+		};
+
+	auto makeTemporary64 =
+		[&]()
+		{
+			return MakeSymbolRef(MakeSymbol(SYM_TEMPORARY64, m_nextTemporary++));
+		};
+
+	auto makeConstant =
+		[&](uint32 value)
+		{
+			return MakeSymbolRef(MakeSymbol(SYM_CONSTANT, value));
+		};
+
+	auto emit =
+		[&](OPERATION op, const SymbolRefPtr& dst, const SymbolRefPtr& src1, const SymbolRefPtr& src2)
+		{
+			STATEMENT statement;
+			statement.op = op;
+			statement.dst = dst;
+			statement.src1 = src1;
+			statement.src2 = src2;
+			newStatements.push_back(statement);
+			return dst;
+		};
+
+	auto emitOperation =
+		[&](OPERATION op, const SymbolRefPtr& src1, const SymbolRefPtr& src2)
+		{
+			return emit(op, makeTemporary(), src1, src2);
+		};
+
+	auto emitShift =
+		[&](OPERATION op, const SymbolRefPtr& src, uint32 amount)
+		{
+			if(amount == 0) return src;
+			return emitOperation(op, src, makeConstant(amount));
+		};
+
+	auto reduceStatement =
+		[&](const STATEMENT& statement)
+		{
+			auto src1 = statement.src1;
+			auto src2 = statement.src2;
+			if(!src1 || !src2) return false;
+			if(src1->GetSymbol()->IsConstant() && !src2->GetSymbol()->IsConstant())
+			{
+				switch(statement.op)
+				{
+				case OP_MUL:
+				case OP_MULS:
+				case OP_AND64:
+					std::swap(src1, src2);
+					break;
+				default:
+					break;
+				}
+			}
+			if(src1->GetSymbol()->IsConstant() || !src2->GetSymbol()->IsConstant()) return false;
+			uint32 cstLow = src2->GetSymbol()->m_valueLow;
+			uint32 cstHigh = src2->GetSymbol()->m_valueHigh;
+
+			switch(statement.op)
+			{
+			case OP_MUL:
+			case OP_MULS:
+				{
+					bool isSigned = (statement.op == OP_MULS);
+					if(cstLow == 1)
+					{
+						auto high = isSigned ? emitShift(OP_SRA, src1, 31) : makeConstant(0);
+						emit(OP_MERGETO64, statement.dst, src1, high);
+						return true;
+					}
+					if(!IsPowerOfTwo(cstLow)) return false;
+					uint32 shift = GetPowerOf2(cstLow);
+					//Signed multiplication by 0x80000000 is a multiplication by a negative number
+					if(isSigned && (shift == 31)) return false;
+					auto low = emitShift(OP_SLL, src1, shift);
+					auto high = emitShift(isSigned ? OP_SRA : OP_SRL, src1, 32 - shift);
+					emit(OP_MERGETO64, statement.dst, low, high);
+					return true;
+				}
+			case OP_DIV:
+				{
+					if(cstLow == 0) return false;
+					if(cstLow == 1)
+					{
+						emit(OP_MERGETO64, statement.dst, src1, makeConstant(0));
+						return true;
+					}
+					if(IsPowerOfTwo(cstLow))
+					{
+						auto quotient = emitShift(OP_SRL, src1, GetPowerOf2(cstLow));
+						auto remainder = emitOperation(OP_AND, src1, makeConstant(cstLow - 1));
+						emit(OP_MERGETO64, statement.dst, quotient, remainder);
+						return true;
+					}
+					auto magic = GetUnsignedDivisionMagic(cstLow);
+					auto product = emit(OP_MUL, makeTemporary64(), src1, makeConstant(magic.multiplier));
+					auto productHigh = emitOperation(OP_EXTHIGH64, product, SymbolRefPtr());
+					SymbolRefPtr quotient;
+					if(magic.needsAdd)
+					{
+						auto difference = emitOperation(OP_SUB, src1, productHigh);
+						auto halfDifference = emitShift(OP_SRL, difference, 1);
+						auto sum = emitOperation(OP_ADD, halfDifference, productHigh);
+						quotient = emitShift(OP_SRL, sum, magic.shift);
+					}
+					else
+					{
+						quotient = emitShift(OP_SRL, productHigh, magic.shift);
+					}
+					auto quotientProduct = emit(OP_MUL, makeTemporary64(), quotient, makeConstant(cstLow));
+					auto quotientProductLow = emitOperation(OP_EXTLOW64, quotientProduct, SymbolRefPtr());
+					auto remainder = emitOperation(OP_SUB, src1, quotientProductLow);
+					emit(OP_MERGETO64, statement.dst, quotient, remainder);
+					return true;
+				}
+			case OP_DIVS:
+				{
+					if(cstLow == 1)
+					{
+						emit(OP_MERGETO64, statement.dst, src1, makeConstant(0));
+						return true;
+					}
+					//Negative divisors are left alone
+					if(!IsPowerOfTwo(cstLow) || (cstLow == 0x80000000)) return false;
+					//Negative dividends need to be biased to get a quotient rounded towards zero
+					uint32 shift = GetPowerOf2(cstLow);
+					auto sign = emitShift(OP_SRA, src1, 31);
+					auto bias = emitShift(OP_SRL, sign, 32 - shift);
+					auto biased = emitOperation(OP_ADD, src1, bias);
+					auto quotient = emitShift(OP_SRA, biased, shift);
+					auto multiple = emitOperation(OP_AND, biased, makeConstant(~(cstLow - 1)));
+					auto remainder = emitOperation(OP_SUB, src1, multiple);
+					emit(OP_MERGETO64, statement.dst, quotient, remainder);
+					return true;
+				}
+			case OP_SLL64:
+			case OP_SRL64:
+			case OP_SRA64:
+				{
+					uint32 shift = cstLow & 0x3F;
+					if(shift < 32) return false;
+					shift -= 32;
+					if(statement.op == OP_SLL64)
+					{
+						auto low = emitOperation(OP_EXTLOW64, src1, SymbolRefPtr());
+						emit(OP_MERGETO64, statement.dst, makeConstant(0), emitShift(OP_SLL, low, shift));
+					}
+					else if(statement.op == OP_SRL64)
+					{
+						auto high = emitOperation(OP_EXTHIGH64, src1, SymbolRefPtr());
+						emit(OP_MERGETO64, statement.dst, emitShift(OP_SRL, high, shift), makeConstant(0));
+					}
+					else
+					{
+						auto high = emitOperation(OP_EXTHIGH64, src1, SymbolRefPtr());
+						auto resultLow = emitShift(OP_SRA, high, shift);
+						auto resultHigh = emitShift(OP_SRA, high, 31);
+						emit(OP_MERGETO64, statement.dst, resultLow, resultHigh);
+					}
+					return true;
+				}
+			case OP_AND64:
+				{
+					//Only masks made of a full half and an empty half
+					if(
+						((cstLow != 0) && (cstLow != ~0U)) ||
+						((cstHigh != 0) && (cstHigh != ~0U)) ||
+						(cstLow == cstHigh)
+					)
+					{
+						return false;
+					}
+					auto low = (cstLow != 0) ? emitOperation(OP_EXTLOW64, src1, SymbolRefPtr()) : makeConstant(0);
+					auto high = (cstHigh != 0) ? emitOperation(OP_EXTHIGH64, src1, SymbolRefPtr()) : makeConstant(0);
+					emit(OP_MERGETO64, statement.dst, low, high);
+					return true;
+				}
+			default:
+				return false;
+			}
+		};
+
+	for(const auto& statement : statements)
+	{
+		if(reduceStatement(statement))
+		{
+			changed = true;
+			continue;
+		}
+		newStatements.push_back(statement);
+	}
+
+	//Forward halves of values built by MERGETO64, only if its sources can't be redefined
+	SymbolUseCountMap definitionCounts;
+	for(const auto& statement : newStatements)
+	{
+		if(statement.dst)
+		{
+			definitionCounts[statement.dst->GetSymbol().get()]++;
+		}
+	}
+
+	auto isForwardable =
+		[&](const SymbolRefPtr& symbolRef)
+		{
+			auto symbol = symbolRef->GetSymbol().get();
+			return symbol->IsConstant() || (symbol->IsTemporary() && (definitionCounts[symbol] == 1));
+		};
+
+	std::unordered_map<CSymbol*, std::pair<SymbolRefPtr, SymbolRefPtr>> merges;
+	for(auto& statement : newStatements)
+	{
+		if((statement.op == OP_EXTLOW64) || (statement.op == OP_EXTHIGH64))
+		{
+			auto mergeIterator = merges.find(statement.src1->GetSymbol().get());
+			if(mergeIterator == merges.end()) continue;
+			const auto& halves = mergeIterator->second;
+			statement.src1 = (statement.op == OP_EXTLOW64) ? halves.first : halves.second;
+			statement.op = OP_MOV;
+			changed = true;
+		}
+		else if(statement.op == OP_MERGETO64)
+		{
+			auto dstSymbol = statement.dst->GetSymbol().get();
+			if(!dstSymbol->IsTemporary() || (definitionCounts[dstSymbol] != 1)) continue;
+			if(!isForwardable(statement.src1) || !isForwardable(statement.src2)) continue;
+			merges[dstSymbol] = std::make_pair(statement.src1, statement.src2);
+		}
+	}
+
+	if(changed)
+	{
+		statements = std::move(newStatements);
+	}
+	return changed;
+}
+
 void CJitter::FixFlowControl(StatementList& statements)
 {
 	//Resolve GOTO instructions
@@ -875,16 +1621,17 @@ void CJitter::MergeBasicBlocks(BASIC_BLOCK& dstBlock, const BASIC_BLOCK& srcBloc
 {
 	auto& dstSymbolTable = dstBlock.symbolTable;
 
+	dstBlock.statements.reserve(dstBlock.statements.size() + srcBlock.statements.size());
 	for(auto statement : srcBlock.statements)
 	{
 		statement.VisitOperands(
-			[&dstSymbolTable](SymbolRefPtr& symbolRef, bool)
+			[this, &dstSymbolTable](SymbolRefPtr& symbolRef, bool)
 			{
 				auto symbol = symbolRef->GetSymbol();
-				symbolRef = std::make_shared<CSymbolRef>(dstSymbolTable.MakeSymbol(symbol));
+				symbolRef = MakeSymbolRef(dstSymbolTable.MakeSymbol(symbol));
 			}
 		);
-		dstBlock.statements.push_back(statement);
+		dstBlock.statements.push_back(std::move(statement));
 	}
 
 	dstBlock.optimized = false;
@@ -892,7 +1639,7 @@ void CJitter::MergeBasicBlocks(BASIC_BLOCK& dstBlock, const BASIC_BLOCK& srcBloc
 
 CJitter::BASIC_BLOCK CJitter::ConcatBlocks(const BasicBlockList& blocks)
 {
-	BASIC_BLOCK result;
+	BASIC_BLOCK result(GetSymbolArena());
 	for(const auto& basicBlock : blocks)
 	{
 		//First, add a mark label statement
@@ -908,85 +1655,72 @@ CJitter::BASIC_BLOCK CJitter::ConcatBlocks(const BasicBlockList& blocks)
 
 bool CJitter::PruneBlocks()
 {
-	bool changed = true;
-	int deletedBlocks = 0;
-
-	while(changed)
+	//Blocks are kept if they can be reached from the first one. Blocks in a loop reference each other,
+	//being referenced isn't enough to be reachable.
+	std::unordered_map<uint32, BasicBlockList::const_iterator> blockIterators;
+	for(auto blockIterator(m_basicBlocks.cbegin());
+		blockIterator != m_basicBlocks.cend(); blockIterator++)
 	{
-		changed = false;
-
-		auto toDeleteIterator = m_basicBlocks.cend();
-		for(auto outerBlockIterator(m_basicBlocks.cbegin());
-			outerBlockIterator != m_basicBlocks.cend(); outerBlockIterator++)
-		{
-			//First block is always referenced
-			if(outerBlockIterator == m_basicBlocks.begin()) continue;
-
-			auto candidateBlockIterator = outerBlockIterator;
-			bool referenced = false;
+		blockIterators[blockIterator->id] = blockIterator;
+	}
 
-			//Check if there's a reference to this block in here
-			for(auto innerBlockIterator(m_basicBlocks.cbegin());
-				innerBlockIterator != m_basicBlocks.cend(); innerBlockIterator++)
-			{
-				const auto& block(*innerBlockIterator);
-				bool referencesNext = false;
+	std::unordered_set<uint32> reachableBlocks;
+	std::vector<BasicBlockList::const_iterator> pendingBlocks;
+	if(!m_basicBlocks.empty())
+	{
+		pendingBlocks.push_back(m_basicBlocks.cbegin());
+	}
 
-				if(block.statements.empty())
-				{
-					//Empty blocks references next one
-					referencesNext = true;
-				}
-				else
-				{
-					//Check if this block references the next one or if it jumps to another one
-					auto lastInstruction(block.statements.end());
-					lastInstruction--;
-					const auto& statement(*lastInstruction);
+	while(!pendingBlocks.empty())
+	{
+		auto blockIterator = pendingBlocks.back();
+		pendingBlocks.pop_back();
+		if(!reachableBlocks.insert(blockIterator->id).second) continue;
 
-					//It jumps to a block, so check if it references the one we're looking for
-					if(statement.op == OP_JMP || statement.op == OP_CONDJMP)
-					{
-						if(statement.jmpBlock == candidateBlockIterator->id)
-						{
-							referenced = true;
-							break;
-						}
-					}
+		const auto& block(*blockIterator);
+		bool referencesNext = true;
 
-					//Otherwise, it references the next one if it's not a jump
-					if(statement.op != OP_JMP)
-					{
-						referencesNext = true;
-					}
-				}
+		if(!block.statements.empty())
+		{
+			const auto& statement(block.statements.back());
 
-				if(referencesNext)
+			//It jumps to a block, that one is reachable
+			if(statement.op == OP_JMP || statement.op == OP_CONDJMP)
+			{
+				auto targetIterator = blockIterators.find(statement.jmpBlock);
+				assert(targetIterator != std::end(blockIterators));
+				if(targetIterator != std::end(blockIterators))
 				{
-					auto nextBlockIterator(innerBlockIterator);
-					nextBlockIterator++;
-					if(nextBlockIterator != m_basicBlocks.end())
-					{
-						if(nextBlockIterator->id == candidateBlockIterator->id)
-						{
-							referenced = true;
-							break;
-						}
-					}
+					pendingBlocks.push_back(targetIterator->second);
 				}
 			}
 
-			if(!referenced)
+			//Otherwise, it references the next one if it's not a jump
+			referencesNext = (statement.op != OP_JMP);
+		}
+
+		if(referencesNext)
+		{
+			auto nextBlockIterator(std::next(blockIterator));
+			if(nextBlockIterator != m_basicBlocks.cend())
 			{
-				toDeleteIterator = candidateBlockIterator;
-				break;
+				pendingBlocks.push_back(nextBlockIterator);
 			}
 		}
-		if(toDeleteIterator == m_basicBlocks.end()) continue;
+	}
 
-		m_basicBlocks.erase(toDeleteIterator);
-		deletedBlocks++;
-		changed = true;
+	int deletedBlocks = 0;
+	for(auto blockIterator(m_basicBlocks.begin()); blockIterator != m_basicBlocks.end();)
+	{
+		if(reachableBlocks.count(blockIterator->id) == 0)
+		{
+			blockIterator = m_basicBlocks.erase(blockIterator);
+			deletedBlocks++;
+		}
+		else
+		{
+			blockIterator++;
+		}
 	}
 
 	HarmonizeBlocks();
@@ -1063,6 +1797,8 @@ bool CJitter::MergeBlocks()
 			auto& nextBlock(*nextBlockIterator);
 
 			if(nextBlock.hasJumpRef) continue;
+			//Keep loop boundaries, loop invariant code motion needs to find what's in a loop
+			if(nextBlock.loopDepth != basicBlock.loopDepth) continue;
 
 			//Check if the last statement is a jump
 			if(!basicBlock.statements.empty())
@@ -1087,14 +1823,198 @@ bool CJitter::MergeBlocks()
 	return deletedBlocks != 0;
 }
 
+bool CJitter::IsProfiledBlock(uint32 blockId) const
+{
+	return (m_profile != nullptr) && (blockId < m_profileSize);
+}
+
+bool CJitter::IsColdBlock(uint32 blockId) const
+{
+	return IsProfiledBlock(blockId) && (m_profile[blockId] == 0);
+}
+
+void CJitter::LayoutBlocks()
+{
+	if(!m_profile) return;
+	if(m_basicBlocks.size() < 2) return;
+
+	//Blocks that fall through to the end of the function use this index
+	static const size_t EXIT_BLOCK = ~static_cast<size_t>(0);
+	static const size_t NO_BLOCK = EXIT_BLOCK - 1;
+
+	struct BLOCK_FLOW
+	{
+		BasicBlockList::iterator	blockIterator;
+		size_t						fallThrough = NO_BLOCK;
+		size_t						jumpTarget = NO_BLOCK;
+		uint32						fallThroughCount = 0;
+		uint32						jumpCount = 0;
+		bool						cold = false;
+	};
+
+	std::vector<BLOCK_FLOW> flows;
+	std::unordered_map<uint32, size_t> blockIndices;
+	flows.reserve(m_basicBlocks.size());
+	for(auto blockIterator(m_basicBlocks.begin()); blockIterator != m_basicBlocks.end(); blockIterator++)
+	{
+		blockIndices[blockIterator->id] = flows.size();
+		BLOCK_FLOW flow;
+		flow.blockIterator = blockIterator;
+		//Entry block always stays first
+		flow.cold = !flows.empty() && IsColdBlock(blockIterator->id);
+		flows.push_back(flow);
+	}
+
+	//Edge counts are derived from block counts: a conditional jump falls through in a block of its own,
+	//the jump is taken every time that block isn't entered
+	for(size_t blockIndex = 0; blockIndex < flows.size(); blockIndex++)
+	{
+		auto& flow = flows[blockIndex];
+		const auto& block = *flow.blockIterator;
+		uint32 blockCount = IsProfiledBlock(block.id) ? m_profile[block.id] : 0;
+		auto op = block.statements.empty() ? OP_NOP : block.statements.back().op;
+		if((op == OP_JMP) || (op == OP_CONDJMP))
+		{
+			auto blockIndexIterator = blockIndices.find(block.statements.back().jmpBlock);
+			assert(blockIndexIterator != std::end(blockIndices));
+			flow.jumpTarget = blockIndexIterator->second;
+		}
+		if((op != OP_JMP) && (op != OP_EXTERNJMP) && (op != OP_EXTERNJMP_DYN))
+		{
+			flow.fallThrough = ((blockIndex + 1) == flows.size()) ? EXIT_BLOCK : (blockIndex + 1);
+		}
+		if(op == OP_CONDJMP)
+		{
+			if(flow.fallThrough != EXIT_BLOCK)
+			{
+				uint32 fallThroughId = flows[flow.fallThrough].blockIterator->id;
+				flow.fallThroughCount = IsProfiledBlock(fallThroughId) ? std::min(m_profile[fallThroughId], blockCount) : 0;
+			}
+			flow.jumpCount = blockCount - flow.fallThroughCount;
+		}
+		else
+		{
+			flow.fallThroughCount = blockCount;
+			flow.jumpCount = blockCount;
+		}
+	}
+
+	//Build chains by following the most executed edge out of each block, fall through wins ties.
+	//Cold blocks are left out and moved to the end of the function.
+	std::vector<size_t> order;
+	std::vector<bool> placed(flows.size(), false);
+	order.reserve(flows.size());
+	for(size_t seedIndex = 0; seedIndex < flows.size(); seedIndex++)
+	{
+		size_t blockIndex = seedIndex;
+		while((blockIndex < flows.size()) && !placed[blockIndex] && !flows[blockIndex].cold)
+		{
+			placed[blockIndex] = true;
+			order.push_back(blockIndex);
+
+			const auto& flow = flows[blockIndex];
+			auto isCandidate =
+				[&] (size_t candidateIndex)
+				{
+					return (candidateIndex < flows.size()) && !placed[candidateIndex] && !flows[candidateIndex].cold;
+				};
+			bool fallThroughCandidate = isCandidate(flow.fallThrough);
+			bool jumpCandidate = isCandidate(flow.jumpTarget);
+			if(jumpCandidate && (!fallThroughCandidate || (flow.jumpCount > flow.fallThroughCount)))
+			{
+				blockIndex = flow.jumpTarget;
+			}
+			else
+			{
+				blockIndex = fallThroughCandidate ? flow.fallThrough : NO_BLOCK;
+			}
+		}
+	}
+	for(size_t blockIndex = 0; blockIndex < flows.size(); blockIndex++)
+	{
+		if(flows[blockIndex].cold)
+		{
+			order.push_back(blockIndex);
+		}
+	}
+	assert(order.size() == flows.size());
+
+	bool reordered = false;
+	for(size_t orderIndex = 0; orderIndex < order.size(); orderIndex++)
+	{
+		reordered |= (order[orderIndex] != orderIndex);
+	}
+	if(!reordered) return;
+
+	for(auto blockIndex : order)
+	{
+		m_basicBlocks.splice(m_basicBlocks.end(), m_basicBlocks, flows[blockIndex].blockIterator);
+	}
+
+	uint32 exitBlockId = 0;
+	if(order.back() != (flows.size() - 1))
+	{
+		//Last block moved, it needs somewhere to jump to reach the end of the function
+		exitBlockId = m_nextBlockId++;
+		auto& exitBlock = *m_basicBlocks.emplace(m_basicBlocks.end(), GetSymbolArena());
+		exitBlock.id = exitBlockId;
+		exitBlock.optimized = true;
+	}
+
+	//Fall through edges that don't lead to the next block anymore need a jump
+	for(size_t orderIndex = 0; orderIndex < order.size(); orderIndex++)
+	{
+		const auto& flow = flows[order[orderIndex]];
+		if(flow.fallThrough == NO_BLOCK) continue;
+
+		auto blockIterator = flow.blockIterator;
+		auto nextBlockIterator = std::next(blockIterator);
+		uint32 fallThroughId = (flow.fallThrough == EXIT_BLOCK) ? exitBlockId : flows[flow.fallThrough].blockIterator->id;
+		if((nextBlockIterator != m_basicBlocks.end()) && (nextBlockIterator->id == fallThroughId)) continue;
+		if((nextBlockIterator == m_basicBlocks.end()) && (flow.fallThrough == EXIT_BLOCK)) continue;
+
+		auto& block = *blockIterator;
+		STATEMENT jumpStatement;
+		jumpStatement.op		= OP_JMP;
+		jumpStatement.jmpBlock	= fallThroughId;
+
+		if(!block.statements.empty() && (block.statements.back().op == OP_CONDJMP))
+		{
+			auto& condJumpStatement = block.statements.back();
+			if((nextBlockIterator != m_basicBlocks.end()) && (nextBlockIterator->id == condJumpStatement.jmpBlock))
+			{
+				//Jump target is next, jump to the fall through block on the reverse condition instead
+				condJumpStatement.jmpCondition = GetReverseCondition(condJumpStatement.jmpCondition);
+				condJumpStatement.jmpBlock = fallThroughId;
+			}
+			else
+			{
+				auto& trampolineBlock = *m_basicBlocks.emplace(nextBlockIterator, GetSymbolArena());
+				trampolineBlock.id = m_nextBlockId++;
+				trampolineBlock.optimized = true;
+				trampolineBlock.loopDepth = block.loopDepth;
+				trampolineBlock.statements.push_back(jumpStatement);
+			}
+		}
+		else
+		{
+			block.statements.push_back(jumpStatement);
+		}
+	}
+
+	HarmonizeBlocks();
+}
+
 bool CJitter::ConstantPropagation(StatementList& statements)
 {
 	bool changed = false;
 
-	for(StatementList::iterator outerStatementIterator(statements.begin());
-		statements.end() != outerStatementIterator; ++outerStatementIterator)
+	//Only constants are introduced by this pass, uses of other symbols stay valid while we go
+	auto symbolUses = GetSymbolUses(statements);
+
+	for(uint32 outerIndex = 0; outerIndex < statements.size(); outerIndex++)
 	{
-		STATEMENT& outerStatement(*outerStatementIterator);
+		STATEMENT& outerStatement(statements[outerIndex]);
 
 		if(outerStatement.op != OP_MOV) continue;
 
@@ -1105,13 +2025,15 @@ bool CJitter::ConstantPropagation(StatementList& statements)
 		}
 		if(!constant) continue;
 
+		auto usesIterator = symbolUses.find(outerStatement.dst->GetSymbol().get());
+		if(usesIterator == symbolUses.end()) continue;
+
 		//Find anything that uses this operand and replace it with the constant
-		for(StatementList::iterator innerStatementIterator(outerStatementIterator);
-			statements.end() != innerStatementIterator; ++innerStatementIterator)
+		for(auto innerIndex : usesIterator->second)
 		{
-			if(outerStatementIterator == innerStatementIterator) continue;
+			if(innerIndex <= outerIndex) continue;
 
-			auto& innerStatement(*innerStatementIterator);
+			auto& innerStatement(statements[innerIndex]);
 			
 			innerStatement.VisitSources(
 				[&] (SymbolRefPtr& symbol, bool)
@@ -1176,10 +2098,13 @@ bool CJitter::CopyPropagation(StatementList& statements)
 {
 	bool changed = false;
 
-	for(auto outerStatementIterator(statements.begin());
-		statements.end() != outerStatementIterator; ++outerStatementIterator)
+	auto symbolUses = GetSymbolUses(statements);
+	//Makes sure statements using a symbol more than once are only counted once
+	std::vector<uint32> countedStatements(statements.size(), ~0U);
+
+	for(uint32 outerIndex = 0; outerIndex < statements.size(); outerIndex++)
 	{
-		STATEMENT& outerStatement(*outerStatementIterator);
+		STATEMENT& outerStatement(statements[outerIndex]);
 
 		//Some operations we can't propagate
 		if(outerStatement.op == OP_RETVAL) continue;
@@ -1193,14 +2118,18 @@ bool CJitter::CopyPropagation(StatementList& statements)
 			continue;
 		}
 
+		auto usesIterator = symbolUses.find(outerDstSymbol->GetSymbol().get());
+		if(usesIterator == symbolUses.end()) continue;
+
 		//Count number of uses of this symbol
 		unsigned int useCount = 0;
-		for(auto innerStatementIterator(outerStatementIterator);
-			statements.end() != innerStatementIterator; ++innerStatementIterator)
+		uint32 useIndex = 0;
+		for(auto innerIndex : usesIterator->second)
 		{
-			if(outerStatementIterator == innerStatementIterator) continue;
+			if(innerIndex <= outerIndex) continue;
+			if(countedStatements[innerIndex] == outerIndex) continue;
 
-			auto& innerStatement(*innerStatementIterator);
+			auto& innerStatement(statements[innerIndex]);
 
 			if(
 				(innerStatement.src1 && innerStatement.src1->Equals(outerDstSymbol)) || 
@@ -1208,131 +2137,596 @@ bool CJitter::CopyPropagation(StatementList& statements)
 				(innerStatement.src3 && innerStatement.src3->Equals(outerDstSymbol))
 				)
 			{
+				countedStatements[innerIndex] = outerIndex;
+				useIndex = innerIndex;
 				useCount++;
 			}
 		}
 
 		if(useCount == 1)
 		{
-			unsigned int changeCount = 0;
+			auto& innerStatement(statements[useIndex]);
 
-			for(auto innerStatementIterator(outerStatementIterator);
-				statements.end() != innerStatementIterator; ++innerStatementIterator)
+			//Check for all OP_MOVs that uses the result of this operation and propagate
+			if(innerStatement.op == OP_MOV && innerStatement.src1->Equals(outerDstSymbol))
 			{
-				if(outerStatementIterator == innerStatementIterator) continue;
-
-				auto& innerStatement(*innerStatementIterator);
+				innerStatement.op = outerStatement.op;
+				innerStatement.src1 = outerStatement.src1;
+				innerStatement.src2 = outerStatement.src2;
+				innerStatement.src3 = outerStatement.src3;
+				innerStatement.jmpCondition = outerStatement.jmpCondition;
+				changed = true;
 
-				//Check for all OP_MOVs that uses the result of this operation and propagate
-				if(innerStatement.op == OP_MOV && innerStatement.src1->Equals(outerDstSymbol))
+				//Sources of this statement are now also used by the inner statement
+				outerStatement.VisitSources(
+					[&] (const SymbolRefPtr& symbolRef, bool)
+					{
+						symbolUses[symbolRef->GetSymbol().get()].push_back(useIndex);
+					}
+				);
+			}
+			// find all the add/sub constant and add them together
+			else if(outerStatement.op == innerStatement.op && innerStatement.op == OP_ADD && innerStatement.src1->Equals(outerDstSymbol))
+			{
+				CSymbol* innerSrc2cst = dynamic_symbolref_cast(SYM_CONSTANT, innerStatement.src2);
+				CSymbol* outerSrc2cst = dynamic_symbolref_cast(SYM_CONSTANT, outerStatement.src2);
+				if(innerSrc2cst && outerSrc2cst)
 				{
-					changeCount++;
-
-					innerStatement.op = outerStatement.op;
-					innerStatement.src1 = outerStatement.src1;
-					innerStatement.src2 = outerStatement.src2;
-					innerStatement.src3 = outerStatement.src3;
-					innerStatement.jmpCondition = outerStatement.jmpCondition;
+					uint32 result = innerSrc2cst->m_valueLow + outerSrc2cst->m_valueLow;
+					outerStatement.src2 = MakeSymbolRef(MakeSymbol(SYM_CONSTANT, result));
+					innerStatement.op = OP_MOV;
+					innerStatement.src2.reset();
 					changed = true;
 				}
-				// find all the add/sub constant and add them together
-				else if(outerStatement.op == innerStatement.op && innerStatement.op == OP_ADD && innerStatement.src1->Equals(outerDstSymbol))
+			}
+		}
+	}
+	return changed;
+}
+
+enum VALUE_NUMBERING_CLASS
+{
+	VALUE_NUMBERING_NONE,
+	VALUE_NUMBERING_PURE,
+	VALUE_NUMBERING_STATEFUL,	//Depends on memory or on the floating point state, which can change at barriers
+	VALUE_NUMBERING_BARRIER,
+};
+
+static VALUE_NUMBERING_CLASS GetValueNumberingClass(OPERATION op)
+{
+	switch(op)
+	{
+	case OP_LOADFROMREF:
+	case OP_LOADFROMREFIDX:
+	case OP_LOAD8FROMREF:
+	case OP_LOAD16FROMREF:
+	case OP_MD_TOSINGLE:
+	case OP_MD_ADD_S:
+	case OP_MD_SUB_S:
+	case OP_MD_MUL_S:
+	case OP_MD_DIV_S:
+	case OP_FP_ADD:
+	case OP_FP_SUB:
+	case OP_FP_MUL:
+	case OP_FP_DIV:
+	case OP_FP_SQRT:
+	case OP_FP_RSQRT:
+	case OP_FP_RCPL:
+	case OP_FP_TOINT_TRUNC:
+		return VALUE_NUMBERING_STATEFUL;
+	case OP_STOREATREF:
+	case OP_STOREATREFIDX:
+	case OP_STORE8ATREF:
+	case OP_STORE16ATREF:
+	case OP_CALL:
+	case OP_EXTERNJMP:
+	case OP_EXTERNJMP_DYN:
+	case OP_LOOKUP:
+		return VALUE_NUMBERING_BARRIER;
+	case OP_NOP:
+	case OP_MOV:
+	case OP_MD_MOV_MASKED:
+	case OP_PARAM:
+	case OP_PARAM_RET:
+	case OP_RETVAL:
+	case OP_JMP:
+	case OP_CONDJMP:
+	case OP_GOTO:
+	case OP_BREAK:
+	case OP_INCCOUNTER:
+	case OP_LABEL:
+		return VALUE_NUMBERING_NONE;
+	default:
+		//Everything else (ALU, 64-bit, MD and FP operations) only depends on its operands
+		assert(op < OP_MAX);
+		return VALUE_NUMBERING_PURE;
+	}
+}
+
+bool CJitter::ValueNumbering(StatementList& statements)
+{
+	//Statements computing a value already held by a temporary are removed and their uses redirected
+	//to that temporary. Sources are identified with a generation number that changes every time they
+	//might have been modified:
+	//- Temporaries and registers: number of definitions seen so far.
+	//- Relatives: last generation of the 4 bytes words they cover, writes to any relative, through a
+	//  reference or by a call update these.
+	//Loads and rounding sensitive operations also depend on the last barrier (store through a reference or call).
+
+	struct VALUE_KEY
+	{
+		OPERATION		op = OP_NOP;
+		CONDITION		condition = CONDITION_NEVER;
+		SYM_TYPE		dstType = SYM_CONSTANT;
+		CSymbol*		sources[3] = {};
+		uint32			generations[3] = {};
+		uint32			memoryGeneration = 0;
+
+		bool operator ==(const VALUE_KEY& rhs) const
+		{
+			return (op == rhs.op) && (condition == rhs.condition) && (dstType == rhs.dstType) &&
+				std::equal(std::begin(sources), std::end(sources), std::begin(rhs.sources)) &&
+				std::equal(std::begin(generations), std::end(generations), std::begin(rhs.generations)) &&
+				(memoryGeneration == rhs.memoryGeneration);
+		}
+	};
+
+	struct VALUE_KEY_HASHER
+	{
+		size_t operator()(const VALUE_KEY& key) const
+		{
+			size_t result = std::hash<uint32>()((key.op << 16) | (key.condition << 8) | key.dstType);
+			for(unsigned int i = 0; i < 3; i++)
+			{
+				result = (result * 31) ^ std::hash<CSymbol*>()(key.sources[i]);
+				result = (result * 31) ^ key.generations[i];
+			}
+			return (result * 31) ^ key.memoryGeneration;
+		}
+	};
+
+	typedef std::unordered_map<VALUE_KEY, SymbolRefPtr, VALUE_KEY_HASHER> ValueMap;
+
+	bool changed = false;
+	StatementTombstoneList tombstones(statements.size(), false);
+
+	//Only values held by temporaries defined once can be reused
+	SymbolUseCountMap definitionCounts;
+	for(const auto& statement : statements)
+	{
+		if(statement.dst)
+		{
+			definitionCounts[statement.dst->GetSymbol().get()]++;
+		}
+	}
+
+	ValueMap values;
+	std::unordered_map<CSymbol*, SymbolRefPtr> replacements;
+	SymbolUseCountMap symbolGenerations;
+	std::unordered_map<uint32, uint32> relativeGenerations;
+	uint32 currentGeneration = 0;
+	uint32 barrierGeneration = 0;
+	uint32 memoryGeneration = 0;
+
+	auto getRelativeGeneration =
+		[&](CSymbol* symbol)
+		{
+			uint32 generation = barrierGeneration;
+			uint32 firstWord = symbol->m_valueLow / 4;
+			uint32 lastWord = (symbol->m_valueLow + symbol->GetSize() - 1) / 4;
+			for(uint32 word = firstWord; word <= lastWord; word++)
+			{
+				auto generationIterator = relativeGenerations.find(word);
+				if(generationIterator == relativeGenerations.end()) continue;
+				generation = std::max(generation, generationIterator->second);
+			}
+			return generation;
+		};
+
+	for(uint32 index = 0; index < statements.size(); index++)
+	{
+		auto& statement = statements[index];
+
+		statement.VisitSources(
+			[&](SymbolRefPtr& symbolRef, bool)
+			{
+				auto replacementIterator = replacements.find(symbolRef->GetSymbol().get());
+				if(replacementIterator == replacements.end()) return;
+				symbolRef = replacementIterator->second;
+				changed = true;
+			}
+		);
+
+		auto valueNumberingClass = GetValueNumberingClass(statement.op);
+
+		if(
+			((valueNumberingClass == VALUE_NUMBERING_PURE) || (valueNumberingClass == VALUE_NUMBERING_STATEFUL)) &&
+			statement.dst && statement.dst->GetSymbol()->IsTemporary() &&
+			(definitionCounts[statement.dst->GetSymbol().get()] == 1)
+		)
+		{
+			auto dstSymbol = statement.dst->GetSymbol().get();
+
+			VALUE_KEY key;
+			key.op = statement.op;
+			key.condition = statement.jmpCondition;
+			key.dstType = dstSymbol->m_type;
+			if(valueNumberingClass == VALUE_NUMBERING_STATEFUL)
+			{
+				key.memoryGeneration = memoryGeneration;
+			}
+			const SymbolRefPtr* sources[3] = { &statement.src1, &statement.src2, &statement.src3 };
+			for(unsigned int i = 0; i < 3; i++)
+			{
+				const auto& source = *sources[i];
+				if(!source) continue;
+				auto sourceSymbol = source->GetSymbol().get();
+				key.sources[i] = sourceSymbol;
+				if(sourceSymbol->IsRelative())
 				{
-					CSymbol* innerSrc2cst = dynamic_symbolref_cast(SYM_CONSTANT, innerStatement.src2);
-					CSymbol* outerSrc2cst = dynamic_symbolref_cast(SYM_CONSTANT, outerStatement.src2);
-					if(innerSrc2cst && outerSrc2cst)
-					{
-						changeCount++;
-						uint32 result = innerSrc2cst->m_valueLow + outerSrc2cst->m_valueLow;
-						outerStatement.src2 = MakeSymbolRef(MakeSymbol(SYM_CONSTANT, result));
-						innerStatement.op = OP_MOV;
-						innerStatement.src2.reset();
-						changed = true;
-					}
+					key.generations[i] = getRelativeGeneration(sourceSymbol);
+				}
+				else if(!sourceSymbol->IsConstant())
+				{
+					key.generations[i] = symbolGenerations[sourceSymbol];
+				}
+			}
+
+			auto valueIterator = values.find(key);
+			if(valueIterator != values.end())
+			{
+				replacements[dstSymbol] = valueIterator->second;
+				tombstones[index] = true;
+				changed = true;
+				continue;
+			}
+			values.emplace(key, statement.dst);
+		}
+
+		if(statement.dst)
+		{
+			auto dstSymbol = statement.dst->GetSymbol().get();
+			if(dstSymbol->IsRelative())
+			{
+				currentGeneration++;
+				uint32 firstWord = dstSymbol->m_valueLow / 4;
+				uint32 lastWord = (dstSymbol->m_valueLow + dstSymbol->GetSize() - 1) / 4;
+				for(uint32 word = firstWord; word <= lastWord; word++)
+				{
+					relativeGenerations[word] = currentGeneration;
 				}
 			}
+			else
+			{
+				symbolGenerations[dstSymbol]++;
+			}
+		}
+
+		if(statement.op == OP_PARAM_RET)
+		{
+			//Callee writes the result in there
+			symbolGenerations[statement.src1->GetSymbol().get()]++;
+		}
 
-			assert(changeCount <= 1);
+		if(valueNumberingClass == VALUE_NUMBERING_BARRIER)
+		{
+			memoryGeneration = ++currentGeneration;
+			//Context pure functions can change memory, but not relatives
+			if(!IsContextPureCall(statement))
+			{
+				barrierGeneration = memoryGeneration;
+			}
 		}
 	}
+
+	CompactStatementList(statements, tombstones);
 	return changed;
 }
 
 bool CJitter::DeadcodeElimination(VERSIONED_STATEMENT_LIST& versionedStatementList)
 {
-	bool changed = false;
+	//Statements are visited backwards, keeping track of every symbol used by live statements.
+	//A definition is dead if no live statement coming after it uses it.
 
-	typedef std::list<StatementList::iterator> ToDeleteList;
-	ToDeleteList toDelete;
+	struct RELATIVE_USE
+	{
+		bool		unversioned = false;
+		bool		relative32 = false;
+		uint32		otherMaxSize = 0;
+	};
+
+	auto& statements = versionedStatementList.statements;
+	StatementTombstoneList tombstones(statements.size(), false);
 
-	for(StatementList::iterator outerStatementIterator(versionedStatementList.statements.begin());
-		versionedStatementList.statements.end() != outerStatementIterator; ++outerStatementIterator)
+	std::unordered_set<CSymbol*> usedTemporaries;
+	//Keyed by (offset, version)
+	std::unordered_set<uint64> usedRelativeVersions;
+	//Keyed by offset, used to check for aliases
+	std::unordered_map<uint32, RELATIVE_USE> relativeUses;
+
+	auto isRelativeUsed =
+		[&](CSymbol* candidate, int version)
+		{
+			uint32 base = candidate->m_valueLow;
+			if(usedRelativeVersions.count((static_cast<uint64>(base) << 32) | static_cast<uint32>(version)))
+			{
+				return true;
+			}
+			if(relativeUses.empty())
+			{
+				return false;
+			}
+			//Same condition as CSymbol::Aliases, biggest relative symbol is 16 bytes
+			for(int32 distance = -15; distance <= 15; distance++)
+			{
+				auto useIterator = relativeUses.find(base + distance);
+				if(useIterator == relativeUses.end()) continue;
+				const auto& use = useIterator->second;
+				int32 absDistance = abs(distance);
+				if((distance == 0) && use.unversioned) return true;
+				if((distance != 0) && use.relative32 && (absDistance < 4)) return true;
+				if((use.otherMaxSize != 0) && ((absDistance < 4) || (absDistance < static_cast<int32>(use.otherMaxSize)))) return true;
+			}
+			return false;
+		};
+
+	for(auto statementIterator = statements.rbegin();
+		statementIterator != statements.rend(); statementIterator++)
 	{
-		STATEMENT& outerStatement(*outerStatementIterator);
+		auto& statement = *statementIterator;
 
-		CSymbol* candidate = NULL;
-		if(outerStatement.dst && outerStatement.dst->GetSymbol()->IsTemporary())
+		bool dead = false;
+		if(statement.dst && statement.dst->GetSymbol()->IsTemporary())
 		{
-			candidate = outerStatement.dst->GetSymbol().get();
+			dead = (usedTemporaries.count(statement.dst->GetSymbol().get()) == 0);
 		}
-		else if(CSymbol* relativeSymbol = dynamic_symbolref_cast(SYM_RELATIVE, outerStatement.dst))
+		else if(CSymbol* relativeSymbol = dynamic_symbolref_cast(SYM_RELATIVE, statement.dst))
 		{
-			VersionedSymbolRefPtr versionedSymbolRef = std::dynamic_pointer_cast<CVersionedSymbolRef>(outerStatement.dst);
+			auto versionedSymbolRef = dynamic_cast<CVersionedSymbolRef*>(statement.dst.get());
 			assert(versionedSymbolRef);
+			//Last definition of a relative is always needed
 			if(versionedSymbolRef->version != versionedStatementList.relativeVersions.GetRelativeVersion(relativeSymbol->m_valueLow))
 			{
-				candidate = relativeSymbol;
+				dead = !isRelativeUsed(relativeSymbol, versionedSymbolRef->version);
 			}
 		}
 
-		if(candidate == NULL) continue;
-		const SymbolRefPtr& symbolRef(outerStatement.dst);
-
-		//Look for any possible use of this symbol
-		bool used = false;
-		for(StatementList::iterator innerStatementIterator(outerStatementIterator);
-			versionedStatementList.statements.end() != innerStatementIterator; ++innerStatementIterator)
+		if(dead)
 		{
-			if(outerStatementIterator == innerStatementIterator) continue;
+			//Kill it!
+			tombstones[statements.rend() - statementIterator - 1] = true;
+			continue;
+		}
 
-			const auto& innerStatement(*innerStatementIterator);
-			
-			innerStatement.VisitSources(
-				[&](const SymbolRefPtr& innerSymbolRef, bool)
+		statement.VisitSources(
+			[&](const SymbolRefPtr& symbolRef, bool)
+			{
+				auto symbol = symbolRef->GetSymbol().get();
+				if(symbol->IsTemporary())
+				{
+					usedTemporaries.insert(symbol);
+				}
+				else if(symbol->m_type == SYM_RELATIVE)
 				{
-					if(innerSymbolRef->Equals(symbolRef.get()))
+					auto& use = relativeUses[symbol->m_valueLow];
+					use.relative32 = true;
+					if(auto versionedSymbolRef = dynamic_cast<CVersionedSymbolRef*>(symbolRef.get()))
 					{
-						used = true;
-						return;
+						usedRelativeVersions.insert((static_cast<uint64>(symbol->m_valueLow) << 32) | static_cast<uint32>(versionedSymbolRef->version));
 					}
-
-					auto symbol(innerSymbolRef->GetSymbol());
-					if(!symbol->Equals(candidate) && symbol->Aliases(candidate))
+					else
 					{
-						used = true;
-						return;
+						use.unversioned = true;
 					}
 				}
-			);
-			
-			if(used) break;
-		}
+				else if(symbol->IsRelative())
+				{
+					auto& use = relativeUses[symbol->m_valueLow];
+					use.otherMaxSize = std::max<uint32>(use.otherMaxSize, symbol->GetSize());
+				}
+			}
+		);
+	}
+
+	return CompactStatementList(statements, tombstones);
+}
+
+void CJitter::HoistLoopInvariants()
+{
+	//Statements are hoisted in the block coming right before the loop's header (the preheader). Temporaries
+	//hoisted this way are used by more than one block, they get a stack location of their own.
+	m_loopInvariantTemporaries.clear();
+	m_loopInvariantStackSize = 0;
 
-		if(!used)
+	if(!m_loopInvariantCodeMotionEnabled) return;
+
+	//Innermost loops go first, what's hoisted out of them can then be hoisted out of their parent loop
+	std::vector<BasicBlockList::iterator> headerIterators;
+	for(auto blockIterator(m_basicBlocks.begin());
+		blockIterator != m_basicBlocks.end(); blockIterator++)
+	{
+		if(blockIterator->loopHeader)
 		{
-			//Kill it!
-			toDelete.push_back(outerStatementIterator);
+			headerIterators.push_back(blockIterator);
 		}
 	}
+	std::stable_sort(headerIterators.begin(), headerIterators.end(),
+		[] (const BasicBlockList::iterator& header1, const BasicBlockList::iterator& header2)
+		{
+			return header1->loopDepth > header2->loopDepth;
+		}
+	);
 
-	for(ToDeleteList::const_iterator deleteIterator(toDelete.begin());
-		toDelete.end() != deleteIterator; ++deleteIterator)
+	for(const auto& headerIterator : headerIterators)
 	{
-		versionedStatementList.statements.erase(*deleteIterator);
-		changed = true;
+		if(headerIterator == m_basicBlocks.begin()) continue;
+
+		//Only the preheader falls through to the header, other references come from within the loop
+		auto& preheader = *std::prev(headerIterator);
+		if(preheader.loopDepth >= headerIterator->loopDepth) continue;
+		auto preheaderTerminator = preheader.statements.end();
+		if(!preheader.statements.empty())
+		{
+			auto op = preheader.statements.back().op;
+			if((op == OP_JMP) || (op == OP_EXTERNJMP) || (op == OP_EXTERNJMP_DYN) || (op == OP_LOOKUP)) continue;
+			if(op == OP_CONDJMP)
+			{
+				preheaderTerminator = std::prev(preheader.statements.end());
+			}
+		}
+
+		//Loop is made of the header and the blocks nested in it that follow
+		unsigned int loopDepth = headerIterator->loopDepth;
+		auto loopEndIterator = std::next(headerIterator);
+		while(
+			(loopEndIterator != m_basicBlocks.end()) &&
+			(loopEndIterator->loopDepth >= loopDepth) &&
+			!(loopEndIterator->loopHeader && (loopEndIterator->loopDepth == loopDepth))
+		)
+		{
+			loopEndIterator++;
+		}
+
+		//Find relatives that might change while the loop runs
+		bool relativesClobbered = false;
+		std::unordered_set<uint32> writtenWords;
+		auto markWritten =
+			[&writtenWords] (const SymbolRefPtr& symbolRef, bool)
+			{
+				auto symbol = symbolRef->GetSymbol();
+				if(!symbol->IsRelative()) return;
+				uint32 firstWord = symbol->m_valueLow / 4;
+				uint32 lastWord = (symbol->m_valueLow + symbol->GetSize() - 1) / 4;
+				for(uint32 word = firstWord; word <= lastWord; word++)
+				{
+					writtenWords.insert(word);
+				}
+			};
+		for(auto blockIterator = headerIterator; blockIterator != loopEndIterator; blockIterator++)
+		{
+			for(const auto& statement : blockIterator->statements)
+			{
+				if((GetValueNumberingClass(statement.op) == VALUE_NUMBERING_BARRIER) && !IsContextPureCall(statement))
+				{
+					relativesClobbered = true;
+				}
+				statement.VisitDestination(markWritten);
+				if(statement.op == OP_PARAM_RET)
+				{
+					//Callee writes the result in there
+					markWritten(statement.src1, false);
+				}
+			}
+		}
+
+		//Temporaries hoisted out of an inner loop are still defined in this loop (in the inner loop's preheader),
+		//they are only invariant here once hoisted out of this loop too
+		std::unordered_set<uint32> loopTemporaries;
+		std::unordered_set<uint32> hoistedTemporaries;
+		for(auto blockIterator = headerIterator; blockIterator != loopEndIterator; blockIterator++)
+		{
+			for(const auto& statement : blockIterator->statements)
+			{
+				if(statement.dst && statement.dst->GetSymbol()->IsTemporary())
+				{
+					loopTemporaries.insert(statement.dst->GetSymbol()->m_valueLow);
+				}
+			}
+		}
+
+		auto isInvariantSource =
+			[&] (const SymbolRefPtr& symbolRef)
+			{
+				auto symbol = symbolRef->GetSymbol();
+				if(symbol->IsConstant()) return true;
+				if(symbol->IsTemporary())
+				{
+					if(!IsLoopInvariantTemporary(symbol.get())) return false;
+					return (loopTemporaries.count(symbol->m_valueLow) == 0) || (hoistedTemporaries.count(symbol->m_valueLow) != 0);
+				}
+				if(!symbol->IsRelative() || relativesClobbered) return false;
+				uint32 firstWord = symbol->m_valueLow / 4;
+				uint32 lastWord = (symbol->m_valueLow + symbol->GetSize() - 1) / 4;
+				for(uint32 word = firstWord; word <= lastWord; word++)
+				{
+					if(writtenWords.count(word)) return false;
+				}
+				return true;
+			};
+
+		StatementList hoistedStatements;
+		for(auto blockIterator = headerIterator; blockIterator != loopEndIterator; blockIterator++)
+		{
+			auto& statements = blockIterator->statements;
+
+			SymbolUseCountMap definitionCounts;
+			for(const auto& statement : statements)
+			{
+				if(statement.dst)
+				{
+					definitionCounts[statement.dst->GetSymbol().get()]++;
+				}
+			}
+
+			StatementTombstoneList tombstones(statements.size(), false);
+			for(const auto& statementInfo : IndexedStatementList(statements))
+			{
+				auto& statement(statementInfo.statement);
+
+				//Hoisted statements also run when the loop isn't entered, divisions could fault
+				if(GetValueNumberingClass(statement.op) != VALUE_NUMBERING_PURE) continue;
+				if((statement.op == OP_DIV) || (statement.op == OP_DIVS)) continue;
+
+				if(!statement.dst) continue;
+				auto dstSymbol = statement.dst->GetSymbol().get();
+				if(
+					(dstSymbol->m_type != SYM_TEMPORARY) &&
+					(dstSymbol->m_type != SYM_TEMPORARY64) &&
+					(dstSymbol->m_type != SYM_TEMPORARY128)
+				)
+				{
+					continue;
+				}
+				if(definitionCounts[dstSymbol] != 1) continue;
+
+				bool invariant = true;
+				statement.VisitSources(
+					[&] (const SymbolRefPtr& symbolRef, bool)
+					{
+						invariant &= isInvariantSource(symbolRef);
+					}
+				);
+				if(!invariant) continue;
+
+				//Slots are 16 bytes wide to keep every temporary type aligned
+				if(!IsLoopInvariantTemporary(dstSymbol))
+				{
+					m_loopInvariantTemporaries[dstSymbol->m_valueLow] = m_loopInvariantStackSize;
+					m_loopInvariantStackSize += 16;
+				}
+				hoistedTemporaries.insert(dstSymbol->m_valueLow);
+
+				auto hoistedStatement = statement;
+				hoistedStatement.VisitOperands(
+					[&] (SymbolRefPtr& symbolRef, bool)
+					{
+						symbolRef = MakeSymbolRef(preheader.symbolTable.MakeSymbol(symbolRef->GetSymbol()));
+					}
+				);
+				hoistedStatements.push_back(std::move(hoistedStatement));
+				tombstones[statementInfo.index] = true;
+			}
+			CompactStatementList(statements, tombstones);
+		}
+
+		preheader.statements.insert(preheaderTerminator, hoistedStatements.begin(), hoistedStatements.end());
 	}
+}
 
-	return changed;
+bool CJitter::IsLoopInvariantTemporary(const CSymbol* symbol) const
+{
+	if(!symbol->IsTemporary()) return false;
+	return m_loopInvariantTemporaries.find(symbol->m_valueLow) != std::end(m_loopInvariantTemporaries);
 }
 
 void CJitter::CoalesceTemporaries(BASIC_BLOCK& basicBlock)
@@ -1351,6 +2745,9 @@ void CJitter::CoalesceTemporaries(BASIC_BLOCK& basicBlock)
 		auto tempSymbol = outerStatement.dst->GetSymbol().get();
 		CSymbol* candidate = nullptr;
 
+		//Loop invariants are used in other blocks, they can't be renamed or reused
+		if(IsLoopInvariantTemporary(tempSymbol)) continue;
+
 		//Check for a possible replacement
 		for(auto* encounteredTemp : encounteredTemps)
 		{
@@ -1443,20 +2840,19 @@ void CJitter::CoalesceTemporaries(BASIC_BLOCK& basicBlock)
 
 void CJitter::RemoveSelfAssignments(BASIC_BLOCK& basicBlock)
 {
-	for(StatementList::iterator outerStatementIterator(basicBlock.statements.begin());
-		basicBlock.statements.end() != outerStatementIterator; )
-	{
-		STATEMENT& outerStatement(*outerStatementIterator);
+	auto& statements = basicBlock.statements;
+	StatementTombstoneList tombstones(statements.size(), false);
 
-		if(outerStatement.op == OP_MOV && outerStatement.dst->Equals(outerStatement.src1.get()))
-		{
-			outerStatementIterator = basicBlock.statements.erase(outerStatementIterator);
-		}
-		else
+	for(const auto& statementInfo : ConstIndexedStatementList(statements))
+	{
+		const auto& statement(statementInfo.statement);
+		if(statement.op == OP_MOV && statement.dst->Equals(statement.src1.get()))
 		{
-			++outerStatementIterator;
+			tombstones[statementInfo.index] = true;
 		}
 	}
+
+	CompactStatementList(statements, tombstones);
 }
 
 void CJitter::PruneSymbols(BASIC_BLOCK& basicBlock) const
@@ -1492,10 +2888,16 @@ void CJitter::PruneSymbols(BASIC_BLOCK& basicBlock) const
 
 unsigned int CJitter::AllocateStack(BASIC_BLOCK& basicBlock)
 {
-	unsigned int stackAlloc = 0;
+	//Loop invariants have the same location in all blocks, other temporaries come after them
+	unsigned int stackAlloc = m_loopInvariantStackSize;
 	for(const auto& symbol : basicBlock.symbolTable.GetSymbols())
 	{
-		if(symbol->m_type == SYM_TEMPORARY || symbol->m_type == SYM_FP_TMP_SINGLE)
+		auto loopInvariantIterator = symbol->IsTemporary() ? m_loopInvariantTemporaries.find(symbol->m_valueLow) : std::end(m_loopInvariantTemporaries);
+		if(loopInvariantIterator != std::end(m_loopInvariantTemporaries))
+		{
+			symbol->m_stackLocation = loopInvariantIterator->second;
+		}
+		else if(symbol->m_type == SYM_TEMPORARY || symbol->m_type == SYM_FP_TMP_SINGLE)
 		{
 			symbol->m_stackLocation = stackAlloc;
 			stackAlloc += 4;
@@ -1647,12 +3049,27 @@ void CJitter::NormalizeStatements(BASIC_BLOCK& basicBlock)
 			case CONDITION_BL:
 				statement.jmpCondition = CONDITION_AB;
 				break;
+			case CONDITION_BE:
+				statement.jmpCondition = CONDITION_AE;
+				break;
+			case CONDITION_AB:
+				statement.jmpCondition = CONDITION_BL;
+				break;
+			case CONDITION_AE:
+				statement.jmpCondition = CONDITION_BE;
+				break;
 			case CONDITION_LT:
 				statement.jmpCondition = CONDITION_GT;
 				break;
+			case CONDITION_LE:
+				statement.jmpCondition = CONDITION_GE;
+				break;
 			case CONDITION_GT:
 				statement.jmpCondition = CONDITION_LT;
 				break;
+			case CONDITION_GE:
+				statement.jmpCondition = CONDITION_LE;
+				break;
 			default:
 				assert(0);
 				break;
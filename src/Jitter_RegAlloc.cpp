@@ -1,6 +1,8 @@
 #include "Jitter.h"
 #include <iostream>
 #include <set>
+#include <unordered_set>
+#include <algorithm>
 
 #ifdef _DEBUG
 //#define DUMP_STATEMENTS
@@ -30,6 +32,7 @@ void CJitter::AllocateRegisters(BASIC_BLOCK& basicBlock)
 		ComputeLivenessForRange(basicBlock, allocRange, symbolRegAllocs);
 
 		MarkAliasedSymbols(basicBlock, allocRange, symbolRegAllocs);
+		MarkCallSpanningSymbols(basicBlock, allocRange, symbolRegAllocs);
 
 		AssociateSymbolsToRegisters(symbolRegAllocs);
 
@@ -76,22 +79,22 @@ void CJitter::AllocateRegisters(BASIC_BLOCK& basicBlock)
 			{
 				STATEMENT statement;
 				statement.op	= OP_MOV;
-				statement.dst	= std::make_shared<CSymbolRef>(
+				statement.dst	= MakeSymbolRef(
 					symbolTable.MakeSymbol(symbolRegAlloc.registerType, symbolRegAlloc.registerId));
-				statement.src1	= std::make_shared<CSymbolRef>(symbol);
+				statement.src1	= MakeSymbolRef(symbol);
 
 				loadStatements.insert(std::make_pair(allocRange.first, statement));
 			}
 
 			//If symbol is defined, we need to save it at the end
-			//Exception: Temporaries that are not used after the allocation range
-			bool deadTemporary = symbol->IsTemporary() && (symbolRegAlloc.lastUse <= allocRange.second);
+			//Exception: Temporaries that are not used after the allocation range (loop invariants are used by other blocks)
+			bool deadTemporary = symbol->IsTemporary() && !IsLoopInvariantTemporary(symbol.get()) && (symbolRegAlloc.lastUse <= allocRange.second);
 			if(!deadTemporary && (symbolRegAlloc.firstDef != -1))
 			{
 				STATEMENT statement;
 				statement.op	= OP_MOV;
-				statement.dst	= std::make_shared<CSymbolRef>(symbol);
-				statement.src1	= std::make_shared<CSymbolRef>(
+				statement.dst	= MakeSymbolRef(symbol);
+				statement.src1	= MakeSymbolRef(
 					symbolTable.MakeSymbol(symbolRegAlloc.registerType, symbolRegAlloc.registerId));
 
 				spillStatements.insert(std::make_pair(allocRange.second, statement));
@@ -104,66 +107,50 @@ void CJitter::AllocateRegisters(BASIC_BLOCK& basicBlock)
 	std::cout << std::endl;
 #endif
 
-	std::map<unsigned int, StatementList::const_iterator> loadPoints;
-	std::map<unsigned int, StatementList::const_iterator> spillPoints;
-
-	//Load
-	for(const auto& statementInfo : ConstIndexedStatementList(basicBlock.statements))
+	//Rebuild statement list with loads and spills inserted
+	StatementList statements;
+	statements.reserve(basicBlock.statements.size() + loadStatements.size() + spillStatements.size());
+	for(const auto& statementInfo : IndexedStatementList(basicBlock.statements))
 	{
+		auto& statement = statementInfo.statement;
 		const auto& statementIdx(statementInfo.index);
-		if(loadStatements.find(statementIdx) != std::end(loadStatements))
+
+		//Loads
+		auto loadRange = loadStatements.equal_range(statementIdx);
+		for(auto loadIterator = loadRange.first; loadIterator != loadRange.second; loadIterator++)
 		{
-			loadPoints.insert(std::make_pair(statementIdx, statementInfo.iterator));
+			statements.push_back(loadIterator->second);
 		}
-	}
 
-	//Spill
-	for(const auto& statementInfo : ConstIndexedStatementList(basicBlock.statements))
-	{
-		const auto& statementIdx(statementInfo.index);
-		if(spillStatements.find(statementIdx) != std::end(spillStatements))
+		//Spills (after statement, unless it leaves the block or calls a function)
+		bool spillAfter =
+			(statement.op != OP_CONDJMP) &&
+			(statement.op != OP_JMP) &&
+			(statement.op != OP_CALL) &&
+			(statement.op != OP_EXTERNJMP) &&
+			(statement.op != OP_EXTERNJMP_DYN) &&
+			(statement.op != OP_LOOKUP);
+
+		auto spillRange = spillStatements.equal_range(statementIdx);
+		if(!spillAfter)
 		{
-			const auto& statement = statementInfo.statement;
-			auto statementIterator = statementInfo.iterator;
-			if(
-				(statement.op != OP_CONDJMP) &&
-				(statement.op != OP_JMP) &&
-				(statement.op != OP_CALL) &&
-				(statement.op != OP_EXTERNJMP) &&
-				(statement.op != OP_EXTERNJMP_DYN)
-				)
+			for(auto spillIterator = spillRange.first; spillIterator != spillRange.second; spillIterator++)
 			{
-				statementIterator++;
+				statements.push_back(spillIterator->second);
 			}
-			spillPoints.insert(std::make_pair(statementIdx, statementIterator));
 		}
-	}
 
-	//Loads
-	for(const auto& loadPoint : loadPoints)
-	{
-		unsigned int statementIndex = loadPoint.first;
-		for(auto statementIterator = loadStatements.lower_bound(statementIndex);
-			statementIterator != loadStatements.upper_bound(statementIndex);
-			statementIterator++)
-		{
-			const auto& statement(statementIterator->second);
-			basicBlock.statements.insert(loadPoint.second, statement);
-		}
-	}
+		statements.push_back(std::move(statement));
 
-	//Spills
-	for(const auto& spillPoint : spillPoints)
-	{
-		unsigned int statementIndex = spillPoint.first;
-		for(auto statementIterator = spillStatements.lower_bound(statementIndex);
-			statementIterator != spillStatements.upper_bound(statementIndex);
-			statementIterator++)
+		if(spillAfter)
 		{
-			const auto& statement(statementIterator->second);
-			basicBlock.statements.insert(spillPoint.second, statement);
+			for(auto spillIterator = spillRange.first; spillIterator != spillRange.second; spillIterator++)
+			{
+				statements.push_back(spillIterator->second);
+			}
 		}
 	}
+	basicBlock.statements = std::move(statements);
 
 #ifdef DUMP_STATEMENTS
 	DumpStatementList(basicBlock.statements);
@@ -173,11 +160,22 @@ void CJitter::AllocateRegisters(BASIC_BLOCK& basicBlock)
 
 void CJitter::AssociateSymbolsToRegisters(SymbolRegAllocInfo& symbolRegAllocs) const
 {
+	auto isGlobalRegister =
+		[this] (SYM_TYPE registerType, unsigned int registerId)
+		{
+			for(const auto& globalRegister : m_globalRegisters)
+			{
+				if((globalRegister.registerType == registerType) && (globalRegister.registerId == registerId)) return true;
+			}
+			return false;
+		};
+
 	std::multimap<SYM_TYPE, unsigned int> availableRegisters;
 	{
 		unsigned int regCount = m_codeGen->GetAvailableRegisterCount();
 		for(unsigned int i = 0; i < regCount; i++)
 		{
+			if(isGlobalRegister(SYM_REGISTER, i)) continue;
 			availableRegisters.insert(std::make_pair(SYM_REGISTER, i));
 		}
 	}
@@ -186,17 +184,23 @@ void CJitter::AssociateSymbolsToRegisters(SymbolRegAllocInfo& symbolRegAllocs) c
 		unsigned int regCount = m_codeGen->GetAvailableMdRegisterCount();
 		for(unsigned int i = 0; i < regCount; i++)
 		{
+			if(isGlobalRegister(SYM_REGISTER128, i)) continue;
 			availableRegisters.insert(std::make_pair(SYM_REGISTER128, i));
 		}
 	}
 
+	uint32 preservedRegisterMask = m_codeGen->GetCallPreservedRegisterMask();
+	uint32 preservedMdRegisterMask = m_codeGen->GetCallPreservedMdRegisterMask();
+	bool fpSingleAllocatable = m_fpRegAllocEnabled && m_codeGen->CanHoldFpSingleInMdRegisters();
+
 	auto isRegisterAllocatable =
-		[] (SYM_TYPE symbolType)
+		[fpSingleAllocatable] (SYM_TYPE symbolType)
 		{
 			return 
 				(symbolType == SYM_RELATIVE) || (symbolType == SYM_TEMPORARY) ||
 				(symbolType == SYM_REL_REFERENCE) || (symbolType == SYM_TMP_REFERENCE) ||
-				(symbolType == SYM_RELATIVE128) || (symbolType == SYM_TEMPORARY128);
+				(symbolType == SYM_RELATIVE128) || (symbolType == SYM_TEMPORARY128) ||
+				(fpSingleAllocatable && ((symbolType == SYM_FP_REL_SINGLE) || (symbolType == SYM_FP_TMP_SINGLE)));
 		};
 
 	//Sort symbols by usage count
@@ -263,6 +267,23 @@ void CJitter::AssociateSymbolsToRegisters(SymbolRegAllocInfo& symbolRegAllocs) c
 			registerIteratorEnd = availableRegisters.upper_bound(SYM_REGISTER128);
 			registerSymbolType = SYM_REGISTER128;
 		}
+		else if((symbol->m_type == SYM_FP_REL_SINGLE) || (symbol->m_type == SYM_FP_TMP_SINGLE))
+		{
+			//Scalar floats live in the lower lane of MD registers
+			registerIterator = availableRegisters.lower_bound(SYM_REGISTER128);
+			registerIteratorEnd = availableRegisters.upper_bound(SYM_REGISTER128);
+			registerSymbolType = SYM_FP_REG_SINGLE;
+		}
+		if(symbolRegAlloc.spansCall)
+		{
+			//Value needs to survive a call to a context pure function, only use a register preserved by the callee
+			bool mdRegister = (registerSymbolType == SYM_REGISTER128) || (registerSymbolType == SYM_FP_REG_SINGLE);
+			uint32 preservedMask = mdRegister ? preservedMdRegisterMask : preservedRegisterMask;
+			while((registerIterator != registerIteratorEnd) && !(preservedMask & (1 << registerIterator->second)))
+			{
+				registerIterator++;
+			}
+		}
 		if(registerIterator != registerIteratorEnd)
 		{
 			symbolRegAlloc.registerType = registerSymbolType;
@@ -280,9 +301,15 @@ CJitter::AllocationRangeArray CJitter::ComputeAllocationRanges(const BASIC_BLOCK
 	{
 		const auto& statement(statementInfo.statement);
 		const auto& statementIdx(statementInfo.index);
-		if(statement.op == OP_CALL)
+		if((statement.op == OP_CALL) && !IsContextPureCall(statement))
 		{
-			//Gotta split here
+			//Gotta split here, callee might access values we have in registers
+			result.push_back(std::make_pair(currentStart, statementIdx));
+			currentStart = statementIdx + 1;
+		}
+		else if(statement.op == OP_LOOKUP)
+		{
+			//Leaves the block on a hit, memory needs to be up to date before the lookup
 			result.push_back(std::make_pair(currentStart, statementIdx));
 			currentStart = statementIdx + 1;
 		}
@@ -368,3 +395,507 @@ void CJitter::MarkAliasedSymbols(const BASIC_BLOCK& basicBlock, const Allocation
 		}
 	}
 }
+
+void CJitter::MarkCallSpanningSymbols(const BASIC_BLOCK& basicBlock, const AllocationRange& allocRange, SymbolRegAllocInfo& symbolRegAllocs) const
+{
+	//Calls to context pure functions don't end allocation ranges, find symbols that need to hold their value across them
+	std::vector<unsigned int> callIndices;
+	for(const auto& statementInfo : ConstIndexedStatementList(basicBlock.statements))
+	{
+		const auto& statementIdx(statementInfo.index);
+		if(statementIdx < allocRange.first) continue;
+		if(statementIdx >= allocRange.second) break;
+		if(IsContextPureCall(statementInfo.statement))
+		{
+			callIndices.push_back(statementIdx);
+		}
+	}
+	if(callIndices.empty()) return;
+
+	for(auto& symbolRegAllocPair : symbolRegAllocs)
+	{
+		const auto& symbol = symbolRegAllocPair.first;
+		auto& symbolRegAlloc = symbolRegAllocPair.second;
+		unsigned int firstAccess = std::min(symbolRegAlloc.firstUse, symbolRegAlloc.firstDef);
+		//Relatives are loaded at the start of the range when read before being written
+		if(symbol->IsRelative() && (symbolRegAlloc.firstUse != -1) && (symbolRegAlloc.firstUse <= symbolRegAlloc.firstDef))
+		{
+			firstAccess = allocRange.first;
+		}
+		//Spilled symbols need to keep their value until the end of the range
+		unsigned int lastAccess = allocRange.second;
+		bool spilled = (symbolRegAlloc.firstDef != -1) &&
+			(!symbol->IsTemporary() || IsLoopInvariantTemporary(symbol.get()) || (symbolRegAlloc.lastUse == -1));
+		if(!spilled)
+		{
+			lastAccess = symbolRegAlloc.lastUse;
+			if(symbolRegAlloc.lastDef != -1)
+			{
+				lastAccess = std::max(lastAccess, symbolRegAlloc.lastDef);
+			}
+		}
+		for(auto callIdx : callIndices)
+		{
+			if((firstAccess < callIdx) && (lastAccess > callIdx))
+			{
+				symbolRegAlloc.spansCall = true;
+				break;
+			}
+		}
+	}
+}
+
+static bool IsGlobalRegisterSpillPoint(OPERATION op)
+{
+	//Memory needs to be up to date when calling a function or leaving the block through an external jump
+	//(OP_LOOKUP is always followed by the OP_EXTERNJMP of its miss path, registers aren't needed after it)
+	return (op == OP_CALL) || (op == OP_EXTERNJMP) || (op == OP_EXTERNJMP_DYN) || (op == OP_LOOKUP);
+}
+
+void CJitter::AllocateGlobalRegisters()
+{
+	m_globalRegisters.clear();
+
+	if(!m_globalRegAllocEnabled) return;
+	if(m_basicBlocks.size() < 2) return;
+
+	m_globalRegisters = SelectGlobalRegisters();
+	if(m_globalRegisters.empty()) return;
+
+	std::unordered_map<SymbolPtr, unsigned int, SymbolHasher, SymbolComparator> globalRegisterIndices;
+	for(unsigned int i = 0; i < m_globalRegisters.size(); i++)
+	{
+		globalRegisterIndices.insert(std::make_pair(m_globalRegisters[i].symbol, i));
+	}
+
+	//Replace all references to global symbols by references to their register, loads and spills are added after local allocation
+	for(auto& basicBlock : m_basicBlocks)
+	{
+		auto& symbolTable = basicBlock.symbolTable;
+		for(auto& statement : basicBlock.statements)
+		{
+			statement.VisitOperands(
+				[&] (SymbolRefPtr& symbolRef, bool)
+				{
+					auto globalRegisterIterator = globalRegisterIndices.find(symbolRef->GetSymbol());
+					if(globalRegisterIterator == std::end(globalRegisterIndices)) return;
+					const auto& globalRegister = m_globalRegisters[globalRegisterIterator->second];
+					symbolRef = MakeSymbolRef(
+						symbolTable.MakeSymbol(globalRegister.registerType, globalRegister.registerId));
+				}
+			);
+		}
+	}
+}
+
+CJitter::GlobalRegisterArray CJitter::SelectGlobalRegisters() const
+{
+	GlobalRegisterCandidateMap candidates;
+	std::unordered_set<SymbolPtr, SymbolHasher, SymbolComparator> relativeSymbols;
+
+	unsigned int blockIndex = 0;
+	for(const auto& basicBlock : m_basicBlocks)
+	{
+		//Uses inside loops are likely to run many times
+		unsigned int useWeight = 1 << (3 * std::min<unsigned int>(basicBlock.loopDepth, 3));
+		if(IsProfiledBlock(basicBlock.id))
+		{
+			//Profile knows better, uses in blocks that never ran don't count
+			useWeight = 0;
+			for(uint32 count = m_profile[basicBlock.id]; count != 0; count >>= 1)
+			{
+				useWeight++;
+			}
+		}
+		for(const auto& statement : basicBlock.statements)
+		{
+			statement.VisitOperands(
+				[&] (const SymbolRefPtr& symbolRef, bool)
+				{
+					auto symbol = symbolRef->GetSymbol();
+					if(!symbol->IsRelative()) return;
+					relativeSymbols.insert(symbol);
+					if((symbol->m_type != SYM_RELATIVE) && (symbol->m_type != SYM_RELATIVE128)) return;
+					auto& candidate = candidates[symbol];
+					candidate.useCount += useWeight;
+					candidate.usedInLoop |= (basicBlock.loopDepth != 0);
+					if(candidate.lastBlockIndex != blockIndex)
+					{
+						candidate.lastBlockIndex = blockIndex;
+						candidate.blockCount++;
+					}
+				}
+			);
+			if(statement.op == OP_PARAM_RET)
+			{
+				//This symbol will end up being written to by the callee, thus will be aliased
+				auto candidateIterator = candidates.find(statement.src1->GetSymbol());
+				if(candidateIterator != std::end(candidates))
+				{
+					candidateIterator->second.aliased = true;
+				}
+			}
+		}
+		blockIndex++;
+	}
+
+	typedef GlobalRegisterCandidateMap::value_type CandidatePair;
+	std::vector<const CandidatePair*> sortedCandidates;
+	for(auto& candidatePair : candidates)
+	{
+		const auto& symbol = candidatePair.first;
+		auto& candidate = candidatePair.second;
+		//Symbols used in a single block are better served by the local allocator, unless
+		//that block is in a loop: the local allocator loads and spills them on every iteration
+		if((candidate.blockCount < 2) && !candidate.usedInLoop) continue;
+		if(candidate.useCount == 0) continue;
+		for(const auto& relativeSymbol : relativeSymbols)
+		{
+			if(relativeSymbol->Equals(symbol.get())) continue;
+			if(relativeSymbol->Aliases(symbol.get()))
+			{
+				candidate.aliased = true;
+				break;
+			}
+		}
+		if(candidate.aliased) continue;
+		sortedCandidates.push_back(&candidatePair);
+	}
+	std::sort(sortedCandidates.begin(), sortedCandidates.end(),
+		[] (const CandidatePair* candidatePair1, const CandidatePair* candidatePair2)
+		{
+			const auto& symbol1(candidatePair1->first);
+			const auto& symbol2(candidatePair2->first);
+			if(candidatePair1->second.useCount != candidatePair2->second.useCount)
+			{
+				return candidatePair1->second.useCount > candidatePair2->second.useCount;
+			}
+			if(symbol1->m_type != symbol2->m_type)
+			{
+				return symbol1->m_type < symbol2->m_type;
+			}
+			return symbol1->m_valueLow < symbol2->m_valueLow;
+		}
+	);
+
+	//Keep at least half of the registers for local allocation
+	unsigned int regCount = m_codeGen->GetAvailableRegisterCount();
+	unsigned int mdRegCount = m_codeGen->GetAvailableMdRegisterCount();
+	unsigned int regAvailable = regCount / 2;
+	unsigned int mdRegAvailable = mdRegCount / 2;
+
+	GlobalRegisterArray result;
+	for(const auto& candidatePair : sortedCandidates)
+	{
+		const auto& symbol = candidatePair->first;
+		GLOBAL_REGISTER globalRegister;
+		globalRegister.symbol = symbol;
+		if((symbol->m_type == SYM_RELATIVE) && (regAvailable != 0))
+		{
+			regAvailable--;
+			globalRegister.registerType = SYM_REGISTER;
+			globalRegister.registerId = regCount - (regCount / 2) + regAvailable;
+		}
+		else if((symbol->m_type == SYM_RELATIVE128) && (mdRegAvailable != 0))
+		{
+			mdRegAvailable--;
+			globalRegister.registerType = SYM_REGISTER128;
+			globalRegister.registerId = mdRegCount - (mdRegCount / 2) + mdRegAvailable;
+		}
+		else
+		{
+			continue;
+		}
+		result.push_back(globalRegister);
+		assert(result.size() <= (sizeof(GlobalRegisterMask) * 8));
+	}
+	return result;
+}
+
+void CJitter::InsertGlobalRegisterLoadsAndSpills()
+{
+	assert(!m_globalRegisters.empty());
+
+	std::vector<BASIC_BLOCK*> blocks;
+	blocks.reserve(m_basicBlocks.size());
+	for(auto& basicBlock : m_basicBlocks)
+	{
+		blocks.push_back(&basicBlock);
+	}
+
+	auto flows = ComputeGlobalRegisterFlow(blocks);
+
+	for(unsigned int blockIndex = 0; blockIndex < blocks.size(); blockIndex++)
+	{
+		auto& basicBlock = *blocks[blockIndex];
+		const auto& flow = flows[blockIndex];
+
+		StatementList statements;
+		statements.reserve(basicBlock.statements.size() + (m_globalRegisters.size() * 2));
+
+		for(const auto& statementInfo : IndexedStatementList(basicBlock.statements))
+		{
+			auto& statement = statementInfo.statement;
+			const auto& statementIdx(statementInfo.index);
+
+			GlobalRegisterMask spillMask = flow.spillMasks[statementIdx];
+			for(unsigned int i = 0; i < m_globalRegisters.size(); i++)
+			{
+				if(spillMask & (1 << i)) statements.push_back(MakeGlobalRegisterSpill(basicBlock, i));
+			}
+
+			statements.push_back(std::move(statement));
+
+			GlobalRegisterMask reloadMask = flow.reloadMasks[statementIdx];
+			for(unsigned int i = 0; i < m_globalRegisters.size(); i++)
+			{
+				if(reloadMask & (1 << i)) statements.push_back(MakeGlobalRegisterLoad(basicBlock, i));
+			}
+		}
+
+		//Leaving the function by falling off the last block
+		if(flow.exitsAtEnd)
+		{
+			for(unsigned int i = 0; i < m_globalRegisters.size(); i++)
+			{
+				if(flow.dirtyOut & (1 << i)) statements.push_back(MakeGlobalRegisterSpill(basicBlock, i));
+			}
+		}
+
+		basicBlock.statements = std::move(statements);
+	}
+
+	//Load registers on function entry
+	GlobalRegisterMask entryLoadMask = flows[0].liveIn;
+	if(entryLoadMask != 0)
+	{
+		//If something jumps back to the first block, loads need to go in a block of their own
+		auto entryBlockIterator = m_basicBlocks.begin();
+		if(!flows[0].predecessors.empty())
+		{
+			entryBlockIterator = m_basicBlocks.emplace(m_basicBlocks.begin(), GetSymbolArena());
+			entryBlockIterator->id = m_nextBlockId++;
+			entryBlockIterator->optimized = true;
+		}
+		auto& entryBlock = *entryBlockIterator;
+
+		StatementList loadStatements;
+		for(unsigned int i = 0; i < m_globalRegisters.size(); i++)
+		{
+			if(entryLoadMask & (1 << i)) loadStatements.push_back(MakeGlobalRegisterLoad(entryBlock, i));
+		}
+		entryBlock.statements.insert(entryBlock.statements.begin(), loadStatements.begin(), loadStatements.end());
+	}
+}
+
+CJitter::GlobalRegisterFlowArray CJitter::ComputeGlobalRegisterFlow(const std::vector<BASIC_BLOCK*>& blocks) const
+{
+	GlobalRegisterFlowArray flows(blocks.size());
+
+	std::unordered_map<uint32, unsigned int> blockIndices;
+	for(unsigned int blockIndex = 0; blockIndex < blocks.size(); blockIndex++)
+	{
+		blockIndices[blocks[blockIndex]->id] = blockIndex;
+	}
+
+	//Build control flow graph
+	for(unsigned int blockIndex = 0; blockIndex < blocks.size(); blockIndex++)
+	{
+		const auto& statements = blocks[blockIndex]->statements;
+		auto& flow = flows[blockIndex];
+		flow.spillMasks.resize(statements.size(), 0);
+		flow.reloadMasks.resize(statements.size(), 0);
+
+		bool fallsThrough = true;
+		if(!statements.empty())
+		{
+			const auto& statement = statements.back();
+			if((statement.op == OP_JMP) || (statement.op == OP_CONDJMP))
+			{
+				auto blockIndexIterator = blockIndices.find(statement.jmpBlock);
+				assert(blockIndexIterator != std::end(blockIndices));
+				flow.successors.push_back(blockIndexIterator->second);
+			}
+			fallsThrough = 
+				(statement.op != OP_JMP) &&
+				(statement.op != OP_EXTERNJMP) &&
+				(statement.op != OP_EXTERNJMP_DYN);
+		}
+		if(fallsThrough)
+		{
+			if((blockIndex + 1) != blocks.size())
+			{
+				flow.successors.push_back(blockIndex + 1);
+			}
+			else
+			{
+				flow.exitsAtEnd = true;
+			}
+		}
+	}
+
+	for(unsigned int blockIndex = 0; blockIndex < blocks.size(); blockIndex++)
+	{
+		for(auto successor : flows[blockIndex].successors)
+		{
+			flows[successor].predecessors.push_back(blockIndex);
+		}
+	}
+
+	//Registers that need to be written back to memory at a spill point, context pure calls only need to
+	//spill registers the callee won't preserve
+	GlobalRegisterMask callClobberMask = GetGlobalRegisterCallClobberMask();
+	auto getSpillPointMask =
+		[&] (const STATEMENT& statement) -> GlobalRegisterMask
+		{
+			return IsContextPureCall(statement) ? callClobberMask : ~0;
+		};
+
+	//Forward pass: find registers that might hold a value more recent than the one in memory
+	bool changed = true;
+	while(changed)
+	{
+		changed = false;
+		for(unsigned int blockIndex = 0; blockIndex < blocks.size(); blockIndex++)
+		{
+			auto& flow = flows[blockIndex];
+			GlobalRegisterMask dirty = 0;
+			for(auto predecessor : flow.predecessors)
+			{
+				dirty |= flows[predecessor].dirtyOut;
+			}
+			flow.dirtyIn = dirty;
+			for(const auto& statementInfo : ConstIndexedStatementList(blocks[blockIndex]->statements))
+			{
+				const auto& statement(statementInfo.statement);
+				if(IsGlobalRegisterSpillPoint(statement.op))
+				{
+					auto spillPointMask = getSpillPointMask(statement);
+					flow.spillMasks[statementInfo.index] = dirty & spillPointMask;
+					dirty &= ~spillPointMask;
+				}
+				else
+				{
+					statement.VisitDestination(
+						[&] (const SymbolRefPtr& symbolRef, bool)
+						{
+							dirty |= GetGlobalRegisterMask(symbolRef);
+						}
+					);
+				}
+			}
+			if(dirty != flow.dirtyOut)
+			{
+				flow.dirtyOut = dirty;
+				changed = true;
+			}
+		}
+	}
+
+	//Backward pass: find registers that must hold a valid value, spills count as uses.
+	//After a call, live registers are reloaded since the callee might have changed memory.
+	changed = true;
+	while(changed)
+	{
+		changed = false;
+		for(unsigned int blockIndex = blocks.size(); blockIndex-- != 0;)
+		{
+			auto& flow = flows[blockIndex];
+			GlobalRegisterMask live = flow.exitsAtEnd ? flow.dirtyOut : 0;
+			for(auto successor : flow.successors)
+			{
+				live |= flows[successor].liveIn;
+			}
+			flow.liveOut = live;
+			const auto& statements = blocks[blockIndex]->statements;
+			for(unsigned int statementIdx = statements.size(); statementIdx-- != 0;)
+			{
+				const auto& statement = statements[statementIdx];
+				if(IsGlobalRegisterSpillPoint(statement.op))
+				{
+					auto spillPointMask = getSpillPointMask(statement);
+					flow.reloadMasks[statementIdx] = (statement.op == OP_CALL) ? (live & spillPointMask) : 0;
+					live = (live & ~spillPointMask) | flow.spillMasks[statementIdx];
+				}
+				else
+				{
+					statement.VisitDestination(
+						[&] (const SymbolRefPtr& symbolRef, bool)
+						{
+							live &= ~GetGlobalRegisterMask(symbolRef);
+						}
+					);
+				}
+				statement.VisitSources(
+					[&] (const SymbolRefPtr& symbolRef, bool)
+					{
+						live |= GetGlobalRegisterMask(symbolRef);
+					}
+				);
+			}
+			if(live != flow.liveIn)
+			{
+				flow.liveIn = live;
+				changed = true;
+			}
+		}
+	}
+
+	return flows;
+}
+
+CJitter::GlobalRegisterMask CJitter::GetGlobalRegisterMask(const SymbolRefPtr& symbolRef) const
+{
+	auto symbol = symbolRef->GetSymbol();
+	if((symbol->m_type != SYM_REGISTER) && (symbol->m_type != SYM_REGISTER128)) return 0;
+	for(unsigned int i = 0; i < m_globalRegisters.size(); i++)
+	{
+		const auto& globalRegister = m_globalRegisters[i];
+		if((globalRegister.registerType == symbol->m_type) && (globalRegister.registerId == symbol->m_valueLow))
+		{
+			return (1 << i);
+		}
+	}
+	return 0;
+}
+
+CJitter::GlobalRegisterMask CJitter::GetGlobalRegisterCallClobberMask() const
+{
+	uint32 preservedRegisterMask = m_codeGen->GetCallPreservedRegisterMask();
+	uint32 preservedMdRegisterMask = m_codeGen->GetCallPreservedMdRegisterMask();
+	GlobalRegisterMask result = 0;
+	for(unsigned int i = 0; i < m_globalRegisters.size(); i++)
+	{
+		const auto& globalRegister = m_globalRegisters[i];
+		uint32 preservedMask = (globalRegister.registerType == SYM_REGISTER128) ? preservedMdRegisterMask : preservedRegisterMask;
+		if(!(preservedMask & (1 << globalRegister.registerId)))
+		{
+			result |= (1 << i);
+		}
+	}
+	return result;
+}
+
+STATEMENT CJitter::MakeGlobalRegisterLoad(BASIC_BLOCK& basicBlock, unsigned int index)
+{
+	const auto& globalRegister = m_globalRegisters[index];
+	auto& symbolTable = basicBlock.symbolTable;
+
+	STATEMENT statement;
+	statement.op	= OP_MOV;
+	statement.dst	= MakeSymbolRef(symbolTable.MakeSymbol(globalRegister.registerType, globalRegister.registerId));
+	statement.src1	= MakeSymbolRef(symbolTable.MakeSymbol(globalRegister.symbol));
+	return statement;
+}
+
+STATEMENT CJitter::MakeGlobalRegisterSpill(BASIC_BLOCK& basicBlock, unsigned int index)
+{
+	const auto& globalRegister = m_globalRegisters[index];
+	auto& symbolTable = basicBlock.symbolTable;
+
+	STATEMENT statement;
+	statement.op	= OP_MOV;
+	statement.dst	= MakeSymbolRef(symbolTable.MakeSymbol(globalRegister.symbol));
+	statement.src1	= MakeSymbolRef(symbolTable.MakeSymbol(globalRegister.registerType, globalRegister.registerId));
+	return statement;
+}
@@ -1,3 +1,4 @@
+#include <assert.h>
 #include <iostream>
 #include "Jitter_Statement.h"
 
@@ -34,6 +35,24 @@ std::string Jitter::ConditionToString(CONDITION condition)
 	}
 }
 
+bool Jitter::CompactStatementList(StatementList& statements, const StatementTombstoneList& tombstones)
+{
+	assert(statements.size() == tombstones.size());
+	size_t dstIndex = 0;
+	for(size_t srcIndex = 0; srcIndex < statements.size(); srcIndex++)
+	{
+		if(tombstones[srcIndex]) continue;
+		if(dstIndex != srcIndex)
+		{
+			statements[dstIndex] = std::move(statements[srcIndex]);
+		}
+		dstIndex++;
+	}
+	bool changed = (dstIndex != statements.size());
+	statements.erase(statements.begin() + dstIndex, statements.end());
+	return changed;
+}
+
 void Jitter::DumpStatementList(const StatementList& statements)
 {
 	DumpStatementList(std::cout, statements);
@@ -150,6 +169,12 @@ void Jitter::DumpStatementList(std::ostream& outputStream, const StatementList&
 		case OP_EXTERNJMP_DYN:
 			outputStream << " EXTJMP_DYN ";
 			break;
+		case OP_LOOKUP:
+			outputStream << " LOOKUP ";
+			break;
+		case OP_INCCOUNTER:
+			outputStream << " INCCOUNTER ";
+			break;
 		case OP_LABEL:
 			outputStream << "LABEL_" << statement.jmpBlock << ":";
 			break;
@@ -3,7 +3,9 @@
 
 using namespace Jitter;
 
-CSymbolTable::CSymbolTable()
+CSymbolTable::CSymbolTable(CArena* arena)
+: m_arena(arena)
+, m_symbols(0, SymbolHasher(), SymbolComparator(), CArenaAllocator<SymbolPtr>(arena))
 {
 
 }
@@ -18,6 +20,11 @@ CSymbolTable::SymbolSet& CSymbolTable::GetSymbols()
 	return m_symbols;
 }
 
+const CSymbolTable::SymbolSet& CSymbolTable::GetSymbols() const
+{
+	return m_symbols;
+}
+
 CSymbolTable::SymbolIterator CSymbolTable::RemoveSymbol(const SymbolIterator& symbolIterator)
 {
 	return m_symbols.erase(symbolIterator);
@@ -30,7 +37,7 @@ SymbolPtr CSymbolTable::MakeSymbol(const SymbolPtr& srcSymbol)
 	{
 		return *symbolIterator;
 	}
-	auto result = std::make_shared<CSymbol>(*srcSymbol);
+	auto result = std::allocate_shared<CSymbol>(CArenaAllocator<CSymbol>(m_arena), *srcSymbol);
 	m_symbols.insert(result);
 	return result;
 }
@@ -38,5 +45,5 @@ SymbolPtr CSymbolTable::MakeSymbol(const SymbolPtr& srcSymbol)
 SymbolPtr CSymbolTable::MakeSymbol(SYM_TYPE type, uint32 valueLow, uint32 valueHigh)
 {
 	CSymbol symbol(type, valueLow, valueHigh);
-	return MakeSymbol(SymbolPtr(&symbol, SymbolNullDeleter()));
+	return MakeSymbol(SymbolPtr(&symbol, SymbolNullDeleter(), CArenaAllocator<CSymbol>(m_arena)));
 }
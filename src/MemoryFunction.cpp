@@ -3,49 +3,14 @@
 #include <assert.h>
 #include <algorithm>
 #include <cstdint>
+#include <stdexcept>
 #include "AlignedAlloc.h"
 #include "MemoryFunction.h"
+#include "CodeHeap.h"
+#include "MemoryFunctionDefs.h"
 
 #define BLOCK_ALIGN 0x10
 
-#ifdef _WIN32
-	#define MEMFUNC_USE_WIN32
-#endif
-
-#ifdef __APPLE__
-	#include "TargetConditionals.h"
-	#include <libkern/OSCacheControl.h>
-
-	#if TARGET_OS_OSX
-		#define MEMFUNC_USE_MMAP
-		#define MEMFUNC_MMAP_ADDITIONAL_FLAGS (MAP_JIT)
-		#if TARGET_CPU_ARM64
-			#define MEMFUNC_MMAP_REQUIRES_JIT_WRITE_PROTECT
-		#endif
-	#else
-		#define MEMFUNC_USE_MACHVM
-		#if TARGET_OS_IPHONE
-			#define MEMFUNC_MACHVM_STRICT_PROTECTION
-		#endif
-	#endif
-#endif
-
-#if defined(__ANDROID__) || defined(__linux__) || defined(__FreeBSD__)
-	#define MEMFUNC_USE_MMAP
-#endif
-
-#if defined(MEMFUNC_USE_WIN32)
-#include <windows.h>
-#elif defined(MEMFUNC_USE_MACHVM)
-#include <mach/mach_init.h>
-#include <mach/vm_map.h>
-#elif defined(MEMFUNC_USE_MMAP)
-#include <sys/mman.h>
-#include <pthread.h>
-#else
-#error "No API to use for CMemoryFunction"
-#endif
-
 CMemoryFunction::CMemoryFunction()
 : m_code(nullptr)
 , m_size(0)
@@ -99,6 +64,38 @@ CMemoryFunction::CMemoryFunction(const void* code, size_t size)
 	assert((reinterpret_cast<uintptr_t>(m_code) & (BLOCK_ALIGN - 1)) == 0);
 }
 
+CMemoryFunction::CMemoryFunction(const void* code, size_t size, CCodeHeap& heap)
+#if defined(MEMFUNC_SUPPORTS_CODE_HEAP)
+: m_code(nullptr)
+, m_size(size)
+, m_heap(&heap)
+{
+	m_code = m_heap->Allocate(size);
+#ifdef MEMFUNC_MMAP_REQUIRES_JIT_WRITE_PROTECT
+	pthread_jit_write_protect_np(false);
+#endif
+	memcpy(m_code, code, size);
+#ifdef MEMFUNC_MMAP_REQUIRES_JIT_WRITE_PROTECT
+	pthread_jit_write_protect_np(true);
+#endif
+	ClearCache();
+	assert((reinterpret_cast<uintptr_t>(m_code) & (BLOCK_ALIGN - 1)) == 0);
+}
+#else
+//Pages need to be flipped between writable and executable for each function, can't share them
+: CMemoryFunction(code, size)
+{
+
+}
+#endif
+
+CMemoryFunction::CMemoryFunction(CMemoryFunction&& rhs)
+: m_code(nullptr)
+, m_size(0)
+{
+	(*this) = std::move(rhs);
+}
+
 CMemoryFunction::~CMemoryFunction()
 {
 	Reset();
@@ -106,18 +103,21 @@ CMemoryFunction::~CMemoryFunction()
 
 void CMemoryFunction::ClearCache()
 {
-#ifdef __APPLE__
-	sys_icache_invalidate(m_code, m_size);
-#elif defined(__ANDROID__) || defined(__linux__) || defined(__FreeBSD__)
-	#if defined(__arm__) || defined(__aarch64__)
-		__clear_cache(m_code, reinterpret_cast<uint8*>(m_code) + m_size);
-	#endif
-#endif
+	if(m_heap)
+	{
+		m_heap->ClearCache(m_code, m_size);
+		return;
+	}
+	MemoryFunction_ClearCache(m_code, m_size);
 }
 
 void CMemoryFunction::Reset()
 {
-	if(m_code != nullptr)
+	if(m_heap)
+	{
+		m_heap->Free(m_code, m_size);
+	}
+	else if(m_code != nullptr)
 	{
 #if defined(MEMFUNC_USE_WIN32)
 		framework_aligned_free(m_code);
@@ -129,6 +129,7 @@ void CMemoryFunction::Reset()
 	}
 	m_code = nullptr;
 	m_size = 0;
+	m_heap = nullptr;
 }
 
 bool CMemoryFunction::IsEmpty() const
@@ -141,6 +142,7 @@ CMemoryFunction& CMemoryFunction::operator =(CMemoryFunction&& rhs)
 	Reset();
 	std::swap(m_code, rhs.m_code);
 	std::swap(m_size, rhs.m_size);
+	std::swap(m_heap, rhs.m_heap);
 	return (*this);
 }
 
@@ -181,3 +183,112 @@ void CMemoryFunction::EndModify()
 #endif
 	ClearCache();
 }
+
+bool CMemoryFunction::LinkExit(uint32 offset, const void* target)
+{
+	auto site = GetExitSite(offset);
+	uint32 branch = 0;
+	bool direct = EncodeExitBranch(site, target, branch);
+	BeginModify();
+	if(direct)
+	{
+		WriteExitBranch(site, branch);
+	}
+	else
+	{
+		WriteIndirectExit(site, target);
+	}
+	EndModify();
+	return direct;
+}
+
+void CMemoryFunction::UnlinkExit(uint32 offset, const void* target)
+{
+	auto site = GetExitSite(offset);
+	BeginModify();
+	WriteIndirectExit(site, target);
+	EndModify();
+}
+
+uint8* CMemoryFunction::GetExitSite(uint32 offset) const
+{
+#ifndef MEMFUNC_EXIT_TARGET_OFFSET
+	throw std::runtime_error("Dynamic exits are not supported on this architecture.");
+#else
+	if((offset + MEMFUNC_EXIT_TARGET_OFFSET + sizeof(uintptr_t)) > m_size)
+	{
+		throw std::runtime_error("Invalid dynamic exit offset.");
+	}
+	return reinterpret_cast<uint8*>(m_code) + offset;
+#endif
+}
+
+bool CMemoryFunction::EncodeExitBranch(const uint8* site, const void* target, uint32& branch)
+{
+	int64 distance = static_cast<int64>(reinterpret_cast<intptr_t>(target) - reinterpret_cast<intptr_t>(site));
+#if defined(MEMFUNC_EXIT_X86)
+	//Relative to the end of the jump
+	distance -= MEMFUNC_EXIT_BRANCH_SIZE;
+	if((distance < INT32_MIN) || (distance > INT32_MAX)) return false;
+	branch = static_cast<uint32>(distance);
+	return true;
+#elif defined(MEMFUNC_EXIT_AARCH64)
+	if((distance & 0x3) != 0) return false;
+	if((distance < -0x8000000) || (distance >= 0x8000000)) return false;
+	branch = 0x14000000 | (static_cast<uint32>(distance / 4) & 0x03FFFFFF);
+	return true;
+#elif defined(MEMFUNC_EXIT_AARCH32)
+	//PC reads 8 bytes ahead, Thumb targets need to go through the interworking indirect jump
+	distance -= 8;
+	if((distance & 0x3) != 0) return false;
+	if((distance < -0x2000000) || (distance >= 0x2000000)) return false;
+	branch = 0xEA000000 | (static_cast<uint32>(distance / 4) & 0x00FFFFFF);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void CMemoryFunction::WriteExitBranch(uint8* site, uint32 branch)
+{
+	//Single aligned store, other threads see either the old or the new branch
+#if defined(MEMFUNC_EXIT_X86)
+	//rel32 follows the opcode byte
+	auto branchAddress = reinterpret_cast<uint32*>(site + 1);
+#else
+	auto branchAddress = reinterpret_cast<uint32*>(site);
+#endif
+	assert((reinterpret_cast<uintptr_t>(branchAddress) & (sizeof(uint32) - 1)) == 0);
+#ifdef _MSC_VER
+	*reinterpret_cast<volatile uint32*>(branchAddress) = branch;
+#else
+	__atomic_store_n(branchAddress, branch, __ATOMIC_RELEASE);
+#endif
+}
+
+void CMemoryFunction::WriteIndirectExit(uint8* site, const void* target)
+{
+#ifdef MEMFUNC_EXIT_BRANCH_SIZE
+	uint32 branch = 0;
+	bool encoded = EncodeExitBranch(site, site + MEMFUNC_EXIT_BRANCH_SIZE, branch);
+	assert(encoded);
+	(void)encoded;
+	//Target is in place before the branch stops skipping over the indirect jump
+	WriteExitTarget(site, target);
+	WriteExitBranch(site, branch);
+#endif
+}
+
+void CMemoryFunction::WriteExitTarget(uint8* site, const void* target)
+{
+#ifdef MEMFUNC_EXIT_TARGET_OFFSET
+	auto targetValue = reinterpret_cast<uintptr_t>(target);
+	auto targetAddress = reinterpret_cast<uintptr_t*>(site + MEMFUNC_EXIT_TARGET_OFFSET);
+	assert((reinterpret_cast<uintptr_t>(targetAddress) & (sizeof(uintptr_t) - 1)) == 0);
+#ifdef _MSC_VER
+	*reinterpret_cast<volatile uintptr_t*>(targetAddress) = targetValue;
+#else
+	__atomic_store_n(targetAddress, targetValue, __ATOMIC_RELEASE);
+#endif
+#endif
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+//Platform selection shared by CMemoryFunction and CCodeHeap
+
+#include "Types.h"
+
+#ifdef _WIN32
+	#define MEMFUNC_USE_WIN32
+#endif
+
+#ifdef __APPLE__
+	#include "TargetConditionals.h"
+	#include <libkern/OSCacheControl.h>
+
+	#if TARGET_OS_OSX
+		#define MEMFUNC_USE_MMAP
+		#define MEMFUNC_MMAP_ADDITIONAL_FLAGS (MAP_JIT)
+		#if TARGET_CPU_ARM64
+			#define MEMFUNC_MMAP_REQUIRES_JIT_WRITE_PROTECT
+		#endif
+	#else
+		#define MEMFUNC_USE_MACHVM
+		#if TARGET_OS_IPHONE
+			#define MEMFUNC_MACHVM_STRICT_PROTECTION
+		#endif
+	#endif
+#endif
+
+#if defined(__ANDROID__) || defined(__linux__) || defined(__FreeBSD__)
+	#define MEMFUNC_USE_MMAP
+#endif
+
+#if defined(MEMFUNC_USE_WIN32)
+#include <windows.h>
+#elif defined(MEMFUNC_USE_MACHVM)
+#include <mach/mach_init.h>
+#include <mach/vm_map.h>
+#elif defined(MEMFUNC_USE_MMAP)
+#include <sys/mman.h>
+#include <pthread.h>
+#else
+#error "No API to use for CMemoryFunction"
+#endif
+
+//Functions sharing pages with others can't have their protection changed individually
+#if !defined(MEMFUNC_MACHVM_STRICT_PROTECTION)
+	#define MEMFUNC_SUPPORTS_CODE_HEAP
+#endif
+
+//Dynamic exits (OP_EXTERNJMP_DYN) start with a relative branch to the next instruction that can be
+//patched, followed by an indirect jump to the target address stored at MEMFUNC_EXIT_TARGET_OFFSET.
+//Code generators align both the branch and the target address so they can be patched with single stores.
+#if defined(_M_X64) || defined(__x86_64__)
+	#define MEMFUNC_EXIT_X86
+	#define MEMFUNC_EXIT_BRANCH_SIZE 5		//jmp rel32
+	#define MEMFUNC_EXIT_TARGET_OFFSET 13	//6 x nop; mov rax, imm64; jmp rax
+#elif defined(_M_IX86) || defined(__i386__)
+	#define MEMFUNC_EXIT_X86
+	#define MEMFUNC_EXIT_BRANCH_SIZE 5		//jmp rel32
+	#define MEMFUNC_EXIT_TARGET_OFFSET 9	//3 x nop; mov eax, imm32; jmp eax
+#elif defined(_M_ARM64) || defined(__aarch64__)
+	#define MEMFUNC_EXIT_AARCH64
+	#define MEMFUNC_EXIT_BRANCH_SIZE 4		//b
+	#define MEMFUNC_EXIT_TARGET_OFFSET 12	//ldr xN, target; br xN
+#elif defined(_M_ARM) || defined(__arm__)
+	#define MEMFUNC_EXIT_AARCH32
+	#define MEMFUNC_EXIT_BRANCH_SIZE 4		//b
+	#define MEMFUNC_EXIT_TARGET_OFFSET 8	//ldr pc, target
+#endif
+
+static inline void MemoryFunction_ClearCache(void* code, size_t size)
+{
+	//Nothing to do on x86, instruction cache is coherent with data writes
+	(void)code;
+	(void)size;
+#ifdef __APPLE__
+	sys_icache_invalidate(code, size);
+#elif defined(__ANDROID__) || defined(__linux__) || defined(__FreeBSD__)
+	#if defined(__arm__) || defined(__aarch64__)
+		__clear_cache(code, reinterpret_cast<uint8*>(code) + size);
+	#endif
+#endif
+}
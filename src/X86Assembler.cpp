@@ -15,6 +15,8 @@ void CX86Assembler::Begin()
 
 void CX86Assembler::End()
 {
+	EndStatsRegion();
+
 	//Mark last label
 	if(m_currentLabel != nullptr)
 	{
@@ -22,140 +24,131 @@ void CX86Assembler::End()
 		m_currentLabel->size = currentPos - m_currentLabel->start;
 	}
 
-	//Initialize
-	for(auto& labelPair : m_labels)
+	//Gather jumps in emission order, labels remember how many jumps precede them
+	m_relaxJumps.clear();
+	for(const auto& labelId : m_labelOrder)
 	{
-		auto& label = labelPair.second;
-		label.projectedStart = label.start;
+		auto& label = GetLabelInfo(labelId);
+		label.firstJumpIndex = static_cast<uint32>(m_relaxJumps.size());
+		for(auto& labelRef : label.labelRefs)
+		{
+			//Make sure any literal ref happens before a label ref
+			for(const auto& literalRefPair : label.literal128Refs)
+			{
+				assert(literalRefPair.second.offset < labelRef.offset);
+				(void)literalRefPair;
+			}
+			assert(labelRef.offset >= label.start);
+			labelRef.length = JMP_NEAR;
+			RELAXJUMP relaxJump;
+			relaxJump.labelRef = &labelRef;
+			m_relaxJumps.push_back(relaxJump);
+		}
 	}
 
-	while(1)
+	for(auto& relaxJump : m_relaxJumps)
 	{
-		bool changed = false;
+		const auto& referencedLabel = GetLabelInfo(relaxJump.labelRef->label);
+		relaxJump.targetStart = referencedLabel.start;
+		relaxJump.targetFirstJump = referencedLabel.firstJumpIndex;
+	}
 
-		for(LabelArray::const_iterator labelIterator(m_labelOrder.begin());
-			labelIterator != m_labelOrder.end(); ++labelIterator)
+	//Start with every jump being short, then grow the ones that don't fit until nothing changes.
+	//Jumps never shrink back, growing one only moves others further away from their targets, so this
+	//converges after a few linear passes. m_jumpGrowth[i] holds the size of all jumps before jump i.
+	unsigned int jumpCount = static_cast<unsigned int>(m_relaxJumps.size());
+	m_jumpGrowth.resize(jumpCount + 1);
+	while(1)
+	{
+		uint32 growth = 0;
+		for(unsigned int i = 0; i < jumpCount; i++)
 		{
-			auto& label = m_labels[*labelIterator];
+			const auto& labelRef = *m_relaxJumps[i].labelRef;
+			m_jumpGrowth[i] = growth;
+			growth += GetJumpSize(labelRef.type, labelRef.length);
+		}
+		m_jumpGrowth[jumpCount] = growth;
 
-			for(LabelRefArray::iterator labelRefIterator(label.labelRefs.begin());
-				labelRefIterator != label.labelRefs.end(); ++labelRefIterator)
+		bool changed = false;
+		for(unsigned int i = 0; i < jumpCount; i++)
+		{
+			const auto& relaxJump = m_relaxJumps[i];
+			auto& labelRef = *relaxJump.labelRef;
+			if(labelRef.length != JMP_NEAR) continue;
+			uint32 jumpEnd = labelRef.offset + m_jumpGrowth[i] + GetJumpSize(labelRef.type, JMP_NEAR);
+			uint32 targetStart = relaxJump.targetStart + m_jumpGrowth[relaxJump.targetFirstJump];
+			if(GetMinimumConstantSize(targetStart - jumpEnd) != 1)
 			{
-				auto& labelRef(*labelRefIterator);
-				switch(labelRef.length)
-				{
-					case JMP_NOTSET:
-						{
-							//Assume a short jump first.
-							unsigned int jumpSize = GetJumpSize(labelRef.type, JMP_NEAR);
-							labelRef.length = JMP_NEAR;
-							IncrementJumpOffsetsLocal(label, labelRefIterator + 1, jumpSize);
-							IncrementJumpOffsets(labelIterator + 1, jumpSize);
-							changed = true;
-						}
-						break;
-					case JMP_NEAR:
-						{
-							//We need to verify if the jump is still good for us, since sizes might have changed
-							LABELINFO& referencedLabel(m_labels[labelRef.label]);
-							unsigned int smallJumpSize = GetJumpSize(labelRef.type, JMP_NEAR);
-							uint32 offset = referencedLabel.projectedStart - (labelRef.offset + smallJumpSize);
-							uint32 offsetSize = GetMinimumConstantSize(offset);
-							if(offsetSize != 1)
-							{
-								//Doesn't fit, recompute offsets
-								labelRef.length = JMP_FAR;
-								unsigned int longJumpSize = GetJumpSize(labelRef.type, JMP_FAR);
-								unsigned int incrementAmount = longJumpSize - smallJumpSize;
-								IncrementJumpOffsetsLocal(label, labelRefIterator + 1, incrementAmount);
-								IncrementJumpOffsets(labelIterator + 1, incrementAmount);
-								changed = true;
-							}
-						}
-						break;
-				}
+				labelRef.length = JMP_FAR;
+				changed = true;
 			}
 		}
 
 		if(!changed) break;
 	}
 
-	assert(m_outputStream != nullptr);
-	m_tmpStream.Seek(0, Framework::STREAM_SEEK_SET);
-
 	for(const auto& labelId : m_labelOrder)
 	{
-		const auto& label = m_labels[labelId];
+		auto& label = GetLabelInfo(labelId);
+		label.projectedStart = label.start + m_jumpGrowth[label.firstJumpIndex];
+	}
 
-		unsigned int currentPos = label.start;
-		unsigned int currentProjectedPos = label.projectedStart;
-		unsigned int endPos = label.start + label.size;
+	//Copy code straight from the temporary stream, inserting jumps as we go
+	assert(m_outputStream != nullptr);
+	const uint8* code = m_tmpStream.GetBuffer();
+	uint32 codeSize = static_cast<uint32>(m_tmpStream.GetSize());
+	uint32 currentPos = 0;
+	for(unsigned int i = 0; i < jumpCount; i++)
+	{
+		const auto& relaxJump = m_relaxJumps[i];
+		const auto& labelRef = *relaxJump.labelRef;
 
-		for(const auto& labelRef : label.labelRefs)
+		assert(labelRef.offset >= currentPos);
+		if(labelRef.offset != currentPos)
 		{
-			const auto& referencedLabel(m_labels[labelRef.label]);
-
-			unsigned int readSize = labelRef.offset - currentProjectedPos;
-			if(readSize != 0)
-			{
-				m_copyBuffer.resize(readSize);
-				m_tmpStream.Read(m_copyBuffer.data(), readSize);
-				m_outputStream->Write(m_copyBuffer.data(), readSize);
-			}
-
-			//Write our jump here.
-			unsigned int jumpSize = GetJumpSize(labelRef.type, labelRef.length);
-			uint32 distance = referencedLabel.projectedStart - (labelRef.offset + jumpSize);
-			WriteJump(m_outputStream, labelRef.type, labelRef.length, distance);
-
-			currentProjectedPos += readSize + jumpSize;
-			currentPos += readSize;
+			m_outputStream->Write(code + currentPos, labelRef.offset - currentPos);
+			currentPos = labelRef.offset;
 		}
 
-		unsigned int lastCopySize = endPos - currentPos;
-		if(lastCopySize != 0)
+		unsigned int jumpSize = GetJumpSize(labelRef.type, labelRef.length);
+		uint32 jumpEnd = labelRef.offset + m_jumpGrowth[i] + jumpSize;
+		uint32 targetStart = relaxJump.targetStart + m_jumpGrowth[relaxJump.targetFirstJump];
+		WriteJump(m_outputStream, labelRef.type, labelRef.length, targetStart - jumpEnd);
+
+		if(m_stats)
 		{
-			m_copyBuffer.resize(lastCopySize);
-			m_tmpStream.Read(m_copyBuffer.data(), lastCopySize);
-			m_outputStream->Write(m_copyBuffer.data(), lastCopySize);
+			auto category = (labelRef.length == JMP_NEAR) ? CAssemblerStats::CATEGORY_JUMP_SHORT : CAssemblerStats::CATEGORY_JUMP_NEAR;
+			m_stats->RecordDetached(category, labelRef.statsTag, jumpSize, 1);
 		}
 	}
+	if(codeSize != currentPos)
+	{
+		m_outputStream->Write(code + currentPos, codeSize - currentPos);
+	}
 
 	ResolveLiteralReferences();
 }
 
-void CX86Assembler::IncrementJumpOffsets(LabelArray::const_iterator startLabel, unsigned int amount)
+void CX86Assembler::SetStream(Framework::CStream* stream)
 {
-	for(LabelArray::const_iterator labelIterator(startLabel);
-		labelIterator != m_labelOrder.end(); ++labelIterator)
-	{
-		LABELINFO& label = m_labels[*labelIterator];
-		label.projectedStart += amount;
-		IncrementJumpOffsetsLocal(label, label.labelRefs.begin(), amount);
-	}
+	m_outputStream = stream;
 }
 
-void CX86Assembler::IncrementJumpOffsetsLocal(LABELINFO& label, LabelRefArray::iterator startJump, unsigned int amount)
+void CX86Assembler::SetStats(CAssemblerStats* stats)
 {
-	for(LabelRefArray::iterator labelRefIterator(startJump);
-		labelRefIterator != label.labelRefs.end(); ++labelRefIterator)
-	{
-		auto& labelRef(*labelRefIterator);
-
-		//Make sure any literal ref happens before a label ref
-		for(const auto& literalRefPair : label.literal128Refs)
-		{
-			const auto& literalRef = literalRefPair.second;
-			assert(literalRef.offset < labelRef.offset);
-		}
+	m_stats = stats;
+}
 
-		labelRef.offset += amount;
-	}
+void CX86Assembler::BeginStatsRegion(CAssemblerStats::CATEGORY category, uint32 tag)
+{
+	if(!m_stats) return;
+	m_stats->BeginRegion(m_tmpStream.Tell(), category, tag);
 }
 
-void CX86Assembler::SetStream(Framework::CStream* stream)
+void CX86Assembler::EndStatsRegion()
 {
-	m_outputStream = stream;
+	if(!m_stats) return;
+	m_stats->EndRegion(m_tmpStream.Tell());
 }
 
 CX86Assembler::CAddress CX86Assembler::MakeRegisterAddress(REGISTER nRegister)
@@ -400,7 +393,8 @@ CX86Assembler::CAddress CX86Assembler::MakeLiteral128Address(LITERAL128ID litera
 CX86Assembler::LABEL CX86Assembler::CreateLabel()
 {
 	LABEL newLabelId = m_nextLabelId++;
-	m_labels[newLabelId] = LABELINFO();
+	m_labels.emplace_back();
+	assert(m_labels.size() == newLabelId);
 	return newLabelId;
 }
 
@@ -413,9 +407,7 @@ void CX86Assembler::MarkLabel(LABEL label, int32 offset)
 		m_currentLabel->size = currentPos - m_currentLabel->start;
 	}
 
-	auto labelIterator(m_labels.find(label));
-	assert(labelIterator != m_labels.end());
-	auto& labelInfo(labelIterator->second);
+	auto& labelInfo = GetLabelInfo(label);
 	labelInfo.start = currentPos;
 	m_currentLabel = &labelInfo;
 	m_labelOrder.push_back(label);
@@ -423,10 +415,15 @@ void CX86Assembler::MarkLabel(LABEL label, int32 offset)
 
 uint32 CX86Assembler::GetLabelOffset(LABEL label) const
 {
-	auto labelIterator(m_labels.find(label));
-	assert(labelIterator != m_labels.end());
-	const auto& labelInfo(labelIterator->second);
-	return labelInfo.projectedStart;
+	assert((label != 0) && (label <= m_labels.size()));
+	return m_labels[label - 1].projectedStart;
+}
+
+CX86Assembler::LABELINFO& CX86Assembler::GetLabelInfo(LABEL label)
+{
+	//Labels are numbered from 1 in creation order
+	assert((label != 0) && (label <= m_labels.size()));
+	return m_labels[label - 1];
 }
 
 CX86Assembler::LITERAL128ID CX86Assembler::CreateLiteral128(const LITERAL128& literal)
@@ -441,12 +438,14 @@ CX86Assembler::LITERAL128ID CX86Assembler::CreateLiteral128(const LITERAL128& li
 
 void CX86Assembler::ResolveLiteralReferences()
 {
+	uint64 poolStart = m_outputStream->Tell();
+
 	CLiteralPool literalPool(m_outputStream);
 	literalPool.AlignPool();
 
 	for(const auto& labelId : m_labelOrder)
 	{
-		const auto& label = m_labels[labelId];
+		const auto& label = GetLabelInfo(labelId);
 		assert(label.projectedStart >= label.start);
 		uint32 projectedDiff = label.projectedStart - label.start;
 		for(const auto& literalRefPair : label.literal128Refs)
@@ -462,6 +461,13 @@ void CX86Assembler::ResolveLiteralReferences()
 	}
 
 	m_outputStream->Seek(0, Framework::STREAM_SEEK_END);
+
+	if(m_stats)
+	{
+		//Includes alignment padding
+		uint32 poolSize = static_cast<uint32>(m_outputStream->Tell() - poolStart);
+		m_stats->RecordDetached(CAssemblerStats::CATEGORY_LITERALPOOL, CAssemblerStats::NO_TAG, poolSize, 0);
+	}
 }
 
 void CX86Assembler::AdcEd(REGISTER registerId, const CAddress& address)
@@ -527,7 +533,12 @@ void CX86Assembler::BsrEd(REGISTER registerId, const CAddress& address)
 
 void CX86Assembler::CallEd(const CAddress& address)
 {
+	uint64 start = m_tmpStream.Tell();
 	WriteEvOp(0xFF, 0x02, false, address);
+	if(m_stats)
+	{
+		m_stats->RecordInstruction(CAssemblerStats::CATEGORY_CALL, static_cast<uint32>(m_tmpStream.Tell() - start));
+	}
 }
 
 void CX86Assembler::CmovsEd(REGISTER registerId, const CAddress& address)
@@ -634,7 +645,23 @@ void CX86Assembler::JnleJx(LABEL label)
 
 void CX86Assembler::JmpEd(const CAddress& address)
 {
+	uint64 start = m_tmpStream.Tell();
 	WriteEvOp(0xFF, 0x04, false, address);
+	if(m_stats)
+	{
+		m_stats->RecordInstruction(CAssemblerStats::CATEGORY_CALL, static_cast<uint32>(m_tmpStream.Tell() - start));
+	}
+}
+
+void CX86Assembler::JmpJd(uint32 offset)
+{
+	//Always encoded with a 32-bit displacement (relative to the next instruction) that can be patched
+	WriteByte(0xE9);
+	WriteDWord(offset);
+	if(m_stats)
+	{
+		m_stats->RecordInstruction(CAssemblerStats::CATEGORY_JUMP_NEAR, 5);
+	}
 }
 
 void CX86Assembler::JmpJx(LABEL label)
@@ -677,6 +704,12 @@ void CX86Assembler::LeaGq(REGISTER registerId, const CAddress& address)
 	WriteEvGvOp(0x8D, true, address, registerId);
 }
 
+void CX86Assembler::LzcntEd(REGISTER registerId, const CAddress& address)
+{
+	WriteByte(0xF3);
+	WriteEvGvOp0F(0xBD, false, address, registerId);
+}
+
 void CX86Assembler::MovEw(REGISTER registerId, const CAddress& address)
 {
 	WriteByte(0x66);
@@ -890,6 +923,11 @@ void CX86Assembler::SarEq(const CAddress& address, uint8 amount)
 	WriteByte(amount);
 }
 
+void CX86Assembler::SarxEd(REGISTER dst, const CAddress& src, REGISTER amount)
+{
+	WriteVexGdOp(VEX_OPCODE_MAP_F3_38, 0xF7, dst, amount, src);
+}
+
 void CX86Assembler::SbbEd(REGISTER registerId, const CAddress& address)
 {
 	WriteEvGvOp(0x1B, false, address, registerId);
@@ -967,6 +1005,11 @@ void CX86Assembler::ShlEq(const CAddress& address, uint8 amount)
 	WriteByte(amount);
 }
 
+void CX86Assembler::ShlxEd(REGISTER dst, const CAddress& src, REGISTER amount)
+{
+	WriteVexGdOp(VEX_OPCODE_MAP_66_38, 0xF7, dst, amount, src);
+}
+
 void CX86Assembler::ShrEd(const CAddress& address)
 {
 	WriteEvOp(0xD3, 0x05, false, address);
@@ -989,6 +1032,11 @@ void CX86Assembler::ShrEq(const CAddress& address, uint8 amount)
 	WriteByte(amount);
 }
 
+void CX86Assembler::ShrxEd(REGISTER dst, const CAddress& src, REGISTER amount)
+{
+	WriteVexGdOp(VEX_OPCODE_MAP_F2_38, 0xF7, dst, amount, src);
+}
+
 void CX86Assembler::ShldEd(const CAddress& address, REGISTER registerId)
 {
 	WriteByte(0x0F);
@@ -1229,6 +1277,7 @@ void CX86Assembler::CreateLabelReference(LABEL label, JMP_TYPE type)
 	reference.label			= label;
 	reference.offset		= static_cast<uint32>(m_tmpStream.Tell());
 	reference.type			= type;
+	reference.statsTag		= m_stats ? m_stats->GetCurrentTag() : CAssemblerStats::NO_TAG;
 	
 	m_currentLabel->labelRefs.push_back(reference);
 }
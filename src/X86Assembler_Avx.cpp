@@ -68,6 +68,17 @@ void CX86Assembler::WriteVexVoOp(VEX_OPCODE_MAP opMap, uint8 op, XMMREGISTER dst
 	}
 }
 
+void CX86Assembler::WriteVexGdOp(VEX_OPCODE_MAP opMap, uint8 op, REGISTER dst, REGISTER src1, const CAddress& src2)
+{
+	//General purpose registers are encoded the same way as XMM registers
+	auto vexDst = static_cast<XMMREGISTER>(dst);
+	WriteVex(opMap, vexDst, static_cast<XMMREGISTER>(src1), src2);
+	WriteByte(op);
+	CAddress newAddress(src2);
+	newAddress.ModRm.nFnReg = vexDst;
+	newAddress.Write(&m_tmpStream);
+}
+
 void CX86Assembler::WriteVexShiftVoOp(uint8 op, uint8 subOp, XMMREGISTER dst, XMMREGISTER src, uint8 amount)
 {
 	assert(subOp < 8);
@@ -381,6 +392,11 @@ void CX86Assembler::VpshufbVo(XMMREGISTER dst, XMMREGISTER src1, const CAddress&
 	WriteVexVoOp(VEX_OPCODE_MAP_66_38, 0x00, dst, src1, src2);
 }
 
+void CX86Assembler::VpbroadcastdVo(XMMREGISTER dst, const CAddress& src)
+{
+	WriteVexVoOp(VEX_OPCODE_MAP_66_38, 0x58, dst, CX86Assembler::xMM0, src);
+}
+
 void CX86Assembler::VpmovmskbVo(REGISTER dst, XMMREGISTER src)
 {
 	WriteVexVoOp(VEX_OPCODE_MAP_66, 0xD7, static_cast<XMMREGISTER>(dst), CX86Assembler::xMM0, CX86Assembler::MakeXmmRegisterAddress(src));
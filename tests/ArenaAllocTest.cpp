@@ -0,0 +1,97 @@
+#include "ArenaAllocTest.h"
+#include <cstdio>
+#include "MemStream.h"
+#include "offsetof_def.h"
+
+void CArenaAllocTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		jitter.PushCst(0);
+		jitter.PullRel(offsetof(CONTEXT, result));
+		for(unsigned int i = 0; i < 0x10; i++)
+		{
+			jitter.PushRel(offsetof(CONTEXT, result));
+			jitter.PushRel(offsetof(CONTEXT, values[i]));
+			jitter.PushCst(i);
+			jitter.Add();
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, result));
+
+			jitter.PushRel(offsetof(CONTEXT, values[i]));
+			jitter.PushCst(0x80);
+			jitter.BeginIf(Jitter::CONDITION_GE);
+			{
+				jitter.PushRel(offsetof(CONTEXT, values[i]));
+				jitter.PushCst(1);
+				jitter.Shl();
+				jitter.PullRel(offsetof(CONTEXT, values[i]));
+			}
+			jitter.EndIf();
+		}
+	}
+	jitter.End();
+}
+
+size_t CArenaAllocTest::MeasureHeapAllocations(Jitter::CJitter& jitter, bool arenaEnabled)
+{
+	jitter.SetSymbolArenaEnabled(arenaEnabled);
+
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+
+	//Warm up once, arena chunks are allocated here
+	EmitCode(jitter);
+
+	//Only counts allocations made while measuring on this thread
+	size_t allocationCount = 0;
+	Jitter::CArena::SetHeapAllocationCounter(&allocationCount);
+	for(unsigned int i = 0; i < ITERATION_COUNT; i++)
+	{
+		codeStream.ResetBuffer();
+		EmitCode(jitter);
+	}
+	Jitter::CArena::SetHeapAllocationCounter(nullptr);
+	return allocationCount / ITERATION_COUNT;
+}
+
+void CArenaAllocTest::Compile(Jitter::CJitter& jitter)
+{
+	bool arenaEnabled = jitter.IsSymbolArenaEnabled();
+
+	m_allocationsWithoutArena = MeasureHeapAllocations(jitter, false);
+	m_allocationsWithArena = MeasureHeapAllocations(jitter, true);
+
+	jitter.SetSymbolArenaEnabled(arenaEnabled);
+
+	printf("ArenaAllocTest: %d symbol heap allocations per compile without symbol arena, %d with symbol arena.\r\n",
+		static_cast<int>(m_allocationsWithoutArena), static_cast<int>(m_allocationsWithArena));
+
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+	EmitCode(jitter);
+	m_function = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+}
+
+void CArenaAllocTest::Run()
+{
+	TEST_VERIFY(m_allocationsWithArena < m_allocationsWithoutArena);
+
+	CONTEXT context;
+	memset(&context, 0, sizeof(context));
+	uint32 expectedResult = 0;
+	for(unsigned int i = 0; i < 0x10; i++)
+	{
+		context.values[i] = i * 0x10;
+		expectedResult += context.values[i] + i;
+	}
+
+	m_function(&context);
+
+	TEST_VERIFY(context.result == expectedResult);
+	for(unsigned int i = 0; i < 0x10; i++)
+	{
+		uint32 value = i * 0x10;
+		TEST_VERIFY(context.values[i] == ((value >= 0x80) ? (value << 1) : value));
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+//Compares heap allocations done for symbols by a compilation with and without the symbol arena
+class CArenaAllocTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	struct CONTEXT
+	{
+		uint32		values[0x10];
+		uint32		result;
+	};
+
+	enum
+	{
+		ITERATION_COUNT = 8,
+	};
+
+	static void			EmitCode(Jitter::CJitter&);
+	static size_t		MeasureHeapAllocations(Jitter::CJitter&, bool);
+
+	size_t				m_allocationsWithArena = 0;
+	size_t				m_allocationsWithoutArena = 0;
+	CMemoryFunction		m_function;
+};
@@ -0,0 +1,106 @@
+#include "BlockLinkTest.h"
+#include "MemStream.h"
+#include "Jitter_CodeCache.h"
+
+void CBlockLinkTest::Dispatcher(void* context)
+{
+	reinterpret_cast<CONTEXT*>(context)->dispatchCount++;
+}
+
+void CBlockLinkTest::FarFunction(void* context)
+{
+	reinterpret_cast<CONTEXT*>(context)->farCount++;
+}
+
+void CBlockLinkTest::CompileSource(Jitter::CJitter& jitter, Framework::CStream& codeStream)
+{
+	jitter.SetStream(&codeStream);
+	jitter.Begin();
+	{
+		jitter.PushRel(offsetof(CONTEXT, sourceCount));
+		jitter.PushCst(1);
+		jitter.Add();
+		jitter.PullRel(offsetof(CONTEXT, sourceCount));
+
+		jitter.JumpToDynamic(reinterpret_cast<void*>(&Dispatcher));
+	}
+	jitter.End();
+}
+
+void CBlockLinkTest::Compile(Jitter::CJitter& jitter)
+{
+	{
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		jitter.Begin();
+		{
+			jitter.PushRel(offsetof(CONTEXT, targetCount));
+			jitter.PushCst(1);
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, targetCount));
+		}
+		jitter.End();
+		m_targetFunction = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	}
+
+	{
+		Framework::CMemStream codeStream;
+		CompileSource(jitter, codeStream);
+		m_dynamicExits = jitter.GetDynamicExits();
+		m_sourceFunction = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	}
+
+	//Exits need to be known when the code comes from the cache
+	{
+		Jitter::CCodeCache codeCache;
+		jitter.SetCodeCache(&codeCache);
+		m_cachedExitsMatch = true;
+		for(unsigned int i = 0; i < 2; i++)
+		{
+			Framework::CMemStream codeStream;
+			CompileSource(jitter, codeStream);
+			m_cachedExitsMatch &= (jitter.GetDynamicExits() == m_dynamicExits);
+		}
+		m_cachedExitsMatch &= (codeCache.GetStats().hitCount == 1);
+		jitter.SetCodeCache(nullptr);
+	}
+}
+
+void CBlockLinkTest::Run()
+{
+	TEST_VERIFY(m_dynamicExits.size() == 1);
+	TEST_VERIFY(m_cachedExitsMatch);
+
+	auto exitOffset = m_dynamicExits[0];
+#if defined(_M_X64) || defined(__x86_64__)
+	//Branch displacement and target address need to be aligned to be patched with single stores
+	TEST_VERIFY(((exitOffset + 1) & 0x3) == 0);
+	TEST_VERIFY(((exitOffset + 13) & 0x7) == 0);
+#endif
+	CONTEXT context;
+
+	m_sourceFunction(&context);
+	TEST_VERIFY(context.sourceCount == 1);
+	TEST_VERIFY(context.dispatchCount == 1);
+
+	//Target is either reached directly or through the indirect jump, depending on where it was allocated
+	m_sourceFunction.LinkExit(exitOffset, m_targetFunction.GetCode());
+	m_sourceFunction(&context);
+	m_sourceFunction(&context);
+	TEST_VERIFY(context.sourceCount == 3);
+	TEST_VERIFY(context.targetCount == 2);
+	TEST_VERIFY(context.dispatchCount == 1);
+
+	m_sourceFunction.LinkExit(exitOffset, reinterpret_cast<void*>(&FarFunction));
+	m_sourceFunction(&context);
+	TEST_VERIFY(context.farCount == 1);
+	TEST_VERIFY(context.targetCount == 2);
+
+	m_sourceFunction.LinkExit(exitOffset, m_targetFunction.GetCode());
+	m_sourceFunction.UnlinkExit(exitOffset, reinterpret_cast<void*>(&Dispatcher));
+	m_sourceFunction(&context);
+	TEST_VERIFY(context.sourceCount == 5);
+	TEST_VERIFY(context.targetCount == 2);
+	TEST_VERIFY(context.farCount == 1);
+	TEST_VERIFY(context.dispatchCount == 2);
+}
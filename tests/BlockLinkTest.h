@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+class CBlockLinkTest : public CTest
+{
+public:
+	void						Run() override;
+	void						Compile(Jitter::CJitter&) override;
+
+private:
+	struct CONTEXT
+	{
+		uint32		sourceCount = 0;
+		uint32		targetCount = 0;
+		uint32		dispatchCount = 0;
+		uint32		farCount = 0;
+	};
+
+	static void					Dispatcher(void*);
+	static void					FarFunction(void*);
+
+	static void					CompileSource(Jitter::CJitter&, Framework::CStream&);
+
+	CMemoryFunction				m_sourceFunction;
+	CMemoryFunction				m_targetFunction;
+	Jitter::CCodeGen::DynamicExitArray	m_dynamicExits;
+	bool						m_cachedExitsMatch = false;
+};
@@ -0,0 +1,101 @@
+#include "BranchRelaxationTest.h"
+#include <cstdio>
+#include "MemStream.h"
+#include "offsetof_def.h"
+#include "Jitter_CompileStats.h"
+
+void CBranchRelaxationTest::Compile(Jitter::CJitter& jitter)
+{
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+	jitter.SetCompileStatsEnabled(true);
+	jitter.ResetCompileStats();
+
+	jitter.Begin();
+	{
+		//Jumps over everything, needs a near jump
+		jitter.PushRel(offsetof(CONTEXT, enabled));
+		jitter.PushCst(0);
+		jitter.BeginIf(Jitter::CONDITION_NE);
+		{
+			for(unsigned int i = 0; i < BLOCK_COUNT; i++)
+			{
+				jitter.PushRel(offsetof(CONTEXT, input[i]));
+				jitter.PushCst(i & 0x0F);
+				jitter.BeginIf(Jitter::CONDITION_NE);
+				{
+					for(unsigned int j = 0; j < (i % MAX_BODY_SIZE); j++)
+					{
+						jitter.PushRel(offsetof(CONTEXT, result[i]));
+						jitter.PushRel(offsetof(CONTEXT, input[(i + j) % BLOCK_COUNT]));
+						jitter.Add();
+						jitter.PullRel(offsetof(CONTEXT, result[i]));
+					}
+				}
+				jitter.Else();
+				{
+					jitter.PushCst(i);
+					jitter.PullRel(offsetof(CONTEXT, result[i]));
+				}
+				jitter.EndIf();
+			}
+		}
+		jitter.EndIf();
+	}
+	jitter.End();
+
+	const auto& stats = jitter.GetLastCompileStats();
+	const auto& codeStats = stats.code;
+	printf("BranchRelaxationTest: %d bytes with %d short and %d near jumps, relaxation and output took %d us, compilation took %d us.\r\n",
+		static_cast<int>(codeStream.GetSize()),
+		static_cast<int>(codeStats.categoryInstructionCounts[CAssemblerStats::CATEGORY_JUMP_SHORT]),
+		static_cast<int>(codeStats.categoryInstructionCounts[CAssemblerStats::CATEGORY_JUMP_NEAR]),
+		static_cast<int>(stats.passes[Jitter::CCompileStats::PASS_ASSEMBLEREND].totalTime / 1000),
+		static_cast<int>(stats.totalTime / 1000));
+	jitter.SetCompileStatsEnabled(false);
+
+	m_function = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+}
+
+void CBranchRelaxationTest::ComputeReference(CONTEXT& context)
+{
+	if(context.enabled == 0) return;
+	for(unsigned int i = 0; i < BLOCK_COUNT; i++)
+	{
+		if(context.input[i] != (i & 0x0F))
+		{
+			for(unsigned int j = 0; j < (i % MAX_BODY_SIZE); j++)
+			{
+				context.result[i] += context.input[(i + j) % BLOCK_COUNT];
+			}
+		}
+		else
+		{
+			context.result[i] = i;
+		}
+	}
+}
+
+void CBranchRelaxationTest::Run()
+{
+	CONTEXT referenceContext;
+	memset(&m_context, 0, sizeof(CONTEXT));
+	m_context.enabled = 1;
+	for(unsigned int i = 0; i < BLOCK_COUNT; i++)
+	{
+		//Take both paths
+		m_context.input[i] = (i % 3) ? (i & 0x0F) : (i * 7);
+		m_context.result[i] = i * 3;
+	}
+	memcpy(&referenceContext, &m_context, sizeof(CONTEXT));
+
+	m_function(&m_context);
+	ComputeReference(referenceContext);
+	TEST_VERIFY(memcmp(&m_context, &referenceContext, sizeof(CONTEXT)) == 0);
+
+	//Outer jump skips everything
+	m_context.enabled = 0;
+	memcpy(&referenceContext, &m_context, sizeof(CONTEXT));
+	m_function(&m_context);
+	TEST_VERIFY(memcmp(&m_context, &referenceContext, sizeof(CONTEXT)) == 0);
+}
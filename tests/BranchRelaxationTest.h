@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+class CBranchRelaxationTest : public CTest
+{
+public:
+	void				Compile(Jitter::CJitter&) override;
+	void				Run() override;
+
+private:
+	enum
+	{
+		BLOCK_COUNT = 1024,
+		//Bodies get up to this many statements, making their jumps straddle the short/near limit
+		MAX_BODY_SIZE = 24,
+	};
+
+	struct CONTEXT
+	{
+		uint32	enabled;
+		uint32	input[BLOCK_COUNT];
+		uint32	result[BLOCK_COUNT];
+	};
+
+	static void			ComputeReference(CONTEXT&);
+
+	CONTEXT				m_context;
+	CMemoryFunction		m_function;
+};
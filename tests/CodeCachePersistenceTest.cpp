@@ -0,0 +1,153 @@
+#include "CodeCachePersistenceTest.h"
+#include <stdexcept>
+#include "MemStream.h"
+#include "offsetof_def.h"
+
+#define EXTERNAL_SYMBOL_NAME "CodeCachePersistenceTest_Function"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+//Calls either load the function address inline or use PC relative branches, none can be relocated
+static const bool g_callsRelocatable = false;
+#else
+static const bool g_callsRelocatable = true;
+#endif
+
+void CCodeCachePersistenceTest::Compile(Jitter::CJitter& jitter)
+{
+	Framework::CMemStream cacheStream;
+
+	//First run, code refers to the symbol by its address in that run
+	{
+		Jitter::CCodeCache codeCache;
+		codeCache.AddExternalSymbol(EXTERNAL_SYMBOL_NAME, reinterpret_cast<uintptr_t>(&FirstRunFunction));
+		jitter.SetCodeCache(&codeCache);
+		CompileCall(jitter, reinterpret_cast<void*>(&FirstRunFunction));
+		CompileAdd(jitter);
+		CompileCall(jitter, reinterpret_cast<void*>(&UnnamedFunction));
+		jitter.SetCodeCache(nullptr);
+		codeCache.Save(cacheStream);
+	}
+
+	//Symbol is at another address in the next run
+	{
+		Jitter::CCodeCache codeCache;
+		codeCache.AddExternalSymbol(EXTERNAL_SYMBOL_NAME, reinterpret_cast<uintptr_t>(&SecondRunFunction));
+		cacheStream.Seek(0, Framework::STREAM_SEEK_SET);
+		m_loadedCount = codeCache.Load(cacheStream);
+
+		jitter.SetCodeCache(&codeCache);
+		auto compileAndCheckHit =
+			[&] (const std::function<CodeBuffer ()>& compile, CodeBuffer& code)
+			{
+				auto hitCount = codeCache.GetStats().hitCount;
+				code = compile();
+				return codeCache.GetStats().hitCount != hitCount;
+			};
+		m_callHit = compileAndCheckHit([&] () { return CompileCall(jitter, reinterpret_cast<void*>(&SecondRunFunction)); }, m_callCode);
+		m_addHit = compileAndCheckHit([&] () { return CompileAdd(jitter); }, m_addCode);
+		m_unnamedCallHit = compileAndCheckHit([&] () { return CompileCall(jitter, reinterpret_cast<void*>(&UnnamedFunction)); }, m_unnamedCallCode);
+		jitter.SetCodeCache(nullptr);
+	}
+
+	//Entries referring to symbols that weren't added can't be used
+	{
+		Jitter::CCodeCache codeCache;
+		cacheStream.Seek(0, Framework::STREAM_SEEK_SET);
+		m_loadedWithoutSymbolCount = codeCache.Load(cacheStream);
+	}
+
+	{
+		Jitter::CCodeCache codeCache;
+		Framework::CMemStream invalidStream;
+		invalidStream.Write32(0);
+		invalidStream.Seek(0, Framework::STREAM_SEEK_SET);
+		try
+		{
+			codeCache.Load(invalidStream);
+		}
+		catch(const std::runtime_error&)
+		{
+			m_invalidFileThrew = true;
+		}
+	}
+}
+
+void CCodeCachePersistenceTest::Run()
+{
+	//Code calling a function that isn't an external symbol isn't saved
+	TEST_VERIFY(m_loadedCount == (g_callsRelocatable ? 2 : 1));
+	TEST_VERIFY(m_loadedWithoutSymbolCount == 1);
+	TEST_VERIFY(m_callHit == g_callsRelocatable);
+	TEST_VERIFY(m_addHit);
+	TEST_VERIFY(!m_unnamedCallHit);
+	TEST_VERIFY(m_invalidFileThrew);
+
+	TEST_VERIFY(RunFunction(m_callCode, 5) == SecondRunFunction(5));
+	TEST_VERIFY(RunFunction(m_addCode, 5) == 7);
+	TEST_VERIFY(RunFunction(m_unnamedCallCode, 5) == UnnamedFunction(5));
+}
+
+uint32 CCodeCachePersistenceTest::FirstRunFunction(uint32 value)
+{
+	return value + 1;
+}
+
+uint32 CCodeCachePersistenceTest::SecondRunFunction(uint32 value)
+{
+	return value * 3;
+}
+
+uint32 CCodeCachePersistenceTest::UnnamedFunction(uint32 value)
+{
+	return value ^ 0x10;
+}
+
+CCodeCachePersistenceTest::CodeBuffer CCodeCachePersistenceTest::CompileCall(Jitter::CJitter& jitter, void* function)
+{
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+
+	jitter.Begin();
+	{
+		jitter.PushRel(offsetof(CONTEXT, input));
+		jitter.Call(function, 1, Jitter::CJitter::RETURN_VALUE_32);
+		jitter.PullRel(offsetof(CONTEXT, result));
+	}
+	jitter.End();
+
+	jitter.SetStream(nullptr);
+
+	auto codeBuffer = codeStream.GetBuffer();
+	return CodeBuffer(codeBuffer, codeBuffer + codeStream.GetSize());
+}
+
+CCodeCachePersistenceTest::CodeBuffer CCodeCachePersistenceTest::CompileAdd(Jitter::CJitter& jitter)
+{
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+
+	jitter.Begin();
+	{
+		jitter.PushRel(offsetof(CONTEXT, input));
+		jitter.PushCst(2);
+		jitter.Add();
+		jitter.PullRel(offsetof(CONTEXT, result));
+	}
+	jitter.End();
+
+	jitter.SetStream(nullptr);
+
+	auto codeBuffer = codeStream.GetBuffer();
+	return CodeBuffer(codeBuffer, codeBuffer + codeStream.GetSize());
+}
+
+uint32 CCodeCachePersistenceTest::RunFunction(const CodeBuffer& code, uint32 input)
+{
+	CMemoryFunction function(code.data(), code.size());
+
+	CONTEXT context;
+	memset(&context, 0, sizeof(context));
+	context.input = input;
+	function(&context);
+	return context.result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+#include "MemoryFunction.h"
+#include "Jitter_CodeCache.h"
+
+class CCodeCachePersistenceTest : public CTest
+{
+public:
+	void						Run() override;
+	void						Compile(Jitter::CJitter&) override;
+
+private:
+	struct CONTEXT
+	{
+		uint32		input;
+		uint32		result;
+	};
+
+	typedef std::vector<uint8> CodeBuffer;
+
+	static uint32				FirstRunFunction(uint32);
+	static uint32				SecondRunFunction(uint32);
+	static uint32				UnnamedFunction(uint32);
+
+	static CodeBuffer			CompileCall(Jitter::CJitter&, void*);
+	static CodeBuffer			CompileAdd(Jitter::CJitter&);
+	static uint32				RunFunction(const CodeBuffer&, uint32);
+
+	unsigned int				m_loadedCount = 0;
+	unsigned int				m_loadedWithoutSymbolCount = 0;
+	bool						m_callHit = false;
+	bool						m_addHit = false;
+	bool						m_unnamedCallHit = false;
+	bool						m_invalidFileThrew = false;
+	CodeBuffer					m_callCode;
+	CodeBuffer					m_addCode;
+	CodeBuffer					m_unnamedCallCode;
+};
@@ -0,0 +1,113 @@
+#include "CodeCacheTest.h"
+#include "MemStream.h"
+#include "offsetof_def.h"
+
+void CCodeCacheTest::Compile(Jitter::CJitter& jitter)
+{
+	m_uncachedCode = CompileFunction(jitter, 2);
+
+	//Room for two functions
+	Jitter::CCodeCache codeCache(2);
+	jitter.SetCodeCache(&codeCache);
+
+	auto compileAndCheckHit =
+		[&] (uint32 value, CodeBuffer* code)
+		{
+			auto hitCount = codeCache.GetStats().hitCount;
+			auto result = CompileFunction(jitter, value);
+			if(code) *code = std::move(result);
+			return codeCache.GetStats().hitCount != hitCount;
+		};
+
+	m_firstCompileHit = compileAndCheckHit(2, &m_firstCode);
+	m_secondCompileHit = compileAndCheckHit(2, &m_secondCode);
+	m_otherCompileHit = compileAndCheckHit(3, &m_otherCode);
+
+	//Cache holds 3 then 2, touching 2 makes 3 the least recently used
+	m_touchedCompileHit = compileAndCheckHit(2, nullptr);
+	m_evictingCompileHit = compileAndCheckHit(4, nullptr);
+	m_touchedAfterEvictionHit = compileAndCheckHit(2, nullptr);
+	m_evictedAfterEvictionHit = compileAndCheckHit(3, nullptr);
+
+	m_stats = codeCache.GetStats();
+
+	jitter.SetCodeCache(nullptr);
+
+	{
+		Jitter::StatementList statements;
+		auto key1 = codeCache.MakeKey(statements, 0, 1);
+		auto key2 = codeCache.MakeKey(statements, 0, 2);
+		m_configurationChangesKey = (key1 != key2) && (Jitter::CCodeCache::HashKey(key1) != Jitter::CCodeCache::HashKey(key2));
+	}
+}
+
+void CCodeCacheTest::Run()
+{
+	TEST_VERIFY(!m_firstCompileHit);
+	TEST_VERIFY(m_secondCompileHit);
+	TEST_VERIFY(!m_otherCompileHit);
+	TEST_VERIFY(m_touchedCompileHit);
+	TEST_VERIFY(!m_evictingCompileHit);
+	TEST_VERIFY(m_touchedAfterEvictionHit);
+	TEST_VERIFY(!m_evictedAfterEvictionHit);
+	TEST_VERIFY(m_configurationChangesKey);
+
+	TEST_VERIFY(m_stats.hitCount == 3);
+	TEST_VERIFY(m_stats.missCount == 4);
+	TEST_VERIFY(m_stats.evictionCount == 2);
+	TEST_VERIFY(m_stats.entryCount == 2);
+
+	//Cached code is the same as the code generated without cache
+	TEST_VERIFY(m_firstCode == m_uncachedCode);
+	TEST_VERIFY(m_secondCode == m_uncachedCode);
+	TEST_VERIFY(m_otherCode != m_uncachedCode);
+
+	VerifyFunction(m_firstCode, 2);
+	VerifyFunction(m_secondCode, 2);
+	VerifyFunction(m_otherCode, 3);
+}
+
+CCodeCacheTest::CodeBuffer CCodeCacheTest::CompileFunction(Jitter::CJitter& jitter, uint32 value)
+{
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+
+	jitter.Begin();
+	{
+		jitter.PushCst(0);
+		jitter.PullRel(offsetof(CONTEXT, result));
+
+		jitter.PushRel(offsetof(CONTEXT, input));
+		jitter.PushCst(0);
+
+		jitter.BeginIf(Jitter::CONDITION_NE);
+		{
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushCst(value);
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, result));
+		}
+		jitter.EndIf();
+	}
+	jitter.End();
+
+	jitter.SetStream(nullptr);
+
+	auto codeBuffer = codeStream.GetBuffer();
+	return CodeBuffer(codeBuffer, codeBuffer + codeStream.GetSize());
+}
+
+void CCodeCacheTest::VerifyFunction(const CodeBuffer& code, uint32 value)
+{
+	CMemoryFunction function(code.data(), code.size());
+
+	CONTEXT context;
+	memset(&context, 0, sizeof(context));
+	context.input = 5;
+	function(&context);
+	TEST_VERIFY(context.result == (5 + value));
+
+	context.input = 0;
+	function(&context);
+	TEST_VERIFY(context.result == 0);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+#include "MemoryFunction.h"
+#include "Jitter_CodeCache.h"
+
+class CCodeCacheTest : public CTest
+{
+public:
+	void						Run() override;
+	void						Compile(Jitter::CJitter&) override;
+
+private:
+	struct CONTEXT
+	{
+		uint32		input;
+		uint32		result;
+	};
+
+	typedef std::vector<uint8> CodeBuffer;
+
+	static CodeBuffer			CompileFunction(Jitter::CJitter&, uint32);
+	static void					VerifyFunction(const CodeBuffer&, uint32);
+
+	Jitter::CCodeCache::STATS	m_stats;
+	CodeBuffer					m_uncachedCode;
+	CodeBuffer					m_firstCode;
+	CodeBuffer					m_secondCode;
+	CodeBuffer					m_otherCode;
+	bool						m_firstCompileHit = false;
+	bool						m_secondCompileHit = false;
+	bool						m_otherCompileHit = false;
+	bool						m_touchedCompileHit = false;
+	bool						m_evictingCompileHit = false;
+	bool						m_touchedAfterEvictionHit = false;
+	bool						m_evictedAfterEvictionHit = false;
+	bool						m_configurationChangesKey = false;
+};
@@ -0,0 +1,129 @@
+#include "CodeHeapTest.h"
+#include <cstdio>
+#include "MemStream.h"
+#include "offsetof_def.h"
+#include "Jitter_CompileStats.h"
+
+void CCodeHeapTest::EmitCode(Jitter::CJitter& jitter, uint32 constant)
+{
+	jitter.Begin();
+	{
+		jitter.PushRel(offsetof(CONTEXT, value));
+		jitter.PushCst(constant);
+		jitter.Add();
+		jitter.PullRel(offsetof(CONTEXT, result));
+	}
+	jitter.End();
+}
+
+void CCodeHeapTest::Compile(Jitter::CJitter& jitter)
+{
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter, 0x1000 * (i + 1));
+		m_code[i] = std::vector<uint8>(codeStream.GetBuffer(), codeStream.GetBuffer() + codeStream.GetSize());
+	}
+
+	uint64 mapTime = 0;
+	{
+		auto startTime = Jitter::CCompileStats::GetTimestamp();
+		FunctionArray functions;
+		functions.reserve(FUNCTION_COUNT);
+		for(unsigned int i = 0; i < FUNCTION_COUNT; i++)
+		{
+			functions.emplace_back(m_code[0].data(), m_code[0].size());
+		}
+		functions.clear();
+		mapTime = Jitter::CCompileStats::GetTimestamp() - startTime;
+	}
+
+	uint64 heapTime = 0;
+	{
+		auto startTime = Jitter::CCompileStats::GetTimestamp();
+		CCodeHeap::CFlushBatch flushBatch(m_heap);
+		m_functions.reserve(FUNCTION_COUNT);
+		for(unsigned int i = 0; i < FUNCTION_COUNT; i++)
+		{
+			m_functions.emplace_back(m_code[i & 1].data(), m_code[i & 1].size(), m_heap);
+		}
+		heapTime = Jitter::CCompileStats::GetTimestamp() - startTime;
+	}
+
+	auto stats = m_heap.GetStats();
+	printf("CodeHeapTest: creating %d functions took %d us with one mapping each, %d us with a code heap (%d regions, %d bytes used).\r\n",
+		FUNCTION_COUNT, static_cast<int>(mapTime / 1000), static_cast<int>(heapTime / 1000),
+		static_cast<int>(stats.regionCount), static_cast<int>(stats.allocatedSize));
+}
+
+void CCodeHeapTest::Run()
+{
+	{
+		auto stats = m_heap.GetStats();
+		TEST_VERIFY(stats.allocationCount == FUNCTION_COUNT);
+		TEST_VERIFY(stats.allocatedSize == FUNCTION_COUNT * CCodeHeap::GetAllocationSize(m_code[0].size()));
+		TEST_VERIFY(stats.freeSize == 0);
+	}
+
+	for(unsigned int i = 0; i < FUNCTION_COUNT; i++)
+	{
+		CONTEXT context;
+		context.value = i;
+		context.result = 0;
+		m_functions[i](&context);
+		TEST_VERIFY(context.result == (i + 0x1000 * ((i & 1) + 1)));
+	}
+
+	//Free half of the functions, their blocks should be reused by new ones
+	for(unsigned int i = 0; i < FUNCTION_COUNT; i += 2)
+	{
+		m_functions[i] = CMemoryFunction();
+	}
+
+	{
+		auto stats = m_heap.GetStats();
+		TEST_VERIFY(stats.allocationCount == FUNCTION_COUNT / 2);
+		TEST_VERIFY(stats.freeSize != 0);
+	}
+
+	auto regionCount = m_heap.GetStats().regionCount;
+	for(unsigned int i = 0; i < FUNCTION_COUNT; i += 2)
+	{
+		m_functions[i] = CMemoryFunction(m_code[1].data(), m_code[1].size(), m_heap);
+	}
+
+	{
+		auto stats = m_heap.GetStats();
+		TEST_VERIFY(stats.allocationCount == FUNCTION_COUNT);
+		TEST_VERIFY(stats.freeSize == 0);
+		TEST_VERIFY(stats.regionCount == regionCount);
+	}
+
+	for(unsigned int i = 0; i < FUNCTION_COUNT; i++)
+	{
+		CONTEXT context;
+		context.value = i;
+		context.result = 0;
+		m_functions[i](&context);
+		TEST_VERIFY(context.result == (i + 0x2000));
+	}
+
+	//Functions larger than the biggest size class get their own mapping
+	{
+		std::vector<uint8> largeCode(0x20000, 0xC3);
+		std::copy(m_code[0].begin(), m_code[0].end(), largeCode.begin());
+		CMemoryFunction largeFunction(largeCode.data(), largeCode.size(), m_heap);
+		TEST_VERIFY(m_heap.GetStats().regionCount == (regionCount + 1));
+
+		CONTEXT context;
+		context.value = 1;
+		context.result = 0;
+		largeFunction(&context);
+		TEST_VERIFY(context.result == 0x1001);
+	}
+	TEST_VERIFY(m_heap.GetStats().regionCount == regionCount);
+
+	m_functions.clear();
+	TEST_VERIFY(m_heap.GetStats().allocationCount == 0);
+}
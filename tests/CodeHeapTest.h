@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+#include "MemoryFunction.h"
+#include "CodeHeap.h"
+
+//Creates many small functions sharing a code heap and checks that they run and that freed blocks are reused
+class CCodeHeapTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		FUNCTION_COUNT = 0x400,
+	};
+
+	struct CONTEXT
+	{
+		uint32		value;
+		uint32		result;
+	};
+
+	typedef std::vector<CMemoryFunction> FunctionArray;
+
+	static void			EmitCode(Jitter::CJitter&, uint32);
+
+	std::vector<uint8>	m_code[2];
+	CCodeHeap			m_heap;
+	FunctionArray		m_functions;
+};
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <vector>
+#include "CodeSizeStatsTest.h"
+#include "MemStream.h"
+
+uint32 CCodeSizeStatsTest::Triple(uint32 value)
+{
+	return value * 3;
+}
+
+void CCodeSizeStatsTest::Compile(Jitter::CJitter& jitter)
+{
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+	jitter.SetCompileStatsEnabled(true);
+	jitter.ResetCompileStats();
+
+	jitter.Begin();
+	{
+		jitter.PushRel(offsetof(CONTEXT, input));
+		jitter.PushCst(0x10);
+
+		jitter.BeginIf(Jitter::CONDITION_BL);
+		{
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.Call(reinterpret_cast<void*>(&CCodeSizeStatsTest::Triple), 1, Jitter::CJitter::RETURN_VALUE_32);
+			jitter.PullRel(offsetof(CONTEXT, result));
+		}
+		jitter.Else();
+		{
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushCst(0x10);
+			jitter.Sub();
+			jitter.PullRel(offsetof(CONTEXT, result));
+		}
+		jitter.EndIf();
+	}
+	jitter.End();
+
+	m_stats = jitter.GetLastCompileStats();
+	m_codeSize = codeStream.GetSize();
+	jitter.SetCompileStatsEnabled(false);
+
+	m_function = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+}
+
+void CCodeSizeStatsTest::Run()
+{
+	const auto& codeStats = m_stats.code;
+
+	//Every emitted byte belongs to exactly one category
+	TEST_VERIFY(codeStats.totalBytes == m_codeSize);
+	uint64 categoryTotal = 0;
+	for(const auto& categoryBytes : codeStats.categoryBytes)
+	{
+		categoryTotal += categoryBytes;
+	}
+	TEST_VERIFY(categoryTotal == m_codeSize);
+
+	TEST_VERIFY(codeStats.categoryBytes[CAssemblerStats::CATEGORY_PROLOG] != 0);
+	TEST_VERIFY(codeStats.categoryBytes[CAssemblerStats::CATEGORY_EPILOG] != 0);
+	TEST_VERIFY(codeStats.categoryInstructionCounts[CAssemblerStats::CATEGORY_CALL] == 1);
+
+	//Conditional jump to the else block and jump over it
+	uint64 jumpCount =
+		codeStats.categoryInstructionCounts[CAssemblerStats::CATEGORY_JUMP_SHORT] +
+		codeStats.categoryInstructionCounts[CAssemblerStats::CATEGORY_JUMP_NEAR];
+	TEST_VERIFY(jumpCount >= 2);
+
+	//Everything that's not prolog, epilog or literal pool comes from a statement
+	uint64 operationTotal = 0;
+	for(const auto& operationStats : codeStats.operations)
+	{
+		operationTotal += operationStats.bytes;
+	}
+	uint64 unattributedTotal =
+		codeStats.categoryBytes[CAssemblerStats::CATEGORY_PROLOG] +
+		codeStats.categoryBytes[CAssemblerStats::CATEGORY_EPILOG] +
+		codeStats.categoryBytes[CAssemblerStats::CATEGORY_LITERALPOOL];
+	TEST_VERIFY((operationTotal + unattributedTotal) == m_codeSize);
+
+	const auto& callStats = codeStats.operations[Jitter::OP_CALL];
+	TEST_VERIFY(callStats.statementCount == 1);
+	TEST_VERIFY(callStats.bytes >= codeStats.categoryBytes[CAssemblerStats::CATEGORY_CALL]);
+	TEST_VERIFY(codeStats.operations[Jitter::OP_CONDJMP].bytes != 0);
+
+	{
+		std::vector<unsigned int> operations;
+		for(unsigned int op = 0; op < Jitter::OP_MAX; op++)
+		{
+			if(codeStats.operations[op].bytes != 0) operations.push_back(op);
+		}
+		std::sort(operations.begin(), operations.end(),
+			[&] (unsigned int op1, unsigned int op2) { return codeStats.operations[op1].bytes > codeStats.operations[op2].bytes; });
+		printf("CodeSizeStatsTest: %d bytes (prolog %d, epilog %d, spill %d, reload %d, calls %d, jumps %d short/%d near), most expensive operation: %d (%d bytes over %d statements).\r\n",
+			static_cast<int>(m_codeSize),
+			static_cast<int>(codeStats.categoryBytes[CAssemblerStats::CATEGORY_PROLOG]),
+			static_cast<int>(codeStats.categoryBytes[CAssemblerStats::CATEGORY_EPILOG]),
+			static_cast<int>(codeStats.categoryBytes[CAssemblerStats::CATEGORY_SPILL]),
+			static_cast<int>(codeStats.categoryBytes[CAssemblerStats::CATEGORY_RELOAD]),
+			static_cast<int>(codeStats.categoryBytes[CAssemblerStats::CATEGORY_CALL]),
+			static_cast<int>(codeStats.categoryInstructionCounts[CAssemblerStats::CATEGORY_JUMP_SHORT]),
+			static_cast<int>(codeStats.categoryInstructionCounts[CAssemblerStats::CATEGORY_JUMP_NEAR]),
+			operations[0],
+			static_cast<int>(codeStats.operations[operations[0]].bytes),
+			static_cast<int>(codeStats.operations[operations[0]].statementCount));
+	}
+
+	CONTEXT context;
+	memset(&context, 0, sizeof(context));
+	context.input = 5;
+	m_function(&context);
+	TEST_VERIFY(context.result == 15);
+
+	context.input = 0x20;
+	m_function(&context);
+	TEST_VERIFY(context.result == 0x10);
+}
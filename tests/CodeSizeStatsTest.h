@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+class CCodeSizeStatsTest : public CTest
+{
+public:
+	void						Run() override;
+	void						Compile(Jitter::CJitter&) override;
+
+private:
+	struct CONTEXT
+	{
+		uint32		input;
+		uint32		result;
+	};
+
+	static uint32				Triple(uint32);
+
+	Jitter::CCompileStats::STATS	m_stats;
+	uint64						m_codeSize = 0;
+	CMemoryFunction				m_function;
+};
@@ -0,0 +1,138 @@
+#include "CompilePoolTest.h"
+#include <cstdio>
+#include <stdexcept>
+#include "Jitter_CompilePool.h"
+#include "Jitter_CompileStats.h"
+
+void CCompilePoolTest::EmitCode(Jitter::CJitter& jitter, uint32 constant)
+{
+	jitter.PushRel(offsetof(CONTEXT, value));
+	jitter.PullRel(offsetof(CONTEXT, result));
+
+	for(uint32 i = 0; i < STEP_COUNT; i++)
+	{
+		jitter.PushRel(offsetof(CONTEXT, result));
+		jitter.PushCst(i);
+		jitter.BeginIf(Jitter::CONDITION_LT);
+		{
+			jitter.PushRel(offsetof(CONTEXT, result));
+			jitter.PushCst(constant + i);
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, result));
+		}
+		jitter.Else();
+		{
+			jitter.PushRel(offsetof(CONTEXT, result));
+			jitter.PushCst(constant);
+			jitter.Xor();
+			jitter.PullRel(offsetof(CONTEXT, result));
+		}
+		jitter.EndIf();
+	}
+}
+
+uint32 CCompilePoolTest::ComputeResult(uint32 value, uint32 constant)
+{
+	uint32 result = value;
+	for(uint32 i = 0; i < STEP_COUNT; i++)
+	{
+		if(result < i)
+		{
+			result += constant + i;
+		}
+		else
+		{
+			result ^= constant;
+		}
+	}
+	return result;
+}
+
+void CCompilePoolTest::CompileFunctions(FunctionArray& functions, unsigned int workerCount)
+{
+	auto startTime = Jitter::CCompileStats::GetTimestamp();
+	{
+		Jitter::CCompilePool pool(workerCount, &m_heap);
+		TEST_VERIFY(pool.GetWorkerCount() == workerCount);
+
+		std::vector<std::future<CMemoryFunction>> futures;
+		futures.reserve(FUNCTION_COUNT);
+		for(uint32 i = 0; i < FUNCTION_COUNT; i++)
+		{
+			futures.push_back(pool.Submit([i] (Jitter::CJitter& jitter) { EmitCode(jitter, i); }));
+		}
+		pool.Wait();
+
+		functions.reserve(FUNCTION_COUNT);
+		for(auto& future : futures)
+		{
+			functions.push_back(future.get());
+		}
+	}
+	auto elapsed = Jitter::CCompileStats::GetTimestamp() - startTime;
+	printf("CompilePoolTest: compiling %d functions with %d worker(s) took %d us.\r\n",
+		FUNCTION_COUNT, workerCount, static_cast<int>(elapsed / 1000));
+}
+
+void CCompilePoolTest::Compile(Jitter::CJitter&)
+{
+	CompileFunctions(m_functions[0], 1);
+	CompileFunctions(m_functions[1], MAX_WORKER_COUNT);
+
+	//Exceptions thrown by builders are forwarded to the future and the worker keeps going
+	{
+		Jitter::CCompilePool pool(1);
+		auto failedFuture = pool.Submit(
+			[] (Jitter::CJitter& jitter)
+			{
+				jitter.PushCst(0);
+				throw std::runtime_error("Builder failed.");
+			});
+		auto future = pool.Submit([] (Jitter::CJitter& jitter) { EmitCode(jitter, 0x1234); });
+		try
+		{
+			failedFuture.get();
+		}
+		catch(const std::runtime_error&)
+		{
+			m_failedBuilderThrew = true;
+		}
+		auto function = future.get();
+		CONTEXT context = {};
+		context.value = 0x10;
+		function(&context);
+		m_poolRecovered = (context.result == ComputeResult(0x10, 0x1234));
+	}
+}
+
+void CCompilePoolTest::Run()
+{
+	TEST_VERIFY(m_failedBuilderThrew);
+	TEST_VERIFY(m_poolRecovered);
+
+	for(const auto& functions : m_functions)
+	{
+		TEST_VERIFY(functions.size() == FUNCTION_COUNT);
+	}
+
+	for(uint32 i = 0; i < FUNCTION_COUNT; i++)
+	{
+		for(auto& functions : m_functions)
+		{
+			CONTEXT context;
+			context.value = i * 3;
+			context.result = 0;
+			functions[i](&context);
+			TEST_VERIFY(context.result == ComputeResult(i * 3, i));
+		}
+	}
+
+	//Both pools should produce the same code
+	for(uint32 i = 0; i < FUNCTION_COUNT; i++)
+	{
+		const auto& function0 = m_functions[0][i];
+		const auto& function1 = m_functions[1][i];
+		TEST_VERIFY(function0.GetSize() == function1.GetSize());
+		TEST_VERIFY(memcmp(function0.GetCode(), function1.GetCode(), function0.GetSize()) == 0);
+	}
+}
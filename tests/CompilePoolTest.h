@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+#include "MemoryFunction.h"
+#include "CodeHeap.h"
+
+//Compiles the same set of functions with pools of different sizes and checks that all of them run properly
+class CCompilePoolTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		FUNCTION_COUNT = 0x100,
+		STEP_COUNT = 0x20,
+		MAX_WORKER_COUNT = 4,
+	};
+
+	struct CONTEXT
+	{
+		uint32		value;
+		uint32		result;
+	};
+
+	typedef std::vector<CMemoryFunction> FunctionArray;
+
+	static void			EmitCode(Jitter::CJitter&, uint32);
+	static uint32		ComputeResult(uint32, uint32);
+
+	void				CompileFunctions(FunctionArray&, unsigned int);
+
+	CCodeHeap			m_heap;
+	FunctionArray		m_functions[2];
+	bool				m_failedBuilderThrew = false;
+	bool				m_poolRecovered = false;
+};
@@ -0,0 +1,95 @@
+#include "CompileStatsTest.h"
+#include "MemStream.h"
+#include "offsetof_def.h"
+
+void CCompileStatsTest::Compile(Jitter::CJitter& jitter)
+{
+	jitter.SetCompileStatsEnabled(true);
+	jitter.ResetCompileStats();
+
+	for(unsigned int i = 0; i < COMPILE_COUNT; i++)
+	{
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+
+		jitter.Begin();
+		{
+			jitter.PushCst(0);
+			jitter.PullRel(offsetof(CONTEXT, result));
+
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushCst(0);
+
+			jitter.BeginIf(Jitter::CONDITION_NE);
+			{
+				jitter.PushRel(offsetof(CONTEXT, input));
+				jitter.PushCst(2);
+				jitter.Add();
+				jitter.PullRel(offsetof(CONTEXT, result));
+			}
+			jitter.EndIf();
+		}
+		jitter.End();
+
+		m_function = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	}
+
+	m_lastStats = jitter.GetLastCompileStats();
+	m_aggregateStats = jitter.GetCompileStats();
+
+	jitter.SetCompileStatsEnabled(false);
+	m_enabledAfterDisable = jitter.IsCompileStatsEnabled();
+}
+
+void CCompileStatsTest::Run()
+{
+	TEST_VERIFY(!m_enabledAfterDisable);
+
+	TEST_VERIFY(m_lastStats.compileCount == 1);
+	TEST_VERIFY(m_aggregateStats.compileCount == COMPILE_COUNT);
+	TEST_VERIFY(GetHistogramTotal(m_aggregateStats.timeHistogram) == COMPILE_COUNT);
+	TEST_VERIFY(m_aggregateStats.totalTime >= m_lastStats.totalTime);
+
+	for(unsigned int i = 0; i < Jitter::CCompileStats::PASS_MAX; i++)
+	{
+		const auto& lastPass = m_lastStats.passes[i];
+		const auto& aggregatePass = m_aggregateStats.passes[i];
+		TEST_VERIFY(lastPass.runCount != 0);
+		TEST_VERIFY(aggregatePass.runCount == (lastPass.runCount * COMPILE_COUNT));
+		TEST_VERIFY(GetHistogramTotal(aggregatePass.timeHistogram) == aggregatePass.runCount);
+		TEST_VERIFY(aggregatePass.maxTime <= m_aggregateStats.maxTime);
+	}
+
+	//Block pruning/merging should leave a single block with all statements
+	const auto& mergeStats = m_lastStats.passes[Jitter::CCompileStats::PASS_MERGEBLOCKS];
+	TEST_VERIFY(mergeStats.statementsBefore != 0);
+	TEST_VERIFY(mergeStats.symbolsBefore != 0);
+
+	//Passes working on statement lists count the symbols used by their statements
+	const auto& propagationStats = m_lastStats.passes[Jitter::CCompileStats::PASS_CONSTANTPROPAGATION];
+	TEST_VERIFY(propagationStats.symbolsBefore != 0);
+	TEST_VERIFY(propagationStats.symbolsAfter != 0);
+
+	//Code generation covers all statements
+	const auto& generateStats = m_lastStats.passes[Jitter::CCompileStats::PASS_GENERATECODE];
+	TEST_VERIFY(generateStats.runCount == 1);
+	TEST_VERIFY(generateStats.statementsBefore != 0);
+	TEST_VERIFY(generateStats.symbolsBefore != 0);
+	TEST_VERIFY(generateStats.totalTime >= m_lastStats.passes[Jitter::CCompileStats::PASS_ASSEMBLEREND].totalTime);
+
+	CONTEXT context;
+	memset(&context, 0, sizeof(context));
+	context.input = 5;
+	m_function(&context);
+	TEST_VERIFY(context.result == 7);
+}
+
+uint64 CCompileStatsTest::GetHistogramTotal(const Jitter::CCompileStats::Histogram& histogram)
+{
+	uint64 total = 0;
+	for(const auto& bucket : histogram)
+	{
+		total += bucket;
+	}
+	return total;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+class CCompileStatsTest : public CTest
+{
+public:
+	void						Run() override;
+	void						Compile(Jitter::CJitter&) override;
+
+private:
+	struct CONTEXT
+	{
+		uint32		input;
+		uint32		result;
+	};
+
+	enum
+	{
+		COMPILE_COUNT = 2,
+	};
+
+	static uint64				GetHistogramTotal(const Jitter::CCompileStats::Histogram&);
+
+	Jitter::CCompileStats::STATS	m_lastStats;
+	Jitter::CCompileStats::STATS	m_aggregateStats;
+	bool						m_enabledAfterDisable = false;
+	CMemoryFunction				m_function;
+};
@@ -0,0 +1,151 @@
+#include "ContextPureCallTest.h"
+#include <cstdio>
+#include "MemStream.h"
+
+uint32 CContextPureCallTest::Mix(uint32 x, uint32 y)
+{
+	return (x * 3) + (y >> 1);
+}
+
+void CContextPureCallTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		for(unsigned int i = 0; i < ITERATION_COUNT; i++)
+		{
+			bool lastIteration = (i == (ITERATION_COUNT - 1));
+			if(lastIteration)
+			{
+				//Vector computed before a call and stored after it
+				jitter.MD_PushRel(offsetof(CONTEXT, vector0));
+				jitter.MD_PushRel(offsetof(CONTEXT, vector1));
+				jitter.MD_AddW();
+			}
+
+			//sum += a; b ^= sum; a += Mix(sum, b);
+			jitter.PushRel(offsetof(CONTEXT, sum));
+			jitter.PushRel(offsetof(CONTEXT, a));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, sum));
+
+			jitter.PushRel(offsetof(CONTEXT, b));
+			jitter.PushRel(offsetof(CONTEXT, sum));
+			jitter.Xor();
+			jitter.PullRel(offsetof(CONTEXT, b));
+
+			jitter.PushRel(offsetof(CONTEXT, sum));
+			jitter.PushRel(offsetof(CONTEXT, b));
+			jitter.Call(reinterpret_cast<void*>(&CContextPureCallTest::Mix), 2, Jitter::CJitter::RETURN_VALUE_32);
+			jitter.PushRel(offsetof(CONTEXT, a));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, a));
+
+			if(i == BRANCH_ITERATION)
+			{
+				//Splits the function in many blocks to involve global registers
+				jitter.PushRel(offsetof(CONTEXT, a));
+				jitter.PushCst(1);
+				jitter.And();
+				jitter.PushCst(0);
+				jitter.BeginIf(Jitter::CONDITION_NE);
+				{
+					jitter.PushRel(offsetof(CONTEXT, count));
+					jitter.PushCst(1);
+					jitter.Add();
+					jitter.PullRel(offsetof(CONTEXT, count));
+				}
+				jitter.EndIf();
+			}
+
+			if(lastIteration)
+			{
+				jitter.MD_PullRel(offsetof(CONTEXT, mdResult));
+			}
+		}
+	}
+	jitter.End();
+}
+
+void CContextPureCallTest::Compile(Jitter::CJitter& jitter)
+{
+	jitter.SetCompileStatsEnabled(true);
+
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		bool contextPure = (i == 0);
+		if(contextPure)
+		{
+			jitter.DeclareContextPureFunction(reinterpret_cast<void*>(&CContextPureCallTest::Mix));
+		}
+
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter);
+		m_functions[i] = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+
+		const auto& codeStats = jitter.GetLastCompileStats().code;
+		m_memoryBytes[i] =
+			codeStats.categoryBytes[CAssemblerStats::CATEGORY_SPILL] +
+			codeStats.categoryBytes[CAssemblerStats::CATEGORY_RELOAD];
+
+		jitter.ClearContextPureFunctions();
+	}
+
+	jitter.SetCompileStatsEnabled(false);
+
+	printf("ContextPureCallTest: spill and reload code went from %d to %d bytes.\r\n",
+		static_cast<int>(m_memoryBytes[1]), static_cast<int>(m_memoryBytes[0]));
+}
+
+void CContextPureCallTest::InitContext(CONTEXT& context)
+{
+	memset(&context, 0, sizeof(CONTEXT));
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		context.vector0[i] = 0x10000 * (i + 1);
+		context.vector1[i] = 0x11 * (i + 1);
+	}
+	context.a = 0x1234;
+	context.b = 0x8765;
+	context.sum = 0x10;
+}
+
+void CContextPureCallTest::CheckContext(const CONTEXT& context)
+{
+	uint32 a = 0x1234;
+	uint32 b = 0x8765;
+	uint32 sum = 0x10;
+	uint32 count = 0;
+	for(unsigned int i = 0; i < ITERATION_COUNT; i++)
+	{
+		sum += a;
+		b ^= sum;
+		a += Mix(sum, b);
+		if((i == BRANCH_ITERATION) && (a & 1))
+		{
+			count++;
+		}
+	}
+
+	TEST_VERIFY(context.a == a);
+	TEST_VERIFY(context.b == b);
+	TEST_VERIFY(context.sum == sum);
+	TEST_VERIFY(context.count == count);
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		TEST_VERIFY(context.mdResult[i] == (context.vector0[i] + context.vector1[i]));
+	}
+}
+
+void CContextPureCallTest::Run()
+{
+	TEST_VERIFY(m_memoryBytes[0] < m_memoryBytes[1]);
+
+	for(auto& function : m_functions)
+	{
+		CONTEXT context;
+		InitContext(context);
+		function(&context);
+		CheckContext(context);
+	}
+}
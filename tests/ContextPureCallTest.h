@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Test.h"
+#include "Align16.h"
+#include "MemoryFunction.h"
+
+//Checks that values stay in registers across calls to context pure functions
+class CContextPureCallTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		ITERATION_COUNT = 6,
+		BRANCH_ITERATION = 2,
+	};
+
+	struct CONTEXT
+	{
+		ALIGN16
+
+		uint32			vector0[4];
+		uint32			vector1[4];
+		uint32			mdResult[4];
+
+		uint32			a;
+		uint32			b;
+		uint32			sum;
+		uint32			count;
+	};
+
+	static void			EmitCode(Jitter::CJitter&);
+	static uint32		Mix(uint32, uint32);
+
+	static void			InitContext(CONTEXT&);
+	static void			CheckContext(const CONTEXT&);
+
+	CMemoryFunction		m_functions[2];
+	uint64				m_memoryBytes[2] = {};
+};
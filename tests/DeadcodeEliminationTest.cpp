@@ -0,0 +1,84 @@
+#include "DeadcodeEliminationTest.h"
+#include <cstdio>
+#include "MemStream.h"
+
+void CDeadcodeEliminationTest::InitContext(CONTEXT& context)
+{
+	memset(&context, 0, sizeof(CONTEXT));
+	for(uint32 i = 0; i < VALUE_COUNT; i++)
+	{
+		context.values[i] = (i * 0x01010101) ^ 0x5A5A5A5A;
+	}
+	context.aliasHi = 0xCAFEBABE;
+}
+
+void CDeadcodeEliminationTest::Compile(Jitter::CJitter& jitter)
+{
+	jitter.SetCompileStatsEnabled(true);
+
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+
+	jitter.Begin();
+	{
+		for(uint32 i = 0; i < GROUP_COUNT; i++)
+		{
+			//Only the last store to each scratch slot survives
+			jitter.PushRel(offsetof(CONTEXT, values[i % VALUE_COUNT]));
+			jitter.PushCst(i);
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, scratch[i % SCRATCH_COUNT]));
+
+			//Intermediate accumulator values end up being dead once propagated
+			jitter.PushRel(offsetof(CONTEXT, accumulator));
+			jitter.PushRel(offsetof(CONTEXT, values[(i * 3) % VALUE_COUNT]));
+			jitter.Xor();
+			jitter.PushCst(i);
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, accumulator));
+		}
+
+		//Store overwritten later, but read through an aliasing 64-bit symbol before that
+		jitter.PushCst(0x12345678);
+		jitter.PullRel(offsetof(CONTEXT, aliasLo));
+		jitter.PushRel64(offsetof(CONTEXT, aliasLo));
+		jitter.PullRel64(offsetof(CONTEXT, copyLo));
+		jitter.PushCst(0x87654321);
+		jitter.PullRel(offsetof(CONTEXT, aliasLo));
+	}
+	jitter.End();
+
+	m_function = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	m_stats = jitter.GetLastCompileStats();
+
+	jitter.SetCompileStatsEnabled(false);
+
+	const auto& dcePass = m_stats.passes[Jitter::CCompileStats::PASS_DEADCODEELIMINATION];
+	printf("DeadcodeEliminationTest: %d statements in, dead code elimination ran %d times and took %d us, compilation took %d us.\r\n",
+		static_cast<int>(m_stats.passes[Jitter::CCompileStats::PASS_CONSTANTPROPAGATION].statementsBefore / m_stats.passes[Jitter::CCompileStats::PASS_CONSTANTPROPAGATION].runCount),
+		static_cast<int>(dcePass.runCount), static_cast<int>(dcePass.totalTime / 1000), static_cast<int>(m_stats.totalTime / 1000));
+}
+
+void CDeadcodeEliminationTest::Run()
+{
+	const auto& dcePass = m_stats.passes[Jitter::CCompileStats::PASS_DEADCODEELIMINATION];
+	TEST_VERIFY(dcePass.statementsAfter < dcePass.statementsBefore);
+
+	CONTEXT context;
+	InitContext(context);
+
+	CONTEXT expected;
+	InitContext(expected);
+	for(uint32 i = 0; i < GROUP_COUNT; i++)
+	{
+		expected.scratch[i % SCRATCH_COUNT] = expected.values[i % VALUE_COUNT] + i;
+		expected.accumulator = (expected.accumulator ^ expected.values[(i * 3) % VALUE_COUNT]) + i;
+	}
+	expected.copyLo = 0x12345678;
+	expected.copyHi = expected.aliasHi;
+	expected.aliasLo = 0x87654321;
+
+	m_function(&context);
+
+	TEST_VERIFY(memcmp(&context, &expected, sizeof(CONTEXT)) == 0);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+//Compiles a large basic block with lots of dead definitions and reports how long dead code elimination took
+class CDeadcodeEliminationTest : public CTest
+{
+public:
+	void						Run() override;
+	void						Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		GROUP_COUNT = 0x400,
+		VALUE_COUNT = 0x10,
+		SCRATCH_COUNT = 0x08,
+	};
+
+	struct CONTEXT
+	{
+		uint32		aliasLo;
+		uint32		aliasHi;
+		uint32		copyLo;
+		uint32		copyHi;
+		uint32		values[VALUE_COUNT];
+		uint32		scratch[SCRATCH_COUNT];
+		uint32		accumulator;
+	};
+
+	static void					InitContext(CONTEXT&);
+
+	Jitter::CCompileStats::STATS	m_stats;
+	CMemoryFunction				m_function;
+};
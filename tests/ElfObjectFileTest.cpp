@@ -0,0 +1,160 @@
+#include "ElfObjectFileTest.h"
+#include <cstdio>
+#include <cstdlib>
+#include "MemStream.h"
+#include "ElfObjectFile.h"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define ELFOBJECTFILETEST_SUPPORTED
+#include <dlfcn.h>
+#include <unistd.h>
+#ifdef __aarch64__
+#include "Jitter_CodeGen_AArch64.h"
+#endif
+#endif
+
+#define FUNCTION_SYMBOL_NAME		"ElfObjectFileTest_Function"
+#define TABLE_SYMBOL_NAME			"ElfObjectFileTest_FunctionTable"
+#define EXTERNAL_SYMBOL_NAME		"abs"
+
+void CElfObjectFileTest::Compile(Jitter::CJitter& jitter)
+{
+#ifdef ELFOBJECTFILETEST_SUPPORTED
+	if(system("cc --version > /dev/null 2>&1") != 0)
+	{
+		printf("ElfObjectFileTest: No system linker available, skipping.\r\n");
+		return;
+	}
+
+	auto externalFunction = reinterpret_cast<uintptr_t>(static_cast<int (*)(int)>(&abs));
+
+#ifdef __aarch64__
+	auto codeGen = static_cast<Jitter::CCodeGen_AArch64*>(jitter.GetCodeGen());
+	codeGen->SetGenerateRelocatableCalls(true);
+	auto objectFile = Jitter::CElfObjectFile(Jitter::CObjectFile::CPU_ARCH_ARM64);
+#else
+	auto objectFile = Jitter::CElfObjectFile(Jitter::CObjectFile::CPU_ARCH_X64);
+#endif
+	objectFile.AddExternalSymbol(EXTERNAL_SYMBOL_NAME, externalFunction);
+
+	Jitter::CObjectFile::INTERNAL_SYMBOL function;
+	function.name		= FUNCTION_SYMBOL_NAME;
+	function.location	= Jitter::CObjectFile::INTERNAL_SYMBOL_LOCATION_TEXT;
+
+	jitter.GetCodeGen()->SetExternalSymbolReferencedHandler(
+		[&] (uintptr_t symbol, uint32 offset, Jitter::CCodeGen::SYMBOL_REF_TYPE refType)
+		{
+			Jitter::CObjectFile::SYMBOL_REFERENCE reference;
+			reference.type			= Jitter::CObjectFile::SYMBOL_TYPE_EXTERNAL;
+			reference.symbolIndex	= objectFile.GetExternalSymbolIndexByValue(symbol);
+			reference.offset		= offset;
+			reference.refType		= refType;
+			function.symbolReferences.push_back(reference);
+		}
+	);
+
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+
+	//result = abs(value)
+	jitter.Begin();
+	{
+		jitter.PushRel(offsetof(CONTEXT, value));
+		jitter.Call(reinterpret_cast<void*>(externalFunction), 1, Jitter::CJitter::RETURN_VALUE_32);
+		jitter.PullRel(offsetof(CONTEXT, result));
+	}
+	jitter.End();
+
+	jitter.GetCodeGen()->SetExternalSymbolReferencedHandler(Jitter::CCodeGen::ExternalSymbolReferencedHandler());
+#ifdef __aarch64__
+	codeGen->SetGenerateRelocatableCalls(false);
+#endif
+
+	function.data = std::vector<uint8>(codeStream.GetBuffer(), codeStream.GetBuffer() + codeStream.GetSize());
+	uint32 functionIndex = objectFile.AddInternalSymbol(function);
+
+	//Table holding a pointer to the function, needs an internal relocation
+	Jitter::CObjectFile::INTERNAL_SYMBOL table;
+	table.name			= TABLE_SYMBOL_NAME;
+	table.location		= Jitter::CObjectFile::INTERNAL_SYMBOL_LOCATION_DATA;
+	table.data			= std::vector<uint8>(sizeof(uint64), 0);
+	{
+		Jitter::CObjectFile::SYMBOL_REFERENCE reference;
+		reference.type			= Jitter::CObjectFile::SYMBOL_TYPE_INTERNAL;
+		reference.symbolIndex	= functionIndex;
+		reference.offset		= 0;
+		table.symbolReferences.push_back(reference);
+	}
+	objectFile.AddInternalSymbol(table);
+
+	//Keep build outputs out of the working directory
+	{
+		const char* tmpDir = getenv("TMPDIR");
+		std::string directoryTemplate = std::string((tmpDir != nullptr) ? tmpDir : "/tmp") + "/ElfObjectFileTestXXXXXX";
+		TEST_VERIFY(mkdtemp(&directoryTemplate[0]) != nullptr);
+		m_directoryPath = directoryTemplate;
+	}
+	m_objectPath = m_directoryPath + "/ElfObjectFileTest.o";
+	m_libraryPath = m_directoryPath + "/ElfObjectFileTest.so";
+
+	{
+		Framework::CMemStream objectStream;
+		objectFile.Write(objectStream);
+		auto objectFileHandle = fopen(m_objectPath.c_str(), "wb");
+		TEST_VERIFY(objectFileHandle != nullptr);
+		fwrite(objectStream.GetBuffer(), objectStream.GetSize(), 1, objectFileHandle);
+		fclose(objectFileHandle);
+	}
+
+	//Absolute relocations in code require text relocations
+	auto command = "cc -shared -Wl,-z,notext -o " + m_libraryPath + " " + m_objectPath;
+	m_linked = (system(command.c_str()) == 0);
+	if(!m_linked)
+	{
+		Cleanup();
+	}
+	TEST_VERIFY(m_linked);
+#endif
+}
+
+void CElfObjectFileTest::Run()
+{
+#ifdef ELFOBJECTFILETEST_SUPPORTED
+	if(!m_linked) return;
+
+	auto library = dlopen(m_libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+	TEST_VERIFY(library != nullptr);
+
+	auto function = reinterpret_cast<FunctionType>(dlsym(library, FUNCTION_SYMBOL_NAME));
+	auto table = reinterpret_cast<FunctionType*>(dlsym(library, TABLE_SYMBOL_NAME));
+	TEST_VERIFY(function != nullptr);
+	TEST_VERIFY(table != nullptr);
+	TEST_VERIFY(table[0] == function);
+
+	{
+		CONTEXT context = {};
+		context.value = -1234;
+		function(&context);
+		TEST_VERIFY(context.result == 1234);
+	}
+
+	{
+		CONTEXT context = {};
+		context.value = -5678;
+		table[0](&context);
+		TEST_VERIFY(context.result == 5678);
+	}
+
+	dlclose(library);
+	Cleanup();
+#endif
+}
+
+void CElfObjectFileTest::Cleanup()
+{
+#ifdef ELFOBJECTFILETEST_SUPPORTED
+	remove(m_objectPath.c_str());
+	remove(m_libraryPath.c_str());
+	rmdir(m_directoryPath.c_str());
+#endif
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include "Test.h"
+
+//Writes a function and a function table in an ELF object file, links it with the system linker and calls it
+class CElfObjectFileTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	struct CONTEXT
+	{
+		int32		value;
+		int32		result;
+	};
+
+	typedef void (*FunctionType)(void*);
+
+	void				Cleanup();
+
+	bool				m_linked = false;
+	std::string			m_directoryPath;
+	std::string			m_objectPath;
+	std::string			m_libraryPath;
+};
@@ -0,0 +1,175 @@
+#include "FpRegAllocTest.h"
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include "MemStream.h"
+
+void CFpRegAllocTest::Callback(CONTEXT* context)
+{
+	context->callCount++;
+}
+
+void CFpRegAllocTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		//poly = ((x * a + b) * x + c) * x + d
+		jitter.FP_PushSingle(offsetof(CONTEXT, x));
+		jitter.FP_PushSingle(offsetof(CONTEXT, a));
+		jitter.FP_Mul();
+		jitter.FP_PushSingle(offsetof(CONTEXT, b));
+		jitter.FP_Add();
+		jitter.FP_PushSingle(offsetof(CONTEXT, x));
+		jitter.FP_Mul();
+		jitter.FP_PushSingle(offsetof(CONTEXT, c));
+		jitter.FP_Add();
+		jitter.FP_PushSingle(offsetof(CONTEXT, x));
+		jitter.FP_Mul();
+		jitter.FP_PushSingle(offsetof(CONTEXT, d));
+		jitter.FP_Add();
+		jitter.FP_PullSingle(offsetof(CONTEXT, poly));
+
+		//acc = acc * x - poly, written back every time
+		for(unsigned int i = 0; i < ACCUMULATE_COUNT; i++)
+		{
+			jitter.FP_PushSingle(offsetof(CONTEXT, acc));
+			jitter.FP_PushSingle(offsetof(CONTEXT, x));
+			jitter.FP_Mul();
+			jitter.FP_PushSingle(offsetof(CONTEXT, poly));
+			jitter.FP_Sub();
+			jitter.FP_PullSingle(offsetof(CONTEXT, acc));
+		}
+
+		//swap1 = swap0 - swap1, destination is also the second source
+		jitter.FP_PushSingle(offsetof(CONTEXT, swap0));
+		jitter.FP_PushSingle(offsetof(CONTEXT, swap1));
+		jitter.FP_Sub();
+		jitter.FP_PullSingle(offsetof(CONTEXT, swap1));
+
+		jitter.FP_PushWord(offsetof(CONTEXT, word));
+		jitter.FP_PullSingle(offsetof(CONTEXT, fromWord));
+
+		//Call splits the allocation ranges
+		jitter.PushCtx();
+		jitter.Call(reinterpret_cast<void*>(&CFpRegAllocTest::Callback), 1, Jitter::CJitter::RETURN_VALUE_NONE);
+
+		//unary = sqrt(abs(neg(fromWord)))
+		jitter.FP_PushSingle(offsetof(CONTEXT, fromWord));
+		jitter.FP_Neg();
+		jitter.FP_Abs();
+		jitter.FP_Sqrt();
+		jitter.FP_PullSingle(offsetof(CONTEXT, unary));
+
+		//recip = rcpl(x) + rsqrt(fromWord)
+		jitter.FP_PushSingle(offsetof(CONTEXT, x));
+		jitter.FP_Rcpl();
+		jitter.FP_PushSingle(offsetof(CONTEXT, fromWord));
+		jitter.FP_Rsqrt();
+		jitter.FP_Add();
+		jitter.FP_PullSingle(offsetof(CONTEXT, recip));
+
+		//minMax = max(min(poly, acc), unary) / x
+		jitter.FP_PushSingle(offsetof(CONTEXT, poly));
+		jitter.FP_PushSingle(offsetof(CONTEXT, acc));
+		jitter.FP_Min();
+		jitter.FP_PushSingle(offsetof(CONTEXT, unary));
+		jitter.FP_Max();
+		jitter.FP_PushSingle(offsetof(CONTEXT, x));
+		jitter.FP_Div();
+		jitter.FP_PullSingle(offsetof(CONTEXT, minMax));
+
+		//cst = (1.5 * 2.0) - 0.25
+		jitter.FP_PushCst(1.5f);
+		jitter.FP_PushCst(2.0f);
+		jitter.FP_Mul();
+		jitter.FP_PushCst(0.25f);
+		jitter.FP_Sub();
+		jitter.FP_PullSingle(offsetof(CONTEXT, cst));
+
+		jitter.FP_PushSingle(offsetof(CONTEXT, poly));
+		jitter.FP_PushSingle(offsetof(CONTEXT, x));
+		jitter.FP_Mul();
+		jitter.FP_PullWordTruncate(offsetof(CONTEXT, trunc));
+
+		jitter.FP_PushSingle(offsetof(CONTEXT, acc));
+		jitter.FP_PushSingle(offsetof(CONTEXT, poly));
+		jitter.FP_Cmp(Jitter::CONDITION_BL);
+		jitter.PullRel(offsetof(CONTEXT, ltTest));
+	}
+	jitter.End();
+}
+
+void CFpRegAllocTest::Compile(Jitter::CJitter& jitter)
+{
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		bool enabled = (i == 0);
+		jitter.SetFpRegisterAllocationEnabled(enabled);
+
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter);
+		m_functions[i] = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+		m_codeSizes[i] = codeStream.GetSize();
+	}
+
+	jitter.SetFpRegisterAllocationEnabled(true);
+
+	printf("FpRegAllocTest: code size went from %d to %d bytes.\r\n",
+		static_cast<int>(m_codeSizes[1]), static_cast<int>(m_codeSizes[0]));
+}
+
+void CFpRegAllocTest::InitContext(CONTEXT& context)
+{
+	memset(&context, 0, sizeof(CONTEXT));
+	context.x = 2.5f;
+	context.a = 0.5f;
+	context.b = -3.0f;
+	context.c = 1.25f;
+	context.d = 7.0f;
+	context.acc = 1.0f;
+	context.swap0 = 10.0f;
+	context.swap1 = 4.0f;
+	context.word = 16;
+}
+
+void CFpRegAllocTest::CheckContext(const CONTEXT& context)
+{
+	float x = 2.5f;
+	float poly = ((x * 0.5f + -3.0f) * x + 1.25f) * x + 7.0f;
+	float acc = 1.0f;
+	for(unsigned int i = 0; i < ACCUMULATE_COUNT; i++)
+	{
+		acc = acc * x - poly;
+	}
+	float fromWord = 16.0f;
+	float unary = sqrtf(fabsf(-fromWord));
+	float recip = (1.0f / x) + (1.0f / sqrtf(fromWord));
+	float minMax = std::max(std::min(poly, acc), unary) / x;
+
+	TEST_VERIFY(context.poly == poly);
+	TEST_VERIFY(context.acc == acc);
+	TEST_VERIFY(context.swap0 == 10.0f);
+	TEST_VERIFY(context.swap1 == 6.0f);
+	TEST_VERIFY(context.fromWord == fromWord);
+	TEST_VERIFY(context.unary == unary);
+	TEST_VERIFY(context.recip == recip);
+	TEST_VERIFY(context.minMax == minMax);
+	TEST_VERIFY(context.cst == 2.75f);
+	TEST_VERIFY(context.trunc == static_cast<uint32>(static_cast<int32>(poly * x)));
+	TEST_VERIFY(context.ltTest == ((acc < poly) ? 1 : 0));
+	TEST_VERIFY(context.callCount == 1);
+}
+
+void CFpRegAllocTest::Run()
+{
+	TEST_VERIFY(m_codeSizes[0] < m_codeSizes[1]);
+
+	for(auto& function : m_functions)
+	{
+		CONTEXT context;
+		InitContext(context);
+		function(&context);
+		CheckContext(context);
+	}
+}
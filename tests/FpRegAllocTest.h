@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+//Checks that FP single values held in registers give the same results as when they live in memory
+class CFpRegAllocTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		ACCUMULATE_COUNT = 4,
+	};
+
+	struct CONTEXT
+	{
+		float			x;
+		float			a;
+		float			b;
+		float			c;
+		float			d;
+		float			acc;
+		float			swap0;
+		float			swap1;
+		uint32			word;
+
+		float			poly;
+		float			fromWord;
+		float			unary;
+		float			recip;
+		float			minMax;
+		float			cst;
+		uint32			trunc;
+		uint32			ltTest;
+		uint32			callCount;
+	};
+
+	static void			EmitCode(Jitter::CJitter&);
+	static void			Callback(CONTEXT*);
+
+	void				InitContext(CONTEXT&);
+	void				CheckContext(const CONTEXT&);
+
+	CMemoryFunction		m_functions[2];
+	size_t				m_codeSizes[2] = {};
+};
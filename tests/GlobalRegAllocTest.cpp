@@ -0,0 +1,147 @@
+#include "GlobalRegAllocTest.h"
+#include <cstdio>
+#include "MemStream.h"
+#include "offsetof_def.h"
+#include "Jitter_CompileStats.h"
+
+void CGlobalRegAllocTest::Callback(CONTEXT* context)
+{
+	//Reads and writes relatives held in registers by the caller
+	context->accumulatorSeen = context->accumulator;
+	context->value += CALL_INCREMENT;
+}
+
+void CGlobalRegAllocTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		auto loopLabel = jitter.CreateLabel();
+		jitter.MarkLabel(loopLabel);
+
+		//if(counter & 1) accumulator += value; else accumulator ^= value;
+		jitter.PushRel(offsetof(CONTEXT, counter));
+		jitter.PushCst(1);
+		jitter.And();
+		jitter.PushCst(0);
+		jitter.BeginIf(Jitter::CONDITION_NE);
+		{
+			jitter.PushRel(offsetof(CONTEXT, accumulator));
+			jitter.PushRel(offsetof(CONTEXT, value));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, accumulator));
+		}
+		jitter.Else();
+		{
+			jitter.PushRel(offsetof(CONTEXT, accumulator));
+			jitter.PushRel(offsetof(CONTEXT, value));
+			jitter.Xor();
+			jitter.PullRel(offsetof(CONTEXT, accumulator));
+		}
+		jitter.EndIf();
+
+		//value = (value << 1) + counter;
+		jitter.PushRel(offsetof(CONTEXT, value));
+		jitter.Shl(1);
+		jitter.PushRel(offsetof(CONTEXT, counter));
+		jitter.Add();
+		jitter.PullRel(offsetof(CONTEXT, value));
+
+		//if(counter == CALL_ITERATION) Callback(context);
+		jitter.PushRel(offsetof(CONTEXT, counter));
+		jitter.PushCst(CALL_ITERATION);
+		jitter.BeginIf(Jitter::CONDITION_EQ);
+		{
+			jitter.PushCtx();
+			jitter.Call(reinterpret_cast<void*>(&CGlobalRegAllocTest::Callback), 1, Jitter::CJitter::RETURN_VALUE_NONE);
+		}
+		jitter.EndIf();
+
+		//if(--counter != 0) goto loop;
+		jitter.PushRel(offsetof(CONTEXT, counter));
+		jitter.PushCst(1);
+		jitter.Sub();
+		jitter.PullRel(offsetof(CONTEXT, counter));
+
+		jitter.PushRel(offsetof(CONTEXT, counter));
+		jitter.PushCst(0);
+		jitter.BeginIf(Jitter::CONDITION_NE);
+		{
+			jitter.Goto(loopLabel);
+		}
+		jitter.EndIf();
+	}
+	jitter.End();
+}
+
+void CGlobalRegAllocTest::Reference(CONTEXT& context)
+{
+	do
+	{
+		if(context.counter & 1)
+		{
+			context.accumulator += context.value;
+		}
+		else
+		{
+			context.accumulator ^= context.value;
+		}
+		context.value = (context.value << 1) + context.counter;
+		if(context.counter == CALL_ITERATION)
+		{
+			Callback(&context);
+		}
+	}
+	while(--context.counter != 0);
+}
+
+void CGlobalRegAllocTest::Compile(Jitter::CJitter& jitter)
+{
+	bool globalRegAllocEnabled = jitter.IsGlobalRegisterAllocationEnabled();
+
+	Framework::CMemStream localCodeStream;
+	jitter.SetStream(&localCodeStream);
+	jitter.SetGlobalRegisterAllocationEnabled(false);
+	EmitCode(jitter);
+
+	Framework::CMemStream globalCodeStream;
+	jitter.SetStream(&globalCodeStream);
+	jitter.SetGlobalRegisterAllocationEnabled(true);
+	EmitCode(jitter);
+
+	jitter.SetGlobalRegisterAllocationEnabled(globalRegAllocEnabled);
+
+	m_localFunction = CMemoryFunction(localCodeStream.GetBuffer(), localCodeStream.GetSize());
+	m_globalFunction = CMemoryFunction(globalCodeStream.GetBuffer(), globalCodeStream.GetSize());
+}
+
+uint64 CGlobalRegAllocTest::RunFunction(CMemoryFunction& function)
+{
+	CONTEXT context;
+	memset(&context, 0, sizeof(context));
+	context.counter = ITERATION_COUNT;
+	context.value = 0x1234;
+	context.accumulator = 0x5678;
+
+	CONTEXT expected = context;
+	Reference(expected);
+
+	auto startTime = Jitter::CCompileStats::GetTimestamp();
+	function(&context);
+	auto elapsed = Jitter::CCompileStats::GetTimestamp() - startTime;
+
+	TEST_VERIFY(context.counter == expected.counter);
+	TEST_VERIFY(context.value == expected.value);
+	TEST_VERIFY(context.accumulator == expected.accumulator);
+	TEST_VERIFY(context.accumulatorSeen == expected.accumulatorSeen);
+
+	return elapsed;
+}
+
+void CGlobalRegAllocTest::Run()
+{
+	uint64 localTime = RunFunction(m_localFunction);
+	uint64 globalTime = RunFunction(m_globalFunction);
+
+	printf("GlobalRegAllocTest: loop took %d us with local register allocation, %d us with global register allocation.\r\n",
+		static_cast<int>(localTime / 1000), static_cast<int>(globalTime / 1000));
+}
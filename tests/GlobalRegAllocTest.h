@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+//Runs a branchy loop with a call using relatives in many blocks, with and without global register allocation
+class CGlobalRegAllocTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		ITERATION_COUNT = 0x100000,
+		CALL_ITERATION = 4,
+		CALL_INCREMENT = 100,
+	};
+
+	struct CONTEXT
+	{
+		uint32		counter;
+		uint32		value;
+		uint32		accumulator;
+		uint32		accumulatorSeen;
+	};
+
+	static void			Callback(CONTEXT*);
+	static void			EmitCode(Jitter::CJitter&);
+	static void			Reference(CONTEXT&);
+	static uint64		RunFunction(CMemoryFunction&);
+
+	CMemoryFunction		m_localFunction;
+	CMemoryFunction		m_globalFunction;
+};
@@ -0,0 +1,105 @@
+#include "LookupTest.h"
+#include "MemStream.h"
+
+#define TARGET_ADDRESS_0 0x00001000
+#define TARGET_ADDRESS_1 0x00001005
+//Same entry as TARGET_ADDRESS_1, but different tag
+#define COLLIDING_ADDRESS 0x00002001
+//Entry is empty
+#define EMPTY_ADDRESS 0x00001002
+
+#define MISS_RESULT 0xFF
+
+void CLookupTest::MissFunction(void* context)
+{
+	auto testContext = reinterpret_cast<CONTEXT*>(context);
+	testContext->result = MISS_RESULT;
+	testContext->missCount++;
+}
+
+void CLookupTest::Compile(Jitter::CJitter& jitter)
+{
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+
+		jitter.Begin();
+		{
+			jitter.PushCst(i + 1);
+			jitter.PullRel(offsetof(CONTEXT, result));
+		}
+		jitter.End();
+
+		m_targetFunctions[i] = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	}
+
+	m_table[TARGET_ADDRESS_0 & (TABLE_SIZE - 1)].tag = TARGET_ADDRESS_0;
+	m_table[TARGET_ADDRESS_0 & (TABLE_SIZE - 1)].code = m_targetFunctions[0].GetCode();
+	m_table[TARGET_ADDRESS_1 & (TABLE_SIZE - 1)].tag = TARGET_ADDRESS_1;
+	m_table[TARGET_ADDRESS_1 & (TABLE_SIZE - 1)].code = m_targetFunctions[1].GetCode();
+
+	{
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+
+		jitter.Begin();
+		{
+			//Sum is likely kept in a register, it needs to be in memory when leaving through either path
+			jitter.PushRel(offsetof(CONTEXT, value0));
+			jitter.PushRel(offsetof(CONTEXT, value1));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, sum));
+
+			jitter.PushRel(offsetof(CONTEXT, address));
+			jitter.Lookup(m_table, TABLE_SIZE - 1, reinterpret_cast<void*>(&MissFunction));
+		}
+		jitter.End();
+
+		m_lookupFunction = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	}
+
+	{
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+
+		jitter.Begin();
+		{
+			jitter.PushCst(TARGET_ADDRESS_1);
+			jitter.Lookup(m_table, TABLE_SIZE - 1, reinterpret_cast<void*>(&MissFunction));
+		}
+		jitter.End();
+
+		m_constantLookupFunction = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	}
+}
+
+void CLookupTest::RunLookup(CMemoryFunction& function, uint32 address, uint32 expectedResult, uint32 expectedMissCount)
+{
+	CONTEXT context;
+	context.address = address;
+	context.value0 = address;
+	context.value1 = 0x10;
+	function(&context);
+	TEST_VERIFY(context.result == expectedResult);
+	TEST_VERIFY(context.missCount == expectedMissCount);
+	if(&function == &m_lookupFunction)
+	{
+		TEST_VERIFY(context.sum == (address + 0x10));
+	}
+}
+
+void CLookupTest::Run()
+{
+	RunLookup(m_lookupFunction, TARGET_ADDRESS_0, 1, 0);
+	RunLookup(m_lookupFunction, TARGET_ADDRESS_1, 2, 0);
+	RunLookup(m_lookupFunction, COLLIDING_ADDRESS, MISS_RESULT, 1);
+	RunLookup(m_lookupFunction, EMPTY_ADDRESS, MISS_RESULT, 1);
+	RunLookup(m_constantLookupFunction, 0, 2, 0);
+
+	//Entries can change after the code is generated
+	m_table[TARGET_ADDRESS_1 & (TABLE_SIZE - 1)].tag = COLLIDING_ADDRESS;
+	RunLookup(m_lookupFunction, COLLIDING_ADDRESS, 2, 0);
+	RunLookup(m_lookupFunction, TARGET_ADDRESS_1, MISS_RESULT, 1);
+	RunLookup(m_constantLookupFunction, 0, MISS_RESULT, 1);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+class CLookupTest : public CTest
+{
+public:
+	void						Compile(Jitter::CJitter&) override;
+	void						Run() override;
+
+private:
+	enum
+	{
+		TABLE_SIZE = 4,
+	};
+
+	struct CONTEXT
+	{
+		uint32		address = 0;
+		uint32		value0 = 0;
+		uint32		value1 = 0;
+		uint32		sum = 0;
+		uint32		result = 0;
+		uint32		missCount = 0;
+	};
+
+	static void					MissFunction(void*);
+
+	void						RunLookup(CMemoryFunction&, uint32, uint32, uint32);
+
+	CMemoryFunction				m_lookupFunction;
+	CMemoryFunction				m_constantLookupFunction;
+	CMemoryFunction				m_targetFunctions[2];
+	Jitter::CJitter::LOOKUP_ENTRY	m_table[TABLE_SIZE];
+};
@@ -0,0 +1,255 @@
+#include "LoopTest.h"
+#include "MemStream.h"
+
+void CLoopTest::Step(CONTEXT* context)
+{
+	context->step++;
+}
+
+void CLoopTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		//sum = count + (count - 1) + ... + 1
+		jitter.PushRel(offsetof(CONTEXT, count));
+		jitter.PullRel(offsetof(CONTEXT, counter));
+
+		jitter.BeginLoop();
+		{
+			jitter.PushRel(offsetof(CONTEXT, sum));
+			jitter.PushRel(offsetof(CONTEXT, counter));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, sum));
+
+			jitter.PushRel(offsetof(CONTEXT, counter));
+			jitter.PushCst(1);
+			jitter.Sub();
+			jitter.PullRel(offsetof(CONTEXT, counter));
+
+			jitter.PushRel(offsetof(CONTEXT, counter));
+			jitter.PushCst(0);
+			jitter.Continue(Jitter::CONDITION_NE);
+		}
+		jitter.EndLoop();
+
+		//acc += ((scale + bias) << 3) ^ index, for index = count to 1
+		jitter.PushRel(offsetof(CONTEXT, count));
+		jitter.PullRel(offsetof(CONTEXT, index));
+
+		jitter.BeginLoop();
+		{
+			jitter.PushRel(offsetof(CONTEXT, scale));
+			jitter.PushRel(offsetof(CONTEXT, bias));
+			jitter.Add();
+			jitter.Shl(3);
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.Xor();
+			jitter.PushRel(offsetof(CONTEXT, acc));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, acc));
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(1);
+			jitter.Sub();
+			jitter.PullRel(offsetof(CONTEXT, index));
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(0);
+			jitter.BeginIf(Jitter::CONDITION_NE);
+			{
+				jitter.Continue();
+			}
+			jitter.EndIf();
+		}
+		jitter.EndLoop();
+
+		//grid += (i << 4) + j, for every i < rows and j < cols
+		jitter.PushCst(0);
+		jitter.PullRel(offsetof(CONTEXT, i));
+
+		jitter.BeginLoop();
+		{
+			jitter.PushCst(0);
+			jitter.PullRel(offsetof(CONTEXT, j));
+
+			jitter.BeginLoop();
+			{
+				jitter.PushRel(offsetof(CONTEXT, i));
+				jitter.Shl(4);
+				jitter.PushRel(offsetof(CONTEXT, j));
+				jitter.Add();
+				jitter.PushRel(offsetof(CONTEXT, grid));
+				jitter.Add();
+				jitter.PullRel(offsetof(CONTEXT, grid));
+
+				jitter.PushRel(offsetof(CONTEXT, j));
+				jitter.PushCst(1);
+				jitter.Add();
+				jitter.PullRel(offsetof(CONTEXT, j));
+
+				jitter.PushRel(offsetof(CONTEXT, j));
+				jitter.PushRel(offsetof(CONTEXT, cols));
+				jitter.Continue(Jitter::CONDITION_BL);
+			}
+			jitter.EndLoop();
+
+			jitter.PushRel(offsetof(CONTEXT, i));
+			jitter.PushCst(1);
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, i));
+
+			jitter.PushRel(offsetof(CONTEXT, i));
+			jitter.PushRel(offsetof(CONTEXT, rows));
+			jitter.Continue(Jitter::CONDITION_BL);
+		}
+		jitter.EndLoop();
+
+		//chain += (x + 1) ^ 5 in the inner loop, x changes in the outer loop: both operations are
+		//invariant in the inner loop, none of them is in the outer one
+		jitter.PushCst(0);
+		jitter.PullRel(offsetof(CONTEXT, outer));
+
+		jitter.BeginLoop();
+		{
+			jitter.PushRel(offsetof(CONTEXT, x));
+			jitter.PushCst(3);
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, x));
+
+			jitter.PushCst(0);
+			jitter.PullRel(offsetof(CONTEXT, inner));
+
+			jitter.BeginLoop();
+			{
+				jitter.PushRel(offsetof(CONTEXT, x));
+				jitter.PushCst(1);
+				jitter.Add();
+				jitter.PushCst(5);
+				jitter.Xor();
+				jitter.PushRel(offsetof(CONTEXT, chain));
+				jitter.Add();
+				jitter.PullRel(offsetof(CONTEXT, chain));
+
+				jitter.PushRel(offsetof(CONTEXT, inner));
+				jitter.PushCst(1);
+				jitter.Add();
+				jitter.PullRel(offsetof(CONTEXT, inner));
+
+				jitter.PushRel(offsetof(CONTEXT, inner));
+				jitter.PushRel(offsetof(CONTEXT, cols));
+				jitter.Continue(Jitter::CONDITION_BL);
+			}
+			jitter.EndLoop();
+
+			jitter.PushRel(offsetof(CONTEXT, outer));
+			jitter.PushCst(1);
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, outer));
+
+			jitter.PushRel(offsetof(CONTEXT, outer));
+			jitter.PushRel(offsetof(CONTEXT, rows));
+			jitter.Continue(Jitter::CONDITION_BL);
+		}
+		jitter.EndLoop();
+
+		//callAcc += step << 1, step is changed by the call, nothing can be hoisted
+		jitter.PushRel(offsetof(CONTEXT, count));
+		jitter.PullRel(offsetof(CONTEXT, index));
+
+		jitter.BeginLoop();
+		{
+			jitter.PushCtx();
+			jitter.Call(reinterpret_cast<void*>(&CLoopTest::Step), 1, Jitter::CJitter::RETURN_VALUE_NONE);
+
+			jitter.PushRel(offsetof(CONTEXT, step));
+			jitter.Shl(1);
+			jitter.PushRel(offsetof(CONTEXT, callAcc));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, callAcc));
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(1);
+			jitter.Sub();
+			jitter.PullRel(offsetof(CONTEXT, index));
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(0);
+			jitter.Continue(Jitter::CONDITION_NE);
+		}
+		jitter.EndLoop();
+	}
+	jitter.End();
+}
+
+void CLoopTest::Compile(Jitter::CJitter& jitter)
+{
+	for(unsigned int i = 0; i < FUNCTION_COUNT; i++)
+	{
+		jitter.SetLoopInvariantCodeMotionEnabled(i != FUNCTION_NO_CODE_MOTION);
+		jitter.SetGlobalRegisterAllocationEnabled(i != FUNCTION_NO_GLOBAL_REGISTERS);
+
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter);
+
+		m_functions[i] = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+	}
+
+	jitter.SetLoopInvariantCodeMotionEnabled(true);
+	jitter.SetGlobalRegisterAllocationEnabled(true);
+}
+
+void CLoopTest::RunFunction(CMemoryFunction& function, uint32 count)
+{
+	CONTEXT context = {};
+	context.count = count;
+	context.scale = 0x10;
+	context.bias = 0x3;
+	context.rows = 3;
+	context.cols = 5;
+	function(&context);
+
+	uint32 expectedAcc = 0;
+	for(uint32 index = count; index != 0; index--)
+	{
+		expectedAcc += ((context.scale + context.bias) << 3) ^ index;
+	}
+
+	uint32 expectedGrid = 0;
+	for(uint32 i = 0; i < context.rows; i++)
+	{
+		for(uint32 j = 0; j < context.cols; j++)
+		{
+			expectedGrid += (i << 4) + j;
+		}
+	}
+
+	uint32 expectedChain = 0;
+	for(uint32 outer = 0; outer < context.rows; outer++)
+	{
+		uint32 x = (outer + 1) * 3;
+		expectedChain += context.cols * ((x + 1) ^ 5);
+	}
+
+	TEST_VERIFY(context.sum == (count * (count + 1)) / 2);
+	TEST_VERIFY(context.counter == 0);
+	TEST_VERIFY(context.acc == expectedAcc);
+	TEST_VERIFY(context.grid == expectedGrid);
+	TEST_VERIFY(context.i == context.rows);
+	TEST_VERIFY(context.j == context.cols);
+	TEST_VERIFY(context.step == count);
+	TEST_VERIFY(context.chain == expectedChain);
+	TEST_VERIFY(context.x == context.rows * 3);
+	TEST_VERIFY(context.callAcc == (count * (count + 1)));
+	TEST_VERIFY(context.index == 0);
+}
+
+void CLoopTest::Run()
+{
+	for(auto& function : m_functions)
+	{
+		RunFunction(function, 1);
+		RunFunction(function, 10);
+		RunFunction(function, 1000);
+	}
+}
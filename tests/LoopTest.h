@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+//Checks loops built with BeginLoop/Continue/EndLoop, with and without loop invariant code motion
+class CLoopTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		FUNCTION_DEFAULT,
+		FUNCTION_NO_CODE_MOTION,
+		FUNCTION_NO_GLOBAL_REGISTERS,
+		FUNCTION_COUNT,
+	};
+
+	struct CONTEXT
+	{
+		uint32			count;
+		uint32			scale;
+		uint32			bias;
+		uint32			rows;
+		uint32			cols;
+
+		uint32			counter;
+		uint32			index;
+		uint32			i;
+		uint32			j;
+		uint32			step;
+		uint32			x;
+		uint32			outer;
+		uint32			inner;
+
+		uint32			sum;
+		uint32			acc;
+		uint32			grid;
+		uint32			callAcc;
+		uint32			chain;
+	};
+
+	static void			EmitCode(Jitter::CJitter&);
+	static void			Step(CONTEXT*);
+
+	void				RunFunction(CMemoryFunction&, uint32);
+
+	CMemoryFunction		m_functions[FUNCTION_COUNT];
+};
@@ -47,6 +47,27 @@
 #include "LzcTest.h"
 #include "NestedIfTest.h"
 #include "ExternJumpTest.h"
+#include "CompileStatsTest.h"
+#include "ArenaAllocTest.h"
+#include "MatcherDispatchTest.h"
+#include "CodeHeapTest.h"
+#include "GlobalRegAllocTest.h"
+#include "ElfObjectFileTest.h"
+#include "CodeSizeStatsTest.h"
+#include "BranchRelaxationTest.h"
+#include "CompilePoolTest.h"
+#include "DeadcodeEliminationTest.h"
+#include "ValueNumberingTest.h"
+#include "ContextPureCallTest.h"
+#include "StrengthReductionTest.h"
+#include "FpRegAllocTest.h"
+#include "CodeCacheTest.h"
+#include "CodeCachePersistenceTest.h"
+#include "BlockLinkTest.h"
+#include "LookupTest.h"
+#include "LoopTest.h"
+#include "ProfileTest.h"
+#include "TieredCompilationTest.h"
 
 typedef std::function<CTest* ()> TestFactoryFunction;
 
@@ -161,7 +182,28 @@ static const TestFactoryFunction s_factories[] =
 	[] () { return new CMerge64Test(); },
 	[] () { return new CMemAccess64Test(); },
 	[] () { return new CCall64Test(); },
-	[] () { return new CExternJumpTest(); }
+	[] () { return new CExternJumpTest(); },
+	[] () { return new CCompileStatsTest(); },
+	[] () { return new CArenaAllocTest(); },
+	[] () { return new CMatcherDispatchTest(); },
+	[] () { return new CCodeHeapTest(); },
+	[] () { return new CGlobalRegAllocTest(); },
+	[] () { return new CElfObjectFileTest(); },
+	[] () { return new CCodeSizeStatsTest(); },
+	[] () { return new CBranchRelaxationTest(); },
+	[] () { return new CCompilePoolTest(); },
+	[] () { return new CDeadcodeEliminationTest(); },
+	[] () { return new CValueNumberingTest(); },
+	[] () { return new CContextPureCallTest(); },
+	[] () { return new CStrengthReductionTest(); },
+	[] () { return new CFpRegAllocTest(); },
+	[] () { return new CCodeCacheTest(); },
+	[] () { return new CCodeCachePersistenceTest(); },
+	[] () { return new CBlockLinkTest(); },
+	[] () { return new CLookupTest(); },
+	[] () { return new CLoopTest(); },
+	[] () { return new CProfileTest(); },
+	[] () { return new CTieredCompilationTest(); }
 };
 
 int main(int argc, const char** argv)
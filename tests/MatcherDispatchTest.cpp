@@ -0,0 +1,118 @@
+#include "MatcherDispatchTest.h"
+#include <cstdio>
+#include "MemStream.h"
+#include "offsetof_def.h"
+
+void CMatcherDispatchTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		for(unsigned int i = 0; i < STEP_COUNT; i++)
+		{
+			unsigned int index0 = (i + 0) % VALUE_COUNT;
+			unsigned int index1 = (i + 1) % VALUE_COUNT;
+			unsigned int index2 = (i + 5) % VALUE_COUNT;
+
+			//result = (result ^ (values[index0] + i))
+			jitter.PushRel(offsetof(CONTEXT, result));
+			jitter.PushRel(offsetof(CONTEXT, values[index0]));
+			jitter.PushCst(i);
+			jitter.Add();
+			jitter.Xor();
+			jitter.PullRel(offsetof(CONTEXT, result));
+
+			//values[index2] = ((values[index0] - values[index1]) << (i & 7)) | result
+			jitter.PushRel(offsetof(CONTEXT, values[index0]));
+			jitter.PushRel(offsetof(CONTEXT, values[index1]));
+			jitter.Sub();
+			jitter.Shl(static_cast<uint8>(i & 7));
+			jitter.PushRel(offsetof(CONTEXT, result));
+			jitter.Or();
+			jitter.PullRel(offsetof(CONTEXT, values[index2]));
+
+			//fpValues[index2] = fpValues[index0] * fpValues[index1] + fpValues[index2]
+			jitter.FP_PushSingle(offsetof(CONTEXT, fpValues[index0]));
+			jitter.FP_PushSingle(offsetof(CONTEXT, fpValues[index1]));
+			jitter.FP_Mul();
+			jitter.FP_PushSingle(offsetof(CONTEXT, fpValues[index2]));
+			jitter.FP_Add();
+			jitter.FP_PullSingle(offsetof(CONTEXT, fpValues[index2]));
+		}
+	}
+	jitter.End();
+}
+
+uint64 CMatcherDispatchTest::MeasureGenerateCodeTime(Jitter::CJitter& jitter, bool matcherTableEnabled, std::vector<uint8>& code)
+{
+	jitter.GetCodeGen()->SetMatcherTableEnabled(matcherTableEnabled);
+	jitter.ResetCompileStats();
+
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+	for(unsigned int i = 0; i < ITERATION_COUNT; i++)
+	{
+		codeStream.ResetBuffer();
+		EmitCode(jitter);
+	}
+
+	code = std::vector<uint8>(codeStream.GetBuffer(), codeStream.GetBuffer() + codeStream.GetSize());
+
+	const auto& stats = jitter.GetCompileStats();
+	const auto& generateStats = stats.passes[Jitter::CCompileStats::PASS_GENERATECODE];
+	const auto& assemblerStats = stats.passes[Jitter::CCompileStats::PASS_ASSEMBLEREND];
+	return generateStats.totalTime - assemblerStats.totalTime;
+}
+
+void CMatcherDispatchTest::Compile(Jitter::CJitter& jitter)
+{
+	bool compileStatsEnabled = jitter.IsCompileStatsEnabled();
+	jitter.SetCompileStatsEnabled(true);
+
+	std::vector<uint8> linearCode;
+	std::vector<uint8> tableCode;
+	uint64 linearTime = MeasureGenerateCodeTime(jitter, false, linearCode);
+	uint64 tableTime = MeasureGenerateCodeTime(jitter, true, tableCode);
+
+	jitter.SetCompileStatsEnabled(compileStatsEnabled);
+
+	m_codeMatches = (linearCode == tableCode);
+
+	printf("MatcherDispatchTest: code emission took %d us with linear matcher search, %d us with matcher tables.\r\n",
+		static_cast<int>(linearTime / 1000), static_cast<int>(tableTime / 1000));
+
+	m_function = CMemoryFunction(tableCode.data(), tableCode.size());
+}
+
+void CMatcherDispatchTest::Run()
+{
+	TEST_VERIFY(m_codeMatches);
+
+	CONTEXT context;
+	memset(&context, 0, sizeof(context));
+	for(unsigned int i = 0; i < VALUE_COUNT; i++)
+	{
+		context.values[i] = i * 0x01010101;
+		context.fpValues[i] = static_cast<float>(i) * 0.25f;
+	}
+
+	CONTEXT expected = context;
+	for(unsigned int i = 0; i < STEP_COUNT; i++)
+	{
+		unsigned int index0 = (i + 0) % VALUE_COUNT;
+		unsigned int index1 = (i + 1) % VALUE_COUNT;
+		unsigned int index2 = (i + 5) % VALUE_COUNT;
+
+		expected.result ^= (expected.values[index0] + i);
+		expected.values[index2] = ((expected.values[index0] - expected.values[index1]) << (i & 7)) | expected.result;
+		expected.fpValues[index2] = expected.fpValues[index0] * expected.fpValues[index1] + expected.fpValues[index2];
+	}
+
+	m_function(&context);
+
+	TEST_VERIFY(context.result == expected.result);
+	for(unsigned int i = 0; i < VALUE_COUNT; i++)
+	{
+		TEST_VERIFY(context.values[i] == expected.values[i]);
+		TEST_VERIFY(context.fpValues[i] == expected.fpValues[i]);
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+//Compares instruction selection through matcher tables against the linear matcher search
+class CMatcherDispatchTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		VALUE_COUNT = 0x10,
+		STEP_COUNT = 0x20,
+		ITERATION_COUNT = 0x08,
+	};
+
+	struct CONTEXT
+	{
+		uint32		values[VALUE_COUNT];
+		float		fpValues[VALUE_COUNT];
+		uint32		result;
+	};
+
+	static void			EmitCode(Jitter::CJitter&);
+	static uint64		MeasureGenerateCodeTime(Jitter::CJitter&, bool, std::vector<uint8>&);
+
+	bool				m_codeMatches = false;
+	CMemoryFunction		m_function;
+};
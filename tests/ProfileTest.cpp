@@ -0,0 +1,187 @@
+#include "ProfileTest.h"
+#include <algorithm>
+#include "MemStream.h"
+
+//Block ids only depend on the jitter calls made by EmitCode
+#define ENTRY_BLOCK_ID	1
+#define ELSE_BLOCK_ID	2
+#define THEN_BLOCK_ID	3
+#define ENDIF_BLOCK_ID	4
+
+void CProfileTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		//result = (input < threshold) ? (input * 3) : (input - threshold)
+		jitter.PushRel(offsetof(CONTEXT, input));
+		jitter.PushCst(INPUT_THRESHOLD);
+		jitter.BeginIf(Jitter::CONDITION_BL);
+		{
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.Add();
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, result));
+		}
+		jitter.Else();
+		{
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushCst(INPUT_THRESHOLD);
+			jitter.Sub();
+			jitter.PullRel(offsetof(CONTEXT, result));
+		}
+		jitter.EndIf();
+
+		//total += result and evens counts even indices, for index = count to 1
+		jitter.PushRel(offsetof(CONTEXT, count));
+		jitter.PullRel(offsetof(CONTEXT, index));
+
+		jitter.BeginLoop();
+		{
+			jitter.PushRel(offsetof(CONTEXT, total));
+			jitter.PushRel(offsetof(CONTEXT, result));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, total));
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(1);
+			jitter.And();
+			jitter.PushCst(0);
+			jitter.BeginIf(Jitter::CONDITION_EQ);
+			{
+				jitter.PushRel(offsetof(CONTEXT, evens));
+				jitter.PushCst(1);
+				jitter.Add();
+				jitter.PullRel(offsetof(CONTEXT, evens));
+			}
+			jitter.EndIf();
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(1);
+			jitter.Sub();
+			jitter.PullRel(offsetof(CONTEXT, index));
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(0);
+			jitter.Continue(Jitter::CONDITION_NE);
+		}
+		jitter.EndLoop();
+	}
+	jitter.End();
+}
+
+void CProfileTest::Compile(Jitter::CJitter& jitter)
+{
+	//Gather a profile where only the "then" side runs and another where only the "else" side runs
+	for(auto counters : { m_thenCounters, m_elseCounters })
+	{
+		std::fill(counters, counters + COUNTER_COUNT, 0);
+		jitter.SetProfileInstrumentation(counters, COUNTER_COUNT);
+
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter);
+
+		m_functions[FUNCTION_INSTRUMENTED] = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+		m_counterCount = jitter.GetProfileCounterCount();
+
+		uint32 inputBase = (counters == m_thenCounters) ? 0 : INPUT_THRESHOLD;
+		for(uint32 i = 0; i < 10; i++)
+		{
+			RunFunction(m_functions[FUNCTION_INSTRUMENTED], inputBase + i, 5);
+		}
+	}
+
+	CompileProfiled(jitter, FUNCTION_PROFILED_THEN, m_thenCounters);
+	CompileProfiled(jitter, FUNCTION_PROFILED_ELSE, m_elseCounters);
+
+	//Instrumentation only applied to the functions above, counters must not move when running the profiled ones
+	RunFunction(m_functions[FUNCTION_PROFILED_THEN], 0, 5);
+	RunFunction(m_functions[FUNCTION_PROFILED_ELSE], INPUT_THRESHOLD, 5);
+
+	//Without global register allocation, block layout is the only thing depending on the profile
+	bool globalRegisterAllocationEnabled = jitter.IsGlobalRegisterAllocationEnabled();
+	jitter.SetGlobalRegisterAllocationEnabled(false);
+	m_layoutCode[LAYOUT_UNPROFILED] = GenerateCode(jitter, nullptr);
+	m_layoutCode[LAYOUT_UNPROFILED_AGAIN] = GenerateCode(jitter, nullptr);
+	m_layoutCode[LAYOUT_PROFILED_THEN] = GenerateCode(jitter, m_thenCounters);
+	m_layoutCode[LAYOUT_PROFILED_ELSE] = GenerateCode(jitter, m_elseCounters);
+	jitter.SetGlobalRegisterAllocationEnabled(globalRegisterAllocationEnabled);
+}
+
+CProfileTest::CodeBuffer CProfileTest::GenerateCode(Jitter::CJitter& jitter, const uint32* counters)
+{
+	if(counters)
+	{
+		jitter.SetProfile(counters, m_counterCount);
+	}
+
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+	EmitCode(jitter);
+
+	return CodeBuffer(codeStream.GetBuffer(), codeStream.GetBuffer() + codeStream.GetSize());
+}
+
+void CProfileTest::CompileProfiled(Jitter::CJitter& jitter, unsigned int functionIndex, const uint32* counters)
+{
+	jitter.SetProfile(counters, m_counterCount);
+
+	Framework::CMemStream codeStream;
+	jitter.SetStream(&codeStream);
+	EmitCode(jitter);
+
+	m_functions[functionIndex] = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+}
+
+void CProfileTest::RunFunction(CMemoryFunction& function, uint32 input, uint32 count)
+{
+	CONTEXT context = {};
+	context.input = input;
+	context.count = count;
+	function(&context);
+
+	uint32 expectedResult = (input < INPUT_THRESHOLD) ? (input * 3) : (input - INPUT_THRESHOLD);
+	TEST_VERIFY(context.result == expectedResult);
+	TEST_VERIFY(context.total == (expectedResult * count));
+	TEST_VERIFY(context.evens == (count / 2));
+	TEST_VERIFY(context.index == 0);
+}
+
+void CProfileTest::Run()
+{
+	TEST_VERIFY(m_counterCount > ENDIF_BLOCK_ID);
+	TEST_VERIFY(m_counterCount <= COUNTER_COUNT);
+
+	TEST_VERIFY(m_thenCounters[ENTRY_BLOCK_ID] == 10);
+	TEST_VERIFY(m_thenCounters[THEN_BLOCK_ID] == 10);
+	TEST_VERIFY(m_thenCounters[ELSE_BLOCK_ID] == 0);
+	TEST_VERIFY(m_thenCounters[ENDIF_BLOCK_ID] == 10);
+
+	TEST_VERIFY(m_elseCounters[ENTRY_BLOCK_ID] == 10);
+	TEST_VERIFY(m_elseCounters[THEN_BLOCK_ID] == 0);
+	TEST_VERIFY(m_elseCounters[ELSE_BLOCK_ID] == 10);
+	TEST_VERIFY(m_elseCounters[ENDIF_BLOCK_ID] == 10);
+
+	//Counters past the ones used by the function are never touched
+	for(uint32 i = m_counterCount; i < COUNTER_COUNT; i++)
+	{
+		TEST_VERIFY(m_thenCounters[i] == 0);
+	}
+
+	//Generation is deterministic, differences only come from the profile moving cold blocks to the end
+	TEST_VERIFY(m_layoutCode[LAYOUT_UNPROFILED] == m_layoutCode[LAYOUT_UNPROFILED_AGAIN]);
+	TEST_VERIFY(m_layoutCode[LAYOUT_PROFILED_THEN] != m_layoutCode[LAYOUT_UNPROFILED]);
+	TEST_VERIFY(m_layoutCode[LAYOUT_PROFILED_ELSE] != m_layoutCode[LAYOUT_UNPROFILED]);
+	TEST_VERIFY(m_layoutCode[LAYOUT_PROFILED_THEN] != m_layoutCode[LAYOUT_PROFILED_ELSE]);
+
+	for(auto& function : m_functions)
+	{
+		for(uint32 input : { 0U, 7U, 99U, 100U, 150U })
+		{
+			RunFunction(function, input, 1);
+			RunFunction(function, input, 10);
+		}
+	}
+}
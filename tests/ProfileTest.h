@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include "Test.h"
+#include "MemoryFunction.h"
+
+//Checks counters emitted by profiling instrumentation and functions laid out using them
+class CProfileTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		COUNTER_COUNT = 64,
+	};
+
+	enum
+	{
+		//Inputs under this go through the "then" side of the branch
+		INPUT_THRESHOLD = 100,
+	};
+
+	enum
+	{
+		FUNCTION_INSTRUMENTED,
+		FUNCTION_PROFILED_THEN,
+		FUNCTION_PROFILED_ELSE,
+		FUNCTION_COUNT,
+	};
+
+	enum
+	{
+		LAYOUT_UNPROFILED,
+		LAYOUT_UNPROFILED_AGAIN,
+		LAYOUT_PROFILED_THEN,
+		LAYOUT_PROFILED_ELSE,
+		LAYOUT_COUNT,
+	};
+
+	typedef std::vector<uint8> CodeBuffer;
+
+	struct CONTEXT
+	{
+		uint32			input;
+		uint32			count;
+
+		uint32			result;
+		uint32			total;
+		uint32			evens;
+		uint32			index;
+	};
+
+	static void			EmitCode(Jitter::CJitter&);
+
+	void				RunFunction(CMemoryFunction&, uint32, uint32);
+	void				CompileProfiled(Jitter::CJitter&, unsigned int, const uint32*);
+	CodeBuffer			GenerateCode(Jitter::CJitter&, const uint32*);
+
+	uint32				m_thenCounters[COUNTER_COUNT];
+	uint32				m_elseCounters[COUNTER_COUNT];
+	uint32				m_counterCount = 0;
+
+	CMemoryFunction		m_functions[FUNCTION_COUNT];
+	CodeBuffer			m_layoutCode[LAYOUT_COUNT];
+};
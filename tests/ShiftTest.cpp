@@ -44,6 +44,10 @@ void CShiftTest::Run()
 
 	TEST_VERIFY(m_context.resultShlVar0 == static_cast<uint32>(CONSTANT_1) << static_cast<uint32>(m_shiftAmount & 0x1F));
 	TEST_VERIFY(m_context.resultShlVar1 == static_cast<uint32>(CONSTANT_2) << static_cast<uint32>(m_shiftAmount & 0x1F));
+
+	TEST_VERIFY(m_context.resultSraCstVar == static_cast<int32>(CONSTANT_2) >> static_cast<int32>(m_shiftAmount & 0x1F));
+	TEST_VERIFY(m_context.resultSrlCstVar == static_cast<uint32>(CONSTANT_2) >> static_cast<uint32>(m_shiftAmount & 0x1F));
+	TEST_VERIFY(m_context.resultShlCstVar == static_cast<uint32>(CONSTANT_1) << static_cast<uint32>(m_shiftAmount & 0x1F));
 }
 
 void CShiftTest::Compile(Jitter::CJitter& jitter)
@@ -118,6 +122,23 @@ void CShiftTest::Compile(Jitter::CJitter& jitter)
 		jitter.PushRel(offsetof(CONTEXT, shiftAmount));
 		jitter.Shl();
 		jitter.PullRel(offsetof(CONTEXT, resultShlVar1));
+
+		//------------------
+		//Constant shifted by variable
+		jitter.PushCst(CONSTANT_2);
+		jitter.PushRel(offsetof(CONTEXT, shiftAmount));
+		jitter.Sra();
+		jitter.PullRel(offsetof(CONTEXT, resultSraCstVar));
+
+		jitter.PushCst(CONSTANT_2);
+		jitter.PushRel(offsetof(CONTEXT, shiftAmount));
+		jitter.Srl();
+		jitter.PullRel(offsetof(CONTEXT, resultSrlCstVar));
+
+		jitter.PushCst(CONSTANT_1);
+		jitter.PushRel(offsetof(CONTEXT, shiftAmount));
+		jitter.Shl();
+		jitter.PullRel(offsetof(CONTEXT, resultShlCstVar));
 	}
 	jitter.End();
 
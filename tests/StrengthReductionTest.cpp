@@ -0,0 +1,246 @@
+#include "StrengthReductionTest.h"
+#include <cstdio>
+#include "MemStream.h"
+
+static const uint32 g_multipliers[] = { 0, 1, 2, 3, 0x10, 0x40000000, 0x80000000, 0xFFFFFFFF };
+static const uint32 g_unsignedDivisors[] = { 1, 2, 3, 7, 8, 10, 641, 0x10000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+static const uint32 g_signedDivisors[] = { 1, 2, 3, 8, 10, 0x40000000, 0xFFFFFFFC };
+static const uint8 g_shiftAmounts[] = { 4, 32, 33, 48, 63 };
+static const uint64 g_masks[] = { 0x00000000FFFFFFFFULL, 0xFFFFFFFF00000000ULL, 0x00FF00FF00FF00FFULL };
+static const uint32 g_logicMasks[] = { 0, 0xFFFFFFFF };
+
+static const uint64 g_inputs[] =
+{
+	0,
+	1,
+	0x7FFFFFFF00000007ULL,
+	0x800000007FFFFFFFULL,
+	0xFFFFFFFF80000000ULL,
+	0x00000001FFFFFFFFULL,
+	0x8765432112345678ULL,
+	0x123456783B9ACA07ULL,
+	0xFFFFFFFFFFFFFFFFULL,
+};
+
+void CStrengthReductionTest::PullHalves(Jitter::CJitter& jitter, size_t offset)
+{
+	jitter.PushTop();
+	jitter.ExtLow64();
+	jitter.PullRel(offset);
+	jitter.ExtHigh64();
+	jitter.PullRel(offset + 4);
+}
+
+void CStrengthReductionTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		for(unsigned int i = 0; i < MULTIPLIER_COUNT; i++)
+		{
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushCst(g_multipliers[i]);
+			jitter.Mult();
+			PullHalves(jitter, offsetof(CONTEXT, mulResults[i]));
+
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushCst(g_multipliers[i]);
+			jitter.MultS();
+			PullHalves(jitter, offsetof(CONTEXT, mulsResults[i]));
+
+			//Constant on the left side
+			jitter.PushCst(g_multipliers[i]);
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.Mult();
+			PullHalves(jitter, offsetof(CONTEXT, cstMulResults[i]));
+		}
+
+		for(unsigned int i = 0; i < UNSIGNED_DIVISOR_COUNT; i++)
+		{
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushCst(g_unsignedDivisors[i]);
+			jitter.Div();
+			PullHalves(jitter, offsetof(CONTEXT, divResults[i]));
+		}
+
+		for(unsigned int i = 0; i < SIGNED_DIVISOR_COUNT; i++)
+		{
+			jitter.PushRel(offsetof(CONTEXT, input));
+			jitter.PushCst(g_signedDivisors[i]);
+			jitter.DivS();
+			PullHalves(jitter, offsetof(CONTEXT, divsResults[i]));
+		}
+
+		for(unsigned int i = 0; i < SHIFT_AMOUNT_COUNT; i++)
+		{
+			jitter.PushRel64(offsetof(CONTEXT, input64));
+			jitter.Shl64(g_shiftAmounts[i]);
+			jitter.PullRel64(offsetof(CONTEXT, sll64Results[i]));
+
+			jitter.PushRel64(offsetof(CONTEXT, input64));
+			jitter.Srl64(g_shiftAmounts[i]);
+			jitter.PullRel64(offsetof(CONTEXT, srl64Results[i]));
+
+			jitter.PushRel64(offsetof(CONTEXT, input64));
+			jitter.Sra64(g_shiftAmounts[i]);
+			jitter.PullRel64(offsetof(CONTEXT, sra64Results[i]));
+		}
+
+		for(unsigned int i = 0; i < MASK_COUNT; i++)
+		{
+			jitter.PushRel64(offsetof(CONTEXT, input64));
+			jitter.PushCst64(g_masks[i]);
+			jitter.And64();
+			jitter.PullRel64(offsetof(CONTEXT, and64Results[i]));
+		}
+	}
+	jitter.End();
+}
+
+void CStrengthReductionTest::EmitLogicCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		for(unsigned int i = 0; i < LOGIC_MASK_COUNT; i++)
+		{
+			jitter.PushRel(offsetof(LOGIC_CONTEXT, input));
+			jitter.PushCst(g_logicMasks[i]);
+			jitter.And();
+			jitter.PullRel(offsetof(LOGIC_CONTEXT, andResults[i][0]));
+
+			jitter.PushCst(g_logicMasks[i]);
+			jitter.PushRel(offsetof(LOGIC_CONTEXT, input));
+			jitter.And();
+			jitter.PullRel(offsetof(LOGIC_CONTEXT, andResults[i][1]));
+
+			jitter.PushRel(offsetof(LOGIC_CONTEXT, input));
+			jitter.PushCst(g_logicMasks[i]);
+			jitter.Or();
+			jitter.PullRel(offsetof(LOGIC_CONTEXT, orResults[i][0]));
+
+			jitter.PushCst(g_logicMasks[i]);
+			jitter.PushRel(offsetof(LOGIC_CONTEXT, input));
+			jitter.Or();
+			jitter.PullRel(offsetof(LOGIC_CONTEXT, orResults[i][1]));
+		}
+	}
+	jitter.End();
+}
+
+void CStrengthReductionTest::Compile(Jitter::CJitter& jitter)
+{
+	jitter.SetCompileStatsEnabled(true);
+
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		bool strengthReductionEnabled = (i == 0);
+		jitter.SetStrengthReductionEnabled(strengthReductionEnabled);
+
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter);
+		m_functions[i] = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+
+		const auto& codeStats = jitter.GetLastCompileStats().code;
+		m_codeBytes[i] = codeStats.totalBytes;
+		m_divisionCount[i] = codeStats.operations[Jitter::OP_DIV].statementCount;
+	}
+
+	jitter.SetStrengthReductionEnabled(true);
+
+	{
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitLogicCode(jitter);
+		m_logicFunction = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+
+		const auto& codeStats = jitter.GetLastCompileStats().code;
+		m_logicOperationCount = codeStats.operations[Jitter::OP_AND].statementCount + codeStats.operations[Jitter::OP_OR].statementCount;
+	}
+
+	jitter.SetCompileStatsEnabled(false);
+
+	printf("StrengthReductionTest: code went from %d to %d bytes, unsigned divisions went from %d to %d.\r\n",
+		static_cast<int>(m_codeBytes[1]), static_cast<int>(m_codeBytes[0]),
+		static_cast<int>(m_divisionCount[1]), static_cast<int>(m_divisionCount[0]));
+}
+
+void CStrengthReductionTest::CheckContext(const CONTEXT& context)
+{
+	uint32 input = context.input;
+	int32 signedInput = static_cast<int32>(input);
+	uint64 input64 = context.input64;
+
+	for(unsigned int i = 0; i < MULTIPLIER_COUNT; i++)
+	{
+		uint64 product = static_cast<uint64>(input) * static_cast<uint64>(g_multipliers[i]);
+		int64 signedProduct = static_cast<int64>(signedInput) * static_cast<int64>(static_cast<int32>(g_multipliers[i]));
+		TEST_VERIFY(context.mulResults[i] == product);
+		TEST_VERIFY(context.mulsResults[i] == static_cast<uint64>(signedProduct));
+		TEST_VERIFY(context.cstMulResults[i] == product);
+	}
+
+	for(unsigned int i = 0; i < UNSIGNED_DIVISOR_COUNT; i++)
+	{
+		uint32 divisor = g_unsignedDivisors[i];
+		uint64 result = static_cast<uint64>(input / divisor) | (static_cast<uint64>(input % divisor) << 32);
+		TEST_VERIFY(context.divResults[i] == result);
+	}
+
+	for(unsigned int i = 0; i < SIGNED_DIVISOR_COUNT; i++)
+	{
+		int32 divisor = static_cast<int32>(g_signedDivisors[i]);
+		uint32 quotient = static_cast<uint32>(signedInput / divisor);
+		uint32 remainder = static_cast<uint32>(signedInput % divisor);
+		uint64 result = static_cast<uint64>(quotient) | (static_cast<uint64>(remainder) << 32);
+		TEST_VERIFY(context.divsResults[i] == result);
+	}
+
+	for(unsigned int i = 0; i < SHIFT_AMOUNT_COUNT; i++)
+	{
+		uint8 amount = g_shiftAmounts[i];
+		TEST_VERIFY(context.sll64Results[i] == (input64 << amount));
+		TEST_VERIFY(context.srl64Results[i] == (input64 >> amount));
+		TEST_VERIFY(context.sra64Results[i] == static_cast<uint64>(static_cast<int64>(input64) >> amount));
+	}
+
+	for(unsigned int i = 0; i < MASK_COUNT; i++)
+	{
+		TEST_VERIFY(context.and64Results[i] == (input64 & g_masks[i]));
+	}
+}
+
+void CStrengthReductionTest::Run()
+{
+	TEST_VERIFY(m_divisionCount[0] == 0);
+	TEST_VERIFY(m_divisionCount[1] != 0);
+
+	for(auto& function : m_functions)
+	{
+		for(const auto& input : g_inputs)
+		{
+			CONTEXT context;
+			memset(&context, 0, sizeof(CONTEXT));
+			context.input = static_cast<uint32>(input);
+			context.input64 = input;
+			function(&context);
+			CheckContext(context);
+		}
+	}
+
+	TEST_VERIFY(m_logicOperationCount == 0);
+	for(const auto& input : g_inputs)
+	{
+		LOGIC_CONTEXT context;
+		memset(&context, 0, sizeof(LOGIC_CONTEXT));
+		context.input = static_cast<uint32>(input);
+		m_logicFunction(&context);
+		for(unsigned int i = 0; i < LOGIC_MASK_COUNT; i++)
+		{
+			for(unsigned int side = 0; side < 2; side++)
+			{
+				TEST_VERIFY(context.andResults[i][side] == (context.input & g_logicMasks[i]));
+				TEST_VERIFY(context.orResults[i][side] == (context.input | g_logicMasks[i]));
+			}
+		}
+	}
+}
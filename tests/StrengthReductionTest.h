@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+
+//Checks that multiplications, divisions and 64-bit operations with constants
+//give the same results once replaced by cheaper operations
+class CStrengthReductionTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		MULTIPLIER_COUNT = 8,
+		UNSIGNED_DIVISOR_COUNT = 11,
+		SIGNED_DIVISOR_COUNT = 7,
+		SHIFT_AMOUNT_COUNT = 5,
+		MASK_COUNT = 3,
+		LOGIC_MASK_COUNT = 2,
+	};
+
+	struct CONTEXT
+	{
+		uint32			input;
+		uint32			padding;
+		uint64			input64;
+
+		uint64			mulResults[MULTIPLIER_COUNT];
+		uint64			mulsResults[MULTIPLIER_COUNT];
+		uint64			cstMulResults[MULTIPLIER_COUNT];
+		uint64			divResults[UNSIGNED_DIVISOR_COUNT];
+		uint64			divsResults[SIGNED_DIVISOR_COUNT];
+		uint64			sll64Results[SHIFT_AMOUNT_COUNT];
+		uint64			srl64Results[SHIFT_AMOUNT_COUNT];
+		uint64			sra64Results[SHIFT_AMOUNT_COUNT];
+		uint64			and64Results[MASK_COUNT];
+	};
+
+	struct LOGIC_CONTEXT
+	{
+		uint32			input;
+
+		//Constant on the right side, then on the left side
+		uint32			andResults[LOGIC_MASK_COUNT][2];
+		uint32			orResults[LOGIC_MASK_COUNT][2];
+	};
+
+	static void			PullHalves(Jitter::CJitter&, size_t);
+	static void			EmitCode(Jitter::CJitter&);
+	static void			CheckContext(const CONTEXT&);
+	static void			EmitLogicCode(Jitter::CJitter&);
+
+	CMemoryFunction		m_functions[2];
+	uint64				m_codeBytes[2] = {};
+	uint64				m_divisionCount[2] = {};
+
+	//AND/OR with all zero or all one masks, expected to be folded away entirely
+	CMemoryFunction		m_logicFunction;
+	uint64				m_logicOperationCount = 0;
+};
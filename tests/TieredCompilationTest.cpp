@@ -0,0 +1,162 @@
+#include "TieredCompilationTest.h"
+#include <cstdio>
+#include <algorithm>
+#include "MemStream.h"
+
+void CTieredCompilationTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		//result = input + (3 + 4), only made of constants on one side
+		jitter.PushRel(offsetof(CONTEXT, input));
+		jitter.PushCst(3);
+		jitter.PushCst(4);
+		jitter.Add();
+		jitter.Add();
+		jitter.PullRel(offsetof(CONTEXT, result));
+
+		//Self assignment
+		jitter.PushRel(offsetof(CONTEXT, result));
+		jitter.PullRel(offsetof(CONTEXT, result));
+
+		//value64 += 0x100000000 + 5
+		jitter.PushRel64(offsetof(CONTEXT, value64));
+		jitter.PushCst64(0x100000000ULL);
+		jitter.PushCst64(5);
+		jitter.Add64();
+		jitter.Add64();
+		jitter.PullRel64(offsetof(CONTEXT, value64));
+
+		//total += result and odds counts odd indices, for index = count to 1
+		jitter.PushRel(offsetof(CONTEXT, count));
+		jitter.PullRel(offsetof(CONTEXT, index));
+
+		jitter.BeginLoop();
+		{
+			jitter.PushRel(offsetof(CONTEXT, total));
+			jitter.PushRel(offsetof(CONTEXT, result));
+			jitter.Add();
+			jitter.PullRel(offsetof(CONTEXT, total));
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(1);
+			jitter.And();
+			jitter.PushCst(0);
+			jitter.BeginIf(Jitter::CONDITION_NE);
+			{
+				jitter.PushRel(offsetof(CONTEXT, odds));
+				jitter.PushCst(1);
+				jitter.Add();
+				jitter.PullRel(offsetof(CONTEXT, odds));
+			}
+			jitter.EndIf();
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(1);
+			jitter.Sub();
+			jitter.PullRel(offsetof(CONTEXT, index));
+
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.PushCst(0);
+			jitter.Continue(Jitter::CONDITION_NE);
+		}
+		jitter.EndLoop();
+	}
+	jitter.End();
+}
+
+void CTieredCompilationTest::Compile(Jitter::CJitter& jitter)
+{
+	jitter.SetCompileStatsEnabled(true);
+
+	//Baseline version counts its executions and gathers a profile for the optimized one
+	{
+		std::fill(std::begin(m_counters), std::end(m_counters), 0);
+
+		jitter.SetCompileTier(Jitter::CJitter::COMPILE_TIER_BASELINE);
+		jitter.SetExecutionCounter(&m_executionCount);
+		jitter.SetProfileInstrumentation(m_counters, COUNTER_COUNT);
+
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter);
+
+		m_baselineFunction = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+		m_baselineStats = jitter.GetLastCompileStats();
+
+		jitter.SetProfileInstrumentation(nullptr, 0);
+		jitter.SetExecutionCounter(nullptr);
+		jitter.SetCompileTier(Jitter::CJitter::COMPILE_TIER_OPTIMIZED);
+	}
+
+	//What a dispatcher would do: run the baseline version until it gets hot, then replace it
+	for(uint32 i = 0; m_executionCount < PROMOTION_THRESHOLD; i++)
+	{
+		RunFunction(m_baselineFunction, i);
+	}
+	m_promotionExecutionCount = m_executionCount;
+
+	{
+		jitter.SetProfile(m_counters, COUNTER_COUNT);
+
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter);
+
+		m_promotedFunction = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+		m_promotedStats = jitter.GetLastCompileStats();
+
+		jitter.SetProfile(nullptr, 0);
+	}
+
+	jitter.SetCompileStatsEnabled(false);
+
+	printf("TieredCompilationTest: baseline compilation took %d us, optimized compilation took %d us.\r\n",
+		static_cast<int>(m_baselineStats.totalTime / 1000), static_cast<int>(m_promotedStats.totalTime / 1000));
+}
+
+void CTieredCompilationTest::RunFunction(CMemoryFunction& function, uint32 count)
+{
+	CONTEXT context = {};
+	context.input = count * 3;
+	context.count = count + 1;
+	context.value64 = 0xFFFFFFFFULL;
+	function(&context);
+
+	uint32 expectedResult = context.input + 7;
+	TEST_VERIFY(context.result == expectedResult);
+	TEST_VERIFY(context.total == (expectedResult * context.count));
+	TEST_VERIFY(context.odds == ((context.count + 1) / 2));
+	TEST_VERIFY(context.index == 0);
+	TEST_VERIFY(context.value64 == 0x200000004ULL);
+}
+
+void CTieredCompilationTest::Run()
+{
+	using namespace Jitter;
+
+	//Baseline doesn't go through the optimizer
+	TEST_VERIFY(m_baselineStats.passes[CCompileStats::PASS_CONSTANTPROPAGATION].runCount == 0);
+	TEST_VERIFY(m_baselineStats.passes[CCompileStats::PASS_VALUENUMBERING].runCount == 0);
+	TEST_VERIFY(m_baselineStats.passes[CCompileStats::PASS_DEADCODEELIMINATION].runCount == 0);
+	TEST_VERIFY(m_baselineStats.passes[CCompileStats::PASS_MERGEBLOCKS].runCount == 0);
+	TEST_VERIFY(m_baselineStats.passes[CCompileStats::PASS_ALLOCATEGLOBALREGISTERS].runCount == 0);
+	TEST_VERIFY(m_baselineStats.passes[CCompileStats::PASS_GENERATECODE].runCount == 1);
+	TEST_VERIFY(m_promotedStats.passes[CCompileStats::PASS_VALUENUMBERING].runCount != 0);
+	TEST_VERIFY(m_promotedStats.passes[CCompileStats::PASS_ALLOCATEGLOBALREGISTERS].runCount != 0);
+
+	//Entry block counter matches the execution counter
+	TEST_VERIFY(m_promotionExecutionCount == PROMOTION_THRESHOLD);
+	TEST_VERIFY(m_counters[1] == PROMOTION_THRESHOLD);
+
+	for(uint32 i = 0; i < 20; i++)
+	{
+		RunFunction(m_promotedFunction, i);
+	}
+
+	//Only the baseline version counts executions
+	TEST_VERIFY(m_executionCount == PROMOTION_THRESHOLD);
+
+	RunFunction(m_baselineFunction, 20);
+	TEST_VERIFY(m_executionCount == (PROMOTION_THRESHOLD + 1));
+}
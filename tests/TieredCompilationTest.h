@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Test.h"
+#include "MemoryFunction.h"
+#include "Jitter_CompileStats.h"
+
+//Compiles a function at the baseline tier with an execution counter, promotes it to the optimized tier
+//once it ran enough times and checks that both versions give the same results
+class CTieredCompilationTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		PROMOTION_THRESHOLD = 8,
+		COUNTER_COUNT = 32,
+	};
+
+	struct CONTEXT
+	{
+		uint32			input;
+		uint32			count;
+
+		uint32			result;
+		uint32			total;
+		uint32			odds;
+		uint32			index;
+		uint64			value64;
+	};
+
+	static void			EmitCode(Jitter::CJitter&);
+
+	void				RunFunction(CMemoryFunction&, uint32);
+
+	CMemoryFunction		m_baselineFunction;
+	CMemoryFunction		m_promotedFunction;
+
+	Jitter::CCompileStats::STATS	m_baselineStats;
+	Jitter::CCompileStats::STATS	m_promotedStats;
+
+	uint32				m_executionCount = 0;
+	uint32				m_promotionExecutionCount = 0;
+	uint32				m_counters[COUNTER_COUNT];
+};
@@ -0,0 +1,179 @@
+#include "ValueNumberingTest.h"
+#include <cstdio>
+#include "MemStream.h"
+
+#define CONSTANT_STORE (0x1234)
+#define CONSTANT_CALLBACK (0x5678)
+
+void CValueNumberingTest::Callback(CONTEXT* context)
+{
+	context->memory[MEMORY_INDEX] = CONSTANT_CALLBACK;
+}
+
+void CValueNumberingTest::EmitCode(Jitter::CJitter& jitter)
+{
+	jitter.Begin();
+	{
+		//Same vector computation twice, then once more after one of its operands changed
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			if(i == 2)
+			{
+				jitter.PushRel(offsetof(CONTEXT, scalar));
+				jitter.PushCst(1);
+				jitter.Add();
+				jitter.PullRel(offsetof(CONTEXT, scalar));
+			}
+			jitter.MD_PushRelExpand(offsetof(CONTEXT, scalar));
+			jitter.MD_PushRel(offsetof(CONTEXT, vector));
+			jitter.MD_AddW();
+			jitter.MD_PullRel(offsetof(CONTEXT, mdResult0) + (i * 0x10));
+		}
+
+		//Same 32-bit sum twice, then once more after one of its operands changed
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			if(i == 2)
+			{
+				jitter.PushRel(offsetof(CONTEXT, b));
+				jitter.PushRel(offsetof(CONTEXT, a));
+				jitter.Xor();
+				jitter.PullRel(offsetof(CONTEXT, a));
+			}
+			jitter.PushRel(offsetof(CONTEXT, a));
+			jitter.PushRel(offsetof(CONTEXT, b));
+			jitter.Add();
+			jitter.PushRel(offsetof(CONTEXT, b));
+			jitter.Xor();
+			jitter.PullRel(offsetof(CONTEXT, sum0) + (i * 4));
+		}
+
+		//Same 64-bit sum twice, then once more after half of an operand changed
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			if(i == 2)
+			{
+				jitter.PushRel(offsetof(CONTEXT, a));
+				jitter.PullRel(offsetof(CONTEXT, value64) + 4);
+			}
+			jitter.PushRel64(offsetof(CONTEXT, value64));
+			jitter.PushRel64(offsetof(CONTEXT, other64));
+			jitter.Add64();
+			jitter.PullRel64(offsetof(CONTEXT, result64_0) + (i * 8));
+		}
+
+		//Loads from the same address, separated by a store and a call
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			if(i == 2)
+			{
+				jitter.PushRelRef(offsetof(CONTEXT, memory));
+				jitter.PushRel(offsetof(CONTEXT, index));
+				jitter.AddRef();
+				jitter.PushCst(CONSTANT_STORE);
+				jitter.StoreAtRef();
+			}
+			else if(i == 3)
+			{
+				jitter.PushCtx();
+				jitter.Call(reinterpret_cast<void*>(&CValueNumberingTest::Callback), 1, Jitter::CJitter::RETURN_VALUE_NONE);
+			}
+			jitter.PushRelRef(offsetof(CONTEXT, memory));
+			jitter.PushRel(offsetof(CONTEXT, index));
+			jitter.AddRef();
+			jitter.LoadFromRef();
+			jitter.PullRel(offsetof(CONTEXT, load0) + (i * 4));
+		}
+	}
+	jitter.End();
+}
+
+void CValueNumberingTest::Compile(Jitter::CJitter& jitter)
+{
+	jitter.SetCompileStatsEnabled(true);
+
+	size_t codeSizes[2] = {};
+	for(unsigned int i = 0; i < 2; i++)
+	{
+		bool enabled = (i == 0);
+		jitter.SetValueNumberingEnabled(enabled);
+
+		Framework::CMemStream codeStream;
+		jitter.SetStream(&codeStream);
+		EmitCode(jitter);
+		m_functions[i] = CMemoryFunction(codeStream.GetBuffer(), codeStream.GetSize());
+		codeSizes[i] = codeStream.GetSize();
+
+		if(enabled)
+		{
+			const auto& passStats = jitter.GetLastCompileStats().passes[Jitter::CCompileStats::PASS_VALUENUMBERING];
+			m_statementsBefore = passStats.statementsBefore;
+			m_statementsAfter = passStats.statementsAfter;
+		}
+	}
+
+	jitter.SetValueNumberingEnabled(true);
+	jitter.SetCompileStatsEnabled(false);
+
+	printf("ValueNumberingTest: value numbering removed %d statements, code size went from %d to %d bytes.\r\n",
+		static_cast<int>(m_statementsBefore - m_statementsAfter), static_cast<int>(codeSizes[1]), static_cast<int>(codeSizes[0]));
+}
+
+void CValueNumberingTest::InitContext(CONTEXT& context)
+{
+	memset(&context, 0, sizeof(CONTEXT));
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		context.vector[i] = 0x10000 * (i + 1);
+	}
+	context.scalar = 0x10;
+	context.a = 0x1111;
+	context.b = 0x2020;
+	context.value64 = 0x00000001FFFFFFFFULL;
+	context.other64 = 0x0000000200000001ULL;
+	for(unsigned int i = 0; i < MEMORY_SIZE; i++)
+	{
+		m_memory[i] = i * 0x100;
+	}
+	context.memory = m_memory;
+	context.index = MEMORY_INDEX * sizeof(uint32);
+}
+
+void CValueNumberingTest::CheckContext(const CONTEXT& context)
+{
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		TEST_VERIFY(context.mdResult0[i] == context.vector[i] + 0x10);
+		TEST_VERIFY(context.mdResult1[i] == context.vector[i] + 0x10);
+		TEST_VERIFY(context.mdResult2[i] == context.vector[i] + 0x11);
+	}
+
+	TEST_VERIFY(context.sum0 == ((0x1111 + 0x2020) ^ 0x2020));
+	TEST_VERIFY(context.sum1 == ((0x1111 + 0x2020) ^ 0x2020));
+	TEST_VERIFY(context.a == (0x1111 ^ 0x2020));
+	TEST_VERIFY(context.sum2 == (((0x1111 ^ 0x2020) + 0x2020) ^ 0x2020));
+
+	TEST_VERIFY(context.result64_0 == 0x0000000400000000ULL);
+	TEST_VERIFY(context.result64_1 == 0x0000000400000000ULL);
+	uint64 value64 = 0x00000000FFFFFFFFULL | (static_cast<uint64>(context.a) << 32);
+	TEST_VERIFY(context.value64 == value64);
+	TEST_VERIFY(context.result64_2 == (value64 + 0x0000000200000001ULL));
+
+	TEST_VERIFY(context.load0 == (MEMORY_INDEX * 0x100));
+	TEST_VERIFY(context.load1 == (MEMORY_INDEX * 0x100));
+	TEST_VERIFY(context.load2 == CONSTANT_STORE);
+	TEST_VERIFY(context.load3 == CONSTANT_CALLBACK);
+}
+
+void CValueNumberingTest::Run()
+{
+	TEST_VERIFY(m_statementsAfter < m_statementsBefore);
+
+	for(auto& function : m_functions)
+	{
+		CONTEXT context;
+		InitContext(context);
+		function(&context);
+		CheckContext(context);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Test.h"
+#include "Align16.h"
+#include "MemoryFunction.h"
+
+//Checks that repeated computations are reused, but not across writes to their operands, stores or calls
+class CValueNumberingTest : public CTest
+{
+public:
+	void				Run() override;
+	void				Compile(Jitter::CJitter&) override;
+
+private:
+	enum
+	{
+		MEMORY_SIZE = 0x10,
+		MEMORY_INDEX = 5,
+	};
+
+	struct CONTEXT
+	{
+		ALIGN16
+
+		uint32			vector[4];
+		uint32			mdResult0[4];
+		uint32			mdResult1[4];
+		uint32			mdResult2[4];
+
+		uint64			value64;
+		uint64			other64;
+		uint64			result64_0;
+		uint64			result64_1;
+		uint64			result64_2;
+
+		uint32*			memory;
+		uint32			index;
+
+		uint32			a;
+		uint32			b;
+		uint32			scalar;
+		uint32			sum0;
+		uint32			sum1;
+		uint32			sum2;
+		uint32			load0;
+		uint32			load1;
+		uint32			load2;
+		uint32			load3;
+	};
+
+	static void			EmitCode(Jitter::CJitter&);
+	static void			Callback(CONTEXT*);
+
+	void				InitContext(CONTEXT&);
+	void				CheckContext(const CONTEXT&);
+
+	uint32				m_memory[MEMORY_SIZE];
+	CMemoryFunction		m_functions[2];
+	uint64				m_statementsBefore = 0;
+	uint64				m_statementsAfter = 0;
+};